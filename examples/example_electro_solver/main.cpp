@@ -1094,6 +1094,18 @@ int main(int argc, char ** argv)
     std::string system_mass = data(model + "/diffusion_mass", "mass");
     std::string iion_mass = data(model + "/reaction_mass", "lumped_mass");
     //bidomain.restart(importer, 1);
+    // Binary checkpoints: restart_checkpoint = file written by a previous run
+    // every checkpoint_every iterations
+    std::string restart_checkpoint = data("restart_checkpoint", "NONE");
+    int checkpoint_every = data("checkpoint_every", 0);
+    bool restarted = false;
+    if ("NONE" != restart_checkpoint)
+    {
+        solver->restart_from_checkpoint(restart_checkpoint, datatime.M_time, datatime.M_iter);
+        save_iter = datatime.M_iter / datatime.M_saveIter;
+        restarted = true;
+    }
+    // after the restart: the system matrix depends on the time step counter
     std::cout << "Assembling matrices" << std::endl;
     solver->assemble_matrices(datatime.M_dt);
 
@@ -1101,7 +1113,7 @@ int main(int argc, char ** argv)
     if (export_data)
     {
         solver->save_parameters();
-        solver->save_potential(save_iter, 0.0);
+        if (!restarted) solver->save_potential(save_iter, 0.0);
     }
 
 
@@ -1140,6 +1152,7 @@ int main(int argc, char ** argv)
 
         //std::cout << "at:" << datatime.M_time << std::endl;
         solver->update_activation_time(datatime.M_time, -5.0);
+        solver->update_activation_maps(datatime.M_time);
         //std::cout << "at done:" << datatime.M_time << std::endl;
 
         //++save_iter_ve;
@@ -1167,7 +1180,15 @@ int main(int argc, char ** argv)
 
         }
 
+        if (checkpoint_every > 0 && 0 == datatime.M_iter % checkpoint_every)
+        {
+            solver->save_checkpoint(solver->M_outputFolder + "checkpoint_" + std::to_string(datatime.M_iter) + ".bin", datatime.M_time, datatime.M_iter);
+        }
+
     }
+    // maps of the last (partial) beat
+    solver->save_activation_maps();
+    solver->wait_for_output();
 //    if (export_data)
         solver->save_activation_times(save_iter);
     delete solver;
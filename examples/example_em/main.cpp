@@ -51,9 +51,11 @@
 // Basic include files needed for the mesh functionality.
 #include "Electromechanics/Electromechanics.hpp"
 #include "Electrophysiology/Monodomain/MonodomainUtil.hpp"
+#include "Electrophysiology/SplittingScheduler.hpp"
 
 #include "libmesh/linear_implicit_system.h"
 #include "libmesh/transient_system.h"
+#include "libmesh/explicit_system.h"
 
 #include "libmesh/wrapped_functor.h"
 #include "libmesh/mesh.h"
@@ -148,7 +150,6 @@ int main (int argc, char ** argv)
       std::string system_mass = data("monodomain/system_mass", "mass");
       std::string iion_mass = data("monodomain/iion_mass", "lumped_mass");
       bool useMidpointMethod = false;
-      int step0 = 0;
       int step1 = 1;
 
       std::cout << "Assembling monodomain ..." << std::endl;
@@ -156,6 +157,12 @@ int main (int argc, char ** argv)
       em.M_monowave->form_system_matrix(datatime.M_dt,false, system_mass);
       std::cout << " done" << std::endl;
 
+      // Splitting of the electrophysiology, read from the monodomain section of its datafile
+      GetPot electro_data(data("electrophysiology", "monodomain.beat"));
+      BeatIt::SplittingScheduler splitting(*em.M_monowave);
+      splitting.setup(electro_data, "monodomain");
+      libMesh::NumericVector<libMesh::Number>* I4f = es.get_system<libMesh::ExplicitSystem>("I4f").solution.get();
+
       double emdt = data("em/time/emdt", 1.0);
       int em_iter = static_cast<int>(emdt/datatime.M_dt);
       double emdt_exo = data("em/time/save_exo", 10.0);
@@ -167,11 +174,8 @@ int main (int argc, char ** argv)
           datatime.advance();
           // Electrophysiology
 
-          em.M_monowave->advance();
-
           //em.M_monowave->update_pacing(datatime.M_time);
-          em.solve_reaction_step(datatime.M_dt, datatime.M_time,step0, useMidpointMethod, iion_mass);
-          em.M_monowave->solve_diffusion_step(datatime.M_dt, datatime.M_time, useMidpointMethod, iion_mass);
+          splitting.step(datatime.M_dt, datatime.M_time, useMidpointMethod, iion_mass, I4f);
 
           em.M_monowave->update_activation_time(datatime.M_time);
           // Activation part
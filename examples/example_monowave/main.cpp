@@ -50,6 +50,7 @@
 // Basic include files needed for the mesh functionality.
 #include "Electrophysiology/Monodomain/Monowave.hpp"
 #include "Electrophysiology/Monodomain/MonodomainUtil.hpp"
+#include "Electrophysiology/SplittingScheduler.hpp"
 
 #include "libmesh/linear_implicit_system.h"
 #include "libmesh/transient_system.h"
@@ -279,6 +280,9 @@ int main(int argc, char ** argv)
 
 
 
+    BeatIt::SplittingScheduler splitting(monodomain);
+    splitting.setup(data, "monodomain");
+
     perf_log.push("time loop");
 
     BeatIt::Timer timer;
@@ -295,24 +299,12 @@ int main(int argc, char ** argv)
 
         perf_log.push("advancing");
         datatime.advance();
-        monodomain.advance();
         perf_log.pop("advancing");
 
-        //perf_log.push("pacing");
-        //monodomain.update_pacing(datatime.M_time);
-        //perf_log.pop("pacing");
-        perf_log.push("reaction");
-        monodomain.solve_reaction_step(datatime.M_dt, datatime.M_time, step0, useMidpointMethod, iion_mass);
-        perf_log.pop("reaction");
-
-//          if( 0 == datatime.M_iter%datatime.M_saveIter )
-//          {
-//              std::cout << "* Test Monowave: Time: " << datatime.M_time << std::endl;
-//             monodomain.save_potential(save_iter++, datatime.M_time-0.5*datatime.M_dt);
-//          }
-        perf_log.push("diffusion");
-        monodomain.solve_diffusion_step(datatime.M_dt, datatime.M_time, useMidpointMethod, iion_mass);
-        perf_log.pop("diffusion");
+        // advance, reaction and diffusion steps
+        perf_log.push("splitting step");
+        splitting.step(datatime.M_dt, datatime.M_time, useMidpointMethod, iion_mass);
+        perf_log.pop("splitting step");
 
 //          if( 0 == datatime.M_iter%datatime.M_saveIter )
 //          {
@@ -71,6 +71,8 @@
 #include "libmesh/perf_log.h"
 
 #include <sys/stat.h>
+#include <algorithm>
+#include <limits>
 #include "BoundaryConditions/BCData.hpp"
 #include "Util/IO/io.hpp"
 #include "Util/MapsToLibMeshTypes.hpp"
@@ -90,7 +92,7 @@ namespace BeatIt
 typedef libMesh::TransientLinearImplicitSystem LinearSystem;
 
 DynamicElasticity::DynamicElasticity(libMesh::EquationSystems& es, std::string system_name)
-                : super(es, system_name)
+                : super(es, system_name), M_cfl(0.5), M_stableTimeStep(0.0), M_lumpedMassDofs(0), M_lumpedMassElements(0)
 {
     // TODO Auto-generated constructor stub
 }
@@ -192,6 +194,8 @@ void DynamicElasticity::setupSystem(std::string section)
 
     system.add_vector("residual");
     system.add_vector("step");
+    system.add_vector("lumped_mass");
+    system.add_vector("inverse_lumped_mass");
     system.add_matrix("mass");
 
     std::cout << "* ELASTICITY: Reading BC ... " << std::endl;
@@ -277,6 +281,8 @@ void DynamicElasticity::setupSystem(std::string section)
     std::string time_integrator = M_datafile(section + "/time_integrator", "explicit");
     if ("implicit" == time_integrator)
         M_timeIntegratorType = DynamicTimeIntegratorType::Implicit;
+    else if ("central_difference" == time_integrator)
+        M_timeIntegratorType = DynamicTimeIntegratorType::CentralDifference;
     else
         M_timeIntegratorType = DynamicTimeIntegratorType::Explicit;
     if (fefamily != libMesh::FEFamily::LAGRANGE)
@@ -286,6 +292,211 @@ void DynamicElasticity::setupSystem(std::string section)
     }
     else
         M_usingDG = false;
+    M_cfl = M_datafile(section + "/cfl", 0.5);
+    std::cout << "* DYNAMIC ELASTICITY: time integrator: " << time_integrator << std::endl;
+}
+
+void DynamicElasticity::newton(double dt, libMesh::NumericVector<libMesh::Number>* activation_ptr)
+{
+    if (M_timeIntegratorType == DynamicTimeIntegratorType::CentralDifference)
+        central_difference(dt, activation_ptr);
+    else
+        super::newton(dt, activation_ptr);
+}
+
+int DynamicElasticity::central_difference(double dt, libMesh::NumericVector<libMesh::Number>* activation_ptr)
+{
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    LinearSystem& disp_system = M_equationSystems.get_system<LinearSystem>("displacement");
+    // After a reinit of the systems (AMR, restart) the mass is assembled again
+    const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
+    if (M_lumpedMassDofs != system.n_dofs() || M_lumpedMassElements != mesh.n_active_elem())
+    {
+        assemble_lumped_mass();
+    }
+    // The wave speed changes with the deformation
+    M_stableTimeStep = estimate_stable_time_step();
+    std::cout << "* DYNAMIC ELASTICITY: central difference: stable time step: " << M_stableTimeStep << std::endl;
+    const int n_substeps = std::max(1, static_cast<int>(std::ceil(dt / M_stableTimeStep - 1e-12)));
+    const double substep = dt / n_substeps;
+
+    // The inertia term of the residual vanishes when the current and old velocities are equal:
+    // the residual is the force F(u)
+    advance();
+    system.update();
+    disp_system.update();
+    auto& step = system.get_vector("step");
+    const auto& inverse_mass = system.get_vector("inverse_lumped_mass");
+    for (int n = 0; n < n_substeps; ++n)
+    {
+        assemble_residual_only(substep, activation_ptr);
+        step.pointwise_mult(*system.rhs, inverse_mass);
+        system.solution->add(substep, step);
+        system.get_dof_map().enforce_constraints_exactly(system);
+        update_displacements(substep);
+        advance();
+    }
+    std::cout << "* DYNAMIC ELASTICITY: central difference: " << n_substeps << " substeps of " << substep << std::endl;
+    return n_substeps;
+}
+
+void DynamicElasticity::assemble_lumped_mass()
+{
+    const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
+    const unsigned int dim = mesh.mesh_dimension();
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    const libMesh::DofMap & dof_map = system.get_dof_map();
+    auto& lumped_mass = system.get_vector("lumped_mass");
+    lumped_mass.zero();
+
+    libMesh::FEType fe_type = dof_map.variable_type(0);
+    std::unique_ptr<libMesh::FEBase> fe(libMesh::FEBase::build(dim, fe_type));
+    libMesh::QGauss qrule(dim, fe_type.default_quadrature_order());
+    fe->attach_quadrature_rule(&qrule);
+    const std::vector<libMesh::Real> & JxW = fe->get_JxW();
+    const std::vector<std::vector<libMesh::Real> > & phi = fe->get_phi();
+
+    libMesh::DenseVector<libMesh::Number> Me;
+    std::vector<libMesh::dof_id_type> dof_indices;
+
+    libMesh::MeshBase::const_element_iterator el = mesh.active_local_elements_begin();
+    const libMesh::MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+    for (; el != end_el; ++el)
+    {
+        const libMesh::Elem * elem = *el;
+        auto material = M_materialMap.find(elem->subdomain_id());
+        if (material == M_materialMap.end()) throw std::runtime_error("DynamicElasticity: no material for the block " + std::to_string(elem->subdomain_id()));
+        const double rho = material->second->M_density;
+        fe->reinit(elem);
+        const unsigned int n_phi = phi.size();
+        Me.resize(n_phi);
+        double element_mass = 0.0;
+        double diagonal_mass = 0.0;
+        for (unsigned int qp = 0; qp < qrule.n_points(); qp++)
+        {
+            element_mass += rho * JxW[qp];
+            for (unsigned int n = 0; n < n_phi; ++n)
+            {
+                Me(n) += rho * JxW[qp] * phi[n][qp] * phi[n][qp];
+                diagonal_mass += rho * JxW[qp] * phi[n][qp] * phi[n][qp];
+            }
+        }
+        // The diagonal is scaled to preserve the mass of the element
+        Me.scale(element_mass / diagonal_mass);
+        for (unsigned int var = 0; var < dim; ++var)
+        {
+            dof_map.dof_indices(elem, dof_indices, var);
+            lumped_mass.add_vector(Me, dof_indices);
+        }
+    }
+    lumped_mass.close();
+    auto& inverse_mass = system.get_vector("inverse_lumped_mass");
+    inverse_mass = lumped_mass;
+    inverse_mass.reciprocal();
+    M_lumpedMassDofs = system.n_dofs();
+    M_lumpedMassElements = mesh.n_active_elem();
+}
+
+void DynamicElasticity::materials_changed()
+{
+    super::materials_changed();
+    // The density and the wave speed belong to the old material
+    M_lumpedMassDofs = 0;
+    M_lumpedMassElements = 0;
+    M_stableTimeStep = 0.0;
+}
+
+namespace
+{
+//! Bound of the largest wave speed of the material at the state
+/*!
+ *  The eigenvalues of the acoustic tensor Q(n)_ji = sum_kl A[i][k](j,l) n_k n_l are bounded
+ *  for all the unit directions n by the Gershgorin bound sum_i max_k sum_l |A[i][k](j,l)|
+ *  (|sum_kl c_kl n_k n_l| is at most the largest row sum of |c|), divided by the density
+ */
+double wave_speed(Material& material, const Material::KinematicState& state, unsigned int dim)
+{
+    libMesh::TensorValue<double> PK1;
+    material.stress(state, ElasticSolverType::Primal, PK1);
+    libMesh::TensorValue<double> A[3][3];
+    material.tangent_basis(dim, A);
+    double q_max = 0.0;
+    for (unsigned int j = 0; j < dim; ++j)
+    {
+        double q = 0.0;
+        for (unsigned int i = 0; i < dim; ++i)
+        {
+            double row_max = 0.0;
+            for (unsigned int k = 0; k < dim; ++k)
+            {
+                double row = 0.0;
+                for (unsigned int l = 0; l < dim; ++l) row += std::abs(A[i][k](j, l));
+                row_max = std::max(row_max, row);
+            }
+            q += row_max;
+        }
+        q_max = std::max(q_max, q);
+    }
+    return std::sqrt(q_max / material.M_density);
+}
+}
+
+double DynamicElasticity::estimate_stable_time_step()
+{
+    const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
+    const unsigned int dim = mesh.mesh_dimension();
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    LinearSystem& disp_system = M_equationSystems.get_system<LinearSystem>("displacement");
+    const libMesh::DofMap & dof_map = disp_system.get_dof_map();
+    const int order = std::max(1, static_cast<int>(system.get_dof_map().variable_type(0).order));
+    const ParameterSystem& fiber_system = M_equationSystems.get_system<ParameterSystem>("fibers");
+    const ParameterSystem& sheets_system = M_equationSystems.get_system<ParameterSystem>("sheets");
+    const libMesh::DofMap & dof_map_fibers = fiber_system.get_dof_map();
+
+    // Displacement gradient at the center of the elements
+    libMesh::FEType fe_type = dof_map.variable_type(0);
+    std::unique_ptr<libMesh::FEBase> fe(libMesh::FEBase::build(dim, fe_type));
+    libMesh::QGauss qrule(dim, libMesh::CONSTANT);
+    fe->attach_quadrature_rule(&qrule);
+    const std::vector<std::vector<libMesh::RealGradient> > & dphi = fe->get_dphi();
+    std::vector<libMesh::dof_id_type> dof_indices;
+    std::vector<libMesh::dof_id_type> dof_indices_fibers;
+    std::vector<double> disp;
+    Material::KinematicState state;
+
+    double c_max = 0.0;
+    double h_min = std::numeric_limits<double>::max();
+    libMesh::MeshBase::const_element_iterator el = mesh.active_local_elements_begin();
+    const libMesh::MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+    for (; el != end_el; ++el)
+    {
+        const libMesh::Elem * elem = *el;
+        h_min = std::min(h_min, elem->hmin() / order);
+        auto material = M_materialMap.find(elem->subdomain_id());
+        if (material == M_materialMap.end()) throw std::runtime_error("DynamicElasticity: no material for the block " + std::to_string(elem->subdomain_id()));
+
+        fe->reinit(elem);
+        dof_map.dof_indices(elem, dof_indices);
+        disp_system.current_local_solution->get(dof_indices, disp);
+        const unsigned int n_phi = dphi.size();
+        state.gradU.zero();
+        for (unsigned int i = 0; i < dim; ++i)
+            for (unsigned int l = 0; l < n_phi; ++l)
+                for (unsigned int k = 0; k < dim; ++k)
+                    state.gradU(i, k) += dphi[l][0](k) * disp[l + i * n_phi];
+        state.FA.zero();
+        dof_map_fibers.dof_indices(elem, dof_indices_fibers);
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            state.f0(i) = (*fiber_system.solution)(dof_indices_fibers[i]);
+            state.s0(i) = (*sheets_system.solution)(dof_indices_fibers[i]);
+        }
+        c_max = std::max(c_max, wave_speed(*material->second, state, dim));
+    }
+    mesh.comm().min(h_min);
+    mesh.comm().max(c_max);
+    std::cout << "* DYNAMIC ELASTICITY: CFL: minimum node spacing: " << h_min << ", wave speed: " << c_max << ", safety factor: " << M_cfl << std::endl;
+    return M_cfl * h_min / c_max;
 }
 
 void DynamicElasticity::update_displacements(double dt)
@@ -333,11 +544,17 @@ void DynamicElasticity::assemble_residual(
 
 //    std::cout << "Disp! " <<std::endl;
 //    disp_system.solution->print(std::cout);
-    system.get_vector("residual").zero();
-    system.get_vector("step").zero();
-    system.get_matrix("mass").zero();
-    system.rhs->zero();
-    system.matrix->zero();
+    if (M_assembleResidual)
+    {
+        system.get_vector("residual").zero();
+        system.get_vector("step").zero();
+        system.rhs->zero();
+    }
+    if (M_assembleJacobian)
+    {
+        system.get_matrix("mass").zero();
+        system.matrix->zero();
+    }
 //    system.solution->print(std::cout);
 //    disp_system.solution->print(std::cout);
 
@@ -614,6 +831,7 @@ void DynamicElasticity::assemble_residual(
             }
 
             // Matrix
+            if (!M_assembleJacobian) continue;
             // for each dimension of the test function
             for (int jdim = 0; jdim < dim; jdim++)
             {
@@ -1286,14 +1504,19 @@ void DynamicElasticity::assemble_residual(
                         dof_map.constrain_element_vector(Fee, dof_indices);
                         dof_map.constrain_element_vector(Fen, neighbor_dof_indices);
 
-                        system.rhs->add_vector(Fee, dof_indices);
-                        system.rhs->add_vector(Fen, neighbor_dof_indices);
+                        if (M_assembleResidual)
+                        {
+                            system.rhs->add_vector(Fee, dof_indices);
+                            system.rhs->add_vector(Fen, neighbor_dof_indices);
+                        }
 //                        std::cout << "BEFORE ADDING KEE" << std::endl;
-                        system.matrix->add_matrix(Kee, dof_indices);
-//                        std::cout << "BEFORE ADDING KEN" << std::endl;
-                        system.matrix->add_matrix(Ken, dof_indices, neighbor_dof_indices);
-                        system.matrix->add_matrix(Kne, neighbor_dof_indices, dof_indices);
-                        system.matrix->add_matrix(Knn, neighbor_dof_indices);
+                        if (M_assembleJacobian)
+                        {
+                            system.matrix->add_matrix(Kee, dof_indices);
+                            system.matrix->add_matrix(Ken, dof_indices, neighbor_dof_indices);
+                            system.matrix->add_matrix(Kne, neighbor_dof_indices, dof_indices);
+                            system.matrix->add_matrix(Knn, neighbor_dof_indices);
+                        }
 //                        std::cout << "AFTER ADDING KEN" << std::endl;
                         //system.rhs->add_vector(Fen, dof_indices);
                     } // end if active element
@@ -1306,15 +1529,21 @@ void DynamicElasticity::assemble_residual(
         dof_map.constrain_element_matrix_and_vector(Ke, Fe, dof_indices);
       dof_map.constrain_element_matrix_and_vector (Me, Fe, dof_indices);
 //      Me.print(std::cout);
-        system.matrix->add_matrix(Ke, dof_indices);
-        system.get_matrix("mass").add_matrix(Me, dof_indices);
-        system.rhs->add_vector(Fe, dof_indices);
+        if (M_assembleJacobian)
+        {
+            system.matrix->add_matrix(Ke, dof_indices);
+            system.get_matrix("mass").add_matrix(Me, dof_indices);
+        }
+        if (M_assembleResidual) system.rhs->add_vector(Fe, dof_indices);
 
 
     } // end loop over elements
-    system.matrix->close();
-    system.get_matrix("mass").close();
-    system.rhs->close();
+    if (M_assembleJacobian)
+    {
+        system.matrix->close();
+        system.get_matrix("mass").close();
+    }
+    if (M_assembleResidual) system.rhs->close();
 
 }
 
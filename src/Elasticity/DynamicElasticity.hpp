@@ -61,10 +61,43 @@ public:
 
     void save(const std::string& output_filename, int step);
 
+    //! With the central difference integrator advances the solution by dt in explicit substeps
+    void newton(double dt = 0.0, libMesh::NumericVector<libMesh::Number>* activation_ptr = nullptr);
+    //! Explicit central difference: v += dt M_L^-1 F(u), u += dt v
+    /*!
+     *  Only the residual is assembled. dt (e.g. the electrophysiology time step)
+     *  is split in the smallest number of substeps satisfying the CFL condition,
+     *  with the activation held constant.
+     *  \return the number of substeps
+     */
+    int central_difference(double dt, libMesh::NumericVector<libMesh::Number>* activation_ptr = nullptr);
+    //! HRZ lumped mass: diagonal of the element mass matrix scaled to preserve the element mass
+    /*!
+     *  The density is the one of the material of each block. Positive also for quadratic elements.
+     */
+    void assemble_lumped_mass();
+    //! CFL time step: cfl * min(h / p) / c, with c the largest wave speed of the materials
+    /*!
+     *  The wave speed is bounded over all the directions with the tangent at the current
+     *  deformation, at the center of each element: stiffening materials get a smaller step
+     *  as they deform. Called at each call of central_difference, the deformation of its
+     *  substeps is covered by the safety factor cfl.
+     */
+    double estimate_stable_time_step();
+    //! The lumped mass and the stable time step are recomputed
+    void materials_changed();
+
 
 	DynamicTimeIntegratorType M_timeIntegratorType;
     bool M_usingDG;
     int M_saveStep;
+    //! Safety factor of the CFL condition of the central difference integrator
+    double M_cfl;
+    //! Largest stable time step of the central difference integrator (0 = not estimated yet)
+    double M_stableTimeStep;
+    //! Dofs and elements of the lumped mass: it is assembled again after a reinit of the systems
+    libMesh::dof_id_type M_lumpedMassDofs;
+    libMesh::dof_id_type M_lumpedMassElements;
 };
 
 } /* namespace BeatIt */
@@ -72,8 +72,11 @@
 #include "libmesh/vtk_io.h"
 
 #include "libmesh/perf_log.h"
+#include "libmesh/libmesh.h"
+#include "libmesh/threads.h"
 
 #include <sys/stat.h>
+#include <algorithm>
 #include "BoundaryConditions/BCData.hpp"
 #include "Util/IO/io.hpp"
 #include "Util/MapsToLibMeshTypes.hpp"
@@ -89,6 +92,8 @@
 #include "Elasticity/Materials/HolzapfelOgden.hpp"
 #include "Elasticity/Materials/Guccione.hpp"
 #include "Util/Timer.hpp"
+#include "Util/IO/CompressedFieldIO.hpp"
+#include "Elasticity/ElasticityFunctions.hpp"
 
 namespace libMesh
 {
@@ -100,9 +105,44 @@ namespace BeatIt
 
 typedef libMesh::TransientLinearImplicitSystem LinearSystem;
 
+namespace
+{
+//! The element matrix has some nonzero entry
+bool has_nonzero_entries(const libMesh::DenseMatrix<libMesh::Number>& Ke)
+{
+    for (unsigned int i = 0; i < Ke.m(); ++i)
+        for (unsigned int j = 0; j < Ke.n(); ++j)
+            if (Ke(i, j) != 0.0) return true;
+    return false;
+}
+
+//! Linear elements with the nodes of a quadratic element, nullptr if the element is not supported
+const std::vector<std::vector<unsigned int> >* low_order_subelements(libMesh::ElemType type)
+{
+    static const std::vector<std::vector<unsigned int> > tri6 = { { 0, 3, 5 }, { 3, 1, 4 }, { 5, 4, 2 }, { 3, 4, 5 } };
+    // 4 corner tetrahedra and the inner octahedron split along the diagonal 4-9
+    static const std::vector<std::vector<unsigned int> > tet10 = { { 0, 4, 6, 7 }, { 4, 1, 5, 8 }, { 6, 5, 2, 9 }, { 7, 8, 9, 3 },
+                                                                    { 4, 9, 5, 6 }, { 4, 9, 6, 7 }, { 4, 9, 7, 8 }, { 4, 9, 8, 5 } };
+    switch (type)
+    {
+        case libMesh::TRI6:
+            return &tri6;
+        case libMesh::TET10:
+            return &tet10;
+        default:
+            return nullptr;
+    }
+}
+}
+
 Elasticity::Elasticity(libMesh::EquationSystems& es, std::string system_name)
         : M_equationSystems(es), M_exporter(), M_outputFolder(), M_datafile(), M_linearSolver(), M_bch(), M_rhsFunction(), M_myName(system_name), M_JacIsAssembled(
-                false), M_stabilize(false), M_currentNewtonIter(0)
+                false), M_assembleJacobian(true), M_assembleResidual(true), M_stabilize(false), M_tangentOnce(false), M_currentNewtonIter(0),
+          M_matrixFree(false), M_shellMatrix(), M_referenceTangentIsAssembled(false), M_referenceConfiguration(false),
+          M_useNearNullSpace(true), M_rigidBodyModes(),
+          M_fieldSplit(false), M_schurScaling(1.0), M_schurFactorization("full"),
+          M_isDisplacement(nullptr), M_isPressure(nullptr), M_schurPreconditioner(nullptr),
+          M_previousActivation(), M_loadScaling(1.0)
 {
     // TODO Auto-generated constructor stub
 
@@ -110,7 +150,9 @@ Elasticity::Elasticity(libMesh::EquationSystems& es, std::string system_name)
 
 Elasticity::~Elasticity()
 {
-    // TODO Auto-generated destructor stub
+    if (M_isDisplacement) ISDestroy(&M_isDisplacement);
+    if (M_isPressure) ISDestroy(&M_isPressure);
+    if (M_schurPreconditioner) MatDestroy(&M_schurPreconditioner);
 }
 
 void Elasticity::write_equation_system(const std::string& es)
@@ -141,6 +183,14 @@ void Elasticity::save_exo(const std::string& output_filename, int step, double t
     {
         project_pressure();
     }
+    if (M_compressedWriter)
+    {
+        std::cout << "* ELASTICITY: Compressed output of " << M_myName << "_*.bfo at time " << time << " in: " << M_outputFolder << " ... " << std::flush;
+        std::set<std::string> systems = { M_myName, "Pressure_Projection" };
+        M_compressedWriter->write_timestep(M_equationSystems, systems, step, time);
+        std::cout << "done " << std::endl;
+        return;
+    }
     std::cout << "* ELASTICITY: EXODUSII::Exporting  time " << time << " in: " << M_outputFolder << " ... " << std::flush;
     M_exporter->write_timestep(M_outputFolder + output_filename, M_equationSystems, step, time);
     M_exporter->write_element_data(M_equationSystems);
@@ -227,6 +277,9 @@ void Elasticity::setupSystem(std::string section)
         libMesh::FEFamily p_fefamily = BeatIt::libmesh_fefamily_map.find(fam)->second;
         system.add_variable(pressure_name, p_order, p_fefamily);
         std::cout << " ... done " << std::endl;
+        // The matrices can be added only before the initialization of the system
+        M_fieldSplit = M_datafile(section + "/linear_solver/fieldsplit", false);
+        if (M_fieldSplit) system.add_matrix("pressure_mass");
 
     }
     else
@@ -451,6 +504,7 @@ void Elasticity::setupParameters(std::string section)
 //    M_linearSolver->set_solver_type(libMesh::GMRES);
    // M_linearSolver->set_preconditioner_type(libMesh::AMG_PRECOND);
     M_linearSolver->init();
+    M_useNearNullSpace = M_datafile(section + "/linear_solver/near_null_space", true);
     M_projectionsLinearSolver = libMesh::LinearSolver<libMesh::Number>::build(M_equationSystems.comm());
     M_projectionsLinearSolver->set_solver_type(libMesh::GMRES);
     M_projectionsLinearSolver->set_preconditioner_type(libMesh::SOR_PRECOND);
@@ -464,6 +518,11 @@ void Elasticity::setupParameters(std::string section)
     M_exporter.reset(new EXOExporter(M_equationSystems.get_mesh()));
     M_GMVexporter.reset(new Exporter(M_equationSystems.get_mesh()));
     M_VTKexporter.reset(new VTKExporter(M_equationSystems.get_mesh()));
+    if (M_datafile(section + "/compressed_output", false))
+    {
+        M_compressedWriter.reset(new CompressedFieldWriter(M_equationSystems.get_mesh(), M_outputFolder + M_myName));
+        M_compressedWriter->setup(M_datafile, section);
+    }
     std::cout << " done. " << std::endl;
     std::cout << "* ELASTICITY: Setup materials ... " << std::flush;
     std::cout << "* ELASTICITY: Setup materials ... " << std::flush;
@@ -500,6 +559,35 @@ void Elasticity::setupParameters(std::string section)
 
     M_newtonData.tol = M_datafile(section + "/newton/tolerance", 1e-9);
     M_newtonData.max_iter = M_datafile(section + "/newton/max_iter", 20);
+    M_newtonData.linear_tol = M_datafile(section + "/newton/linear_tolerance", 1e-12);
+    M_newtonData.linear_max_iter = M_datafile(section + "/newton/linear_max_iter", 2000);
+    M_newtonData.inexact = M_datafile(section + "/newton/inexact", false);
+    M_newtonData.forcing_choice = M_datafile(section + "/newton/forcing_choice", 2);
+    M_newtonData.eta0 = M_datafile(section + "/newton/eta0", 0.5);
+    M_newtonData.eta_max = M_datafile(section + "/newton/eta_max", 0.9);
+    M_newtonData.eta_min = M_datafile(section + "/newton/eta_min", M_newtonData.linear_tol);
+    M_newtonData.gamma = M_datafile(section + "/newton/gamma", 0.9);
+    M_newtonData.alpha = M_datafile(section + "/newton/alpha", 0.5 * (1.0 + std::sqrt(5.0)));
+    if (M_newtonData.forcing_choice != 1 && M_newtonData.forcing_choice != 2)
+    {
+        throw std::runtime_error("Elasticity: newton/forcing_choice must be 1 or 2");
+    }
+    M_newtonData.jacobian_lag = M_datafile(section + "/newton/jacobian_lag", 1);
+    M_newtonData.jacobian_max_contraction = M_datafile(section + "/newton/jacobian_max_contraction", 0.5);
+    M_newtonData.lag_across_solves = M_datafile(section + "/newton/lag_across_solves", false);
+    if (M_newtonData.jacobian_lag < 1)
+    {
+        throw std::runtime_error("Elasticity: newton/jacobian_lag must be at least 1");
+    }
+    M_newtonData.line_search = M_datafile(section + "/newton/line_search", false);
+    M_newtonData.ls_max_iter = M_datafile(section + "/newton/line_search_max_iter", 10);
+    M_newtonData.ls_alpha = M_datafile(section + "/newton/line_search_alpha", 1e-4);
+    M_newtonData.max_load_cuts = M_datafile(section + "/newton/max_load_cuts", 0);
+    std::cout << "* ELASTICITY: Line search: " << M_newtonData.line_search << ", max load step cuts: " << M_newtonData.max_load_cuts << std::endl;
+    std::cout << "* ELASTICITY: Jacobian lag: " << M_newtonData.jacobian_lag << ", across solves: " << M_newtonData.lag_across_solves << std::endl;
+    std::cout << "* ELASTICITY: Inexact Newton: " << M_newtonData.inexact;
+    if (M_newtonData.inexact) std::cout << ", Eisenstat-Walker choice " << M_newtonData.forcing_choice;
+    std::cout << std::endl;
 //    if(M_solverType == ElasticSolverType::Primal)
 //    {
 //    	std::cout << "Solver Type = PRIMAL" << std::endl;
@@ -507,7 +595,24 @@ void Elasticity::setupParameters(std::string section)
 //    else     	std::cout << "Solver Type = MIXED" << std::endl;
 
     M_stabilize = M_datafile(section + "/stabilize", false);
+    M_tangentOnce = M_datafile(section + "/tangent_once", false);
+    std::cout << "* ELASTICITY: Evaluating the tangent once per quadrature point: " << M_tangentOnce << std::endl;
     std::cout << "* ELASTICITY: Using stabilization: " << M_stabilize << std::endl;
+    M_matrixFree = M_datafile(section + "/matrix_free", false);
+    if (M_matrixFree && M_solverType != ElasticSolverType::Primal)
+    {
+        std::cout << "* ELASTICITY: WARNING: the matrix-free Jacobian is available only for the primal formulation: assembling it" << std::endl;
+        M_matrixFree = false;
+    }
+    std::cout << "* ELASTICITY: Matrix-free Jacobian: " << M_matrixFree << std::endl;
+    std::cout << "* ELASTICITY: Rigid body modes as near null space: " << M_useNearNullSpace << std::endl;
+    if (M_fieldSplit)
+    {
+        M_schurScaling = M_datafile(section + "/linear_solver/schur_scaling", 1.0);
+        M_schurFactorization = M_datafile(section + "/linear_solver/schur_factorization", "full");
+        std::cout << "* ELASTICITY: Field-split preconditioner: Schur factorization: " << M_schurFactorization << ", pressure mass scaling: " << M_schurScaling << std::endl;
+    }
+    init_thread_materials();
 }
 
 void
@@ -519,10 +624,34 @@ Elasticity::reset_material(std::string material, std::string path)
 
     int dimension = M_equationSystems.get_mesh().mesh_dimension();
     M_materialMap[materialID]->setup(M_datafile, path, dimension);
+    init_thread_materials();
+    materials_changed();
+}
+
+void
+Elasticity::materials_changed()
+{
+    // The lagged Jacobian belongs to the old material
+    M_JacIsAssembled = false;
+    M_referenceTangentIsAssembled = false;
 }
 
 
 
+void Elasticity::init_thread_materials()
+{
+    const unsigned int n_chunks = std::max(static_cast<unsigned int>(libMesh::n_threads()), 1u);
+    M_threadMaterials.clear();
+    M_threadMaterials.resize(n_chunks - 1);
+    for (auto && materials : M_threadMaterials)
+    {
+        for (auto && m : M_materialMap)
+        {
+            materials[m.first].reset(m.second->clone());
+        }
+    }
+}
+
 void Elasticity::setTime(double time)
 {
     LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
@@ -533,22 +662,77 @@ void Elasticity::assemble_residual(double /* dt */, libMesh::NumericVector<libMe
 {
     std::cout << "* ELASTICITY: assembling ... " << std::endl;
 
+    const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
+    // Get a reference to the LinearImplicitSystem we are solving
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+
+    if (M_assembleResidual)
+    {
+        system.get_vector("residual").zero();
+        system.rhs->zero();
+    }
+    // With the matrix-free Jacobian system.matrix holds the preconditioner
+    const bool assemble_matrix = M_assembleJacobian && !M_matrixFree;
+    if (assemble_matrix) system.matrix->zero();
+    system.update();
+
+    std::vector<const libMesh::Elem *> elements;
+    libMesh::MeshBase::const_element_iterator el = mesh.active_local_elements_begin();
+    const libMesh::MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+    for (; el != end_el; ++el) elements.push_back(*el);
+
+    if (M_matrixFree && M_assembleJacobian)
+    {
+        if (!M_shellMatrix)
+        {
+            auto boundary_jacobian = [this](const libMesh::Elem* elem, const std::vector<double>& solution, libMesh::DenseMatrix<libMesh::Number>& Ke)
+            {
+                assemble_boundary_jacobian(elem, solution, Ke);
+            };
+            M_shellMatrix.reset(new ElasticityShellMatrix(system, boundary_jacobian));
+        }
+        M_shellMatrix->resize(elements.size(), M_materialMap);
+    }
+
+    // The local elements are split in contiguous chunks, one for each thread:
+    // each chunk is assembled with its own copies of the materials, cloned by init_thread_materials
+    const unsigned int n_chunks = M_threadMaterials.size() + 1;
+    const unsigned int n_elements = elements.size();
+    libMesh::Threads::spin_mutex insert_mutex;
+    auto assemble_chunk = [&](const libMesh::Threads::BlockedRange<unsigned int>& range)
+    {
+        for (unsigned int c = range.begin(); c != range.end(); ++c)
+        {
+            const unsigned int begin = (n_elements * c) / n_chunks;
+            const unsigned int end = (n_elements * (c + 1)) / n_chunks;
+            assemble_residual_elements(elements, begin, end, c == 0 ? M_materialMap : M_threadMaterials[c - 1], activation_ptr, insert_mutex);
+        }
+    };
+    libMesh::Threads::parallel_for(libMesh::Threads::BlockedRange<unsigned int>(0, n_chunks, 1), assemble_chunk);
+
+    if (assemble_matrix) system.matrix->close();
+    if (M_assembleResidual) system.rhs->close();
+
+}
+
+void Elasticity::assemble_residual_elements(const std::vector<const libMesh::Elem *>& elements,
+                                            unsigned int begin,
+                                            unsigned int end,
+                                            std::map<unsigned int, MaterialPtr>& materials,
+                                            libMesh::NumericVector<libMesh::Number>* activation_ptr,
+                                            libMesh::Threads::spin_mutex& insert_mutex)
+{
     using std::unique_ptr;
 
     const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
     const unsigned int dim = mesh.mesh_dimension();
     const unsigned int max_dim = 3;
-    // Get a reference to the LinearImplicitSystem we are solving
-    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    const LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
     double time = system.time;
-    ParameterSystem& fiber_system = M_equationSystems.get_system<ParameterSystem>("fibers");
-    ParameterSystem& sheets_system = M_equationSystems.get_system<ParameterSystem>("sheets");
-    ParameterSystem& xfiber_system = M_equationSystems.get_system<ParameterSystem>("xfibers");
+    const ParameterSystem& fiber_system = M_equationSystems.get_system<ParameterSystem>("fibers");
+    const ParameterSystem& sheets_system = M_equationSystems.get_system<ParameterSystem>("sheets");
+    const ParameterSystem& xfiber_system = M_equationSystems.get_system<ParameterSystem>("xfibers");
 
-    system.get_vector("residual").zero();
-    system.rhs->zero();
-    system.matrix->zero();
-    system.update();
     unsigned int ux_var = system.variable_number("displacementx");
     unsigned int uy_var, uz_var;
 
@@ -621,21 +805,22 @@ void Elasticity::assemble_residual(double /* dt */, libMesh::NumericVector<libMe
     libMesh::QGauss qface(dim - 1, libMesh::FIRST);
     fe_face->attach_quadrature_rule(&qface);
 
-    libMesh::MeshBase::const_element_iterator el = mesh.active_local_elements_begin();
-    const libMesh::MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
-
     double rho;
     libMesh::RealGradient f0;
     libMesh::RealGradient s0;
     libMesh::RealGradient n0;
+    Material::KinematicState state;
+    // Tangent along the basis of the displacement gradients
+    libMesh::TensorValue<libMesh::Number> tangent[3][3];
 
 //	    std::cout << "* ELASTICITY:loop starts ... " << std::endl;
 
-    for (; el != end_el; ++el)
+    for (unsigned int e = begin; e < end; ++e)
     {
-        const libMesh::Elem * elem = *el;
+        const libMesh::Elem * elem = elements[e];
         auto blockID = elem->subdomain_id();
-        rho = M_materialMap[blockID]->M_density;
+        Material& material = *materials[blockID];
+        rho = material.M_density;
         auto elID = elem->id();
 
         dof_map.dof_indices(elem, dof_indices);
@@ -658,6 +843,8 @@ void Elasticity::assemble_residual(double /* dt */, libMesh::NumericVector<libMe
 //  	  for(auto && di : dof_indices)  std::cout << "dof id: " << di << std::endl;
 
         system.current_local_solution->get(dof_indices, solution_k);
+        if (M_referenceConfiguration) std::fill(solution_k.begin(), solution_k.end(), 0.0);
+        if (M_matrixFree && M_assembleJacobian) M_shellMatrix->init_element(e, elem, dof_indices, qrule_1.n_points());
 
         dof_map_fibers.dof_indices(elem, dof_indices_fibers);
         // fiber direction
@@ -741,37 +928,49 @@ void Elasticity::assemble_residual(double /* dt */, libMesh::NumericVector<libMe
                 }
             }
 
-            M_materialMap[blockID]->M_f0 = f0;
-            M_materialMap[blockID]->M_s0 = s0;
-
-            M_materialMap[blockID]->M_gradU = dUk;
-            M_materialMap[blockID]->M_FA = FA;
-            M_materialMap[blockID]->updateVariables();
-            M_materialMap[blockID]->evaluateStress(ElasticSolverType::Primal);
-            Sk = M_materialMap[blockID]->M_PK1;
+            state.f0 = f0;
+            state.s0 = s0;
+            state.gradU = dUk;
+            state.FA = FA;
+            material.stress(state, ElasticSolverType::Primal, Sk);
             // Residual
-            const double x = q_point[qp](0);
-            const double y = q_point[qp](1);
-            const double z = q_point[qp](2);
-            const double time = 0.0;
-            for (int idim = 0; idim < dim; idim++)
-                body_force[idim] = M_rhsFunction(time, x, y, z, idim);
-
-            for (unsigned int n = 0; n < phi_u.size(); ++n)
+            if (M_assembleResidual)
             {
-                for (int jdim = 0; jdim < dim; jdim++)
+                const double x = q_point[qp](0);
+                const double y = q_point[qp](1);
+                const double z = q_point[qp](2);
+                const double time = 0.0;
+                for (int idim = 0; idim < dim; idim++)
+                    body_force[idim] = M_rhsFunction(time, x, y, z, idim);
+
+                for (unsigned int n = 0; n < phi_u.size(); ++n)
                 {
-                    dW *= 0.0;
-                    dW(jdim, 0) = JxW_u[qp] * dphi_u[n][qp](0);
-                    dW(jdim, 1) = JxW_u[qp] * dphi_u[n][qp](1);
-                    dW(jdim, 2) = JxW_u[qp] * dphi_u[n][qp](2);
-                    // Compute  - \nabla \cdot \sigma + f
-                    Fe(n + jdim * n_ux_dofs) -= Sk.contract(dW);
-                    Fe(n + jdim * n_ux_dofs) += JxW_u[qp] * rho * body_force[jdim] * phi_u[n][qp];
+                    for (int jdim = 0; jdim < dim; jdim++)
+                    {
+                        dW *= 0.0;
+                        dW(jdim, 0) = JxW_u[qp] * dphi_u[n][qp](0);
+                        dW(jdim, 1) = JxW_u[qp] * dphi_u[n][qp](1);
+                        dW(jdim, 2) = JxW_u[qp] * dphi_u[n][qp](2);
+                        // Compute  - \nabla \cdot \sigma + f
+                        Fe(n + jdim * n_ux_dofs) -= Sk.contract(dW);
+                        Fe(n + jdim * n_ux_dofs) += JxW_u[qp] * rho * body_force[jdim] * phi_u[n][qp];
+                    }
                 }
             }
 
             // Matrix
+            if (!M_assembleJacobian) continue;
+            if (M_matrixFree)
+            {
+                M_shellMatrix->set_quadrature_point(e, qp, state);
+                continue;
+            }
+            if (M_tangentOnce)
+            {
+                material.tangent_basis(dim, tangent);
+                add_tangent_block(tangent, dphi_u, qp, JxW_u[qp], dim, n_ux_dofs, Ke);
+                continue;
+            }
             // For each test function
             for (unsigned int n = 0; n < phi_u.size(); ++n)
             {
@@ -797,8 +996,7 @@ void Elasticity::assemble_residual(double /* dt */, libMesh::NumericVector<libMe
                             dU(idim, 1) = dphi_u[m][qp](1);
                             dU(idim, 2) = dphi_u[m][qp](2);
 
-                            M_materialMap[blockID]->evaluateJacobian(dU, 0.0);
-                            S = M_materialMap[blockID]->M_total_jacobian;
+                            material.tangent(dU, S);
                             auto int_1 = n + jdim * n_ux_dofs;
                             auto int_2 = m + idim * n_ux_dofs;
 //	                            std::cout << int_1 << ", " << int_2 << ", SdW: " << S.contract(dW) << std::endl;
@@ -811,15 +1009,233 @@ void Elasticity::assemble_residual(double /* dt */, libMesh::NumericVector<libMe
         }
 
         apply_BC(elem, Ke, Fe, fe_face, qface, mesh, n_ux_dofs, nullptr, 0.0, time, &solution_k);
+        // Ke holds only the boundary terms: the shell matrix evaluates them again when needed
+        if (M_matrixFree && M_assembleJacobian && has_nonzero_entries(Ke)) M_shellMatrix->set_boundary_element(e, solution_k);
         dof_map.constrain_element_matrix_and_vector(Ke, Fe, dof_indices);
 //      dof_map.heterogenously_constrain_element_matrix_and_vector (Ke, Fe, dof_indices);
 
+        // The insertion in the PETSc matrix and vector is not thread safe
+        libMesh::Threads::spin_mutex::scoped_lock lock(insert_mutex);
+        if (M_assembleJacobian && !M_matrixFree) system.matrix->add_matrix(Ke, dof_indices);
+        if (M_assembleResidual) system.rhs->add_vector(Fe, dof_indices);
+    }
+
+}
+
+void Elasticity::assemble_residual_only(double dt, libMesh::NumericVector<libMesh::Number>* activation_ptr)
+{
+    M_assembleJacobian = false;
+    assemble_residual(dt, activation_ptr);
+    M_assembleJacobian = true;
+}
+
+void Elasticity::assemble_reference_tangent()
+{
+    if (M_matrixFree && assemble_low_order_tangent())
+    {
+        M_referenceTangentIsAssembled = true;
+        return;
+    }
+    const bool matrix_free = M_matrixFree;
+    M_matrixFree = false;
+    M_referenceConfiguration = true;
+    M_assembleResidual = false;
+    Elasticity::assemble_residual(0.0, nullptr);
+    M_assembleResidual = true;
+    M_referenceConfiguration = false;
+    M_matrixFree = matrix_free;
+    M_referenceTangentIsAssembled = true;
+}
+
+void Elasticity::assemble_jacobian_only(double dt, libMesh::NumericVector<libMesh::Number>* activation_ptr)
+{
+    M_assembleResidual = false;
+    assemble_residual(dt, activation_ptr);
+    M_assembleResidual = true;
+}
+
+bool Elasticity::assemble_low_order_tangent()
+{
+    const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
+    const unsigned int dim = mesh.mesh_dimension();
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    const libMesh::DofMap & dof_map = system.get_dof_map();
+    auto petsc_matrix = dynamic_cast<libMesh::PetscMatrix<libMesh::Number>*>(system.matrix);
+
+    // Only quadratic Lagrange displacements on TRI6 and TET10
+    bool supported = petsc_matrix && dof_map.variable_type(0) == libMesh::FEType(libMesh::SECOND, libMesh::LAGRANGE);
+    libMesh::MeshBase::const_element_iterator el = mesh.active_local_elements_begin();
+    const libMesh::MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+    for (; el != end_el && supported; ++el)
+    {
+        supported = low_order_subelements((*el)->type()) != nullptr;
+    }
+    mesh.comm().min(supported);
+    if (!supported) return false;
+
+    std::vector<std::vector<libMesh::dof_id_type> > dof_indices_var(dim);
+    std::vector<libMesh::dof_id_type> dof_indices;
+
+    // Sparsity of the subdivision: the rows of the local dofs get the couplings
+    // of all the elements sharing them, including the ghosted ones
+    const libMesh::dof_id_type first_dof = dof_map.first_dof();
+    const libMesh::dof_id_type end_dof = dof_map.end_dof();
+    std::vector<std::vector<libMesh::dof_id_type> > couplings(end_dof - first_dof);
+    const unsigned int rank = mesh.comm().rank();
+    el = mesh.active_elements_begin();
+    const libMesh::MeshBase::const_element_iterator end_all = mesh.active_elements_end();
+    for (; el != end_all; ++el)
+    {
+        const libMesh::Elem * elem = *el;
+        bool local = false;
+        for (unsigned int n = 0; n < elem->n_nodes() && !local; ++n) local = elem->node_ref(n).processor_id() == rank;
+        if (!local) continue;
+        const auto * subelements = low_order_subelements(elem->type());
+        if (!subelements) continue;
+        for (unsigned int i = 0; i < dim; ++i) dof_map.dof_indices(elem, dof_indices_var[i], i);
+        for (auto && sub : *subelements)
+            for (auto a : sub)
+                for (unsigned int i = 0; i < dim; ++i)
+                {
+                    const libMesh::dof_id_type row = dof_indices_var[i][a];
+                    if (row < first_dof || row >= end_dof) continue;
+                    for (auto b : sub)
+                        for (unsigned int j = 0; j < dim; ++j) couplings[row - first_dof].push_back(dof_indices_var[j][b]);
+                }
+    }
+    std::vector<libMesh::numeric_index_type> n_nz(couplings.size(), 0);
+    std::vector<libMesh::numeric_index_type> n_oz(couplings.size(), 0);
+    for (unsigned int r = 0; r < couplings.size(); ++r)
+    {
+        auto& row = couplings[r];
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+        for (auto && col : row)
+        {
+            if (col >= first_dof && col < end_dof) ++n_nz[r];
+            else ++n_oz[r];
+        }
+        std::vector<libMesh::dof_id_type>().swap(row);
+    }
+    // system.matrix takes the sparsity of the subdivision
+    petsc_matrix->clear();
+    petsc_matrix->init(system.n_dofs(), system.n_dofs(), system.n_local_dofs(), system.n_local_dofs(), n_nz, n_oz);
+    // The element matrices are inserted with their zeros: skip them.
+    // The hanging node constraints can add couplings outside of the subdivision
+    MatSetOption(petsc_matrix->mat(), MAT_IGNORE_ZERO_ENTRIES, PETSC_TRUE);
+    MatSetOption(petsc_matrix->mat(), MAT_NEW_NONZERO_ALLOCATION_ERR, PETSC_FALSE);
+    system.matrix->zero();
+
+    const ParameterSystem& fiber_system = M_equationSystems.get_system<ParameterSystem>("fibers");
+    const ParameterSystem& sheets_system = M_equationSystems.get_system<ParameterSystem>("sheets");
+    const libMesh::DofMap & dof_map_fibers = fiber_system.get_dof_map();
+    std::vector<libMesh::dof_id_type> dof_indices_fibers;
+
+    std::unique_ptr<libMesh::FEBase> fe(libMesh::FEBase::build(dim, libMesh::FEType(libMesh::FIRST, libMesh::LAGRANGE)));
+    libMesh::QGauss qrule(dim, libMesh::FIRST);
+    fe->attach_quadrature_rule(&qrule);
+    const std::vector<libMesh::Real> & JxW = fe->get_JxW();
+    const std::vector<std::vector<libMesh::RealGradient> > & dphi = fe->get_dphi();
+    std::unique_ptr<libMesh::Elem> subelem = libMesh::Elem::build(dim == 3 ? libMesh::TET4 : libMesh::TRI3);
+
+    libMesh::DenseMatrix<libMesh::Number> Ke;
+    libMesh::DenseMatrix<libMesh::Number> Ks;
+    libMesh::DenseMatrix<libMesh::Number> Kb;
+    Material::KinematicState state;
+    libMesh::TensorValue<libMesh::Number> P;
+    libMesh::TensorValue<libMesh::Number> tangent[3][3];
+    std::vector<double> zero_solution;
+    std::vector<std::vector<char> > coupled;
+
+    for (el = mesh.active_local_elements_begin(); el != end_el; ++el)
+    {
+        const libMesh::Elem * elem = *el;
+        Material& material = *M_materialMap[elem->subdomain_id()];
+        dof_map.dof_indices(elem, dof_indices);
+        const unsigned int n_dofs = dof_indices.size();
+        const unsigned int n_u = n_dofs / dim;
+        Ke.resize(n_dofs, n_dofs);
+
+        // Tangent of the reference configuration, constant in the element
+        dof_map_fibers.dof_indices(elem, dof_indices_fibers);
+        state.gradU.zero();
+        state.FA.zero();
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            state.f0(i) = (*fiber_system.solution)(dof_indices_fibers[i]);
+            state.s0(i) = (*sheets_system.solution)(dof_indices_fibers[i]);
+        }
+        material.stress(state, ElasticSolverType::Primal, P);
+        material.tangent_basis(dim, tangent);
+
+        coupled.assign(n_u, std::vector<char>(n_u, 0));
+        std::vector<unsigned int> nodes;
+        for (auto && sub : *low_order_subelements(elem->type()))
+        {
+            nodes = sub;
+            // Positive orientation of the subelement
+            const libMesh::Point& p0 = elem->point(nodes[0]);
+            const libMesh::Point e1 = elem->point(nodes[1]) - p0;
+            const libMesh::Point e2 = elem->point(nodes[2]) - p0;
+            const double measure = (dim == 3) ? e1.cross(e2) * (elem->point(nodes[3]) - p0) : e1(0) * e2(1) - e1(1) * e2(0);
+            if (measure < 0.0) std::swap(nodes[1], nodes[2]);
+            for (unsigned int a = 0; a < nodes.size(); ++a)
+            {
+                subelem->set_node(a) = const_cast<libMesh::Node *>(elem->node_ptr(nodes[a]));
+                for (auto b : nodes) coupled[nodes[a]][b] = 1;
+            }
+            fe->reinit(subelem.get());
+            const unsigned int n_s = nodes.size();
+            Ks.resize(n_s * dim, n_s * dim);
+            for (unsigned int qp = 0; qp < qrule.n_points(); ++qp)
+            {
+                add_tangent_block(tangent, dphi, qp, JxW[qp], dim, n_s, Ks);
+            }
+            for (unsigned int j = 0; j < dim; ++j)
+                for (unsigned int a = 0; a < n_s; ++a)
+                    for (unsigned int i = 0; i < dim; ++i)
+                        for (unsigned int b = 0; b < n_s; ++b)
+                            Ke(nodes[a] + j * n_u, nodes[b] + i * n_u) += Ks(a + j * n_s, b + i * n_s);
+        }
+
+        // Boundary terms of the reference configuration: the couplings outside of the subdivision are lumped on the diagonal
+        zero_solution.assign(n_dofs, 0.0);
+        Kb.resize(n_dofs, n_dofs);
+        assemble_boundary_jacobian(elem, zero_solution, Kb);
+        for (unsigned int r = 0; r < n_dofs; ++r)
+            for (unsigned int c = 0; c < n_dofs; ++c)
+            {
+                if (coupled[r % n_u][c % n_u]) Ke(r, c) += Kb(r, c);
+                else Ke(r, r) += Kb(r, c);
+            }
+
+        dof_map.constrain_element_matrix(Ke, dof_indices);
         system.matrix->add_matrix(Ke, dof_indices);
-        system.rhs->add_vector(Fe, dof_indices);
     }
     system.matrix->close();
-    system.rhs->close();
+    std::cout << "* ELASTICITY: preconditioner: tangent of the reference configuration on the linear subdivision of the elements" << std::endl;
+    return true;
+}
 
+void Elasticity::assemble_boundary_jacobian(const libMesh::Elem* elem, const std::vector<double>& solution, libMesh::DenseMatrix<libMesh::Number>& Ke)
+{
+    const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
+    const unsigned int dim = mesh.mesh_dimension();
+    const LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    libMesh::FEType fe_disp = system.get_dof_map().variable_type(0);
+    std::unique_ptr<libMesh::FEBase> fe_face(libMesh::FEBase::build(dim, fe_disp));
+    libMesh::QGauss qface(dim - 1, libMesh::FIRST);
+    fe_face->attach_quadrature_rule(&qface);
+
+    const unsigned int n_dofs = solution.size();
+    Ke.resize(n_dofs, n_dofs);
+    libMesh::DenseVector<libMesh::Number> Fe(n_dofs);
+    std::vector<double> solution_k(solution);
+    // Only the Jacobian terms of apply_BC are kept
+    const bool assemble_jacobian = M_assembleJacobian;
+    M_assembleJacobian = true;
+    apply_BC(elem, Ke, Fe, fe_face, qface, mesh, n_dofs / dim, nullptr, 0.0, system.time, &solution_k);
+    M_assembleJacobian = assemble_jacobian;
 }
 
 void Elasticity::apply_BC(const libMesh::Elem*& elem, libMesh::DenseMatrix<libMesh::Number>& Ke, libMesh::DenseVector<libMesh::Number>& Fe,
@@ -869,7 +1285,7 @@ void Elasticity::apply_BC(const libMesh::Elem*& elem, libMesh::DenseMatrix<libMe
                         {
                             for (int idim = 0; idim < dim; ++idim)
                             {
-                                const double traction = bc->get_function()(time, xq, yq, zq, idim);
+                                const double traction = M_loadScaling * bc->get_function()(time, xq, yq, zq, idim);
                                 for (unsigned int i = 0; i < n_ux_dofs; i++)
                                 {
                                     Fe(i + idim * n_ux_dofs) += JxW_face[qp] * traction * phi_face[i][qp];
@@ -883,7 +1299,7 @@ void Elasticity::apply_BC(const libMesh::Elem*& elem, libMesh::DenseMatrix<libMe
                                 idim = 1;
                             if (BCComponent::Z == bc->get_component())
                                 idim = 2;
-                            const double traction = bc->get_function()(time, xq, yq, zq, 0);
+                            const double traction = M_loadScaling * bc->get_function()(time, xq, yq, zq, 0);
                             for (unsigned int i = 0; i < n_ux_dofs; i++)
                             {
                                 Fe(i + idim * n_ux_dofs) += JxW_face[qp] * traction * phi_face[i][qp];
@@ -891,7 +1307,7 @@ void Elasticity::apply_BC(const libMesh::Elem*& elem, libMesh::DenseMatrix<libMe
                         }
                         else if (BCMode::Normal == mode)
                         {
-                            const double traction = bc->get_function()(time, xq, yq, zq, 0);
+                            const double traction = M_loadScaling * bc->get_function()(time, xq, yq, zq, 0);
                             for (int idim = 0; idim < dim; ++idim)
                             {
                                 for (unsigned int i = 0; i < n_ux_dofs; i++)
@@ -946,7 +1362,7 @@ void Elasticity::apply_BC(const libMesh::Elem*& elem, libMesh::DenseMatrix<libMe
                            double Jk = Fk.det();
                            auto Ftk = Fk.transpose();
                            auto Finvtk = Ftk.inverse();
-                           const double pressure = bc->get_function()(time, xq, yq, zq, 0);
+                           const double pressure = M_loadScaling * bc->get_function()(time, xq, yq, zq, 0);
                            for (int idim = 0; idim < dim; ++idim)
                            {
                                for (unsigned int i = 0; i < n_ux_dofs; i++)
@@ -955,20 +1371,23 @@ void Elasticity::apply_BC(const libMesh::Elem*& elem, libMesh::DenseMatrix<libMe
                                    test(idim) = JxW_face[qp] * phi_face[i][qp];
                                    Fe(i + idim * n_ux_dofs) += pressure * Jk  * Finvtk * normals[qp] * test;
 
-                                   for (int jdim = 0; jdim < dim; ++jdim)
+                                   if (M_assembleJacobian)
                                    {
-                                       for (unsigned int j = 0; j < phi_face.size(); j++)
+                                       for (int jdim = 0; jdim < dim; ++jdim)
                                        {
-//                                           trial *= 0.0;
-//                                           trial(jdim) = phi_face[j][qp];
+                                           for (unsigned int j = 0; j < phi_face.size(); j++)
+                                           {
+//                                               trial *= 0.0;
+//                                               trial(jdim) = phi_face[j][qp];
 
-                                           dF *= 0.0;
-                                           dF(jdim, 0) = dphi_face[j][qp](0);
-                                           dF(jdim, 1) = dphi_face[j][qp](1);
-                                           dF(jdim, 2) = dphi_face[j][qp](2);
+                                               dF *= 0.0;
+                                               dF(jdim, 0) = dphi_face[j][qp](0);
+                                               dF(jdim, 1) = dphi_face[j][qp](1);
+                                               dF(jdim, 2) = dphi_face[j][qp](2);
 
-                                           Ke(i + idim * n_ux_dofs, j + jdim * n_ux_dofs) -= pressure * Jk * ( Finvtk.contract(dF) * id - Finvtk* dF.transpose() ) * Finvtk * normals[qp] * test;
+                                               Ke(i + idim * n_ux_dofs, j + jdim * n_ux_dofs) -= pressure * Jk * ( Finvtk.contract(dF) * id - Finvtk* dF.transpose() ) * Finvtk * normals[qp] * test;
 
+                                           }
                                        }
                                    }
                                }
@@ -1456,27 +1875,8 @@ void Elasticity::solve_system()
 //    std::cout << "\nRHS!" << std::endl;
 //    system.rhs->print(std::cout);
 
-    // set near null space
-    {
-//        auto petscMatrixPtr = dynamic_cast<libMesh::PetscMatrix<libMesh::Number> *>(system.matrix);
-//        auto petscVecPtr = dynamic_cast<libMesh::PetscVector<libMesh::Number> *>(system.request_vector("X"));
-//        MatNullSpace matnull;
-//        Vec          vec_coords;
-//        PetscScalar  *c;
-
-//        VecCreate(MPI_COMM_WORLD,&vec_coords);
-//        VecSetBlockSize(vec_coords,3);
-//        VecSetSizes(vec_coords,m,PETSC_DECIDE);
-//        VecSetUp(vec_coords);
-//        VecGetArray(vec_coords,&c);
-//        for (i=0; i<m; i++) c[i] = coords[i]; /* Copy since Scalar type might be Complex */
-//        VecRestoreArray(vec_coords,&c);
-//        MatNullSpaceCreateRigidBody(petscVecPtr->vec(),&matnull);
-//        MatSetNearNullSpace(petscMatrixPtr->mat(),matnull);
-//        MatNullSpaceDestroy(&matnull);
-
-    }
-
+    set_near_null_space(*system.matrix);
+    if (M_fieldSplit) setup_field_split(*system.matrix);
     std::pair<unsigned int, double> rval = std::make_pair(0, 0.0);
     rval = M_linearSolver->solve(*system.matrix, system.get_vector("step"), *system.rhs, tol, max_iter);
 
@@ -1487,6 +1887,267 @@ void Elasticity::solve_system()
 
 }
 
+void Elasticity::build_rigid_body_modes()
+{
+    const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
+    const unsigned int dim = mesh.mesh_dimension();
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    const unsigned int sys_num = system.number();
+
+    // dim translations and dim (dim - 1) / 2 rotations
+    const unsigned int n_modes = dim + dim * (dim - 1) / 2;
+    M_rigidBodyModes.clear();
+    for (unsigned int m = 0; m < n_modes; ++m)
+    {
+        M_rigidBodyModes.push_back(system.solution->zero_clone());
+    }
+
+    // The first dim variables are the vector unknown (displacement or velocity of the dynamic solvers):
+    // the pressure components of the modes are zero
+    libMesh::MeshBase::const_node_iterator node = mesh.local_nodes_begin();
+    const libMesh::MeshBase::const_node_iterator end_node = mesh.local_nodes_end();
+    for (; node != end_node; ++node)
+    {
+        const libMesh::Node & nn = **node;
+        for (unsigned int d = 0; d < dim; ++d)
+        {
+            if (nn.n_comp(sys_num, d) == 0) continue;
+            const libMesh::dof_id_type dof = nn.dof_number(sys_num, d, 0);
+            // translation
+            M_rigidBodyModes[d]->set(dof, 1.0);
+            // rotations: (-y, x, 0), (0, -z, y), (z, 0, -x)
+            if (dim == 2)
+            {
+                M_rigidBodyModes[2]->set(dof, d == 0 ? -nn(1) : nn(0));
+            }
+            else if (dim == 3)
+            {
+                if (d == 0)
+                {
+                    M_rigidBodyModes[3]->set(dof, -nn(1));
+                    M_rigidBodyModes[5]->set(dof, nn(2));
+                }
+                else if (d == 1)
+                {
+                    M_rigidBodyModes[3]->set(dof, nn(0));
+                    M_rigidBodyModes[4]->set(dof, -nn(2));
+                }
+                else
+                {
+                    M_rigidBodyModes[4]->set(dof, nn(1));
+                    M_rigidBodyModes[5]->set(dof, -nn(0));
+                }
+            }
+        }
+    }
+
+    // PETSc expects an orthonormal basis: modified Gram-Schmidt
+    for (unsigned int m = 0; m < n_modes; ++m)
+    {
+        auto& mode = *M_rigidBodyModes[m];
+        mode.close();
+        for (unsigned int k = 0; k < m; ++k)
+        {
+            mode.add(-mode.dot(*M_rigidBodyModes[k]), *M_rigidBodyModes[k]);
+        }
+        mode.scale(1.0 / mode.l2_norm());
+    }
+}
+
+void Elasticity::set_near_null_space(libMesh::SparseMatrix<libMesh::Number>& matrix)
+{
+    if (!M_useNearNullSpace) return;
+    auto petsc_matrix = dynamic_cast<libMesh::PetscMatrix<libMesh::Number>*>(&matrix);
+    if (!petsc_matrix) return;
+
+    // A matrix created by a reinit of the systems has no near null space:
+    // the dofs may have changed, so the modes are rebuilt
+    MatNullSpace near_null_space = nullptr;
+    MatGetNearNullSpace(petsc_matrix->mat(), &near_null_space);
+    if (near_null_space) return;
+
+    build_rigid_body_modes();
+    std::vector<Vec> modes;
+    for (auto && mode : M_rigidBodyModes)
+    {
+        modes.push_back(dynamic_cast<libMesh::PetscVector<libMesh::Number>&>(*mode).vec());
+    }
+    MatNullSpaceCreate(M_equationSystems.comm().get(), PETSC_FALSE, modes.size(), modes.data(), &near_null_space);
+    MatSetNearNullSpace(petsc_matrix->mat(), near_null_space);
+    MatNullSpaceDestroy(&near_null_space);
+    std::cout << "* ELASTICITY: attached " << modes.size() << " rigid body modes as near null space" << std::endl;
+}
+
+void Elasticity::assemble_pressure_mass()
+{
+    const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
+    const unsigned int dim = mesh.mesh_dimension();
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    libMesh::SparseMatrix<libMesh::Number>& mass = system.get_matrix("pressure_mass");
+    mass.zero();
+
+    const libMesh::DofMap & dof_map = system.get_dof_map();
+    unsigned int p_var = system.variable_number("pressure");
+    libMesh::FEType fe_pr = dof_map.variable_type(p_var);
+    std::unique_ptr<libMesh::FEBase> fe_p(libMesh::FEBase::build(dim, fe_pr));
+    libMesh::QGauss qrule(dim, libMesh::SECOND);
+    fe_p->attach_quadrature_rule(&qrule);
+    const std::vector<libMesh::Real> & JxW = fe_p->get_JxW();
+    const std::vector<std::vector<libMesh::Real> > & phi = fe_p->get_phi();
+
+    libMesh::DenseMatrix<libMesh::Number> Me;
+    std::vector<libMesh::dof_id_type> dof_indices_p;
+
+    libMesh::MeshBase::const_element_iterator el = mesh.active_local_elements_begin();
+    const libMesh::MeshBase::const_element_iterator end_el = mesh.active_local_elements_end();
+    for (; el != end_el; ++el)
+    {
+        const libMesh::Elem * elem = *el;
+        dof_map.dof_indices(elem, dof_indices_p, p_var);
+        fe_p->reinit(elem);
+        const unsigned int n_p = dof_indices_p.size();
+        Me.resize(n_p, n_p);
+        for (unsigned int qp = 0; qp < qrule.n_points(); qp++)
+            for (unsigned int n = 0; n < n_p; ++n)
+                for (unsigned int m = 0; m < n_p; ++m)
+                    Me(n, m) += JxW[qp] * phi[n][qp] * phi[m][qp];
+        mass.add_matrix(Me, dof_indices_p);
+    }
+    mass.close();
+}
+
+void Elasticity::setup_field_split(libMesh::SparseMatrix<libMesh::Number>& matrix)
+{
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    if (!system.has_variable("pressure") || !system.have_matrix("pressure_mass"))
+    {
+        std::cout << "* ELASTICITY: WARNING: the field-split preconditioner needs the pressure in the system: using the monolithic one" << std::endl;
+        M_fieldSplit = false;
+        return;
+    }
+    const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
+    const unsigned int dim = mesh.mesh_dimension();
+    const libMesh::DofMap & dof_map = system.get_dof_map();
+
+    // Local dofs of the displacement components and of the pressure
+    std::vector<libMesh::dof_id_type> var_indices;
+    std::vector<PetscInt> u_indices;
+    std::vector<PetscInt> p_indices;
+    for (unsigned int d = 0; d < dim; ++d)
+    {
+        dof_map.local_variable_indices(var_indices, mesh, d);
+        u_indices.insert(u_indices.end(), var_indices.begin(), var_indices.end());
+    }
+    std::sort(u_indices.begin(), u_indices.end());
+    dof_map.local_variable_indices(var_indices, mesh, system.variable_number("pressure"));
+    p_indices.assign(var_indices.begin(), var_indices.end());
+
+    // The splitting is kept as long as the dofs are the ones of the index sets:
+    // a reinit of the DofMap (AMR, restart) renumbers them on some processor
+    auto same_indices = [](IS is, const std::vector<PetscInt>& indices)
+    {
+        PetscInt n = 0;
+        ISGetLocalSize(is, &n);
+        if (n != static_cast<PetscInt>(indices.size())) return false;
+        const PetscInt * values;
+        ISGetIndices(is, &values);
+        const bool same = std::equal(indices.begin(), indices.end(), values);
+        ISRestoreIndices(is, &values);
+        return same;
+    };
+    int changed = !M_isDisplacement || !same_indices(M_isDisplacement, u_indices) || !same_indices(M_isPressure, p_indices);
+    M_equationSystems.comm().max(changed);
+    if (!changed) return;
+
+    std::cout << "* ELASTICITY: setting up the field-split preconditioner ... " << std::flush;
+    if (M_isDisplacement) ISDestroy(&M_isDisplacement);
+    if (M_isPressure) ISDestroy(&M_isPressure);
+    if (M_schurPreconditioner) MatDestroy(&M_schurPreconditioner);
+
+    MPI_Comm comm = M_equationSystems.comm().get();
+    ISCreateGeneral(comm, u_indices.size(), u_indices.data(), PETSC_COPY_VALUES, &M_isDisplacement);
+    ISCreateGeneral(comm, p_indices.size(), p_indices.data(), PETSC_COPY_VALUES, &M_isPressure);
+
+    // The displacement block gets the rigid body modes restricted to its dofs
+    if (M_useNearNullSpace)
+    {
+        build_rigid_body_modes();
+        std::vector<Vec> modes;
+        for (auto && mode : M_rigidBodyModes)
+        {
+            Vec full = dynamic_cast<libMesh::PetscVector<libMesh::Number>&>(*mode).vec();
+            Vec sub;
+            Vec restricted;
+            VecGetSubVector(full, M_isDisplacement, &sub);
+            VecDuplicate(sub, &restricted);
+            VecCopy(sub, restricted);
+            VecRestoreSubVector(full, M_isDisplacement, &sub);
+            modes.push_back(restricted);
+        }
+        MatNullSpace near_null_space;
+        MatNullSpaceCreate(comm, PETSC_FALSE, modes.size(), modes.data(), &near_null_space);
+        PetscObjectCompose((PetscObject) M_isDisplacement, "nearnullspace", (PetscObject) near_null_space);
+        MatNullSpaceDestroy(&near_null_space);
+        for (auto && v : modes) VecDestroy(&v);
+    }
+
+    // Schur complement S = -B A^-1 B^T - C ~ -M_p / mu
+    assemble_pressure_mass();
+    auto mass = dynamic_cast<libMesh::PetscMatrix<libMesh::Number>*>(&system.get_matrix("pressure_mass"));
+    MatCreateSubMatrix(mass->mat(), M_isPressure, M_isPressure, MAT_INITIAL_MATRIX, &M_schurPreconditioner);
+    MatScale(M_schurPreconditioner, -M_schurScaling);
+
+    PCFieldSplitSchurFactType fact_type = PC_FIELDSPLIT_SCHUR_FACT_FULL;
+    if (M_schurFactorization == "diag") fact_type = PC_FIELDSPLIT_SCHUR_FACT_DIAG;
+    else if (M_schurFactorization == "lower") fact_type = PC_FIELDSPLIT_SCHUR_FACT_LOWER;
+    else if (M_schurFactorization == "upper") fact_type = PC_FIELDSPLIT_SCHUR_FACT_UPPER;
+    else if (M_schurFactorization != "full") throw std::runtime_error("Elasticity: unknown Schur factorization " + M_schurFactorization);
+
+    KSP ksp = M_linearSolver->ksp();
+    PC pc;
+    KSPGetPC(ksp, &pc);
+    // Changing the type discards the splits of a previous setup
+    PCSetType(pc, PCNONE);
+    PCSetType(pc, PCFIELDSPLIT);
+    PCFieldSplitSetIS(pc, "u", M_isDisplacement);
+    PCFieldSplitSetIS(pc, "p", M_isPressure);
+    PCFieldSplitSetType(pc, PC_COMPOSITE_SCHUR);
+    PCFieldSplitSetSchurFactType(pc, fact_type);
+    PCFieldSplitSetSchurPre(pc, PC_FIELDSPLIT_SCHUR_PRE_USER, M_schurPreconditioner);
+    // The options of the solver (-pc_fieldsplit_*) override the ones above
+    KSPSetFromOptions(ksp);
+    PetscBool is_field_split = PETSC_FALSE;
+    PetscObjectTypeCompare((PetscObject) pc, PCFIELDSPLIT, &is_field_split);
+    if (!is_field_split)
+    {
+        std::cout << " replaced by the preconditioner of the options" << std::endl;
+        return;
+    }
+
+    // The sub-solvers exist after the setup of the preconditioner:
+    // AMG on the displacement block and Jacobi on the pressure mass matrix,
+    // unless the options of the solver (-fieldsplit_u_*, -fieldsplit_p_*) say otherwise
+    auto petsc_matrix = dynamic_cast<libMesh::PetscMatrix<libMesh::Number>*>(&matrix);
+    if (!petsc_matrix) throw std::runtime_error("Elasticity: the field-split preconditioner needs a PETSc matrix");
+    KSPSetOperators(ksp, petsc_matrix->mat(), petsc_matrix->mat());
+    PCSetUp(pc);
+    PetscInt n_splits = 0;
+    KSP * sub_ksp;
+    PCFieldSplitGetSubKSP(pc, &n_splits, &sub_ksp);
+    const PCType sub_pc_types[2] = { PCGAMG, PCJACOBI };
+    for (PetscInt i = 0; i < n_splits && i < 2; ++i)
+    {
+        PC sub_pc;
+        KSPSetType(sub_ksp[i], KSPPREONLY);
+        KSPGetPC(sub_ksp[i], &sub_pc);
+        PCSetType(sub_pc, sub_pc_types[i]);
+        KSPSetFromOptions(sub_ksp[i]);
+    }
+    PetscFree(sub_ksp);
+
+    std::cout << " done: " << u_indices.size() << " local displacement dofs, " << p_indices.size() << " local pressure dofs" << std::endl;
+}
+
 void Elasticity::project_pressure()
 {
     std::cout << "* ELASTICITY: projecting pressure ... " << std::endl;
@@ -1630,16 +2291,184 @@ void Elasticity::project_pressure()
     rval = M_projectionsLinearSolver->solve(*system_p.matrix, *system_p.solution, *system_p.rhs, tol, max_iter);
 }
 
+double Elasticity::forcing_term(double eta_old, double res_norm, double res_norm_old, double lin_res_norm) const
+{
+    const NewtonData& nd = M_newtonData;
+    double eta;
+    double eta_safe;
+    if (nd.forcing_choice == 1)
+    {
+        // eta_k = | |F_k| - |F_k-1 + J_k-1 s_k-1| | / |F_k-1|
+        eta = std::abs(res_norm - lin_res_norm) / res_norm_old;
+        eta_safe = std::pow(eta_old, nd.alpha);
+    }
+    else
+    {
+        // eta_k = gamma (|F_k| / |F_k-1|)^alpha
+        eta = nd.gamma * std::pow(res_norm / res_norm_old, nd.alpha);
+        eta_safe = nd.gamma * std::pow(eta_old, nd.alpha);
+    }
+    // Safeguard: do not let the forcing term drop too fast
+    if (eta_safe > 0.1) eta = std::max(eta, eta_safe);
+    return std::max(std::min(eta, nd.eta_max), nd.eta_min);
+}
+
 void Elasticity::newton(double dt, libMesh::NumericVector<libMesh::Number>* activation_ptr)
 {
     Timer timer;
     timer.start();
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    NewtonData& nd = M_newtonData;
+
+    // Keep the initial guess for the load stepping
+    std::unique_ptr<libMesh::NumericVector<libMesh::Number> > initial_solution;
+    const bool load_stepping = nd.max_load_cuts > 0 && (activation_ptr || has_boundary_loads());
+    if (load_stepping) initial_solution = system.solution->clone();
+
+    bool converged = newton_iterations(dt, activation_ptr);
+
+    if (!converged && load_stepping)
+    {
+        std::cout << "* ELASTICITY: Newton failed: applying the " << (activation_ptr ? "activation" : "boundary loads") << " in load steps" << std::endl;
+        *system.solution = *initial_solution;
+        M_JacIsAssembled = false;
+        converged = load_steps(dt, activation_ptr);
+    }
+    if (!converged)
+    {
+        std::cout << "* ELASTICITY: WARNING: Newton did not converge, hopefully you are close enough " << std::endl;
+    }
+    if (activation_ptr)
+    {
+        if (!M_previousActivation || M_previousActivation->size() != activation_ptr->size())
+        {
+            M_previousActivation = activation_ptr->clone();
+        }
+        else
+        {
+            *M_previousActivation = *activation_ptr;
+        }
+    }
+    timer.stop();
+    timer.print(std::cout);
+}
+
+bool Elasticity::load_steps(double dt, libMesh::NumericVector<libMesh::Number>* activation_ptr)
+{
+    LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
+    NewtonData& nd = M_newtonData;
+
+    // The load goes from the activation of the previous solve (or zero) to the current one:
+    // a_s = a_prev + s (a - a_prev)
+    // Without activation the boundary loads go from zero to the current ones: s t
+    std::unique_ptr<libMesh::NumericVector<libMesh::Number> > activation_s;
+    if (activation_ptr) activation_s = activation_ptr->clone();
+    std::unique_ptr<libMesh::NumericVector<libMesh::Number> > last_solution = system.solution->clone();
+    const bool has_previous = activation_ptr && M_previousActivation && M_previousActivation->size() == activation_ptr->size();
+
+    double s = 0.0;
+    double ds = 0.5;
+    int cuts = 1;
+    bool converged = true;
+    while (s < 1.0)
+    {
+        const double s_next = std::min(1.0, s + ds);
+        if (activation_ptr)
+        {
+            *activation_s = *activation_ptr;
+            activation_s->scale(s_next);
+            if (has_previous) activation_s->add(1.0 - s_next, *M_previousActivation);
+            activation_s->close();
+        }
+        else M_loadScaling = s_next;
+
+        std::cout << "* ELASTICITY: load step: " << s_next << ", increment: " << ds << std::endl;
+        if (newton_iterations(dt, activation_s.get()))
+        {
+            s = s_next;
+            *last_solution = *system.solution;
+        }
+        else
+        {
+            *system.solution = *last_solution;
+            M_JacIsAssembled = false;
+            ds *= 0.5;
+            if (++cuts > nd.max_load_cuts)
+            {
+                std::cout << "* ELASTICITY: load stepping failed after " << nd.max_load_cuts << " cuts" << std::endl;
+                update_displacements(dt);
+                converged = false;
+                break;
+            }
+        }
+    }
+    // The Jacobian of the last load step belongs to the scaled loads
+    if (M_loadScaling != 1.0) M_JacIsAssembled = false;
+    M_loadScaling = 1.0;
+    return converged;
+}
+
+bool Elasticity::has_boundary_loads()
+{
+    for (auto && bc : M_bch.get_bc_map())
+    {
+        const BCType type = bc.second->get_type();
+        if (BCType::Neumann == type || BCType::NormalPressure == type) return true;
+    }
+    return false;
+}
+
+namespace
+{
+//! Bytes used by the local part of a PETSc matrix (0 for the other matrices)
+double local_matrix_memory(libMesh::SparseMatrix<libMesh::Number>& matrix)
+{
+    auto petsc_matrix = dynamic_cast<libMesh::PetscMatrix<libMesh::Number>*>(&matrix);
+    if (!petsc_matrix) return 0.0;
+    MatInfo info;
+    MatGetInfo(petsc_matrix->mat(), MAT_LOCAL, &info);
+    return info.memory;
+}
+}
+
+bool Elasticity::newton_iterations(double dt, libMesh::NumericVector<libMesh::Number>* activation_ptr)
+{
     LinearSystem& system = M_equationSystems.get_system<LinearSystem>(M_myName);
     update_displacements(dt);
 
+    // Modified Newton: the Jacobian is assembled only when refresh_jacobian() is true,
+    // otherwise the residual is assembled alone and the preconditioner is reused
+    NewtonData& nd = M_newtonData;
+    auto refresh_jacobian = [&]()
+    {
+        return nd.jacobian_lag <= 1 || !M_JacIsAssembled || nd.jacobian_age >= nd.jacobian_lag;
+    };
+    auto assemble = [&](bool jacobian)
+    {
+        if (jacobian) assemble_residual(dt, activation_ptr);
+        else assemble_residual_only(dt, activation_ptr);
+        if (jacobian)
+        {
+            M_JacIsAssembled = true;
+            nd.jacobian_age = 0;
+            nd.jacobian_updates++;
+        }
+    };
+    nd.jacobian_updates = 0;
+    if (!nd.lag_across_solves) M_JacIsAssembled = false;
+
     M_currentNewtonIter = 0;
-    assemble_residual(dt, activation_ptr);
+    assemble(refresh_jacobian());
+    // Only the static primal assembly fills the shell matrix
+    const bool matrix_free = M_matrixFree && M_shellMatrix;
+    bool setup_preconditioner = false;
+    if (matrix_free && !M_referenceTangentIsAssembled)
+    {
+        assemble_reference_tangent();
+        setup_preconditioner = true;
+    }
     auto res_norm = system.rhs->linfty_norm();
+    double res_norm_old = res_norm;
     // assume we ask for the same absolute and relative tolerances
     // tol = atol + rtol * res_norm
     double tol = M_newtonData.tol * (1 + res_norm);
@@ -1649,8 +2478,31 @@ void Elasticity::newton(double dt, libMesh::NumericVector<libMesh::Number>* acti
     std::cout << "* ELASTICITY: Performing Newton solve:  max iterations: " << max_iter << ", target tolerance: " << tol << std::endl;
     std::cout << "\t\t\t  iter: " << iter << ", residual: " << res_norm << std::endl;
 
-    double linear_tol = 1e-12;
-    double linear_max_iter = 2000;
+    double linear_tol = M_newtonData.linear_tol;
+    double linear_max_iter = M_newtonData.linear_max_iter;
+    M_newtonData.linear_iters.clear();
+    // The forcing terms and the line search use the l2 norm, which is the one used by the Krylov solver
+    double res_l2_norm = 0.0;
+    double res_l2_norm_old = 0.0;
+    double lin_res_norm = 0.0;
+    if (M_newtonData.inexact || M_newtonData.line_search)
+    {
+        res_l2_norm = system.rhs->l2_norm();
+    }
+    // Eisenstat-Walker choice 1 needs the true linear residual |F + J s|:
+    // the norm returned by the Krylov solver may be the preconditioned one
+    std::unique_ptr<libMesh::NumericVector<libMesh::Number> > lin_res;
+    std::unique_ptr<libMesh::NumericVector<libMesh::Number> > rhs_old;
+    if (M_newtonData.inexact)
+    {
+        linear_tol = M_newtonData.eta0;
+        if (1 == M_newtonData.forcing_choice)
+        {
+            lin_res = system.rhs->zero_clone();
+            rhs_old = system.rhs->zero_clone();
+        }
+    }
+    bool failed = false;
 
     while (res_norm > tol && M_currentNewtonIter < max_iter)
     {
@@ -1660,7 +2512,21 @@ void Elasticity::newton(double dt, libMesh::NumericVector<libMesh::Number>* acti
 //        system.matrix->print(std::cout);
 //        system.matrix->print_matlab("Jk_"+std::to_string(M_currentNewtonIter)+".m");
         std::pair<unsigned int, double> rval = std::make_pair(0, 0.0);
-        rval = M_linearSolver->solve(*system.matrix, system.get_vector("step"), *system.rhs, linear_tol, linear_max_iter);
+        set_near_null_space(*system.matrix);
+        if (M_fieldSplit) setup_field_split(*system.matrix);
+        if (matrix_free)
+        {
+            // The reference tangent changes only with the material
+            M_linearSolver->reuse_preconditioner(!setup_preconditioner);
+            setup_preconditioner = false;
+            rval = M_linearSolver->solve(*M_shellMatrix, *system.matrix, system.get_vector("step"), *system.rhs, linear_tol, linear_max_iter);
+        }
+        else
+        {
+            M_linearSolver->reuse_preconditioner(nd.jacobian_age > 0);
+            rval = M_linearSolver->solve(*system.matrix, system.get_vector("step"), *system.rhs, linear_tol, linear_max_iter);
+        }
+        M_newtonData.linear_iters.push_back(rval.first);
 //          std::cout << "RHS!\n" << std::endl;
 //          system.rhs->print(std::cout);
 //          system.rhs->print_matlab("Rk_"+std::to_string(M_currentNewtonIter)+".m");
@@ -1672,24 +2538,127 @@ void Elasticity::newton(double dt, libMesh::NumericVector<libMesh::Number>* acti
 //          std::cout << "Solution!\n" << std::endl;
 //          system.solution->print(std::cout);
 
+        if (rval.first == 0 && nd.jacobian_age > 0)
+        {
+            std::cout << "* ELASTICITY: linear solver diverged with a lagged Jacobian: refreshing it" << std::endl;
+            assemble(true);
+            continue;
+        }
         if (rval.first == 0)
         {
             std::cout << "* ELASTICITY: WARNING: linear solver diverged, try adding -ksp_divtol 1e10 " << std::endl;
-            std::cout << "* ELASTICITY: I'm stopping the newton iterations, hopefully you are close enough " << std::endl;
+            failed = true;
             break;
         }
 
+        if (lin_res)
+        {
+            // J s - rhs, with the Jacobian of the solve
+            if (matrix_free) M_shellMatrix->vector_mult(*lin_res, system.get_vector("step"));
+            else system.matrix->vector_mult(*lin_res, system.get_vector("step"));
+            lin_res->add(-1.0, *system.rhs);
+            // rhs is assembled again at the new iterate
+            *rhs_old = *system.rhs;
+        }
+
         (*system.solution) += system.get_vector("step");
+        nd.jacobian_age++;
 
         update_displacements(dt);
-        assemble_residual(dt, activation_ptr);
+        // With a lagged Jacobian it may be due at the full step: if the line search
+        // backtracks it has to be assembled again at the accepted point
+        const bool jacobian_at_trial = refresh_jacobian();
+        assemble(jacobian_at_trial);
+        res_norm_old = res_norm;
+        res_l2_norm_old = res_l2_norm;
+        if (M_newtonData.inexact || M_newtonData.line_search)
+        {
+            res_l2_norm = system.rhs->l2_norm();
+        }
+
+        // Backtracking line search: accept the step length lambda when
+        // |F(u + lambda s)| <= (1 - c lambda) |F(u)| (Armijo)
+        double lambda = 1.0;
+        if (M_newtonData.line_search)
+        {
+            int ls_iter = 0;
+            while (res_l2_norm > (1.0 - nd.ls_alpha * lambda) * res_l2_norm_old)
+            {
+                if (ls_iter == nd.ls_max_iter)
+                {
+                    std::cout << "* ELASTICITY: line search failed, step length: " << lambda << std::endl;
+                    failed = true;
+                    break;
+                }
+                ls_iter++;
+                // Minimizer of the quadratic through |F(u)|^2, its slope -2|F(u)|^2 and |F(u + lambda s)|^2,
+                // safeguarded in [0.1, 0.5] lambda
+                const double f0 = res_l2_norm_old * res_l2_norm_old;
+                const double f1 = res_l2_norm * res_l2_norm;
+                double lambda_new = f0 * lambda * lambda / (f1 - f0 + 2.0 * f0 * lambda);
+                lambda_new = std::max(0.1 * lambda, std::min(0.5 * lambda, lambda_new));
+                system.solution->add(lambda_new - lambda, system.get_vector("step"));
+                lambda = lambda_new;
+                update_displacements(dt);
+                assemble(false);
+                res_l2_norm = system.rhs->l2_norm();
+            }
+            if (ls_iter > 0)
+            {
+                std::cout << "\t\t\t  line search: step length: " << lambda << ", backtracking steps: " << ls_iter << std::endl;
+                // The Jacobian was due at the new iterate or was assembled at the rejected full step:
+                // the trial steps assembled only the residual
+                if (!failed && (jacobian_at_trial || refresh_jacobian())) assemble(true);
+                else if (jacobian_at_trial) M_JacIsAssembled = false;
+            }
+            if (failed) break;
+        }
+        if (lin_res)
+        {
+            // Linear residual of the step taken: F + lambda J s = (1 - lambda) F + lambda (F + J s)
+            if (lambda < 1.0)
+            {
+                lin_res->scale(lambda);
+                lin_res->add(lambda - 1.0, *rhs_old);
+            }
+            lin_res_norm = lin_res->l2_norm();
+        }
+
         res_norm = system.rhs->linfty_norm();
-        std::cout << "\t\t\t  iter: " << M_currentNewtonIter << ", residual: " << res_norm << std::endl;
+        // The lagged Jacobian does not reduce the residual enough: assemble a new one
+        if (nd.jacobian_age > 0 && res_norm > tol && res_norm > nd.jacobian_max_contraction * res_norm_old)
+        {
+            assemble(true);
+        }
+        std::cout << "\t\t\t  iter: " << M_currentNewtonIter << ", residual: " << res_norm << ", linear iterations: " << rval.first;
+        if (M_newtonData.inexact)
+        {
+            std::cout << ", linear tolerance: " << linear_tol;
+            if (res_l2_norm_old > 0.0)
+            {
+                linear_tol = forcing_term(linear_tol, res_l2_norm, res_l2_norm_old, lin_res_norm);
+            }
+        }
+        std::cout << std::endl;
     }
 
+    unsigned int total_linear_iters = 0;
+    for (auto && it : M_newtonData.linear_iters) total_linear_iters += it;
     std::cout << "* ELASTICITY: Newton solve completed in " << M_currentNewtonIter << " iterations. Final residual: " << res_norm << std::endl;
-    timer.stop();
-    timer.print(std::cout);
+    std::cout << "* ELASTICITY: linear iterations: " << total_linear_iters;
+    if (M_currentNewtonIter > 0) std::cout << ", per Newton step: " << double(total_linear_iters) / M_currentNewtonIter;
+    std::cout << std::endl;
+    if (nd.jacobian_lag > 1) std::cout << "* ELASTICITY: Jacobian assemblies: " << nd.jacobian_updates << std::endl;
+    if (matrix_free)
+    {
+        std::cout << "* ELASTICITY: local memory: matrix-free Jacobian: " << M_shellMatrix->memory() / 1048576.0
+                  << " MB, preconditioner: " << local_matrix_memory(*system.matrix) / 1048576.0 << " MB" << std::endl;
+    }
+    else
+    {
+        std::cout << "* ELASTICITY: local memory: Jacobian: " << local_matrix_memory(*system.matrix) / 1048576.0 << " MB" << std::endl;
+    }
+    return !failed && res_norm <= tol;
 }
 
 void Elasticity::evaluate_nodal_I4f()
@@ -40,12 +40,16 @@
 #include "libmesh/equation_systems.h"
 #include "libmesh/linear_solver.h"
 #include "libmesh/petsc_linear_solver.h"
+#include "libmesh/threads.h"
 #include <memory>
+#include <cmath>
+#include <vector>
 #include "libmesh/getpot.h"
 #include "BoundaryConditions/BCHandler.hpp"
 #include "Util/SpiritFunction.hpp"
 #include "Elasticity/ElasticSolverType.hpp"
 #include "Elasticity/Materials/Material.hpp"
+#include "Elasticity/ElasticityShellMatrix.hpp"
 
 namespace libMesh
 {
@@ -62,6 +66,7 @@ class ErrorVector;
 class MeshRefinement;
 template<class T> class DenseMatrix;
 template<class T> class DenseVector;
+template<typename T> class SparseMatrix;
 class QGauss;
 class MeshBase;
 }
@@ -71,6 +76,7 @@ namespace BeatIt
 class BCHandler;
 class SpiritFunction;
 class Material;
+class CompressedFieldWriter;
 
 
 class Elasticity
@@ -100,6 +106,8 @@ public:
             libMesh::NumericVector<libMesh::Number>* activation_ptr = nullptr);
 
     void reset_material(std::string material, std::string path);
+    //! Drop what depends on the materials: called by reset_material
+    virtual void materials_changed();
     //void assemble_external_dirichlet_bc(libMesh::MeshFunction& fe_function);
 //    virtual void assemble_residual(
 //            double dt,
@@ -112,14 +120,85 @@ public:
     virtual void assemble_jacobian()
     {
     }
-    void newton(
+    //! Assemble the elements [begin, end) of the list with the given materials
+    /*!
+     *  Called concurrently by assemble_residual on disjoint chunks:
+     *  the insertion in the global matrix and vector is serialized by insert_mutex
+     */
+    void assemble_residual_elements(const std::vector<const libMesh::Elem *>& elements,
+                                    unsigned int begin,
+                                    unsigned int end,
+                                    std::map<unsigned int, std::unique_ptr<Material> >& materials,
+                                    libMesh::NumericVector<libMesh::Number>* activation_ptr,
+                                    libMesh::Threads::spin_mutex& insert_mutex);
+    //! Clone the materials once for each thread of the assembly
+    /*!
+     *  Called by setup and reset_material: call it again after changing the parameters of M_materialMap
+     */
+    void init_thread_materials();
+    //! Assemble only system.rhs: the element tangents are not evaluated and system.matrix is not touched
+    void assemble_residual_only(
             double dt = 0.0,
             libMesh::NumericVector<libMesh::Number>* activation_ptr = nullptr);
+    //! Assemble only system.matrix: system.rhs is not touched
+    void assemble_jacobian_only(
+            double dt = 0.0,
+            libMesh::NumericVector<libMesh::Number>* activation_ptr = nullptr);
+    virtual void newton(
+            double dt = 0.0,
+            libMesh::NumericVector<libMesh::Number>* activation_ptr = nullptr);
+    //! Newton iterations with the current load, returns true if they converged
+    bool newton_iterations(
+            double dt,
+            libMesh::NumericVector<libMesh::Number>* activation_ptr);
+    //! Assemble in system.matrix the tangent of the reference configuration (zero displacement, no activation)
+    /*!
+     *  Used as preconditioner of the matrix-free Jacobian: it is assembled once
+     *  and kept until the material changes.
+     *  With quadratic elements the low order tangent of assemble_low_order_tangent is used instead
+     */
+    void assemble_reference_tangent();
+    //! Reference tangent of the linear elements splitting the quadratic ones (TRI6, TET10)
+    /*!
+     *  system.matrix is initialized again with the sparsity of the subdivision,
+     *  much smaller than the one of the quadratic elements.
+     *  \return false if the displacement is not quadratic or the elements are not supported
+     */
+    bool assemble_low_order_tangent();
+    //! Jacobian of the boundary conditions (follower pressures, Robin) of an element at the given element solution
+    void assemble_boundary_jacobian(const libMesh::Elem* elem, const std::vector<double>& solution, libMesh::DenseMatrix<libMesh::Number>& Ke);
+    //! Reach the given activation in load steps starting from the one of the previous solve
+    /*!
+     *  Without activation the boundary tractions and pressures are ramped from zero
+     *  (see M_loadScaling)
+     */
+    bool load_steps(double dt, libMesh::NumericVector<libMesh::Number>* activation_ptr);
+    //! True if the boundary conditions include tractions or pressures
+    bool has_boundary_loads();
     virtual void update_displacements(double /* dt */)
     {
     }
     virtual void solve_system();
     virtual void project_pressure();
+    //! Attach the rigid body modes of the displacement to the matrix as near null space (used by AMG)
+    /*!
+     *  The modes are rebuilt and attached whenever the matrix has none,
+     *  i.e. the first time and after the systems are reinitialized (AMR, restart)
+     */
+    void set_near_null_space(libMesh::SparseMatrix<libMesh::Number>& matrix);
+    //! Translations and rotations of the reference configuration, orthonormalized
+    void build_rigid_body_modes();
+    //! Field-split (Schur complement) preconditioner of the mixed displacement-pressure system
+    /*!
+     *  The displacement block is solved with AMG (with the rigid body modes as near null space),
+     *  the Schur complement is preconditioned with -schur_scaling times the pressure mass matrix.
+     *  The sub-solvers can be changed with the options -fieldsplit_u_* and -fieldsplit_p_*.
+     *  The splitting is set up again when the local dofs differ from the ones of the index sets,
+     *  i.e. after the DofMap is reinitialized (AMR, restart). matrix is the preconditioner matrix
+     */
+    void setup_field_split(libMesh::SparseMatrix<libMesh::Number>& matrix);
+    //! Assemble the pressure mass matrix in system.get_matrix("pressure_mass")
+    void assemble_pressure_mass();
 
     virtual void advance()
     {
@@ -131,14 +210,63 @@ public:
     struct NewtonData
     {
         NewtonData()
-                : tol(1e-9), max_iter(20), iter(0)
+                : tol(1e-9), max_iter(20), iter(0),
+                  linear_tol(1e-12), linear_max_iter(2000),
+                  inexact(false), forcing_choice(2),
+                  eta0(0.5), eta_max(0.9), eta_min(1e-12), gamma(0.9), alpha(0.5 * (1.0 + std::sqrt(5.0))),
+                  linear_iters(),
+                  jacobian_lag(1), jacobian_max_contraction(0.5), lag_across_solves(false),
+                  jacobian_age(0), jacobian_updates(0),
+                  line_search(false), ls_max_iter(10), ls_alpha(1e-4), max_load_cuts(0)
         {
         }
         double tol;
         int max_iter;
         int iter;
+        //! Linear tolerance of the exact Newton method
+        double linear_tol;
+        int linear_max_iter;
+        //! Inexact Newton: relative linear tolerance given by the Eisenstat-Walker forcing terms
+        bool inexact;
+        //! Eisenstat-Walker choice 1 or 2
+        int forcing_choice;
+        //! Forcing term of the first iteration and its bounds
+        double eta0;
+        double eta_max;
+        double eta_min;
+        //! Parameters of choice 2: eta = gamma * (|F_k| / |F_k-1|)^alpha
+        double gamma;
+        double alpha;
+        //! Linear iterations of each Newton step of the last solve
+        std::vector<unsigned int> linear_iters;
+        //! Modified Newton: refresh the Jacobian every jacobian_lag steps (1 = Newton)
+        int jacobian_lag;
+        //! Refresh a lagged Jacobian also when |F_k+1| / |F_k| > jacobian_max_contraction
+        double jacobian_max_contraction;
+        //! Start the solve with the Jacobian of the previous one (previous time step)
+        bool lag_across_solves;
+        //! Newton steps done with the current Jacobian
+        int jacobian_age;
+        //! Jacobian assemblies of the last solve
+        int jacobian_updates;
+        //! Backtracking line search with the Armijo condition on the l2 norm of the residual
+        bool line_search;
+        int ls_max_iter;
+        double ls_alpha;
+        //! When Newton fails, apply the activation (or the boundary loads) in load steps,
+        //! halving the increment up to max_load_cuts times (0 = off)
+        int max_load_cuts;
     };
 
+    //! Relative tolerance of the linear solver at the current Newton step
+    /*!
+     *  \param [in] eta_old forcing term of the previous step
+     *  \param [in] res_norm norm of the current residual
+     *  \param [in] res_norm_old norm of the previous residual
+     *  \param [in] lin_res_norm unpreconditioned l2 norm of the linear residual of the previous step, |F + J s| (choice 1)
+     */
+    double forcing_term(double eta_old, double res_norm, double res_norm_old, double lin_res_norm) const;
+
     void setTime(double time);
 
     GetPot M_datafile;
@@ -149,6 +277,8 @@ public:
     std::unique_ptr<EXOExporter> M_exporter;
     std::unique_ptr<Exporter> M_GMVexporter;
     std::unique_ptr<VTKExporter> M_VTKexporter;
+    //! save_exo writes a compressed series instead (section/compressed_output)
+    std::unique_ptr<CompressedFieldWriter> M_compressedWriter;
     std::unique_ptr<libMesh::PetscLinearSolver<libMesh::Number> > M_linearSolver;
     std::unique_ptr<libMesh::LinearSolver<libMesh::Number> > M_projectionsLinearSolver;
     std::string M_outputFolder;
@@ -157,12 +287,45 @@ public:
 
     typedef std::unique_ptr<Material> MaterialPtr;
     std::map<unsigned int, MaterialPtr> M_materialMap;
+    //! Copies of the materials for the threads of the assembly after the first one, which uses M_materialMap
+    std::vector<std::map<unsigned int, MaterialPtr> > M_threadMaterials;
 
     ElasticSolverType M_solverType;
     NewtonData M_newtonData;
     bool M_stabilize;
+    //! Evaluate the material tangent once per quadrature point (see Material::tangent_basis)
+    bool M_tangentOnce;
     int M_currentNewtonIter;
+    //! system.matrix holds a Jacobian that can be reused by the modified Newton method
     bool M_JacIsAssembled;
+    //! assemble_residual assembles also the Jacobian: false when the Jacobian is lagged
+    bool M_assembleJacobian;
+    //! assemble_residual assembles also the residual: false for assemble_jacobian_only
+    bool M_assembleResidual;
+    //! Apply the Jacobian matrix-free (static primal formulation), preconditioned with the (low order) reference tangent
+    bool M_matrixFree;
+    //! Element data of the matrix-free Jacobian, filled by assemble_residual
+    std::unique_ptr<ElasticityShellMatrix> M_shellMatrix;
+    //! system.matrix holds the reference tangent used as preconditioner
+    bool M_referenceTangentIsAssembled;
+    //! assemble_residual evaluates the tangent at zero displacement
+    bool M_referenceConfiguration;
+    //! Attach the rigid body modes to the matrix before the linear solves
+    bool M_useNearNullSpace;
+    std::vector<std::unique_ptr<libMesh::NumericVector<libMesh::Number> > > M_rigidBodyModes;
+    //! Use the field-split preconditioner for the mixed formulation
+    bool M_fieldSplit;
+    //! Inverse of the shear modulus: the Schur complement is approximated by -M_schurScaling M_p
+    double M_schurScaling;
+    //! Schur factorization: diag, lower, upper or full
+    std::string M_schurFactorization;
+    IS M_isDisplacement;
+    IS M_isPressure;
+    Mat M_schurPreconditioner;
+    //! Activation of the last solve: starting point of the load stepping
+    std::unique_ptr<libMesh::NumericVector<libMesh::Number> > M_previousActivation;
+    //! Scaling of the boundary tractions and pressures, below 1 only in the load steps
+    double M_loadScaling;
 
     void evaluate_nodal_I4f();
     void evaluate_L2_J_err();
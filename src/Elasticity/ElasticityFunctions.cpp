@@ -33,6 +33,50 @@
  *      Author: srossi
  */
 
+#include "Elasticity/ElasticityFunctions.hpp"
 
+namespace BeatIt
+{
 
+void add_tangent_block( const libMesh::TensorValue<double> (&A)[3][3],
+                        const std::vector<std::vector<libMesh::RealGradient> >& dphi,
+                        unsigned int qp,
+                        double JxW,
+                        unsigned int dim,
+                        unsigned int n_u,
+                        libMesh::DenseMatrix<libMesh::Number>& Ke )
+{
+    const unsigned int n_phi = dphi.size();
+    double C[3][3];
+    double w[3];
+    for (unsigned int j = 0; j < dim; ++j)
+    {
+        for (unsigned int i = 0; i < dim; ++i)
+        {
+            // C(l,k) = A[i][k](j,l)
+            for (unsigned int l = 0; l < dim; ++l)
+                for (unsigned int k = 0; k < dim; ++k)
+                    C[l][k] = A[i][k](j, l);
 
+            for (unsigned int n = 0; n < n_phi; ++n)
+            {
+                const libMesh::RealGradient& dphi_n = dphi[n][qp];
+                for (unsigned int k = 0; k < dim; ++k)
+                {
+                    w[k] = 0.0;
+                    for (unsigned int l = 0; l < dim; ++l) w[k] += dphi_n(l) * C[l][k];
+                    w[k] *= JxW;
+                }
+                for (unsigned int m = 0; m < n_phi; ++m)
+                {
+                    const libMesh::RealGradient& dphi_m = dphi[m][qp];
+                    double value = 0.0;
+                    for (unsigned int k = 0; k < dim; ++k) value += w[k] * dphi_m(k);
+                    Ke(n + j * n_u, m + i * n_u) += value;
+                }
+            }
+        }
+    }
+}
+
+} /* namespace BeatIt */
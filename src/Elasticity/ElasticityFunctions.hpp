@@ -37,9 +37,34 @@
 #define SRC_ELASTICITY_ELASTICITYFUNCTIONS_HPP_
 
 
+#include "libmesh/tensor_value.h"
+#include "libmesh/vector_value.h"
+#include "libmesh/dense_matrix.h"
+#include <vector>
+
 namespace BeatIt
 {
 
+//! Add the tangent of a quadrature point to the displacement block of the element matrix
+/*!
+ *  Ke(n + j n_u, m + i n_u) += JxW sum_{l,k} dphi_n(l) A[i][k](j,l) dphi_m(k)
+ *
+ *  \param [in] A tangent along the basis e_i (x) e_k, see Material::tangent_basis
+ *  \param [in] dphi gradients of the shape functions
+ *  \param [in] qp quadrature point
+ *  \param [in] JxW quadrature weight
+ *  \param [in] dim dimension of the displacement
+ *  \param [in] n_u number of dofs of each displacement component
+ *  \param [out] Ke element matrix
+ */
+void add_tangent_block( const libMesh::TensorValue<double> (&A)[3][3],
+                        const std::vector<std::vector<libMesh::RealGradient> >& dphi,
+                        unsigned int qp,
+                        double JxW,
+                        unsigned int dim,
+                        unsigned int n_u,
+                        libMesh::DenseMatrix<libMesh::Number>& Ke );
+
 }
 
 
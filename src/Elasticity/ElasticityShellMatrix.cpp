@@ -0,0 +1,252 @@
+/*
+ * ElasticityShellMatrix.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Elasticity/ElasticityShellMatrix.hpp"
+#include "Elasticity/ElasticityFunctions.hpp"
+#include "libmesh/system.h"
+#include "libmesh/dof_map.h"
+#include "libmesh/elem.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/enum_parallel_type.h"
+
+namespace BeatIt
+{
+
+ElasticityShellMatrix::ElasticityShellMatrix(const libMesh::System& system, BoundaryJacobian boundary_jacobian)
+    : libMesh::ShellMatrix<libMesh::Number>(system.comm()), M_system(system), M_boundaryJacobian(boundary_jacobian),
+      M_elements(), M_materials(), M_fe(), M_qrule(), M_ghosted(), M_constrained()
+{
+}
+
+ElasticityShellMatrix::~ElasticityShellMatrix()
+{
+}
+
+libMesh::numeric_index_type ElasticityShellMatrix::m() const
+{
+    return M_system.n_dofs();
+}
+
+libMesh::numeric_index_type ElasticityShellMatrix::n() const
+{
+    return M_system.n_dofs();
+}
+
+void ElasticityShellMatrix::resize(unsigned int n_elements, const MaterialMap& materials)
+{
+    M_elements.clear();
+    M_elements.resize(n_elements);
+
+    M_materials.clear();
+    for (auto && m : materials)
+    {
+        M_materials[m.first].reset(m.second->clone());
+    }
+
+    // Same shape functions and quadrature rule of the assembly
+    const unsigned int dim = M_system.get_mesh().mesh_dimension();
+    libMesh::FEType fe_disp = M_system.get_dof_map().variable_type(0);
+    M_fe = libMesh::FEBase::build(dim, fe_disp);
+    M_qrule.reset(new libMesh::QGauss(dim, M_fe->get_order()));
+    M_fe->attach_quadrature_rule(M_qrule.get());
+    M_fe->get_JxW();
+    M_fe->get_dphi();
+
+    // The dof distribution may have changed
+    M_ghosted.reset();
+    M_constrained.reset();
+}
+
+void ElasticityShellMatrix::init_element(unsigned int e,
+                                         const libMesh::Elem* elem,
+                                         const std::vector<libMesh::dof_id_type>& dofs,
+                                         unsigned int n_qp)
+{
+    ElementData& data = M_elements[e];
+    data.elem = elem;
+    data.dofs = dofs;
+    data.states.resize(n_qp);
+    data.solution.clear();
+}
+
+void ElasticityShellMatrix::set_quadrature_point(unsigned int e, unsigned int qp, const Material::KinematicState& state)
+{
+    M_elements[e].states[qp] = state;
+}
+
+void ElasticityShellMatrix::set_boundary_element(unsigned int e, const std::vector<double>& solution)
+{
+    M_elements[e].solution = solution;
+}
+
+Material& ElasticityShellMatrix::material(const ElementData& data) const
+{
+    auto it = M_materials.find(data.elem->subdomain_id());
+    if (it == M_materials.end())
+    {
+        throw std::runtime_error("ElasticityShellMatrix: no material for the block " + std::to_string(data.elem->subdomain_id()));
+    }
+    return *it->second;
+}
+
+void ElasticityShellMatrix::element_mult(const ElementData& data,
+                                         const libMesh::DenseVector<libMesh::Number>& x,
+                                         libMesh::DenseVector<libMesh::Number>& y) const
+{
+    const std::vector<libMesh::Real>& JxW = M_fe->get_JxW();
+    const std::vector<std::vector<libMesh::RealGradient> >& dphi = M_fe->get_dphi();
+    M_fe->reinit(data.elem);
+    if (M_qrule->n_points() != data.states.size())
+    {
+        throw std::runtime_error("ElasticityShellMatrix: the quadrature rule differs from the one of the assembly");
+    }
+
+    Material& mat = material(data);
+    const unsigned int dim = M_system.get_mesh().mesh_dimension();
+    const unsigned int n_u = dphi.size();
+    const unsigned int n_dofs = x.size();
+    y.resize(n_dofs);
+    libMesh::TensorValue<double> P;
+    libMesh::TensorValue<double> G;
+    libMesh::TensorValue<double> dP;
+    for (unsigned int qp = 0; qp < data.states.size(); ++qp)
+    {
+        // The tangent of the state
+        mat.stress(data.states[qp], ElasticSolverType::Primal, P);
+        // Gradient of the argument
+        G.zero();
+        for (unsigned int i = 0; i < dim; ++i)
+        {
+            for (unsigned int m = 0; m < n_u; ++m)
+            {
+                const double xm = x(m + i * n_u);
+                for (unsigned int k = 0; k < dim; ++k) G(i, k) += xm * dphi[m][qp](k);
+            }
+        }
+        mat.tangent(G, dP);
+        // Test with the shape functions
+        for (unsigned int n = 0; n < n_u; ++n)
+        {
+            for (unsigned int j = 0; j < dim; ++j)
+            {
+                double value = 0.0;
+                for (unsigned int l = 0; l < dim; ++l) value += dphi[n][qp](l) * dP(j, l);
+                y(n + j * n_u) += JxW[qp] * value;
+            }
+        }
+    }
+    if (!data.solution.empty())
+    {
+        libMesh::DenseMatrix<libMesh::Number> Ke(n_dofs, n_dofs);
+        M_boundaryJacobian(data.elem, data.solution, Ke);
+        libMesh::DenseVector<libMesh::Number> Kx;
+        Ke.vector_mult(Kx, x);
+        y += Kx;
+    }
+}
+
+void ElasticityShellMatrix::element_matrix(const ElementData& data, libMesh::DenseMatrix<libMesh::Number>& Ke) const
+{
+    const std::vector<libMesh::Real>& JxW = M_fe->get_JxW();
+    const std::vector<std::vector<libMesh::RealGradient> >& dphi = M_fe->get_dphi();
+    M_fe->reinit(data.elem);
+
+    Material& mat = material(data);
+    const unsigned int dim = M_system.get_mesh().mesh_dimension();
+    const unsigned int n_u = dphi.size();
+    const unsigned int n_dofs = data.dofs.size();
+    Ke.resize(n_dofs, n_dofs);
+    if (!data.solution.empty()) M_boundaryJacobian(data.elem, data.solution, Ke);
+    libMesh::TensorValue<double> P;
+    libMesh::TensorValue<double> A[3][3];
+    for (unsigned int qp = 0; qp < data.states.size(); ++qp)
+    {
+        mat.stress(data.states[qp], ElasticSolverType::Primal, P);
+        mat.tangent_basis(dim, A);
+        add_tangent_block(A, dphi, qp, JxW[qp], dim, n_u, Ke);
+    }
+}
+
+void ElasticityShellMatrix::vector_mult(Vector& dest, const Vector& arg) const
+{
+    dest.zero();
+    vector_mult_add(dest, arg);
+}
+
+void ElasticityShellMatrix::vector_mult_add(Vector& dest, const Vector& arg) const
+{
+    const libMesh::DofMap& dof_map = M_system.get_dof_map();
+    if (!M_ghosted)
+    {
+        M_ghosted = Vector::build(M_system.comm());
+        M_ghosted->init(M_system.n_dofs(), M_system.n_local_dofs(), dof_map.get_send_list(), false, libMesh::GHOSTED);
+        M_constrained = Vector::build(M_system.comm());
+        M_constrained->init(M_system.n_dofs(), M_system.n_local_dofs(), dof_map.get_send_list(), false, libMesh::GHOSTED);
+    }
+    arg.localize(*M_ghosted, dof_map.get_send_list());
+    // C v: the constrained dofs are given by the others (zero on the Dirichlet boundary)
+    arg.localize(*M_constrained, dof_map.get_send_list());
+    dof_map.enforce_constraints_exactly(M_system, M_constrained.get(), true);
+
+    std::vector<libMesh::dof_id_type> dofs;
+    std::vector<double> values;
+    libMesh::DenseVector<libMesh::Number> x;
+    libMesh::DenseVector<libMesh::Number> y;
+    for (auto && data : M_elements)
+    {
+        const unsigned int n_dofs = data.dofs.size();
+        if (n_dofs == 0) continue;
+        M_constrained->get(data.dofs, values);
+        x.resize(n_dofs);
+        for (unsigned int i = 0; i < n_dofs; ++i) x(i) = values[i];
+        element_mult(data, x, y);
+        // C^T y, with zero on the constrained rows
+        dofs = data.dofs;
+        dof_map.constrain_element_vector(y, dofs);
+        // Constrained rows: v_i - sum_j c_ij v_j
+        for (unsigned int i = 0; i < n_dofs; ++i)
+        {
+            if (dof_map.is_constrained_dof(dofs[i])) y(i) += (*M_ghosted)(dofs[i]) - x(i);
+        }
+        dest.add_vector(y, dofs);
+    }
+    dest.close();
+}
+
+void ElasticityShellMatrix::get_diagonal(Vector& dest) const
+{
+    const libMesh::DofMap& dof_map = M_system.get_dof_map();
+    dest.zero();
+    std::vector<libMesh::dof_id_type> dofs;
+    libMesh::DenseMatrix<libMesh::Number> Ke;
+    libMesh::DenseVector<libMesh::Number> d;
+    for (auto && data : M_elements)
+    {
+        if (data.dofs.empty()) continue;
+        element_matrix(data, Ke);
+        dofs = data.dofs;
+        dof_map.constrain_element_matrix(Ke, dofs);
+        d.resize(dofs.size());
+        for (unsigned int i = 0; i < dofs.size(); ++i) d(i) = Ke(i, i);
+        dest.add_vector(d, dofs);
+    }
+    dest.close();
+}
+
+std::size_t ElasticityShellMatrix::memory() const
+{
+    std::size_t bytes = M_elements.capacity() * sizeof(ElementData);
+    for (auto && data : M_elements)
+    {
+        bytes += data.dofs.capacity() * sizeof(libMesh::dof_id_type);
+        bytes += data.states.capacity() * sizeof(Material::KinematicState);
+        bytes += data.solution.capacity() * sizeof(double);
+    }
+    return bytes;
+}
+
+} /* namespace BeatIt */
@@ -0,0 +1,123 @@
+/*
+ * ElasticityShellMatrix.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_ELASTICITY_ELASTICITYSHELLMATRIX_HPP_
+#define SRC_ELASTICITY_ELASTICITYSHELLMATRIX_HPP_
+
+#include "libmesh/shell_matrix.h"
+#include "libmesh/dense_matrix.h"
+#include "libmesh/dense_vector.h"
+#include "libmesh/id_types.h"
+#include "libmesh/fe_base.h"
+#include "libmesh/quadrature_gauss.h"
+#include "Elasticity/Materials/Material.hpp"
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace libMesh
+{
+class System;
+class Elem;
+template<typename T> class NumericVector;
+}
+
+namespace BeatIt
+{
+
+//! Matrix-free action of the Jacobian of the primal elasticity problem
+/*!
+ *  For each element the assembly stores only the kinematic state of the quadrature points
+ *  (displacement gradient, active deformation gradient, fibers).
+ *  The product with a vector v is computed element by element: the shape functions are evaluated again
+ *  and the tangent of the material is applied on the fly to the gradient of v,
+ *     y(n + j n_u) += JxW sum_l dphi_n(l) dP[grad v](j,l),
+ *  without assembling the global matrix.
+ *  The elements with boundary conditions contributing to the Jacobian (follower pressures, Robin)
+ *  store their solution: their element matrix is evaluated on demand by the BoundaryJacobian callback.
+ *  The constraints are applied as in the assembled Jacobian (DofMap::constrain_element_matrix):
+ *  y_e = C^T A_e C v_e, and each element adds v_i - (C v)_i to the constrained rows.
+ */
+class ElasticityShellMatrix : public libMesh::ShellMatrix<libMesh::Number>
+{
+public:
+    typedef libMesh::NumericVector<libMesh::Number> Vector;
+    typedef std::map<unsigned int, std::unique_ptr<Material> > MaterialMap;
+    //! Element matrix of the boundary conditions at the given element solution
+    typedef std::function<void(const libMesh::Elem*, const std::vector<double>&, libMesh::DenseMatrix<libMesh::Number>&)> BoundaryJacobian;
+
+    ElasticityShellMatrix(const libMesh::System& system, BoundaryJacobian boundary_jacobian);
+    ~ElasticityShellMatrix();
+
+    libMesh::numeric_index_type m() const override;
+    libMesh::numeric_index_type n() const override;
+
+    void vector_mult(Vector& dest, const Vector& arg) const override;
+    void vector_mult_add(Vector& dest, const Vector& arg) const override;
+    void get_diagonal(Vector& dest) const override;
+
+    //! Clear the stored data and reserve the given number of elements
+    /*!
+     *  The products evaluate copies of the given materials (see Material::clone()),
+     *  so that they do not share the work variables with the assembly
+     */
+    void resize(unsigned int n_elements, const MaterialMap& materials);
+    //! Prepare the storage of the element e
+    /*!
+     *  Different elements are written concurrently by the threads of the assembly
+     *  \param [in] elem the element
+     *  \param [in] dofs dof indices of the element
+     *  \param [in] n_qp number of quadrature points
+     */
+    void init_element(unsigned int e,
+                      const libMesh::Elem* elem,
+                      const std::vector<libMesh::dof_id_type>& dofs,
+                      unsigned int n_qp);
+    //! Store the kinematic state of a quadrature point
+    void set_quadrature_point(unsigned int e, unsigned int qp, const Material::KinematicState& state);
+    //! The boundary conditions of the element contribute to the Jacobian: keep its solution
+    void set_boundary_element(unsigned int e, const std::vector<double>& solution);
+
+    //! Bytes used by the stored element data on this processor
+    std::size_t memory() const;
+
+private:
+    struct ElementData
+    {
+        const libMesh::Elem* elem;
+        std::vector<libMesh::dof_id_type> dofs;
+        std::vector<Material::KinematicState> states;
+        //! Solution of the element, empty if there are no boundary terms
+        std::vector<double> solution;
+    };
+
+    //! y = A_e x for the element
+    void element_mult(const ElementData& data,
+                      const libMesh::DenseVector<libMesh::Number>& x,
+                      libMesh::DenseVector<libMesh::Number>& y) const;
+    //! Element matrix A_e, evaluated on the fly
+    void element_matrix(const ElementData& data, libMesh::DenseMatrix<libMesh::Number>& Ke) const;
+    //! Material of the element
+    Material& material(const ElementData& data) const;
+
+    const libMesh::System& M_system;
+    BoundaryJacobian M_boundaryJacobian;
+    std::vector<ElementData> M_elements;
+    //! Copies of the materials of the assembly
+    MaterialMap M_materials;
+    std::unique_ptr<libMesh::FEBase> M_fe;
+    std::unique_ptr<libMesh::QGauss> M_qrule;
+    //! Ghosted copy of the argument of the product
+    mutable std::unique_ptr<Vector> M_ghosted;
+    //! Ghosted copy of the argument with the homogeneous constraints enforced
+    mutable std::unique_ptr<Vector> M_constrained;
+};
+
+} /* namespace BeatIt */
+
+#endif /* SRC_ELASTICITY_ELASTICITYSHELLMATRIX_HPP_ */
@@ -45,6 +45,10 @@ class BenNeohookean : public virtual Material
 public:
     BenNeohookean();
 	virtual ~BenNeohookean();
+	Material* clone() const
+	{
+	    return new BenNeohookean(*this);
+	}
 
 
     void setup(GetPot& data, std::string section);
@@ -57,6 +57,10 @@ class Guccione : public virtual Material
 public:
 	Guccione();
 	virtual ~Guccione();
+	Material* clone() const
+	{
+	    return new Guccione(*this);
+	}
 
 
     void setup(GetPot& data, std::string section);
@@ -63,6 +63,10 @@ class HolzapfelOgden : public virtual IsotropicMaterial
 public:
     HolzapfelOgden();
     ~HolzapfelOgden();
+    Material* clone() const
+    {
+        return new HolzapfelOgden(*this);
+    }
 
     void setup(GetPot& data, std::string section);
     /// This method is used for primal elasticity
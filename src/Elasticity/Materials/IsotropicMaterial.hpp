@@ -57,6 +57,10 @@ class IsotropicMaterial : public virtual Material
 public:
 	IsotropicMaterial();
 	virtual ~IsotropicMaterial();
+	Material* clone() const
+	{
+	    return new IsotropicMaterial(*this);
+	}
 
 
     void setup(GetPot& data, std::string section);
@@ -45,6 +45,10 @@ class LinearMaterial : public virtual Material
 public:
 	LinearMaterial();
 	virtual ~LinearMaterial();
+	Material* clone() const
+	{
+	    return new LinearMaterial(*this);
+	}
 
 	void setup(GetPot& data, std::string section);
 	/// This method is used for primal elasticity
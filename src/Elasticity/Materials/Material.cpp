@@ -116,6 +116,49 @@ Material::setup(GetPot& data, std::string section, int ndim)
 
 
 
+void
+Material::stress(const KinematicState& state, ElasticSolverType solverType, libMesh::TensorValue <double>& PK1)
+{
+    M_f0 = state.f0;
+    M_s0 = state.s0;
+    M_gradU = state.gradU;
+    M_FA = state.FA;
+    updateVariables();
+    evaluateStress(solverType);
+    PK1 = M_PK1;
+}
+
+void
+Material::tangent(const libMesh::TensorValue <double>& dU, libMesh::TensorValue <double>& dP, double q)
+{
+    evaluateJacobian(dU, q);
+    dP = M_total_jacobian;
+}
+
+void
+Material::tangent_basis(unsigned int ndim, libMesh::TensorValue <double> (&A)[3][3], bool deviatoric)
+{
+    libMesh::TensorValue <double> dU;
+    for (unsigned int i = 0; i < ndim; ++i)
+    {
+        for (unsigned int k = 0; k < ndim; ++k)
+        {
+            dU.zero();
+            dU(i, k) = 1.0;
+            if (deviatoric)
+            {
+                evaluateDeviatoricJacobian(dU, 0.0);
+                A[i][k] = M_deviatoric_jacobian;
+            }
+            else
+            {
+                evaluateJacobian(dU, 0.0);
+                A[i][k] = M_total_jacobian;
+            }
+        }
+    }
+}
+
 void
 Material::dH(const libMesh::TensorValue <double>&  dU, libMesh::TensorValue <double> dcof)   const
 {
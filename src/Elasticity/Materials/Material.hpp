@@ -58,6 +58,12 @@ void dH(const libMesh::TensorValue <double>& dU, const libMesh::TensorValue <dou
 } // MaterialUtilities
 
 
+//! Constitutive law of the elasticity solvers
+/*!
+ *  The stress and tangent kernels store the state of the last material point in the
+ *  work variables of the instance (M_Fk, M_Cinvk, ...): an instance is not thread safe.
+ *  Threaded callers must evaluate their own copy (see clone() and Elasticity::init_thread_materials()).
+ */
 class Material {
 public:
 
@@ -68,6 +74,38 @@ public:
 	void setup(GetPot& data, std::string section, int ndim);
 	virtual void setup(GetPot& data, std::string section) = 0;
 
+	//! Copy of the material, with its parameters and its work variables
+	virtual Material* clone() const = 0;
+
+	//! Kinematic state of a material point
+	struct KinematicState
+	{
+	    libMesh::TensorValue <double> gradU;
+	    //! Active deformation gradient
+	    libMesh::TensorValue <double> FA;
+	    libMesh::VectorValue <double> f0;
+	    libMesh::VectorValue <double> s0;
+	};
+
+	//! Stress kernel: first Piola-Kirchhoff stress of the given state
+	/*!
+	 *  The kernel updates the work variables (M_Fk, M_Cinvk, the invariants, ...)
+	 *  of this instance, which are then used by tangent(): not thread safe.
+	 *  Concurrent callers must use one instance for each thread (see clone()).
+	 */
+	void stress(const KinematicState& state, ElasticSolverType solverType, libMesh::TensorValue <double>& PK1);
+	//! Tangent kernel: derivative of the stress of the last state along dU
+	//! (the state of the last stress() call on this instance)
+	void tangent(const libMesh::TensorValue <double>& dU, libMesh::TensorValue <double>& dP, double q = 0.0);
+	//! Tangent of the last state along the basis e_i (x) e_k, for i, k < ndim
+	/*!
+	 *  The tangent is linear in dU, so dP[dU] = sum_ik dU(i,k) A[i][k]:
+	 *  ndim^2 evaluations per quadrature point instead of one for each trial function.
+	 *  As tangent(), it uses the work variables of the last stress() call on this instance.
+	 *  \param [in] deviatoric use the deviatoric jacobian of the mixed formulation
+	 */
+	void tangent_basis(unsigned int ndim, libMesh::TensorValue <double> (&A)[3][3], bool deviatoric = false);
+
 
 
 	virtual void evaluateVolumetricStress() = 0;
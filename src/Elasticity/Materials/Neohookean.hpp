@@ -45,6 +45,10 @@ class Neohookean : public virtual Material
 public:
     Neohookean();
 	virtual ~Neohookean();
+	Material* clone() const
+	{
+	    return new Neohookean(*this);
+	}
 
 
     void setup(GetPot& data, std::string section);
@@ -102,6 +102,10 @@ class TransverselyIsoytopicMaterial : public virtual IsotropicMaterial
 public:
     TransverselyIsoytopicMaterial();
     ~TransverselyIsoytopicMaterial();
+    Material* clone() const
+    {
+        return new TransverselyIsoytopicMaterial(*this);
+    }
 
     void setup(GetPot& data, std::string section);
     /// This method is used for primal elasticity
@@ -337,11 +337,14 @@ void MixedDynamicElasticity::assemble_residual(
 
     // Zero out the vectors
 //    system.get_vector("residual").zero();
-    system.get_vector("step").zero();
-    p_system.get_vector("step").zero();
+    if (M_assembleResidual)
+    {
+        system.get_vector("step").zero();
+        p_system.get_vector("step").zero();
+    }
     //system.get_matrix("mass").zero();
-    system.rhs->zero();
-    system.matrix->zero();
+    if (M_assembleResidual) system.rhs->zero();
+    if (M_assembleJacobian) system.matrix->zero();
 
 
     // Define the midpoint vectors
@@ -861,18 +864,24 @@ void MixedDynamicElasticity::assemble_residual(
         } // end for loop on edges
 
         dof_map.constrain_element_matrix_and_vector (Me, Fe, dof_indices);
-        system.matrix->add_matrix(Me, dof_indices);
-        p_system.matrix->add_matrix(Mep, dof_indices_p);
-        system.rhs->add_vector(Fe, dof_indices);
-        p_system.rhs->add_vector(Fep, dof_indices_p);
+        if (M_assembleJacobian)
+        {
+            system.matrix->add_matrix(Me, dof_indices);
+            p_system.matrix->add_matrix(Mep, dof_indices_p);
+        }
+        if (M_assembleResidual)
+        {
+            system.rhs->add_vector(Fe, dof_indices);
+            p_system.rhs->add_vector(Fep, dof_indices_p);
+        }
 
 
     } // end loop over elements
-    system.matrix->close();
+    if (M_assembleJacobian) system.matrix->close();
     //system.get_matrix("mass").close();
-    system.rhs->close();
-    p_system.matrix->close();
-    p_system.rhs->close();
+    if (M_assembleResidual) system.rhs->close();
+    if (M_assembleJacobian) p_system.matrix->close();
+    if (M_assembleResidual) p_system.rhs->close();
     std::cout << "Assembly completed" << std::endl;
 
 }
@@ -889,6 +898,7 @@ MixedDynamicElasticity::solve_system()
     double max_iter = 2000;
 
     std::pair<unsigned int, double> rval = std::make_pair(0,0.0);
+    set_near_null_space(*system.matrix);
     rval = M_linearSolver->solve (*system.matrix, system.get_vector("step"),
                                                         *system.rhs, tol, max_iter);
 
@@ -78,6 +78,7 @@
 #include "Elasticity/Materials/Neohookean.hpp"
 #include "Elasticity/Materials/IsotropicMaterial.hpp"
 #include "Elasticity/Materials/HolzapfelOgden.hpp"
+#include "Elasticity/ElasticityFunctions.hpp"
 
 #include "libmesh/petsc_linear_solver.h"
 #include "libmesh/petsc_vector.h"
@@ -121,9 +122,12 @@ MixedElasticity::assemble_residual(double dt , libMesh::NumericVector<libMesh::N
     ParameterSystem& xfiber_system       = M_equationSystems.get_system<ParameterSystem>("xfibers");
     ParameterSystem& dummy_system       = M_equationSystems.get_system<ParameterSystem>("dumb");
 
-    system.get_vector("residual").zero();
-    system.rhs->zero();
-    system.matrix->zero();
+    if (M_assembleResidual)
+    {
+        system.get_vector("residual").zero();
+        system.rhs->zero();
+    }
+    if (M_assembleJacobian) system.matrix->zero();
     system.update();
     unsigned int ux_var = system.variable_number ("displacementx");
     unsigned int uy_var, uz_var, p_var;
@@ -197,6 +201,9 @@ MixedElasticity::assemble_residual(double dt , libMesh::NumericVector<libMesh::N
     libMesh::TensorValue <libMesh::Number> S;
     // Grad W (test function)
     libMesh::TensorValue <libMesh::Number> dW;
+    // Tangent along the basis of the displacement gradients and volumetric jacobian for q = 1
+    libMesh::TensorValue <libMesh::Number> tangent[3][3];
+    libMesh::TensorValue <libMesh::Number> Vk;
     // Cofactor
     libMesh::TensorValue <libMesh::Number> Hk;
     // Linearization Cofactor
@@ -485,6 +492,15 @@ MixedElasticity::assemble_residual(double dt , libMesh::NumericVector<libMesh::N
             }
 
             // Matrix
+            if (!M_assembleJacobian) continue;
+            if (M_tangentOnce)
+            {
+                M_materialMap[blockID]->tangent_basis(dim, tangent, true);
+                add_tangent_block(tangent, dphi_u, qp, JxW_u[qp], dim, n_ux_dofs, Ke);
+                // The volumetric jacobian is linear in q
+                M_materialMap[blockID]->evaluateVolumetricJacobian(dU, 1.0);
+                Vk = M_materialMap[blockID]->M_volumetric_jacobian;
+            }
             // For each test function
             for(unsigned int n = 0; n < phi_u.size(); ++n )
             {
@@ -498,6 +514,7 @@ MixedElasticity::assemble_residual(double dt , libMesh::NumericVector<libMesh::N
                     dW(jdim, 2) = JxW_u[qp]* dphi_u[n][qp](2);
 
                     // for each trial function
+                    if (!M_tangentOnce)
                     for(unsigned int m = 0; m < phi_u.size(); ++m )
                     {
                         // for each dimension of the trial function
@@ -521,6 +538,11 @@ MixedElasticity::assemble_residual(double dt , libMesh::NumericVector<libMesh::N
                     for(unsigned int m = 0; m < phi_p.size(); ++m )
                     {
                         q = phi_p[m][qp];
+                        if (M_tangentOnce)
+                        {
+                            Ke(n+jdim*n_ux_dofs,m+dim*n_ux_dofs) += q * Vk.contract(dW);
+                            continue;
+                        }
                         M_materialMap[blockID]->evaluateVolumetricJacobian(dU, q);
                         S = M_materialMap[blockID]->M_volumetric_jacobian;
                         Ke(n+jdim*n_ux_dofs,m+dim*n_ux_dofs) += S.contract(dW);
@@ -634,15 +656,15 @@ MixedElasticity::assemble_residual(double dt , libMesh::NumericVector<libMesh::N
         Elasticity::apply_BC(elem, Ke, Fe, fe_face, qface, mesh, n_ux_dofs, nullptr, 0.0, time, &solution_k);
 
         dof_map.constrain_element_matrix_and_vector (Ke, Fe, dof_indices);
-        system.matrix->add_matrix (Ke, dof_indices);
-        system.rhs->add_vector    (Fe, dof_indices);
+        if (M_assembleJacobian) system.matrix->add_matrix (Ke, dof_indices);
+        if (M_assembleResidual) system.rhs->add_vector    (Fe, dof_indices);
 
     }
 
     std::cout << " closing. " << std::endl;
-    system.matrix->close();
+    if (M_assembleJacobian) system.matrix->close();
 
-    system.rhs->close();
+    if (M_assembleResidual) system.rhs->close();
     std::cout << " done. " << std::endl;
 //    {
 //            std::cout << "* MIXED ELASTICITY: Assigning field split information ... " << std::flush;
@@ -0,0 +1,210 @@
+/*
+ * ActivationMaps.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Electrophysiology/ActivationMaps.hpp"
+
+#include "libmesh/equation_systems.h"
+#include "libmesh/system.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/mesh_base.h"
+#include "libmesh/node.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+namespace BeatIt
+{
+
+    namespace
+    {
+        const char * map_names[] = { "activation_time", "repolarization_time", "apd", "n_activations" };
+        const unsigned int n_maps = 4;
+    }
+
+    ActivationMaps::ActivationMaps()
+        : M_potentialSystem(nullptr)
+        , M_mapsSystem(nullptr)
+        , M_activationThreshold(-40.0)
+        , M_repolarizationThreshold(-70.0)
+        , M_cycleLength(0.0)
+        , M_beatEnd(0.0)
+        , M_beat(1)
+        , M_hasPrevious(false)
+        , M_timePrev(0.0)
+    {
+    }
+
+    void ActivationMaps::clear()
+    {
+        M_potentialSystem = nullptr;
+        M_mapsSystem = nullptr;
+        M_dofsV.clear();
+        M_dofsMaps.clear();
+        M_hasPrevious = false;
+        M_V.clear();
+        M_Vprev.clear();
+        M_depolarized.clear();
+        M_lastActivation.clear();
+        M_activationTime.clear();
+        M_repolarizationTime.clear();
+        M_apd.clear();
+        M_nActivations.clear();
+    }
+
+    void ActivationMaps::build(libMesh::EquationSystems& es, const std::string& potential_system, const std::string& maps_system)
+    {
+        clear();
+        M_potentialSystem = &es.get_system(potential_system);
+        M_mapsSystem = &es.get_system(maps_system);
+        const unsigned int sys_V = M_potentialSystem->number();
+        const unsigned int sys_maps = M_mapsSystem->number();
+        std::vector<unsigned int> vars(n_maps);
+        for (unsigned int k = 0; k < n_maps; ++k)
+        {
+            if (!M_mapsSystem->has_variable(map_names[k])) throw std::runtime_error("ActivationMaps: the system " + maps_system + " has no variable " + map_names[k]);
+            vars[k] = M_mapsSystem->variable_number(map_names[k]);
+        }
+
+        const libMesh::MeshBase& mesh = es.get_mesh();
+        M_dofsMaps.resize(n_maps);
+        for (auto node = mesh.local_nodes_begin(); node != mesh.local_nodes_end(); ++node)
+        {
+            const libMesh::Node * nn = *node;
+            // Nodes in the bath have no potential
+            if (nn->n_comp(sys_V, 0) == 0) continue;
+            M_dofsV.push_back(nn->dof_number(sys_V, 0, 0));
+            for (unsigned int k = 0; k < n_maps; ++k)
+                M_dofsMaps[k].push_back(nn->dof_number(sys_maps, vars[k], 0));
+        }
+
+        const unsigned int n = M_dofsV.size();
+        M_V.assign(n, 0.0);
+        M_Vprev.assign(n, 0.0);
+        M_depolarized.assign(n, 0);
+        M_lastActivation.assign(n, -1.0);
+        M_activationTime.assign(n, -1.0);
+        M_repolarizationTime.assign(n, -1.0);
+        M_apd.assign(n, -1.0);
+        M_nActivations.assign(n, 0.0);
+        std::cout << "* ActivationMaps: " << n << " local nodes, thresholds: activation " << M_activationThreshold << ", repolarization " << M_repolarizationThreshold << std::endl;
+    }
+
+    bool ActivationMaps::update(double time)
+    {
+        M_potentialSystem->solution->get(M_dofsV, M_V);
+        const unsigned int n = M_V.size();
+        if (!M_hasPrevious)
+        {
+            // Nodes already above the threshold are not counted as activated
+            for (unsigned int i = 0; i < n; ++i)
+                M_depolarized[i] = M_V[i] >= M_activationThreshold;
+        }
+        else
+        {
+            const double t0 = M_timePrev;
+            const double dt = time - M_timePrev;
+            const double va = M_activationThreshold;
+            const double vr = M_repolarizationThreshold;
+            for (unsigned int i = 0; i < n; ++i)
+            {
+                const double v0 = M_Vprev[i];
+                const double v1 = M_V[i];
+                if (!M_depolarized[i])
+                {
+                    if (v0 < va && v1 >= va)
+                    {
+                        const double t = t0 + dt * (va - v0) / (v1 - v0);
+                        M_depolarized[i] = 1;
+                        M_lastActivation[i] = t;
+                        if (M_activationTime[i] < 0.0) M_activationTime[i] = t;
+                        M_nActivations[i] += 1.0;
+                    }
+                }
+                else if (v0 > vr && v1 <= vr)
+                {
+                    const double t = t0 + dt * (v0 - vr) / (v0 - v1);
+                    M_depolarized[i] = 0;
+                    M_repolarizationTime[i] = t;
+                    if (M_lastActivation[i] >= 0.0) M_apd[i] = t - M_lastActivation[i];
+                }
+            }
+        }
+        M_Vprev.swap(M_V);
+        M_timePrev = time;
+        M_hasPrevious = true;
+        return M_cycleLength > 0.0 && time >= M_beatEnd;
+    }
+
+    ActivationMaps::Summary ActivationMaps::summary() const
+    {
+        Summary s;
+        s.n_nodes = M_dofsV.size();
+        s.n_activated = 0;
+        s.n_repolarized = 0;
+        s.first_activation = std::numeric_limits<double>::max();
+        s.last_activation = -std::numeric_limits<double>::max();
+        s.max_activations = 0.0;
+        double apd_sum = 0.0;
+        for (unsigned int i = 0; i < M_dofsV.size(); ++i)
+        {
+            if (M_activationTime[i] >= 0.0)
+            {
+                ++s.n_activated;
+                s.first_activation = std::min(s.first_activation, M_activationTime[i]);
+                s.last_activation = std::max(s.last_activation, M_activationTime[i]);
+            }
+            if (M_apd[i] >= 0.0)
+            {
+                ++s.n_repolarized;
+                apd_sum += M_apd[i];
+            }
+            s.max_activations = std::max(s.max_activations, M_nActivations[i]);
+        }
+        const libMesh::Parallel::Communicator& comm = M_mapsSystem->comm();
+        comm.sum(s.n_nodes);
+        comm.sum(s.n_activated);
+        comm.sum(s.n_repolarized);
+        comm.sum(apd_sum);
+        comm.min(s.first_activation);
+        comm.max(s.last_activation);
+        comm.max(s.max_activations);
+        s.mean_apd = s.n_repolarized > 0 ? apd_sum / s.n_repolarized : -1.0;
+        return s;
+    }
+
+    ActivationMaps::Summary ActivationMaps::end_beat()
+    {
+        Summary s = summary();
+        auto& solution = *M_mapsSystem->solution;
+        if (size() > 0)
+        {
+            solution.insert(M_activationTime, M_dofsMaps[0]);
+            solution.insert(M_repolarizationTime, M_dofsMaps[1]);
+            solution.insert(M_apd, M_dofsMaps[2]);
+            solution.insert(M_nActivations, M_dofsMaps[3]);
+        }
+        // close is collective: call it also without local nodes
+        solution.close();
+        M_mapsSystem->update();
+
+        // The nodes still depolarized keep the time of their last activation for the APD
+        std::fill(M_activationTime.begin(), M_activationTime.end(), -1.0);
+        std::fill(M_repolarizationTime.begin(), M_repolarizationTime.end(), -1.0);
+        std::fill(M_apd.begin(), M_apd.end(), -1.0);
+        std::fill(M_nActivations.begin(), M_nActivations.end(), 0.0);
+        ++M_beat;
+        if (M_cycleLength > 0.0)
+        {
+            while (M_beatEnd <= M_timePrev)
+                M_beatEnd += M_cycleLength;
+        }
+        return s;
+    }
+
+} /* namespace BeatIt */
@@ -0,0 +1,161 @@
+/*
+ * ActivationMaps.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_ELECTROPHYSIOLOGY_ACTIVATIONMAPS_HPP_
+#define SRC_ELECTROPHYSIOLOGY_ACTIVATIONMAPS_HPP_
+
+#include <string>
+#include <vector>
+#include "libmesh/id_types.h"
+
+// Forward Definition
+namespace libMesh
+{
+class EquationSystems;
+class System;
+}
+
+namespace BeatIt
+{
+
+/*!
+ *  In-situ activation and repolarization maps.
+ *
+ *  For each local node with a potential dof the potential at the previous call of
+ *  update is kept in a contiguous array: when the potential crosses the activation
+ *  threshold upwards (or the repolarization threshold downwards) the crossing time is
+ *  linearly interpolated between the two steps. For each beat the maps store
+ *  the first activation time, the last repolarization time, the APD of the last
+ *  action potential and the number of activations (-1: not activated / repolarized).
+ *
+ *  The maps are copied into the variables "activation_time", "repolarization_time",
+ *  "apd" and "n_activations" of the maps system only at the end of each beat.
+ */
+class ActivationMaps
+{
+public:
+    typedef std::vector<double> Array;
+
+    //! Global statistics of a beat
+    struct Summary
+    {
+        unsigned long n_nodes;
+        unsigned long n_activated;
+        unsigned long n_repolarized;
+        double first_activation;
+        double last_activation;
+        double mean_apd;
+        double max_activations;
+    };
+
+    ActivationMaps();
+
+    //! Local nodes with a potential dof and their dofs in the potential and maps systems
+    /*!
+     *  \param [in] potential_system system whose first variable is the potential
+     *  \param [in] maps_system system with the variables of the maps
+     */
+    void build( libMesh::EquationSystems& es,
+                const std::string& potential_system = "wave",
+                const std::string& maps_system = "activation_maps" );
+    void clear();
+
+    void set_thresholds(double activation, double repolarization)
+    {
+        M_activationThreshold = activation;
+        M_repolarizationThreshold = repolarization;
+    }
+    //! Beats of length cycle_length starting at start_time (cycle_length <= 0: one beat)
+    void set_cycle_length(double cycle_length, double start_time = 0.0)
+    {
+        M_cycleLength = cycle_length;
+        M_beatEnd = start_time + cycle_length;
+    }
+
+    //! Detect the crossings of the thresholds between the previous call and time
+    /*!
+     *  The first call only stores the potential.
+     *  \return true if time reached the end of the current beat
+     */
+    bool update(double time);
+
+    //! Copy the maps of the current beat into the maps system and start a new beat
+    /*!
+     *  Collective.
+     *  \return the statistics of the beat just ended
+     */
+    Summary end_beat();
+
+    //! Number of the current beat, starting from 1
+    int beat() const
+    {
+        return M_beat;
+    }
+    //! Time of the last call to update
+    double time() const
+    {
+        return M_timePrev;
+    }
+    //! Number of local nodes
+    unsigned int size() const
+    {
+        return M_dofsV.size();
+    }
+    bool empty() const
+    {
+        return !M_mapsSystem;
+    }
+    const Array& activation_time() const
+    {
+        return M_activationTime;
+    }
+    const Array& repolarization_time() const
+    {
+        return M_repolarizationTime;
+    }
+    const Array& apd() const
+    {
+        return M_apd;
+    }
+    const Array& n_activations() const
+    {
+        return M_nActivations;
+    }
+
+private:
+    Summary summary() const;
+
+    libMesh::System * M_potentialSystem;
+    libMesh::System * M_mapsSystem;
+    /// dofs of the potential of the local nodes
+    std::vector<libMesh::dof_id_type> M_dofsV;
+    /// M_dofsMaps[variable][node]: dofs of the maps of the local nodes
+    std::vector<std::vector<libMesh::dof_id_type> > M_dofsMaps;
+
+    double M_activationThreshold;
+    double M_repolarizationThreshold;
+    double M_cycleLength;
+    double M_beatEnd;
+    int M_beat;
+    bool M_hasPrevious;
+    double M_timePrev;
+
+    Array M_V;
+    Array M_Vprev;
+    /// the node is activated and not yet repolarized
+    std::vector<char> M_depolarized;
+    /// time of the last activation, for the APD
+    Array M_lastActivation;
+    Array M_activationTime;
+    Array M_repolarizationTime;
+    Array M_apd;
+    Array M_nActivations;
+};
+
+} /* namespace BeatIt */
+
+#endif /* SRC_ELECTROPHYSIOLOGY_ACTIVATIONMAPS_HPP_ */
@@ -781,6 +781,7 @@ void Bidomain::assemble_matrices(double dt)
 //      std::cout << "* BIDOMAIN: initialized linear solver  " << prec_type
 //              << std::endl;
 //    }
+    operator_changed();
 }
 
 void Bidomain::form_system_rhs(double dt, bool useMidpoint, const std::string& mass)
@@ -984,7 +985,7 @@ void Bidomain::solve_diffusion_step(double dt, double time, bool useMidpoint, co
     double max_iter = 2000;
 
     std::pair<unsigned int, double> rval = std::make_pair(0, 0.0);
-    rval = M_linearSolver->solve(*bidomain_system.matrix, *bidomain_system.solution, *bidomain_system.rhs, tol, max_iter);
+    rval = solve_diffusion_system(*bidomain_system.matrix, *bidomain_system.solution, *bidomain_system.rhs, tol, max_iter);
 //    bidomain_system.solution->print();
 
     // Update V_n+1 = V_n + dt * Q_n+1:
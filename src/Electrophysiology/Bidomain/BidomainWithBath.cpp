@@ -1082,6 +1082,7 @@ void BidomainWithBath::assemble_matrices(double dt)
 
     }
 
+    operator_changed();
 }
 
 
@@ -1422,19 +1423,8 @@ void BidomainWithBath::solve_diffusion_step(double dt, double time, bool useMidp
     Timer timer;
     M_equationSystems.comm().barrier();
     timer.start();
-    if(M_timestep_counter > 1)
-    {
-        M_linearSolver->reuse_preconditioner(true);
-    }
-    else
-    {
-        //std::cout << "* BidomainWithBath: Calling reuse preconditioner: false" << std::endl;
-        M_linearSolver->reuse_preconditioner(false);
-        //std::cout << "* BidomainWithBath: not reusing preconditioner: " << std::endl;
-    }
-    //std::cout << "* BidomainWithBath: Calling linear solver: " << std::endl;
-
-    rval = M_linearSolver->solve(*bidomain_system.matrix, *bidomain_system.solution, *bidomain_system.rhs, tol, max_iter);
+    // The preconditioner is rebuilt only after assemble_matrices
+    rval = solve_diffusion_system(*bidomain_system.matrix, *bidomain_system.solution, *bidomain_system.rhs, tol, max_iter);
     //std::cout << "* BidomainWithBath: linear solver converged to: " << rval.second << std::endl;
     M_equationSystems.comm().barrier();
     timer.stop();
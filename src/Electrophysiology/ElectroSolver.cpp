@@ -40,11 +40,15 @@
 #include "libmesh/nemesis_io.h"
 
 #include "libmesh/perf_log.h"
+#include "libmesh/libmesh.h"
+#include "libmesh/threads.h"
 #include "libmesh/string_to_enum.h"
 #include "libmesh/enum_preconditioner_type.h"
 #include "libmesh/enum_solver_type.h"
 
 #include <sys/stat.h>
+#include <algorithm>
+#include <cmath>
 
 #include "Electrophysiology/IonicModels/NashPanfilov.hpp"
 #include "Electrophysiology/IonicModels/Grandi11.hpp"
@@ -52,6 +56,10 @@
 #include "Electrophysiology/IonicModels/TP06.hpp"
 #include "Electrophysiology/ElectroSolver.hpp"
 #include "Util/SpiritFunction.hpp"
+#include "Util/IO/AsyncVTKWriter.hpp"
+#include "Util/IO/NemesisSeries.hpp"
+#include "Util/IO/CompressedFieldIO.hpp"
+#include "Util/IO/Checkpoint.hpp"
 
 #include "libmesh/petsc_linear_solver.h"
 #include "libmesh/petsc_vector.h"
@@ -69,10 +77,10 @@ namespace BeatIt
     typedef libMesh::ExplicitSystem ParameterSystem;
 
     ElectroSolver::ElectroSolver(libMesh::EquationSystems& es, std::string model)
-            : M_equationSystems(es), M_exporter(), M_exporterNames(), M_ionicModelExporter(), M_ionicModelExporterNames(), M_parametersExporter(), M_parametersExporterNames(), M_outputFolder(), M_datafile(), M_pacing_i(), M_pacing_e(), M_linearSolver(), M_anisotropy(
+            : M_equationSystems(es), M_exporter(), M_compressedOutput(false), M_exporterNames(), M_ionicModelExporter(), M_ionicModelExporterNames(), M_parametersExporter(), M_parametersExporterNames(), M_outputFolder(), M_datafile(), M_pacing_i(), M_pacing_e(), M_linearSolver(), M_anisotropy(
                     Anisotropy::Orthotropic), M_equationType(EquationType::ParabolicEllipticBidomain), M_timeIntegratorType(DynamicTimeIntegratorType::Implicit), M_useAMR(false), M_assembleMatrix(
                     true), M_systemMass("lumped"), M_intraConductivity(), M_extraConductivity(), M_conductivity(), M_meshSize(1.0), M_model(model), M_ground_ve(Ground::Nullspace), M_timeIntegrator(
-                    TimeIntegrator::FirstOrderIMEX), M_timestep_counter(0), M_symmetricOperator(false), M_elapsed_time(), M_num_linear_iters(0), M_order(libMesh::FIRST), M_FEFamily(libMesh::LAGRANGE)
+                    TimeIntegrator::FirstOrderIMEX), M_timestep_counter(0), M_symmetricOperator(false), M_elapsed_time(), M_reactionTimer(), M_reactionNodeUpdates(0), M_reactionSubsteppedNodes(0), M_reactionSubsteps(1), M_reactionSubstepThreshold(0.0), M_reactionPotentialTimestep(0.0), M_reactionMidpointPotential(false), M_num_linear_iters(0), M_reusePreconditioner(true), M_rebuildPreconditioner(true), M_setupSolveTimer(), M_reuseSolveTimer(), M_numSetupSolves(0), M_numReuseSolves(0), M_order(libMesh::FIRST), M_FEFamily(libMesh::LAGRANGE)
     {
         // TODO Auto-generated constructor stub
 
@@ -80,6 +88,7 @@ namespace BeatIt
 
     ElectroSolver::~ElectroSolver()
     {
+        // The writer waits for the pending output
     }
 
     void ElectroSolver::setup(GetPot& data, std::string section)
@@ -193,6 +202,24 @@ namespace BeatIt
         CV_system.add_variable("cvz", libMesh::CONSTANT, libMesh::MONOMIAL);
         CV_system.init();
 
+        // In-situ activation / repolarization maps
+        if (M_datafile(M_section + "/activation_maps/enable", false))
+        {
+            ParameterSystem& maps_system = M_equationSystems.add_system < ParameterSystem > ("activation_maps");
+            maps_system.add_variable("activation_time", M_order, M_FEFamily);
+            maps_system.add_variable("repolarization_time", M_order, M_FEFamily);
+            maps_system.add_variable("apd", M_order, M_FEFamily);
+            maps_system.add_variable("n_activations", M_order, M_FEFamily);
+            maps_system.init();
+            double threshold = M_datafile(M_section + "/activation_maps/threshold", -40.0);
+            double repolarization_threshold = M_datafile(M_section + "/activation_maps/repolarization_threshold", -70.0);
+            double cycle_length = M_datafile(M_section + "/activation_maps/cycle_length", 0.0);
+            double start_time = M_datafile(M_section + "/activation_maps/start_time", 0.0);
+            M_activationMaps.set_thresholds(threshold, repolarization_threshold);
+            M_activationMaps.set_cycle_length(cycle_length, start_time);
+            std::cout << "* ElectroSolver: activation maps every " << cycle_length << " ms from " << start_time << std::endl;
+        }
+
         if (!M_equationSystems.has_system("fibers"))
         {
             ParameterSystem& fiber_system = M_equationSystems.add_system < ParameterSystem > ("fibers");
@@ -256,6 +283,14 @@ namespace BeatIt
             std::cout << "ELECTROSOLVER: using SBDF order 1 " << std::endl;
             M_timeIntegrator = TimeIntegrator::FirstOrderIMEX;
         }
+        // The Rush-Larsen integrators of the ionic models are used only in the first order scheme
+        for (auto && map : M_ionicModelPtrMap)
+        {
+            if (TimeIntegrator::SecondOrderIMEX == M_timeIntegrator && IonicIntegrator::Native != map.second->integrator())
+            {
+                throw std::runtime_error("ElectroSolver: SBDF2 requires the native integrator of the ionic model " + map.second->ionicModelName());
+            }
+        }
 
         // ///////////////////////////////////////////////////////////////////////
         // ///////////////////////////////////////////////////////////////////////
@@ -270,7 +305,14 @@ namespace BeatIt
         M_parametersExporter.reset(new EXOExporter(M_equationSystems.get_mesh()));
         M_EXOExporter.reset(new EXOExporter(M_equationSystems.get_mesh()));
         M_potentialEXOExporter.reset(new EXOExporter(M_equationSystems.get_mesh()));
-        M_nemesis_exporter.reset(new NemesisIO(M_equationSystems.get_mesh()));
+        bool async_output = M_datafile(M_section + "/async_output", false);
+        if (async_output)
+        {
+            M_asyncWriter.reset(new AsyncVTKWriter(M_equationSystems.get_mesh(), M_outputFolder));
+        }
+        std::cout << "* ElectroSolver: asynchronous VTK output: " << async_output << std::endl;
+        M_compressedOutput = M_datafile(M_section + "/compressed_output", false);
+        std::cout << "* ElectroSolver: compressed output: " << M_compressedOutput << std::endl;
 
         M_symmetricOperator = M_datafile(M_section + "/symmetric_operator", false);
         std::cout << "* ElectroSolver: Using Symmetric Operator: " << M_symmetricOperator << std::endl;
@@ -472,6 +514,7 @@ namespace BeatIt
 
         // Call specific system initializations
         init_systems(time);
+        init_ionic_state_store();
 //    M_linearSolver =  libMesh::LinearSolver<libMesh::Number>::build( M_equationSystems.comm() );
         typedef libMesh::PetscLinearSolver<libMesh::Number> PetscSolver;
         M_linearSolver.reset(new PetscSolver(M_equationSystems.comm()));
@@ -481,6 +524,9 @@ namespace BeatIt
         //M_linearSolver->set_solver_type(solver_map.find(solver_type)->second);
         //M_linearSolver->set_preconditioner_type(prec_map.find(prec_type)->second);
         M_linearSolver->init();
+        M_reusePreconditioner = M_datafile(M_section + "/linear_solver/reuse_preconditioner", true);
+        M_rebuildPreconditioner = true;
+        std::cout << "* ElectroSolver: reuse preconditioner: " << M_reusePreconditioner << std::endl;
 
         std::cout << "* ElectroSolver: Init complete " << std::endl;
 
@@ -718,6 +764,45 @@ namespace BeatIt
 
     }
 
+    void ElectroSolver::init_ionic_state_store()
+    {
+        std::cout << "* ElectroSolver: Setup ionic model state store " << std::endl;
+        bool store_old = (TimeIntegrator::SecondOrderIMEX == M_timeIntegrator);
+        M_ionicStateStore.build(M_equationSystems, M_model, M_ionicModelPtrMap, M_ionicModelNameMap, store_old, libMesh::n_threads());
+        M_ionicStateStore.sync_from_systems();
+
+        // The stimulated nodes of each block are found once, here and after AMR
+        for (PacingProtocol* pacing : { M_pacing.get(), M_pacing_i.get(), M_pacing_e.get(), M_surf_pacing_i.get(), M_surf_pacing_e.get() })
+        {
+            if (!pacing) continue;
+            unsigned int n_stimulated = 0;
+            for (unsigned int k = 0; k < M_ionicStateStore.M_blocks.size(); ++k)
+            {
+                pacing->build_support(k, M_ionicStateStore.M_blocks[k].points);
+                n_stimulated += pacing->support_size(k);
+            }
+            if (pacing->is_separable()) std::cout << "* ElectroSolver: pacing protocol stimulating " << n_stimulated << " local nodes" << std::endl;
+            else std::cout << "* ElectroSolver: pacing protocol evaluated at all the local nodes" << std::endl;
+        }
+    }
+
+    void ElectroSolver::mesh_changed()
+    {
+        // The local nodes have changed: rebuild the ionic state store
+        init_ionic_state_store();
+        operator_changed();
+        if (M_asyncWriter) M_asyncWriter->reset_mesh();
+        if (M_nemesis_exporter) M_nemesis_exporter->reset();
+        for (auto && writer : M_compressedWriters)
+        {
+            if (writer.second) writer.second->reset();
+        }
+        // The exodus file keeps the mesh of the first write
+        M_parametersExporter.reset(new EXOExporter(M_equationSystems.get_mesh()));
+        // The local nodes of the activation maps: the current beat starts again
+        if (!M_activationMaps.empty()) M_activationMaps.build(M_equationSystems, "wave", "activation_maps");
+    }
+
     void ElectroSolver::init_endocardial_ve(std::set<libMesh::boundary_id_type>& IDs, std::set<unsigned short>& subdomainIDs)
     {
         std::cout << "* ElectroSolver: Initializing endocardial mesh " << std::endl;
@@ -800,9 +885,30 @@ namespace BeatIt
                     }
                 }
             }
+            // the reaction step works on the ionic state store
+            M_ionicStateStore.sync_from_systems();
         }
     }
 
+    void ElectroSolver::save_checkpoint(const std::string& filename, double time, int step)
+    {
+        std::cout << "* ElectroSolver: writing checkpoint " << filename << " at time " << time << std::endl;
+        // the state variables are stored in the ionic state store
+        M_ionicStateStore.sync_to_systems();
+        write_checkpoint(filename, M_equationSystems, time, step, M_timestep_counter);
+    }
+
+    void ElectroSolver::restart_from_checkpoint(const std::string& filename, double& time, int& step)
+    {
+        std::cout << "* ElectroSolver: reading checkpoint " << filename << std::endl;
+        // the step counter selects the first order start of SBDF2
+        read_checkpoint(filename, M_equationSystems, time, step, &M_timestep_counter);
+        M_equationSystems.parameters.set < libMesh::Real > ("time") = time;
+        // the reaction step works on the ionic state store
+        M_ionicStateStore.sync_from_systems();
+        std::cout << "* ElectroSolver: restarting at time " << time << ", step " << step << ", time step counter " << M_timestep_counter << std::endl;
+    }
+
     void ElectroSolver::read_fibers(EXOExporter& importer, int step)
     {
         const int num_fiber_systems = 3;
@@ -837,6 +943,7 @@ namespace BeatIt
     void ElectroSolver::init_exo_output()
     {
         std::cout << "* " << M_model << ": EXODUSII::Exporting " << M_model << ".exo at time 0.0" << " in: " << M_outputFolder << " ... " << std::flush;
+        M_ionicStateStore.sync_to_systems();
 
         M_EXOExporter->write_equation_systems(M_outputFolder + M_model + ".exo", M_equationSystems);
         M_EXOExporter->append(true);
@@ -927,6 +1034,7 @@ namespace BeatIt
     void ElectroSolver::save_exo_timestep(int step, double time)
     {
         std::cout << "* " << M_model << ": EXODUSII::Exporting " << M_model << ".exo at time " << time << " in: " << M_outputFolder << " ... " << std::flush;
+        M_ionicStateStore.sync_to_systems();
         M_EXOExporter->write_timestep(M_outputFolder + M_model + ".exo", M_equationSystems, step, time);
         std::cout << "done " << std::endl;
     }
@@ -938,22 +1046,34 @@ namespace BeatIt
 //        vtk.write_equation_systems(M_outputFolder + "parameters.pvtu", M_equationSystems, &M_parametersExporterNames);
 //        std::cout << "done " << std::endl;
         std::cout << "* " << M_model << ": EXODUSII::Exporting parameters in: " << M_outputFolder << " ... " << std::flush;
-        EXOExporter exo(M_equationSystems.get_mesh());
-        exo.write_equation_systems(M_outputFolder+"parameters.exo", M_equationSystems, &M_parametersExporterNames);
+        M_parametersExporter->write_equation_systems(M_outputFolder+"parameters.exo", M_equationSystems, &M_parametersExporterNames);
 //        exo.write(M_outputFolder + "parameters.exo");
-        exo.write_element_data(M_equationSystems);
+        M_parametersExporter->append(true);
+        M_parametersExporter->write_element_data(M_equationSystems);
         std::cout << "done " << std::endl;
 
     }
 
     void ElectroSolver::save_potential(int step, double time)
     {
+        if (M_compressedOutput)
+        {
+            save_compressed("potential", M_exporterNames, step, time);
+            return;
+        }
         std::cout << "* " << M_model << ": VTKIO::Exporting potential*.pvtu at step " << step << " for time: " << time << " in: " << M_outputFolder << " ... " << std::flush;
 
         //M_potentialEXOExporter->write_timestep(M_outputFolder + "potential.exo", M_equationSystems, step, time);
         std::ostringstream ss;
         ss << std::setw(4) << std::setfill('0') << step;
         std::string step_str = ss.str();
+        if (M_asyncWriter)
+        {
+            update_exported_systems(M_exporterNames);
+            M_asyncWriter->write("potential", step, time, M_equationSystems, M_exporterNames);
+            std::cout << "queued " << std::endl;
+            return;
+        }
         M_exporter->write_equation_systems(M_outputFolder + "potential_" + step_str + ".pvtu", M_equationSystems, &M_exporterNames);
         std::cout << "done " << std::endl;
     }
@@ -961,39 +1081,48 @@ namespace BeatIt
     void ElectroSolver::save_potential_nemesis(int step, double time)
     {
 
-        //M_potentialEXOExporter->write_timestep(M_outputFolder + "potential.exo", M_equationSystems, step, time);
-        std::ostringstream ss;
-        ss << std::setw(4) << std::setfill('0') << step;
-        std::string step_str = ss.str();
-        std::string filename = M_outputFolder + "potential_" + step_str + ".e";
-        std::cout << "* " << M_model << ": NEMESIS_IO::Exporting potential*.e at step " << step << " for time: " << time << " in: " << M_outputFolder << " ... " << std::flush;
-        std::cout << "\n" << filename << std::endl;
-        M_nemesis_exporter.reset(new NemesisIO(M_equationSystems.get_mesh()));
-        M_nemesis_exporter->write_equation_systems(filename, M_equationSystems, &M_exporterNames);
+        if (!M_nemesis_exporter)
+        {
+            M_nemesis_exporter.reset(new NemesisSeries(M_equationSystems.get_mesh(), M_outputFolder + "potential.e", M_exporterNames));
+        }
+        std::cout << "* " << M_model << ": NEMESIS_IO::Appending step " << step << " for time: " << time << " to potential.e in: " << M_outputFolder << " ... " << std::flush;
+        M_nemesis_exporter->write_timestep(M_equationSystems, time);
         std::cout << "done " << std::endl;
     }
 
     void ElectroSolver::save_activation_times(int step)
     {
         std::cout << "* " << M_model << ": VTKIO::Exporting activaton times: " << M_outputFolder << " ... " << std::flush;
-        Exporter vtk(M_equationSystems.get_mesh());
         std::set < std::string > output;
         output.insert("activation_times");
 
+        if (M_asyncWriter)
+        {
+            update_exported_systems(output);
+            M_asyncWriter->write("activation_times", step, M_equationSystems.get_system(M_model).time, M_equationSystems, output);
+            std::cout << "queued " << std::endl;
+            return;
+        }
         std::ostringstream ss;
         ss << std::setw(4) << std::setfill('0') << step;
         std::string step_str = ss.str();
-        vtk.write_equation_systems(M_outputFolder + "activation_times_" + step_str + ".pvtu", M_equationSystems, &output);
+        M_exporter->write_equation_systems(M_outputFolder + "activation_times_" + step_str + ".pvtu", M_equationSystems, &output);
         std::cout << "done " << std::endl;
     }
 
     void ElectroSolver::save_conduction_velocity(int step)
     {
         std::cout << "* " << M_model << ": VTKIO::Exporting Conduction Velocity: " << M_outputFolder << " ... " << std::flush;
-        Exporter vtk(M_equationSystems.get_mesh());
         std::set < std::string > output;
         output.insert("CV");
-        vtk.write_equation_systems(M_outputFolder + "CV" + std::to_string(step) + ".pvtu", M_equationSystems, &output);
+        if (M_asyncWriter)
+        {
+            update_exported_systems(output);
+            M_asyncWriter->write("CV", step, M_equationSystems.get_system(M_model).time, M_equationSystems, output);
+            std::cout << "queued " << std::endl;
+            return;
+        }
+        M_exporter->write_equation_systems(M_outputFolder + "CV" + std::to_string(step) + ".pvtu", M_equationSystems, &output);
         std::cout << "done " << std::endl;
     }
 
@@ -1005,18 +1134,101 @@ namespace BeatIt
 
         //save in subfolder
 
+        M_ionicStateStore.sync_to_systems();
+        if (M_compressedOutput)
+        {
+            double time = M_equationSystems.get_system(M_model).time;
+            save_compressed(M_model, M_exporterNames, step, time);
+            save_compressed("ionic_model", M_ionicModelExporterNames, step, time);
+            return;
+        }
         std::cout << "* " << M_model << ": VTKIO::Exporting " << step << " in: " << M_outputFolder << " ... " << std::flush;
+        if (M_asyncWriter)
+        {
+            update_exported_systems(M_exporterNames);
+            update_exported_systems(M_ionicModelExporterNames);
+            double time = M_equationSystems.get_system(M_model).time;
+            M_asyncWriter->write(M_model, step, time, M_equationSystems, M_exporterNames);
+            M_asyncWriter->write("ionic_model", step, time, M_equationSystems, M_ionicModelExporterNames);
+            std::cout << "queued " << std::endl;
+            return;
+        }
         M_exporter->write_equation_systems(M_outputFolder + M_model + "_" + step_str + ".pvtu", M_equationSystems, &M_exporterNames);
         M_ionicModelExporter->write_equation_systems(M_outputFolder + "ionic_model_" + step_str + ".pvtu", M_equationSystems, &M_ionicModelExporterNames);
         std::cout << "done " << std::endl;
     }
 
+    void ElectroSolver::update_exported_systems(const std::set<std::string>& names)
+    {
+        // The asynchronous writer copies the ghosted solutions
+        for (auto && name : names)
+        {
+            if (M_equationSystems.has_system(name)) M_equationSystems.get_system(name).update();
+        }
+    }
+
+    void ElectroSolver::save_compressed(const std::string& name, const std::set<std::string>& system_names, int step, double time)
+    {
+        std::cout << "* " << M_model << ": Compressed output of " << name << "_*.bfo at step " << step << " for time: " << time << " in: " << M_outputFolder << " ... " << std::flush;
+        auto& writer = M_compressedWriters[name];
+        if (!writer)
+        {
+            writer.reset(new CompressedFieldWriter(M_equationSystems.get_mesh(), M_outputFolder + name));
+            writer->setup(M_datafile, M_section);
+        }
+        writer->write_timestep(M_equationSystems, system_names, step, time);
+        std::cout << "done: " << writer->input_bytes() << " -> " << writer->stored_bytes() << " local bytes" << std::endl;
+    }
+
+    void ElectroSolver::wait_for_output()
+    {
+        if (!M_asyncWriter) return;
+        Timer timer;
+        timer.start();
+        M_asyncWriter->finish();
+        timer.stop();
+        std::cout << "* ElectroSolver: asynchronous output: " << M_asyncWriter->number_of_writes() << " files written in " << M_asyncWriter->write_time() << " s (background), " << M_asyncWriter->snapshot_time() << " s spent copying the data, " << timer.M_elapsed.count() << " s waiting at the end" << std::endl;
+    }
+
     void ElectroSolver::reinit_linear_solver()
     {
         M_linearSolver->clear();
         M_linearSolver->set_solver_type(libMesh::CG);
         M_linearSolver->set_preconditioner_type(libMesh::AMG_PRECOND);
         M_linearSolver->init();
+        operator_changed();
+    }
+
+    std::pair<unsigned int, double> ElectroSolver::solve_diffusion_system( libMesh::SparseMatrix<libMesh::Number>& matrix,
+                                                                           libMesh::NumericVector<libMesh::Number>& solution,
+                                                                           libMesh::NumericVector<libMesh::Number>& rhs,
+                                                                           double tol,
+                                                                           unsigned int max_iter )
+    {
+        // KSPSetReusePreconditioner: the operator is still passed to the solver,
+        // but the preconditioner is set up only when the matrix has changed
+        const bool setup = M_rebuildPreconditioner || !M_reusePreconditioner;
+        M_linearSolver->reuse_preconditioner(!setup);
+        Timer& timer = setup ? M_setupSolveTimer : M_reuseSolveTimer;
+        timer.start();
+        std::pair<unsigned int, double> rval = M_linearSolver->solve(matrix, solution, rhs, tol, max_iter);
+        timer.stop();
+        if (setup) ++M_numSetupSolves;
+        else ++M_numReuseSolves;
+        M_rebuildPreconditioner = false;
+        return rval;
+    }
+
+    void ElectroSolver::print_linear_solver_timings(std::ostream& out)
+    {
+        const double setup_time = M_setupSolveTimer.elapsed().count();
+        const double reuse_time = M_reuseSolveTimer.elapsed().count();
+        out << "* ElectroSolver: " << M_numSetupSolves << " solves building the preconditioner: " << setup_time << " s";
+        if (M_numSetupSolves > 0) out << " (" << setup_time / M_numSetupSolves << " s/solve)";
+        out << std::endl;
+        out << "* ElectroSolver: " << M_numReuseSolves << " solves reusing the preconditioner: " << reuse_time << " s";
+        if (M_numReuseSolves > 0) out << " (" << reuse_time / M_numReuseSolves << " s/solve)";
+        out << std::endl;
     }
 
     void ElectroSolver::evaluate_conduction_velocity()
@@ -1147,6 +1359,43 @@ namespace BeatIt
         activation_times_system.update();
     }
 
+    void ElectroSolver::update_activation_maps(double time)
+    {
+        if (!M_equationSystems.has_system("activation_maps")) return;
+        if (M_activationMaps.empty()) M_activationMaps.build(M_equationSystems, "wave", "activation_maps");
+        if (M_activationMaps.update(time)) save_activation_maps();
+    }
+
+    void ElectroSolver::save_activation_maps()
+    {
+        if (M_activationMaps.empty()) return;
+        const int beat = M_activationMaps.beat();
+        const double time = M_activationMaps.time();
+        ActivationMaps::Summary summary = M_activationMaps.end_beat();
+        std::cout << "* ElectroSolver: beat " << beat << ": " << summary.n_activated << " / " << summary.n_nodes << " nodes activated";
+        if (summary.n_activated > 0) std::cout << " in [" << summary.first_activation << ", " << summary.last_activation << "]";
+        std::cout << ", mean APD: " << summary.mean_apd << " (" << summary.n_repolarized << " nodes), max activations: " << summary.max_activations << std::endl;
+
+        std::set < std::string > output;
+        output.insert("activation_maps");
+        if (M_compressedOutput)
+        {
+            save_compressed("activation_maps", output, beat, time);
+            return;
+        }
+        std::cout << "* " << M_model << ": VTKIO::Exporting activation maps of beat " << beat << " in: " << M_outputFolder << " ... " << std::flush;
+        if (M_asyncWriter)
+        {
+            M_asyncWriter->write("activation_maps", beat, time, M_equationSystems, output);
+            std::cout << "queued " << std::endl;
+            return;
+        }
+        std::ostringstream ss;
+        ss << std::setw(4) << std::setfill('0') << beat;
+        M_exporter->write_equation_systems(M_outputFolder + "activation_maps_" + ss.str() + ".pvtu", M_equationSystems, &output);
+        std::cout << "done " << std::endl;
+    }
+
     void ElectroSolver::advance()
     {
         ElectroSystem& system = M_equationSystems.get_system < ElectroSystem > (M_model);
@@ -1158,17 +1407,7 @@ namespace BeatIt
         *system.old_local_solution = *system.solution;
         system.update();
 
-        for (auto && name : M_ionic_models_systems_name_vec)
-        {
-            IonicModelSystem& ionic_model_system = M_equationSystems.get_system < IonicModelSystem > (name);
-            ionic_model_system.solution->close();
-            ionic_model_system.old_local_solution->close();
-            ionic_model_system.older_local_solution->close();
-            *ionic_model_system.older_local_solution = *ionic_model_system.old_local_solution;
-            *ionic_model_system.old_local_solution = *ionic_model_system.solution;
-            ionic_model_system.get_vector("rhs_old") = *ionic_model_system.rhs;
-            ionic_model_system.update();
-        }
+        // The ionic model variables are advanced in place in M_ionicStateStore
         // WAVE
         ElectroSystem& wave_system = M_equationSystems.get_system < ElectroSystem > ("wave");
         wave_system.solution->close();
@@ -1286,42 +1525,24 @@ namespace BeatIt
 
     void ElectroSolver::solve_reaction_step_cg(double dt, double time, int step, bool useMidpoint, const std::string& mass, libMesh::NumericVector<libMesh::Number>* I4f_ptr)
     {
-        const libMesh::MeshBase & mesh = M_equationSystems.get_mesh();
-//    BidomainSystem& bidomain_system = M_equationSystems.get_system
-//            < BidomainSystem > ("bidomain"); //Q
-        ElectroSystem& system = M_equationSystems.get_system < ElectroSystem > (M_model);
-        IonicModelSystem& istim_system = M_equationSystems.get_system < IonicModelSystem > ("istim");
+        M_reactionTimer.start();
+        // Systems, vectors and buffers have been resolved in init_ionic_state_store:
+        // no allocations and no lookups by name in the loop over the blocks
+        IonicStateStore& store = M_ionicStateStore;
+        ElectroSystem& system = *store.M_system;
+        IonicModelSystem& istim_system = *store.M_istimSystem;
         // WAVE
-        ElectroSystem& wave_system = M_equationSystems.get_system < ElectroSystem > ("wave");
-        IonicModelSystem& iion_system = M_equationSystems.get_system < IonicModelSystem > ("iion");
+        ElectroSystem& wave_system = *store.M_waveSystem;
+        IonicModelSystem& iion_system = *store.M_iionSystem;
 
         system.rhs->zero();
         istim_system.solution->zero();
-        istim_system.get_vector("stim_i").zero();
-        istim_system.get_vector("stim_e").zero();
-        istim_system.get_vector("surf_stim_i").zero();
-        istim_system.get_vector("surf_stim_e").zero();
+        store.M_stim_i->zero();
+        store.M_stim_e->zero();
+        store.M_surf_stim_i->zero();
+        store.M_surf_stim_e->zero();
         iion_system.solution->zero();
-        iion_system.get_vector("diion").zero();
-
-        //iion_system.old_local_solution->zero();
-
-        double Cm = 1.0;        //M_ionicModelPtr->membraneCapacitance();
-
-        int var_index = 0;
-
-        libMesh::MeshBase::const_node_iterator node = mesh.local_nodes_begin();
-        const libMesh::MeshBase::const_node_iterator end_node = mesh.local_nodes_end();
-
-        const libMesh::DofMap & dof_map = system.get_dof_map();
-        const libMesh::DofMap & dof_map_V = wave_system.get_dof_map();
-        const libMesh::DofMap & dof_map_istim = istim_system.get_dof_map();
-
-        std::vector < libMesh::dof_id_type > dof_indices;
-        std::vector < libMesh::dof_id_type > dof_indices_V;
-        std::vector < libMesh::dof_id_type > dof_indices_Q;
-        std::vector < libMesh::dof_id_type > dof_indices_istim;
-        std::vector < libMesh::dof_id_type > dof_indices_gating;
+        store.M_diion->zero();
 
         if (M_pacing) M_pacing->update(time);
         if (M_pacing_i) M_pacing_i->update(time);
@@ -1329,174 +1550,262 @@ namespace BeatIt
         if (M_surf_pacing_i) M_surf_pacing_i->update(time);
         if (M_surf_pacing_e) M_surf_pacing_e->update(time);
 
-        int c = 0;
-        for (; node != end_node; ++node)
+        unsigned int n_nodes = 0;
+        for (unsigned int k = 0; k < store.M_blocks.size(); ++k)
         {
-            double istim = 0.0;
-            double istim_zero = 0.0;
-            double stim_i = 0.0;
-            double surf_stim_i = 0.0;
-            double stim_e = 0.0;
-            double surf_stim_e = 0.0;
-
-            double dIion = 0.0;
-
-            const libMesh::Node * nn = *node;
-            // Are we in the bath?
-            auto n_var = nn->n_vars(system.number());
-            auto n_dofs = nn->n_dofs(system.number());
-            // std::cout << "n_dofs per node: " << n_dofs << ", n_var: " << n_var << std::endl;
-            libMesh::Point p((*nn)(0), (*nn)(1), (*nn)(2));
-            if (n_var == n_dofs)
+            IonicStateStore::Block& block = store.M_blocks[k];
+            const unsigned int n = block.size();
+            if (0 == n) continue;
+            n_nodes += n;
+
+            // Block values: read and written with a single call for each vector
+            IonicStateStore::Buffers& b = block.buffers;
+            wave_system.old_local_solution->get(block.dofs_V, b.V); //V^n
+            if (M_reactionMidpointPotential || (M_reactionSubsteps > 1 && M_reactionSubstepThreshold > 0.0))
             {
-                dof_map.dof_indices(nn, dof_indices_Q, 0);
-                dof_map_V.dof_indices(nn, dof_indices_V, 0);
-                dof_map_istim.dof_indices(nn, dof_indices_istim, 0);
-
-                if (M_pacing_i) stim_i = M_pacing_i->eval(p, time);
-                if (M_pacing_e) stim_e = M_pacing_e->eval(p, time);
-                if (M_surf_pacing_i) surf_stim_i = M_surf_pacing_i->eval(p, time);
-                if (M_surf_pacing_e) surf_stim_e = M_surf_pacing_e->eval(p, time);
-                if (M_pacing) istim = M_pacing->eval(p, time);
-
-                double Iion_old = 0.0;
-                double v = (*wave_system.old_local_solution)(dof_indices_V[0]); //V^n
-                double gating_rhs_ = (*system.old_local_solution)(dof_indices_Q[0]); //Q^n
-                Iion_old = (*iion_system.old_local_solution)(dof_indices_istim[0]); // gating
-                int key = iion_system.get_vector("ionic_model_map")(dof_indices_istim[0]);
-                auto it_ionic_model = M_ionicModelPtrMap.find(key);
-                auto it_ionic_model_name = M_ionicModelNameMap.find(key);
-//                std::cout << "key: " << key << std::endl;
-
-                IonicModel * ionicModelPtr = nullptr;
-                if (it_ionic_model != M_ionicModelPtrMap.end()) ionicModelPtr = it_ionic_model->second.get();
-                else
+                wave_system.older_local_solution->get(block.dofs_V, b.V_prev); //V^n-1
+            }
+            if (M_reactionMidpointPotential)
+            {
+                // V^n+1/2, keeping V - V_prev for the substeps (see set_reaction_midpoint_potential)
+                for (unsigned int i = 0; i < n; ++i)
                 {
-                   throw std::runtime_error("node without ionicModelPtr!!!");
+                    const double dv = b.V[i] - b.V_prev[i];
+                    b.V[i] += 0.5 * dv;
+                    b.V_prev[i] = b.V[i] - dv;
                 }
-//                if (it_ionic_model_name != M_ionicModelNameMap.end()) ionic_model_system_name = it_ionic_model_name->second;
-                std::string ionic_model_system_name = M_ionicModelNameMap[it_ionic_model->first];
-//                std::cout << "node ID: " << nn->id() << std::endl;
-//                std::cout  << "ionicModelPtr: " << ionicModelPtr << std::end;
-//                std::cout  << "ionic_model_system_name: " << ionic_model_system_name << std::end;
-               // std::cout << "ptr: " << ionicModelPtr << std::endl;
-                if (ionicModelPtr)
+            }
+            system.old_local_solution->get(block.dofs_Q, b.Q); //Q^n
+            if (I4f_ptr) I4f_ptr->get(block.dofs_V, b.I4f);
+            else b.I4f.clear();
+            std::fill(b.Iion.begin(), b.Iion.end(), 0.0);
+            std::fill(b.dIion.begin(), b.dIion.end(), 0.0);
+
+            // Only the nodes stimulated by each protocol are written, the other entries
+            // of the stimulus buffers stay zero: a buffer is inserted only if it is not zero
+            const bool stim_i = M_pacing_i && M_pacing_i->stimulate(k, block.points, time, b.stim_i);
+            const bool stim_e = M_pacing_e && M_pacing_e->stimulate(k, block.points, time, b.stim_e);
+            const bool surf_stim_i = M_surf_pacing_i && M_surf_pacing_i->stimulate(k, block.points, time, b.surf_stim_i);
+            const bool surf_stim_e = M_surf_pacing_e && M_surf_pacing_e->stimulate(k, block.points, time, b.surf_stim_e);
+            const bool istim = M_pacing && M_pacing->stimulate(k, block.points, time, b.istim);
+
+            // The lookup tables of the ionic model are built once, one for each time step
+            // of the kernels, and shared by the copies: the kernels only select them
+            if (M_reactionSubsteps > 1) block.model->prepareLUT(dt / M_reactionSubsteps);
+            block.model->prepareLUT(dt);
+            for (unsigned int t = 1; t < block.thread_models.size(); ++t)
+            {
+                block.thread_models[t]->shareLUT(*block.model);
+            }
+
+            // The nodes of the block are split in contiguous chunks, one for each thread:
+            // each chunk is evaluated with its own copy of the ionic model
+            const unsigned int n_chunks = store.n_threads();
+            auto reaction_step = [&](const libMesh::Threads::BlockedRange<unsigned int>& range)
+            {
+                for (unsigned int c = range.begin(); c != range.end(); ++c)
                 {
-                    IonicModelSystem& ionic_model_system = M_equationSystems.get_system < IonicModelSystem > (ionic_model_system_name);
-                    auto& iion_rhs_old = ionic_model_system.get_vector("rhs_old");
-                    int num_vars = ionic_model_system.n_vars();
-                   // std::cout << "ionic_model_system_name: " << ionicModelPtr->ionicModelName() << ", num_vars: " << num_vars << std::endl;
-                    std::vector<double> values(num_vars + 1, 0.0);
-                    values[0] = v;
-                    std::vector<double> old_values(num_vars + 1, 0.0);
-                    std::vector<double> gating_rhs(num_vars + 1, 0.0); // First entry is reserved to Q^n
-                    gating_rhs[0] = gating_rhs_;
-                    std::vector<double> gating_rhs_old(num_vars + 1, 0.0); // First entry is reserved to Q^n-1
-                    const libMesh::DofMap & dof_map_gating = ionic_model_system.get_dof_map();
-                    dof_map_gating.dof_indices(nn, dof_indices_gating);
+                    const unsigned int begin = store.chunk_begin(n, c);
+                    const unsigned int end = store.chunk_begin(n, c + 1);
+                    solve_reaction_step_chunk(block, c, begin, end, dt);
+                }
+            };
+            libMesh::Threads::parallel_for(libMesh::Threads::BlockedRange<unsigned int>(0, n_chunks, 1), reaction_step);
+            for (auto && scratch : block.thread_scratch)
+            {
+                M_reactionSubsteppedNodes += scratch.substepped_nodes;
+            }
 
-                    for (int nv = 0; nv < num_vars; ++nv)
-                    {
-                        var_index = dof_indices_gating[nv];
-                        values[nv + 1] = (*ionic_model_system.old_local_solution)(var_index);
-                        old_values[nv + 1] = values[nv + 1];
+            iion_system.solution->insert(b.Iion, block.dofs_I);
+            store.M_diion->insert(b.dIion, block.dofs_I);
+            if (istim) istim_system.solution->insert(b.istim, block.dofs_I);
+            if (stim_i) store.M_stim_i->insert(b.stim_i, block.dofs_I); //Istim^n+1
+            if (surf_stim_i) store.M_surf_stim_i->insert(b.surf_stim_i, block.dofs_I); //Istim^n+1
+            if (stim_e) store.M_stim_e->insert(b.stim_e, block.dofs_I); //Istim^n+1
+            if (surf_stim_e) store.M_surf_stim_e->insert(b.surf_stim_e, block.dofs_I); //Istim^n+1
+        }
 
-                    }
+        iion_system.solution->close();
+        istim_system.solution->close();
+        store.M_stim_i->close();
+        store.M_stim_e->close();
+        store.M_surf_stim_i->close();
+        store.M_surf_stim_e->close();
+        store.M_diion->close();
+        store.M_diion_old->close();
 
-                    if (TimeIntegrator::FirstOrderIMEX == M_timeIntegrator)
-                    {
-                        ionicModelPtr->updateVariables(values, istim, dt);
+        iion_system.update();
+        istim_system.update();
 
-                    }
-                    else // using SBDF2
-                    {
-                        if (M_timestep_counter >= 0)
-                        {
-                            bool overwrite = true;
-                            // Recall: gating_rhs[0] = Q^n
-                            ionicModelPtr->updateVariables(values, gating_rhs, istim, dt, overwrite);
-                        }
-                        else
-                        {
-                            bool overwrite = false;
-                            // Recall: gating_rhs[0] = Q^n
-                            ionicModelPtr->updateVariables(values, gating_rhs, istim, dt, overwrite);
-                            for (int nv = 0; nv < values.size(); ++nv)
-                            {
-                                var_index = dof_indices_gating[nv];
-                                ionic_model_system.rhs->set(var_index, gating_rhs[nv + 1]);
-
-                                old_values[nv + 1] = (*ionic_model_system.older_local_solution)(var_index);
-                                double f_nm1 = iion_rhs_old(var_index);
-                                double f_n = gating_rhs[nv + 1];
-                                // Update using SBDF2
-                                // w^n+1 = 4/3 * w^n - 1/3 * w^n-1 + 2/3*dt * (2*f^n - f^n-1)
-                                // w^n+1 = ( 4 * w^n - w^n-1 + 2 * dt * (2*f^n - f^n-1) ) / 3
-                                values[nv + 1] = (4.0 * values[nv + 1] - old_values[nv + 1] + 2.0 * dt * (2 * f_n - f_nm1)) / 3;
-                            }
-                        }
+        M_reactionTimer.stop();
+        M_reactionNodeUpdates += n_nodes;
+    }
 
-                    }
-                    double Iion = ionicModelPtr->current_scaling() * ionicModelPtr->evaluateIonicCurrent(values, istim, dt);
-                    // Recall: gating_rhs[0] = Q^n
-                    // HACK: For now, as I've implemented the second order scheme only for a dew ionic models
-                    //       I keep everything as it was before I started the implementation of SBDF2
-                    if (ionicModelPtr->isSecondOrderImplemented()) dIion = ionicModelPtr->evaluateIonicCurrentTimeDerivative(values, gating_rhs, dt, M_meshSize);
-                    else dIion = ionicModelPtr->evaluateIonicCurrentTimeDerivative(values, old_values, dt, M_meshSize);
+    void ElectroSolver::solve_reaction_step_chunk( IonicStateStore::Block& block,
+                                                   unsigned int thread,
+                                                   unsigned int begin,
+                                                   unsigned int end,
+                                                   double dt )
+    {
+        if (begin == end) return;
+        IonicModel& model = *block.thread_models[thread];
+        IonicStateStore::ThreadScratch& scratch = block.thread_scratch[thread];
+        IonicStateStore::Buffers& b = block.buffers;
+        std::vector<double>& V = b.V;
+        const std::vector<double>& Q = b.Q;
+        const std::vector<double>& I4f = b.I4f;
+        const std::vector<double>& istim = b.istim;
+        std::vector<double>& Iion = b.Iion;
+        std::vector<double>& dIion = b.dIion;
+        const unsigned int num_vars = block.num_vars;
+        if (TimeIntegrator::FirstOrderIMEX == M_timeIntegrator)
+        {
+            // Update the whole block at once: variables[0] = V^n, variables[nv+1] = w^n
+            // The gating variables are advanced in place in the store
+            std::vector<double *>& variables = scratch.variables;
+            scratch.substepped_nodes = 0;
+            if (M_reactionSubsteps <= 1)
+            {
+                variables[0] = V.data() + begin;
+                for (unsigned int nv = 0; nv < num_vars; ++nv)
+                {
+                    variables[nv + 1] = block.state[nv].data() + begin;
+                }
+                model.advanceBatch(variables.data(), Q.data() + begin, istim.data() + begin, Iion.data() + begin, dIion.data() + begin, end - begin, dt, M_meshSize);
+            }
+            else
+            {
+                // Multirate: the nodes with a fast potential take the substeps.
+                // The chunk is split in runs of consecutive nodes with the same number of substeps,
+                // each run is updated at once
+                const std::vector<double>& V_prev = b.V_prev;
+                const bool adaptive = M_reactionSubstepThreshold > 0.0;
+                // V - V_prev spans a diffusion step, not the reaction step
+                const double potential_dt = M_reactionPotentialTimestep > 0.0 ? M_reactionPotentialTimestep : dt;
+                const double dv_threshold = M_reactionSubstepThreshold * potential_dt;
+                auto substepped = [&](unsigned int i)
+                {
+                    return !adaptive || std::abs(V[i] - V_prev[i]) > dv_threshold;
+                };
+                const double substep_dt = dt / M_reactionSubsteps;
+                unsigned int run_begin = begin;
+                while (run_begin < end)
+                {
+                    const bool fine = substepped(run_begin);
+                    unsigned int run_end = run_begin + 1;
+                    while (run_end < end && substepped(run_end) == fine) ++run_end;
 
-                    double Isac = 0.0;
-                    if (I4f_ptr)
+                    variables[0] = V.data() + run_begin;
+                    for (unsigned int nv = 0; nv < num_vars; ++nv)
+                    {
+                        variables[nv + 1] = block.state[nv].data() + run_begin;
+                    }
+                    const unsigned int n_steps = fine ? M_reactionSubsteps : 1;
+                    const double step_dt = fine ? substep_dt : dt;
+                    // The current of the last substep is used by the diffusion step
+                    for (unsigned int s = 0; s < n_steps; ++s)
                     {
-                        double I4f = (*I4f_ptr)(dof_indices_V[0]);
-                        Isac = ionicModelPtr->evaluateSAC(values[0], I4f);
+                        model.advanceBatch(variables.data(), Q.data() + run_begin, istim.data() + run_begin, Iion.data() + run_begin, dIion.data() + run_begin, run_end - run_begin, step_dt, M_meshSize);
                     }
-                    Iion += Isac;
+                    if (fine) scratch.substepped_nodes += run_end - run_begin;
+                    run_begin = run_end;
+                }
+            }
+            if (M_reactionMidpointPotential && IonicIntegrator::Native != model.integrator())
+            {
+                // The Rush-Larsen integrators return the current before the update:
+                // the diffusion step needs the one of the updated variables
+                variables[0] = V.data() + begin;
+                for (unsigned int nv = 0; nv < num_vars; ++nv)
+                {
+                    variables[nv + 1] = block.state[nv].data() + begin;
+                }
+                model.evaluateIonicCurrentBatch(variables.data(), istim.data() + begin, Iion.data() + begin, end - begin);
+            }
+            const double current_scaling = model.current_scaling();
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                Iion[i] *= current_scaling;
+                if (!I4f.empty())
+                {
+                    // contains Istim
+                    Iion[i] += model.evaluateSAC(V[i], I4f[i]);
+                }
+            }
+        }
+        else // using SBDF2
+        {
+            // Local values for a single cell
+            std::vector<double>& values = scratch.values;
+            std::vector<double>& old_values = scratch.old_values;
+            std::vector<double>& gating_rhs = scratch.gating_rhs; // First entry is reserved to Q^n
 
-                    iion_system.solution->set(dof_indices_istim[0], Iion); // contains Istim
-                    istim_system.solution->set(dof_indices_istim[0], istim);
-                    istim_system.get_vector("stim_i").set(dof_indices_istim[0], stim_i); //Istim^n+1
-                    istim_system.get_vector("surf_stim_i").set(dof_indices_istim[0], surf_stim_i); //Istim^n+1
-                    istim_system.get_vector("stim_e").set(dof_indices_istim[0], stim_e); //Istim^n+1
-                    istim_system.get_vector("surf_stim_e").set(dof_indices_istim[0], surf_stim_e); //Istim^n+1
+            for (unsigned int i = begin; i < end; ++i)
+            {
+                values[0] = V[i];
+                gating_rhs[0] = Q[i];
+                for (unsigned int nv = 0; nv < num_vars; ++nv)
+                {
+                    values[nv + 1] = block.state[nv][i];
+                    old_values[nv + 1] = values[nv + 1];
+                }
 
-                    iion_system.get_vector("diion").set(dof_indices_istim[0], dIion);
-                    for (int nv = 0; nv < num_vars; ++nv)
+                if (M_timestep_counter >= 0)
+                {
+                    bool overwrite = true;
+                    // Recall: gating_rhs[0] = Q^n
+                    model.updateVariables(values, gating_rhs, istim[i], dt, overwrite);
+                }
+                else
+                {
+                    bool overwrite = false;
+                    // Recall: gating_rhs[0] = Q^n
+                    model.updateVariables(values, gating_rhs, istim[i], dt, overwrite);
+                    for (unsigned int nv = 0; nv < num_vars; ++nv)
                     {
-                        var_index = dof_indices_gating[nv];
-
-                        ionic_model_system.solution->set(var_index, values[nv + 1]);
+                        double f_nm1 = block.rhs_old[nv][i];
+                        double f_n = gating_rhs[nv + 1];
+                        block.rhs_old[nv][i] = f_n;
+                        // Update using SBDF2
+                        // w^n+1 = 4/3 * w^n - 1/3 * w^n-1 + 2/3*dt * (2*f^n - f^n-1)
+                        // w^n+1 = ( 4 * w^n - w^n-1 + 2 * dt * (2*f^n - f^n-1) ) / 3
+                        values[nv + 1] = (4.0 * values[nv + 1] - block.state_old[nv][i] + 2.0 * dt * (2 * f_n - f_nm1)) / 3;
                     }
                 }
-            }
-            c++;
+                // w^n becomes w^n-1
+                for (unsigned int nv = 0; nv < num_vars; ++nv)
+                {
+                    block.state_old[nv][i] = old_values[nv + 1];
+                }
+                Iion[i] = model.current_scaling() * model.evaluateIonicCurrent(values, istim[i], dt);
+                // Recall: gating_rhs[0] = Q^n
+                // HACK: For now, as I've implemented the second order scheme only for a dew ionic models
+                //       I keep everything as it was before I started the implementation of SBDF2
+                if (model.isSecondOrderImplemented()) dIion[i] = model.evaluateIonicCurrentTimeDerivative(values, gating_rhs, dt, M_meshSize);
+                else dIion[i] = model.evaluateIonicCurrentTimeDerivative(values, old_values, dt, M_meshSize);
+
+                if (!I4f.empty())
+                {
+                    // contains Istim
+                    Iion[i] += model.evaluateSAC(values[0], I4f[i]);
+                }
 
+                for (unsigned int nv = 0; nv < num_vars; ++nv)
+                {
+                    block.state[nv][i] = values[nv + 1];
+                }
+            }
         }
-        iion_system.solution->close();
-
-        istim_system.solution->close();
-//    std::cout << "Iion sol: " << std::endl;
-//    iion_system.solution->print();
-//    istim_system.solution->print();
-//    std::cout << "Iion sol: " << std::endl;
-
-        istim_system.get_vector("stim_i").close();
-        istim_system.get_vector("stim_e").close();
-        istim_system.get_vector("surf_stim_i").close();
-        istim_system.get_vector("surf_stim_e").close();
-        iion_system.get_vector("diion").close();
-        iion_system.get_vector("diion_old").close();
+    }
 
-        for (auto && name : M_ionic_models_systems_name_vec)
+    void ElectroSolver::set_reaction_substeps(unsigned int n, double dvdt_threshold)
+    {
+        if (n > 1 && TimeIntegrator::FirstOrderIMEX != M_timeIntegrator)
         {
-            IonicModelSystem& ionic_model_system = M_equationSystems.get_system < IonicModelSystem > (name);
-            ionic_model_system.solution->close();
-            ionic_model_system.get_vector("rhs_old").close();
-            ionic_model_system.rhs->close();
-            ionic_model_system.update();
+            throw std::runtime_error("ElectroSolver: reaction substeps are implemented only for the FirstOrderIMEX time integrator");
         }
-
-        iion_system.update();
-        istim_system.update();
+        M_reactionSubsteps = std::max(n, 1u);
+        M_reactionSubstepThreshold = dvdt_threshold;
     }
 
     void ElectroSolver::solve_reaction_step_dg(double dt, double time, int step, bool useMidpoint, const std::string& mass, libMesh::NumericVector<libMesh::Number>* I4f_ptr)
@@ -22,6 +22,8 @@
 #include "Util/Timer.hpp"
 #include "libmesh/id_types.h"
 #include "BoundaryConditions/BCHandler.hpp"
+#include "Electrophysiology/IonicStateStore.hpp"
+#include "Electrophysiology/ActivationMaps.hpp"
 
 // Forward Definition
 namespace libMesh
@@ -50,6 +52,9 @@ namespace BeatIt
 class BCHandler;
 class IonicModel;
 class PacingProtocol;
+class AsyncVTKWriter;
+class NemesisSeries;
+class CompressedFieldWriter;
 
 enum class Anisotropy { Isotropic,
                         TransverselyIsotropic,
@@ -89,9 +94,63 @@ public:
 
     void restart( EXOExporter& importer, int step = 0, bool restart = true );
     void read_fibers( EXOExporter& importer, int step = 1);
+    //! Binary checkpoint of all the systems (see write_checkpoint)
+    void save_checkpoint(const std::string& filename, double time, int step);
+    //! Restart from a binary checkpoint, on any number of processors
+    /*!
+     *  The time step counter and the time of the systems are restored: the system matrix
+     *  depends on the counter with SBDF2, therefore assemble the matrices after the restart.
+     */
+    void restart_from_checkpoint(const std::string& filename, double& time, int& step);
 
     void init(double time);
     void init_systems(double time);
+    void init_ionic_state_store();
+    //! Rebuild the data that depend on the mesh and on the dof numbering
+    /*!
+     *  Call it after M_equationSystems.reinit() (AMR): the ionic state store is rebuilt,
+     *  the preconditioner and the output writers are reset and the activation maps
+     *  are rebuilt (the current beat starts again).
+     */
+    void mesh_changed();
+    //! Average wall time of the reaction step for one node, in ns
+    double reaction_step_ns_per_node() const
+    {
+        return M_reactionNodeUpdates > 0 ? 1e9 * M_reactionTimer.M_elapsed.count() / M_reactionNodeUpdates : 0.0;
+    }
+    //! Fraction of the node updates of the reaction step done with substeps
+    double reaction_substepped_fraction() const
+    {
+        return M_reactionNodeUpdates > 0 ? static_cast<double>(M_reactionSubsteppedNodes) / M_reactionNodeUpdates : 0.0;
+    }
+    //! Multirate reaction step (FirstOrderIMEX only)
+    /*!
+     *  The state variables of the selected nodes are advanced with n substeps of dt / n,
+     *  keeping the potential at its value at the beginning of the step.
+     *  \param [in] n number of substeps (1: no substeps)
+     *  \param [in] dvdt_threshold only the nodes with |dV/dt| > dvdt_threshold take the substeps,
+     *               dV/dt being estimated from the last two values of the potential.
+     *               With dvdt_threshold <= 0 all the nodes take the substeps.
+     */
+    void set_reaction_substeps(unsigned int n, double dvdt_threshold = 0.0);
+    //! Time step between V^n-1 and V^n, used by the dV/dt estimate of the substeps
+    /*!
+     *  The length of the diffusion step: with the Strang splitting the reaction steps are dt/2.
+     *  With dt <= 0 the time step of the reaction step is used.
+     */
+    void set_reaction_potential_timestep(double dt)
+    {
+        M_reactionPotentialTimestep = dt;
+    }
+    //! The reaction step uses the potential extrapolated at the middle of the step
+    /*!
+     *  V^n+1/2 = V^n + ( V^n - V^n-1 ) / 2 instead of V^n, and the current is evaluated
+     *  at the updated state variables. Used by the Strang splitting (FirstOrderIMEX only)
+     */
+    void set_reaction_midpoint_potential(bool midpoint)
+    {
+        M_reactionMidpointPotential = midpoint;
+    }
     void save(int step);
     void save_exo_timestep(int step, double time);
     void save_ve_timestep(int step, double time);
@@ -101,11 +160,25 @@ public:
     void save_parameters();
     void save_activation_times(int step = 1);
     void save_conduction_velocity(int step = 1);
+    //! Wait until the asynchronous output is written
+    void wait_for_output();
+    //! Update the ghosted solutions of the systems copied by the asynchronous writer
+    void update_exported_systems(const std::set<std::string>& names);
+    //! Append the nodal variables of the systems to the compressed series name_*.bfo
+    void save_compressed(const std::string& name, const std::set<std::string>& system_names, int step, double time);
 
     virtual void amr( libMesh:: MeshRefinement& mesh_refinement, const std::string& type = "kelly" ) {}
     void reinit_linear_solver();
     //void update_pacing(double time);
     void update_activation_time(double time, double threshold = 0.8);
+    //! Update the in-situ activation / repolarization maps (section/activation_maps)
+    /*!
+     *  Call after the diffusion step: the crossings are interpolated between the
+     *  current and the previous call. At the end of each beat the maps are saved.
+     */
+    void update_activation_maps(double time);
+    //! Save the maps of the current beat and start a new one
+    void save_activation_maps();
     void evaluate_conduction_velocity();
 
 
@@ -129,6 +202,18 @@ public:
                               const std::string& mass = "mass",
                               libMesh::NumericVector<libMesh::Number>* I4f_ptr = nullptr);
 
+    //! Reaction step for the nodes [begin, end) of a block of the ionic state store
+    /*!
+     *  Called concurrently on disjoint chunks: thread selects the copy of the ionic model
+     *  and the work space of the block, the values are read from / written to the block
+     *  arrays at the node index.
+     */
+    void solve_reaction_step_chunk( IonicStateStore::Block& block,
+                                    unsigned int thread,
+                                    unsigned int begin,
+                                    unsigned int end,
+                                    double dt );
+
     virtual void solve_reaction_step_dg( double dt,
                               double time,
                               int step = 0,
@@ -137,6 +222,24 @@ public:
                               libMesh::NumericVector<libMesh::Number>* I4f_ptr = nullptr);
 
     virtual void solve_diffusion_step(double dt, double time,  bool useMidpoint = true, const std::string& mass = "lumped_mass", bool reassemble = true) = 0;
+    //! Solve the linear system of the diffusion step
+    /*!
+     *  The preconditioner is built at the first solve and then reused
+     *  until operator_changed() is called (linear_solver/reuse_preconditioner = true).
+     *  The solves building the preconditioner and the ones reusing it are timed separately.
+     */
+    std::pair<unsigned int, double> solve_diffusion_system( libMesh::SparseMatrix<libMesh::Number>& matrix,
+                                                            libMesh::NumericVector<libMesh::Number>& solution,
+                                                            libMesh::NumericVector<libMesh::Number>& rhs,
+                                                            double tol,
+                                                            unsigned int max_iter );
+    //! The matrix of the diffusion step has changed: rebuild the preconditioner at the next solve
+    void operator_changed()
+    {
+        M_rebuildPreconditioner = true;
+    }
+    //! Print the cost of the solves with and without the setup of the preconditioner
+    void print_linear_solver_timings(std::ostream& out = std::cout);
     virtual void generate_fibers(   const GetPot& data,
                             const std::string& section = "rule_based_fibers" ) {}
    double last_activation_time();
@@ -163,6 +266,10 @@ public:
 //    std::unique_ptr<IonicModel> M_ionicModelPtr;
     std::map<unsigned int, std::shared_ptr<IonicModel> > M_ionicModelPtrMap;
     std::map<unsigned int, std::string > M_ionicModelNameMap;
+    /// Structure-of-arrays storage of the ionic model variables used in the reaction step
+    IonicStateStore M_ionicStateStore;
+    /// Activation time, repolarization time and APD of each beat, computed during the run
+    ActivationMaps M_activationMaps;
     /// Equation Systems: One for the potential and one for the other variables
     /*!
      *  Use separate systems to avoid saving in all the variables
@@ -170,7 +277,13 @@ public:
     libMesh::EquationSystems&  M_equationSystems;
 
     std::unique_ptr<Exporter> M_exporter;
-    std::unique_ptr<NemesisIO> M_nemesis_exporter;
+    //! Background writer of the VTK output (section/async_output)
+    std::unique_ptr<AsyncVTKWriter> M_asyncWriter;
+    //! Compressed output series, by name (section/compressed_output)
+    std::map<std::string, std::unique_ptr<CompressedFieldWriter> > M_compressedWriters;
+    bool M_compressedOutput;
+    //! potential.e: the mesh is written once and the time steps are appended
+    std::unique_ptr<NemesisSeries> M_nemesis_exporter;
     std::set<std::string> M_exporterNames;
     std::unique_ptr<Exporter> M_ionicModelExporter;
     std::set<std::string> M_ionicModelExporterNames;
@@ -241,7 +354,24 @@ public:
     void init_endocardial_ve(std::set<libMesh::boundary_id_type>& IDs, std::set<unsigned short>& subdomainIDs);
 
     Timer::duration_Type M_elapsed_time;
+    /// Time spent in the reaction step and number of nodes updated
+    Timer M_reactionTimer;
+    unsigned long M_reactionNodeUpdates;
+    unsigned long M_reactionSubsteppedNodes;
+    /// Multirate reaction step and potential read by the reaction step (see set_reaction_substeps)
+    unsigned int M_reactionSubsteps;
+    double M_reactionSubstepThreshold;
+    double M_reactionPotentialTimestep;
+    bool M_reactionMidpointPotential;
     unsigned int M_num_linear_iters;
+    /// Preconditioner of the diffusion step: reuse it, rebuild it at the next solve
+    bool M_reusePreconditioner;
+    bool M_rebuildPreconditioner;
+    /// Solves building the preconditioner and solves reusing it
+    Timer M_setupSolveTimer;
+    Timer M_reuseSolveTimer;
+    unsigned int M_numSetupSolves;
+    unsigned int M_numReuseSolves;
 
 
 };
@@ -72,6 +72,7 @@ public:
      */
     BistablePiecewiseLinear();
     ~BistablePiecewiseLinear() {};
+    IonicModel* clone() const { return new BistablePiecewiseLinear(*this); }
 
     //! Update all the variables in the ionic model
     /*!
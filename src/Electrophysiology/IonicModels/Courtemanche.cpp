@@ -48,6 +48,7 @@
  */
 
 #include "Electrophysiology/IonicModels/Courtemanche.hpp"
+#include <algorithm>
 #include <cmath>
 
 namespace BeatIt
@@ -201,14 +202,85 @@ double Courtemanche::evaluateIonicCurrent(std::vector<double>& variables,
 		double appliedCurrent, double dt)
 {
     // Itot
-	return itot;
+	return M_cell.itot;
 }
 
 void Courtemanche::updateVariables(std::vector<double>& variables,
 		double appliedCurrent, double dt)
 {
-	this->dt = dt;
 	//istim = -appliedCurrent;
+	cellStep(variables, dt, M_cell);
+}
+
+double Courtemanche::evaluateRates(std::vector<double>& variables,
+		double appliedCurrent, std::vector<double>& rhs, std::vector<double>& jac)
+{
+	// Currents and fluxes at the given state:
+	// with dt = 0 update() leaves the variables unchanged
+	this->dt = 0.0;
+	load_variables(variables);
+	calc_itr();
+	update();
+
+	std::fill(rhs.begin(), rhs.end(), 0.0);
+	std::fill(jac.begin(), jac.end(), 0.0);
+
+	/*  Ion Concentrations */
+	rhs[1] = -naiont * acap / (vmyo * zna * frdy);
+	rhs[2] = -kiont * acap / (vmyo * zk * frdy);
+	rhs[3] = b1cai / b2cai;
+
+	/*  Gate Conditions */
+	rhs[4] = am * (1 - m) - bm * m;
+	jac[4] = -(am + bm);
+	rhs[5] = ah * (1 - h) - bh * h;
+	jac[5] = -(ah + bh);
+	rhs[6] = aj * (1 - j) - bj * j;
+	jac[6] = -(aj + bj);
+	rhs[7] = (dss - d) / taud;
+	jac[7] = -1.0 / taud;
+	rhs[8] = (fss - f) / tauf;
+	jac[8] = -1.0 / tauf;
+	rhs[9] = (xsss - xs) / tauxs;
+	jac[9] = -1.0 / tauxs;
+	rhs[10] = (xrss - xr) / tauxr;
+	jac[10] = -1.0 / tauxr;
+	rhs[11] = (atoss - ato) / tauato;
+	jac[11] = -1.0 / tauato;
+	rhs[12] = (iitoss - iito) / tauiito;
+	jac[12] = -1.0 / tauiito;
+	rhs[13] = (uakurss - uakur) / tauuakur;
+	jac[13] = -1.0 / tauuakur;
+	rhs[14] = (uikurss - uikur) / tauuikur;
+	jac[14] = -1.0 / tauuikur;
+	// as in comp_ical, fca uses tauf
+	rhs[15] = (fcass - fca) / tauf;
+	jac[15] = -1.0 / tauf;
+
+	/*  SR Ca */
+	rhs[17] = (itr - 0.5 * ireljsrol)
+			/ (1 + csqnbar * kmcsqn / pow((jsr + kmcsqn), 2));
+	rhs[18] = iup - ileak - itr * vjsr / vnsr;
+	rhs[22] = (urelss - urel) / tauurel;
+	jac[22] = -1.0 / tauurel;
+	rhs[23] = (vrelss - vrel) / tauvrel;
+	jac[23] = -1.0 / tauvrel;
+	rhs[24] = (wrelss - wrel) / tauwrel;
+	jac[24] = -1.0 / tauwrel;
+	rhs[25] = (yachss - yach) / tauyach;
+	jac[25] = -1.0 / tauyach;
+
+	/*  Algebraic variables */
+	variables[16] = ireljsrol;
+	variables[19] = trpn;
+	variables[20] = cmdn;
+	variables[21] = csqn;
+
+	return itot;
+}
+
+void Courtemanche::load_variables(const std::vector<double>& variables)
+{
 	v = variables[0];
 	/*  Ion Concentrations */
 	nai = variables[1];
@@ -240,38 +312,333 @@ void Courtemanche::updateVariables(std::vector<double>& variables,
 	wrel = variables[24];
 	yach = variables[25];
 	iky = variables[26];
+}
 
-    update();
-	/*  Ion Concentrations */
-	variables[1] = nai;
-	variables[2] = ki;
-	variables[3] = cai;
+template <class Variables>
+BEATIT_CELL_KERNEL void
+Courtemanche::cellStep(Variables& variables, double dt, CellState& cell) const
+{
+	const double v = variables[0];
+	double& nai = variables[1];
+	double& ki = variables[2];
+	double& cai = variables[3];
+	double& m = variables[4];
+	double& h = variables[5];
+	double& j = variables[6];
+	double& d = variables[7];
+	double& f = variables[8];
+	double& xs = variables[9];
+	double& xr = variables[10];
+	double& ato = variables[11];
+	double& iito = variables[12];
+	double& uakur = variables[13];
+	double& uikur = variables[14];
+	double& fca = variables[15];
+	double& ireljsrol = variables[16];
+	double& jsr = variables[17];
+	double& nsr = variables[18];
+	double& trpn = variables[19];
+	double& cmdn = variables[20];
+	double& csqn = variables[21];
+	double& urel = variables[22];
+	double& vrel = variables[23];
+	double& wrel = variables[24];
+	double& yach = variables[25];
+
+	const double RTF = (R * temp) / frdy;
+	const double itr = (nsr - jsr) / tautr;
+
+	/* Fast Na Current */
+	const double gna = 7.8;
+	const double ena = RTF * std::log(nao / nai);
+	const double am = 0.32 * (v + 47.13) / (1 - std::exp(-0.1 * (v + 47.13)));
+	const double bm = 0.08 * std::exp(-v / 11);
+	// The branches are selections, so that the cell loop vectorizes
+	const bool below = v < -40;
+	const double ah = below ? 0.135 * std::exp((80 + v) / -6.8) : 0.0;
+	const double bh = below ? 3.56 * std::exp(0.079 * v) + 310000 * std::exp(0.35 * v)
+	                        : 1 / (0.13 * (1 + std::exp((v + 10.66) / -11.1)));
+	const double aj = below ? (-127140 * std::exp(0.2444 * v) - 0.00003474 * std::exp(-0.04391 * v))
+	                          * ((v + 37.78) / (1 + std::exp(0.311 * (v + 79.23))))
+	                        : 0.0;
+	const double bj = below ? (0.1212 * std::exp(-0.01052 * v)) / (1 + std::exp(-0.1378 * (v + 40.14)))
+	                        : (0.3 * std::exp(-0.0000002535 * v)) / (1 + std::exp(-0.1 * (v + 32)));
+	h = ah / (ah + bh) - ((ah / (ah + bh)) - h) * std::exp(-dt / (1 / (ah + bh)));
+	j = aj / (aj + bj) - ((aj / (aj + bj)) - j) * std::exp(-dt / (1 / (aj + bj)));
+	m = am / (am + bm) - ((am / (am + bm)) - m) * std::exp(-dt / (1 / (am + bm)));
+	const double ina = gna * m * m * m * h * j * (v - ena);
+
+	/* L-Type Ca Channel */
+	const double dss = 1 / (1 + std::exp(-(v + 10) / 8));
+	const double taud = (1 - std::exp((v + 10) / -6.24))
+			/ (0.035 * (v + 10) * (1 + std::exp((v + 10) / -6.24)));
+	const double fss = 1 / (1 + std::exp((v + 28) / 6.9));
+	const double tauf = 9 / (0.0197 * std::exp(-std::pow((0.0337 * (v + 10)), 2)) + 0.02);
+	const double fcass = 1 / (1 + cai / 0.00035);
+	d = dss - (dss - d) * std::exp(-dt / taud);
+	f = fss - (fss - f) * std::exp(-dt / tauf);
+	fca = fcass - (fcass - fca) * std::exp(-dt / tauf);
+	const double ibarca = gcalbar * (v - 65);
+	const double ilca = d * f * fca * ibarca;
+
+	/* K currents: the reversal potentials are the same */
+	const double ek = RTF * std::log(ko / ki);
+
+	/* Rapidly Activating K Current */
+	const double gkr = 0.0294 * std::sqrt(ko / 5.4);
+	const double xrss = 1 / (1 + std::exp(-(v + 14.1) / 6.5));
+	const double tauxr = 1
+			/ (0.0003 * (v + 14.1) / (1 - std::exp(-(v + 14.1) / 5))
+					+ 0.000073898 * (v - 3.3328)
+							/ (std::exp((v - 3.3328) / 5.1237) - 1));
+	xr = xrss - (xrss - xr) * std::exp(-dt / tauxr);
+	const double r = 1 / (1 + std::exp((v + 15) / 22.4));
+	const double ikr = gkr * xr * r * (v - ek);
+
+	/* Slowly Activating K Current */
+	const double gks = 0.129;
+	const double tauxs = 0.5
+			/ (0.00004 * (v - 19.9) / (1 - std::exp(-(v - 19.9) / 17))
+					+ 0.000035 * (v - 19.9) / (std::exp((v - 19.9) / 9) - 1));
+	const double xsss = 1 / std::pow((1 + std::exp(-(v - 19.9) / 12.7)), 0.5);
+	xs = xsss - (xsss - xs) * std::exp(-dt / tauxs);
+	const double iks = gks * xs * xs * (v - ek);
+
+	/* Time-Independent K Current */
+	const double gki = 0.09 * std::pow(ko / 5.4, 0.4);
+	const double kin = 1 / (1 + std::exp(0.07 * (v + 80)));
+	const double iki = gki * kin * (v - ek);
+
+	/* Acetylcholine-sensitive K Current */
+	const double gkach = 0.135;
+	const double alphayach = 1.232e-2 / (1 + 0.0042 / ach) + 0.0002475;
+	const double betayach = 0.01 * std::exp(0.0133 * (v + 40));
+	const double tauyach = 1 / (alphayach + betayach);
+	const double yachss = alphayach / (alphayach + betayach);
+	yach = yachss - (yachss - yach) * std::exp(-dt / tauyach);
+	const double ikach = gkach * yach * (v - ek) / (1 + std::exp((v + 20) / 20));
+
+	/* Ultra-Rapidly Activating K Current */
+	const double gkur = 0.005 + 0.05 / (1 + std::exp(-(v - 15) / 13));
+	const double alphauakur = 0.65 / (std::exp(-(v + 10) / 8.5) + std::exp(-(v - 30) / 59.0));
+	const double betauakur = 0.65 / (2.5 + std::exp((v + 82) / 17.0));
+	const double tauuakur = 1 / (3 * (alphauakur + betauakur));
+	const double uakurss = 1 / (1 + std::exp(-(v + 30.3) / 9.6));
+	const double alphauikur = 1 / (21 + std::exp(-(v - 185) / 28));
+	const double betauikur = std::exp((v - 158) / 16);
+	const double tauuikur = 1 / (3 * (alphauikur + betauikur));
+	const double uikurss = 1 / (1 + std::exp((v - 99.45) / 27.48));
+	uakur = uakurss - (uakurss - uakur) * std::exp(-dt / tauuakur);
+	uikur = uikurss - (uikurss - uikur) * std::exp(-dt / tauuikur);
+	const double ikur = gkur * uakur * uakur * uakur * uikur * (v - ek);
+
+	/* Transient Outward Current */
+	const double gito = 0.1652;
+	const double alphaato = 0.65 / (std::exp(-(v + 10) / 8.5) + std::exp(-(v - 30) / 59));
+	const double betaato = 0.65 / (2.5 + std::exp((v + 82) / 17));
+	const double tauato = 1 / (3 * (alphaato + betaato));
+	const double atoss = 1 / (1 + std::exp(-(v + 20.47) / 17.54));
+	ato = atoss - (atoss - ato) * std::exp(-dt / tauato);
+	const double alphaiito = 1 / (18.53 + std::exp((v + 113.7) / 10.95));
+	const double betaiito = 1 / (35.56 + std::exp(-(v + 1.26) / 7.44));
+	const double tauiito = 1 / (3 * (alphaiito + betaiito));
+	const double iitoss = 1 / (1 + std::exp((v + 43.1) / 5.3));
+	iito = iitoss - (iitoss - iito) * std::exp(-dt / tauiito);
+	const double ito = gito * ato * ato * ato * iito * (v - ek);
+
+	/* Na-Ca Exchanger */
+	const double inaca = 1750
+			* (std::exp(gammas * frdy * v / (R * temp)) * nai * nai * nai * cao
+					- std::exp((gammas - 1) * frdy * v / (R * temp)) * nao * nao * nao * cai)
+			/ ((std::pow(kmnancx, 3) + std::pow(nao, 3)) * (kmcancx + cao)
+					* (1 + ksatncx * std::exp((gammas - 1) * frdy * v / (R * temp))));
+
+	/* Na-K Pump */
+	const double fnak = (v + 150) / (v + 200);
+	const double inak = ibarnak * fnak * (1 / (1 + std::pow((kmnai / nai), 1.5)))
+			* (ko / (ko + kmko));
 
-	/*  Gate Conditions */
-	variables[4] = m;
-	variables[5] = h;
-	variables[6] = j;
-	variables[7] = d;
-	variables[8] = f;
-	variables[9] = xs;
-	variables[10] = xr;
-	variables[11] = ato;
-	variables[12] = iito;
-	variables[13] = uakur;
-	variables[14] = uikur;
-	variables[15] = fca;
-	variables[16] = ireljsrol;
+	/* Sarcolemmal Ca Pump */
+	const double ipca = (ibarpca * cai) / (kmpca + cai);
+
+	/* Ca and Na Background Currents */
+	const double gcab = 0.00113;
+	const double ecan = RTF * std::log(cao / cai);
+	const double icab = gcab * (v - ecan);
+	const double gnab = 0.000674;
+	const double inab = gnab * (v - ena);
+
+	/* Total Current */
+	const double naiont = ina + inab + 3 * inak + 3 * inaca + 1.5e-2;
+	const double kiont = ikr + iks + iki - 2 * inak + ito + ikur + ikach + 1.5e-2;
+	const double caiont = ilca + icab + ipca - 2 * inaca;
+	cell.itot = naiont + kiont + caiont;
+	cell.ena = ena;
+	cell.ek = ek;
+
+	/* Concentrations */
+	nai += -dt * naiont * acap / (vmyo * zna * frdy);
+	ki += -dt * kiont * acap / (vmyo * zk * frdy);
+
+	const double ileak = iupbar / nsrbar * nsr;
+	const double iup = iupbar * cai / (cai + kmup);
+	csqn = csqnbar * (jsr / (jsr + kmcsqn));
+	nsr += dt * (iup - ileak - itr * vjsr / vnsr);
+
+	const double fn = vjsr * (1e-12) * ireljsrol - (1e-12) * caiont * acap / (2 * frdy);
+	const double tauurel = 8.0;
+	const double urelss = 1 / (1 + std::exp(-(fn - 3.4175e-13) / 13.67e-16));
+	const double tauvrel = 1.91 + 2.09 / (1 + std::exp(-(fn - 3.4175e-13) / 13.67e-16));
+	const double vrelss = 1 - 1 / (1 + std::exp(-(fn - 6.835e-14) / 13.67e-16));
+	const double tauwrel = 6.0 * (1 - std::exp(-(v - 7.9) / 5))
+			/ ((1 + 0.3 * std::exp(-(v - 7.9) / 5)) * (v - 7.9));
+	const double wrelss = 1 - 1 / (1 + std::exp(-(v - 40) / 17));
+	urel = urelss - (urelss - urel) * std::exp(-dt / tauurel);
+	vrel = vrelss - (vrelss - vrel) * std::exp(-dt / tauvrel);
+	wrel = wrelss - (wrelss - wrel) * std::exp(-dt / tauwrel);
+	ireljsrol = grelbarjsrol * urel * urel * vrel * wrel * (jsr - cai);
+	jsr += dt * (itr - 0.5 * ireljsrol)
+			/ (1 + csqnbar * kmcsqn / std::pow((jsr + kmcsqn), 2));
 
-	variables[17] = jsr;
-	variables[18] = nsr;
-	variables[19] = trpn;
-	variables[20] = cmdn;
-	variables[21] = csqn;
-	variables[22] = urel;
-	variables[23] = vrel;
-	variables[24] = wrel;
-	variables[25] = yach;
-	variables[26] = iky;
+	trpn = trpnbar * (cai / (cai + kmtrpn));
+	cmdn = cmdnbar * (cai / (cai + kmcmdn));
+	const double b1cai = -caiont * acap / (2 * frdy * vmyo)
+			+ (vnsr * (ileak - iup) + 0.5 * ireljsrol * vjsr) / vmyo;
+	const double b2cai = 1 + trpnbar * kmtrpn / std::pow((cai + kmtrpn), 2)
+			+ cmdn * kmcmdn / std::pow((cai + kmcmdn), 2);
+	cai += dt * b1cai / b2cai;
+}
+
+template <class Variables, class OldVariables>
+BEATIT_CELL_KERNEL double
+Courtemanche::cellTimeDerivative(Variables& variables, OldVariables& old_variables,
+		double dt, const CellState& cell) const
+{
+	const double qn = old_variables[0];
+	const double v = variables[0];
+	const double nai = variables[1];
+	const double ki = variables[2];
+	const double cai = variables[3];
+	const double m = variables[4];
+	const double h = variables[5];
+	const double j = variables[6];
+	const double d = variables[7];
+	const double f = variables[8];
+	const double xr = variables[10];
+	const double ato = variables[11];
+	const double iito = variables[12];
+	const double uakur = variables[13];
+	const double uikur = variables[14];
+	const double fca = variables[15];
+	const double yach = variables[25];
+	const double dnai = (variables[1] - old_variables[1]) / dt;
+	const double dki = (variables[2] - old_variables[2]) / dt;
+	const double dcai = (variables[3] - old_variables[3]) / dt;
+	const double dm = (variables[4] - old_variables[4]) / dt;
+	const double dh = (variables[5] - old_variables[5]) / dt;
+	const double dj = (variables[6] - old_variables[6]) / dt;
+	const double dd = (variables[7] - old_variables[7]) / dt;
+	const double df = (variables[8] - old_variables[8]) / dt;
+	const double dxs = (variables[9] - old_variables[9]) / dt;
+	const double dxr = (variables[10] - old_variables[10]) / dt;
+	const double dato = (variables[11] - old_variables[11]) / dt;
+	const double diito = (variables[12] - old_variables[12]) / dt;
+	const double duakur = (variables[13] - old_variables[13]) / dt;
+	const double duikur = (variables[14] - old_variables[14]) / dt;
+	const double dfca = (variables[15] - old_variables[15]) / dt;
+	const double dyach = (variables[25] - old_variables[25]) / dt;
+
+	const double RTF = (R * temp) / frdy;
+	const double ena = cell.ena;
+	const double ek = cell.ek;
+	// The reversal potentials depend on the concentrations as RTF log(c_o / c)
+	const double dena = -RTF / nai;
+	const double dek = -RTF / ki;
+
+	// Ina depends on v, nai, m, h, j
+	const double gna = 7.8;
+	const double dina = gna * m * m * m * h * j * qn - gna * m * m * m * h * j * dena * dnai
+			+ 3 * gna * m * m * h * j * (v - ena) * dm + gna * m * m * m * j * (v - ena) * dh
+			+ gna * m * m * m * h * (v - ena) * dj;
+
+	// Ical depends on v, d, f, fca
+	const double ibarca = gcalbar * (v - 65);
+	const double dical = d * f * fca * gcalbar * qn + f * fca * ibarca * dd
+			+ d * fca * ibarca * df + d * f * ibarca * dfca;
+
+	// Ikr depends on v, ki, xr and r = r(v)
+	const double gkr = 0.0294 * std::sqrt(ko / 5.4);
+	const double r = 1 / (1 + std::exp((v + 15) / 22.4));
+	const double aux_r = std::exp((15 + v) / 22.4);
+	const double drdv = -aux_r / (22.4 * (aux_r + 1) * (aux_r + 1));
+	const double dikr = gkr * xr * r * qn - gkr * xr * r * dek * dki + gkr * r * (v - ek) * dxr
+			+ gkr * (v - ek) * drdv * qn;
+	// As in the original implementation, the Iks term uses the one of Ikr with dxs
+	const double diks = gkr * xr * r * qn - gkr * xr * r * dek * dki + gkr * r * (v - ek) * dxs
+			+ gkr * (v - ek) * drdv * qn;
+
+	// Iki depends on v, ki and kin = kin(v)
+	const double gki = 0.09 * std::pow(ko / 5.4, 0.4);
+	const double kin = 1 / (1 + std::exp(0.07 * (v + 80)));
+	const double aux_kin = std::exp(0.07 * (80 + v));
+	const double dkindv = -(0.07 * aux_kin) / (aux_kin + 1) / (aux_kin + 1);
+	const double diki = gki * kin * qn - gki * kin * dek * dki + gki * (v - ek) * dkindv * qn;
+
+	// Ikach depends on v, ki, yach
+	const double gkach = 0.135;
+	const double aux_ach = std::exp((v + 20) / 20);
+	const double dikach = (gkach * yach / (1 + aux_ach)
+			- gkach * yach * (v - ek) / (1 + aux_ach) / (1 + aux_ach) / 20) * qn
+			- gkach * yach * dek / (1 + aux_ach) * dki
+			+ gkach * (v - ek) / (1 + aux_ach) * dyach;
+
+	// Ikur depends on v, ki, uakur, uikur and gkur = gkur(v)
+	const double aux_kur = std::exp(-(v - 15) / 13);
+	const double gkur = 0.005 + 0.05 / (1 + aux_kur);
+	const double dgkurdv = -0.05 * aux_kur / (1 + aux_kur) / (1 + aux_kur) * (-1.0 / 13);
+	const double dikur = gkur * uakur * uakur * uakur * uikur * qn
+			- gkur * uakur * uakur * uakur * uikur * dek * dki
+			+ 3 * gkur * uakur * uakur * uikur * (v - ek) * duakur
+			+ gkur * uakur * uakur * uakur * (v - ek) * duikur
+			+ uakur * uakur * uakur * uikur * (v - ek) * dgkurdv * qn;
+
+	// Ito depends on v, ki, ato, iito
+	const double gito = 0.1652;
+	const double dito = gito * ato * ato * ato * iito * qn - gito * ato * ato * ato * iito * dek * dki
+			+ 3 * gito * ato * ato * iito * (v - ek) * dato + gito * ato * ato * ato * (v - ek) * diito;
+
+	// Inaca depends on v, nai, cai
+	const double ev = std::exp(gammas * frdy * v / (R * temp));
+	const double dev = gammas * frdy / (R * temp) * ev;
+	const double ev2 = std::exp((gammas - 1) * frdy * v / (R * temp));
+	const double dev2 = (gammas - 1) * frdy / (R * temp) * ev2;
+	const double num = 1750 * (ev * nai * nai * nai * cao - ev2 * nao * nao * nao * cai);
+	const double den = (std::pow(kmnancx, 3) + std::pow(nao, 3)) * (kmcancx + cao) * (1 + ksatncx * ev2);
+	const double ddendev2 = (std::pow(kmnancx, 3) + std::pow(nao, 3)) * (kmcancx + cao) * ksatncx;
+	const double dIdev = 1750 * nai * nai * nai * cao / den;
+	const double dIdev2 = -1750 * nao * nao * nao * cai / den - num / den / den * ddendev2;
+	const double dinaca = (dIdev * dev + dIdev2 * dev2) * qn
+			+ 1750 * (3 * ev * nai * nai * cao) / den * dnai
+			- 1750 * ev2 * nao * nao * nao / den * dcai;
+
+	// Inak depends on v, nai
+	const double fnak = (v + 150) / (v + 200);
+	const double dfnakdv = 1.0 / (v + 200) - (v + 150) / (v + 200) / (v + 200);
+	const double den_nak = (1 + std::pow((kmnai / nai), 1.5));
+	const double dden_nak = -1.5 * (den_nak - 1) / nai;
+	const double dinak = ibarnak * (1 / den_nak) * (ko / (ko + kmko)) * dfnakdv * qn
+			+ ibarnak * fnak * (ko / (ko + kmko)) * (-1.0 / den_nak / den_nak) * dden_nak * dnai;
+
+	// Ipca depends on cai
+	const double dipca = (ibarpca / (kmpca + cai) - (ibarpca * cai) / (kmpca + cai) / (kmpca + cai)) * dcai;
+
+	// Icab and Inab
+	const double gcab = 0.00113;
+	const double dicab = gcab * qn - gcab * (-RTF / cai) * dcai;
+	const double gnab = 0.000674;
+	const double dinab = gnab * qn - gnab * dena * dnai;
+
+	return dina + dical + dikr + diks + diki + dikach + dikur + dito + dinaca + dinak + dipca + dicab + dinab;
 }
 
 
@@ -337,25 +704,6 @@ void Courtemanche::comp_ina()
 }
 
 
-double Courtemanche::comp_d_ina(double qn, double dNai, double dm, double dh, double dj)
-{
-    // Ina depends on
-    // v
-    // Nai
-    // m
-    // h
-    // j
-
-    // dIna = dIdv * qn+ dIdNai *dNai + dIdm * dm + dIdh * dh + dIdj * dj
-    double dIdv = gna * m * m * m * h * j;
-    double dena = - ((R * temp) / frdy) / nai;
-    double dIdNai = - gna * m * m * m * h * j * dena;
-    double dIdm = 3 * gna * m * m * h * j * (v - ena);
-    double dIdh = gna * m * m * m * j * (v - ena);
-    double dIdj = gna * m * m * m * h * (v - ena);
-    return dIdv * qn+ dIdNai *dNai + dIdm * dm + dIdh * dh + dIdj * dj;
-}
-
 void Courtemanche::comp_ical()
 {
 	dss = 1 / (1 + exp(-(v + 10) / 8));
@@ -379,22 +727,6 @@ void Courtemanche::comp_ical()
 	ilcatot = ilca;
 }
 
-double Courtemanche::comp_d_ical(double qn, double dd, double df, double dfca)
-{
-    // Ical depends on
-    // v
-    // d
-    // f
-    // fca
-
-    // dIcal = dIdv * qn + dIdd * dd + dIdf * df + dIdfca * dfca
-    double dIdv = d * f * fca * gcalbar;
-    double dIdd = f * fca * ibarca;
-    double dIdf = d * fca * ibarca;
-    double dIdfca = d * f * ibarca;
-    return  dIdv * qn + dIdd * dd + dIdf * df + dIdfca * dfca;
-}
-
 
 void Courtemanche::comp_ikr()
 {
@@ -414,26 +746,6 @@ void Courtemanche::comp_ikr()
 	ikr = gkr * xr * r * (v - ekr);
 }
 
-double Courtemanche::comp_d_ikr(double qn, double dki, double dxr)
-{
-    // Ikr depends on
-    // v
-    // ki
-    // xr
-    // r = r(v)
-
-    // dIkr = dIdv * qn + dIdki * dki + dIdxr * dxr + dIdr * drdv * qn
-    double dIdv = gkr * xr * r ;
-    double dekr = - ((R * temp) / frdy) / ki;
-    double dIdki = - gkr * xr * r * dekr;
-    double dIdxr = gkr * r * (v - ekr);
-    // auxiliary variable
-    double aux = exp((15 + v)/22.4);
-    double drdv = -aux/(22.4*(aux + 1)*(aux + 1));
-    double dIdr = gkr * (v - ekr);
-    return dIdv * qn + dIdki * dki + dIdxr * dxr + dIdr * drdv * qn;
-}
-
 void Courtemanche::comp_iks()
 {
 	gks = 0.129;
@@ -447,21 +759,6 @@ void Courtemanche::comp_iks()
 	iks = gks * xs * xs * (v - eks);
 }
 
-double Courtemanche::comp_d_iks(double qn, double dki, double dxs)
-{
-    // Iks depends on
-    // v
-    // ki
-    // xs
-
-    // dIks = dIdv * qn + dIdki * dki + dIdxs * dxs
-    double dIdv = gks * xs * xs;
-    double deks = - ((R * temp) / frdy) / ki;
-    double dIdki = -gks * xs * xs * deks;
-    double dIdxs = 2 * gks * xs * (v - eks);
-    return dIdv * qn + dIdki * dki + dIdxs * dxs;
-}
-
 void Courtemanche::comp_iki()
 {
 	gki = 0.09 * pow(ko / 5.4, 0.4);
@@ -489,22 +786,6 @@ void Courtemanche::comp_iki()
 }
 
 
-double Courtemanche::comp_d_iki(double qn, double dki)
-{
-    // Iki depends on
-    // v
-    // ki
-
-    // dIki = dIdv * qn + dIdki * dki + dIdkin * dkindv * qn
-    double deki = - ((R * temp) / frdy) / ki;
-    double dIdv =  gki * kin;
-    double dIdki = - gki * kin * deki;
-    double dIdkin =  gki * (v - eki);
-    double aux = exp(0.07*(80 + v));
-    double dkindv = -(0.07*aux)/(aux + 1)/(aux + 1);
-    return dIdv * qn + dIdki * dki + dIdkin * dkindv * qn;
-}
-
 void Courtemanche::comp_ikach()
 {
 	gkach = 0.135;
@@ -518,25 +799,6 @@ void Courtemanche::comp_ikach()
 	ikach = gkach * yach * (v - ekach) / (1 + exp((v + 20) / 20));
 }
 
-double Courtemanche::comp_d_ikach(double qn, double dki, double dyach)
-{
-    // I depends on
-    // v
-    // ki
-    // yach
-
-    // dIki = dIdv * qn + dIdki * dki + dIdyach  dyach
-    double aux = exp((v + 20) / 20);
-    double dekach = - ((R * temp) / frdy) / ki;
-    double dIdki = - gkach * yach * dekach / (1 + aux);
-
-    double dIdyach = gkach * (v - ekach) / (1 + aux);
-
-    double dIdv =  gkach * yach / (1 + aux)
-                -  gkach * yach * (v - ekach) / (1 + aux) / (1 + aux) / 20;
-    return  dIdv * qn + dIdki * dki + dIdyach * dyach;
-}
-
 void Courtemanche::comp_ikur()
 {
 	gkur = 0.005 + 0.05 / (1 + exp(-(v - 15) / 13));
@@ -556,33 +818,6 @@ void Courtemanche::comp_ikur()
 	ikur = gkur * uakur * uakur * uakur * uikur * (v - ekur);
 }
 
-double Courtemanche::comp_d_ikur(double qn, double dki, double duakur, double duikur)
-{
-    // I depends on
-    // v
-    // ki
-    // uakur
-    // uikur
-
-    // dIki = dIdv * qn + dIdki * dki + dIdyach  dyach + dIdgkur * dgkurdv * qn
-    double dekur = - ((R * temp) / frdy) / ki;
-    double dIdki = -gkur * uakur * uakur * uakur * uikur * dekur;
-
-    double dIduakur =  3 * gkur * uakur * uakur * uikur * (v - ekur);
-    double dIduikur =  gkur * uakur * uakur * uakur * (v - ekur);
-
-    double dIdv =  gkur * uakur * uakur * uakur * uikur;
-
-    double dIdgkur = uakur * uakur * uakur * uikur * (v - ekur);
-    //     gkur = 0.005 + 0.05 / (1 + exp(-(v - 15) / 13));
-    double aux =  exp(-(v - 15) / 13);
-
-    //daux =
-    double daux = -1.0/13;
-    double dgkurdv =  - 0.05 * aux / (1 + aux) / (1 + aux) * daux;
-    return  dIdv * qn + dIdki * dki + dIduakur * duakur + dIduikur * duikur + dIdgkur * dgkurdv * qn;
-}
-
 void Courtemanche::comp_ito()
 {
 	gito = 0.1652;
@@ -603,21 +838,6 @@ void Courtemanche::comp_ito()
 	ito = gito * ato * ato * ato * iito * (v - erevto);
 }
 
-double Courtemanche::comp_d_ito(double qn, double dki, double dato, double diito)
-{
-    // I depends on
-    // v
-    // ki
-    // ato
-    // iito
-    double dIdv = gito * ato * ato * ato * iito;
-    double derevto = - ((R * temp) / frdy) / ki;
-    double dIdki = - gito * ato * ato * ato * iito * derevto;
-    double dIdato = 3 * gito * ato * ato * iito * (v - erevto);
-    double dIdiito =  gito * ato * ato * ato * (v - erevto);
-    return dIdv * qn  + dIdki * dki + dIdato * dato + dIdiito * diito;
-}
-
 void Courtemanche::comp_inaca()
 {
     // Inaca depends on v, nai, cai
@@ -635,36 +855,6 @@ void Courtemanche::comp_inaca()
 															/ (R * temp))));
 }
 
-double Courtemanche::comp_d_inaca(double qn, double dnai, double dcai)
-{
-    // Inaca depends on v, nai, cai
-
-
-    //
-    // Inaca =  1750 * ( ev * nai^3 * cao - ev2 * nao^3 * cai )
-    //           ----------------------------------------------
-    //          (nao^3+ kmnancx^3)*(kmcancx + cao)*(1+ksatncx*ev2)
-    //
-
-    // ev = exp(gammas * frdy * v / (R * temp))
-    double ev =  exp(gammas * frdy * v / (R * temp));
-    double dev = gammas * frdy / (R * temp) * ev;
-
-    double ev2 = exp((gammas - 1) * frdy * v / (R * temp));
-    double dev2 = (gammas - 1) * frdy / (R * temp) * ev2;
-
-    double num = 1750 * (ev* nai * nai * nai* cao - ev2 * nao * nao * nao * cai);
-    double den = (pow(kmnancx, 3) + pow(nao, 3)) * (kmcancx + cao) * (1 + ksatncx * ev2);
-    double ddendev2 = (pow(kmnancx, 3) + pow(nao, 3)) * (kmcancx + cao) * ksatncx;
-    double dIdev = 1750 * nai * nai * nai * cao / den;
-    double dIdev2= - 1750 * nao * nao * nao * cai / den - num / den / den * ddendev2;
-    double dIdv = dIdev * dev + dIdev2 * dev2;
-
-    double dIdnai = 1750 * ( 3 * ev* nai * nai* cao ) / den;
-    double dIdcai = - 1750 * ev2 * nao * nao * nao / den;
-    return dIdv * qn + dIdnai * dnai + dIdcai * dcai;
-}
-
 void Courtemanche::comp_inak()
 {
 	sigma = (exp(nao / 67.3) - 1) / 7;
@@ -675,28 +865,11 @@ void Courtemanche::comp_inak()
 			* (ko / (ko + kmko));
 }
 
-double Courtemanche::comp_d_inak(double qn, double dnai)
-{
-    double dfnakdv = 1.0 / (v + 200) - (v + 150) / (v + 200) / (v + 200);
-    double den = (1 + pow((kmnai / nai), 1.5));
-    double dIdfnak = ibarnak * (1 / den)* (ko / (ko + kmko));
-
-    double dden = -1.5*(den-1) / nai;
-
-    double dIdnai = ibarnak * fnak * (ko / (ko + kmko)) * (-1.0/den/den)*dden;
-    return dIdfnak * dfnakdv * qn + dIdnai * dnai;
-}
-
 void Courtemanche::comp_ipca()
 {
 	ipca = (ibarpca * cai) / (kmpca + cai);
 }
 
-double Courtemanche::comp_d_ipca(double dcai)
-{
-    return  (ibarpca/ (kmpca + cai) - (ibarpca * cai) / (kmpca + cai) / (kmpca + cai) ) * dcai;
-}
-
 void Courtemanche::comp_icab()
 {
 	gcab = 0.00113;
@@ -706,14 +879,6 @@ void Courtemanche::comp_icab()
 }
 
 
-double Courtemanche::comp_d_icab(double qn, double dcai)
-{
-    double dIdv = gcab;
-    double decan = - ((R * temp) / frdy) / cai;
-    double dIdcai = - gcab * decan;
-    return dIdv * qn + dIdcai * dcai;
-}
-
 
 void Courtemanche::comp_inab()
 {
@@ -723,14 +888,6 @@ void Courtemanche::comp_inab()
 	inab = gnab * (v - enan);
 }
 
-double Courtemanche::comp_d_inab(double qn, double dnai)
-{
-    double denan = -((R * temp) / frdy) / nai;
-    double dIdv = gnab;
-    double dIdnai = - gnab * denan;
-    return dIdv * qn + dIdnai * dnai;
-}
-
 /* Total sum of currents is calculated here, if the time is between stimtime = 0 and stimtime = 0.5, a stimulus is applied */
 void Courtemanche::comp_it()
 {
@@ -820,84 +977,55 @@ Courtemanche::evaluateIonicCurrentTimeDerivative(std::vector<double>& variables,
         std::vector<double>& old_variables, double dt,
         double h )
 {
-    //istim = -appliedCurrent;
-    double qn = old_variables[0];
-//    v = variables[0];
-//    /*  Ion Concentrations */
-    double dnai = ( variables[1] - old_variables[1] ) / dt;
-//    ki = variables[2];
-    double dki = ( variables[2] - old_variables[2] ) / dt;
-//    cai = variables[3];
-    double dcai = ( variables[3] - old_variables[3] ) / dt;
-//
-//    /*  Gate Conditions */
-//    m = variables[4];
-    double dm = ( variables[4] - old_variables[4] ) / dt;
-//    h = variables[5];
-    double dh = ( variables[5] - old_variables[5] ) / dt;
-//    j = variables[6];
-    double dj = ( variables[6] - old_variables[6] ) / dt;
-//    d = variables[7];
-    double dd = ( variables[7] - old_variables[7] ) / dt;
-//    f = variables[8];
-    double df = ( variables[8] - old_variables[8] ) / dt;
-//    xs = variables[9];
-    double dxs = ( variables[9] - old_variables[9] ) / dt;
-//    xr = variables[10];
-    double dxr = ( variables[10] - old_variables[10] ) / dt;
-//    ato = variables[11];
-    double dato = ( variables[11] - old_variables[11] ) / dt;
-//    iito = variables[12];
-    double diito = ( variables[12] - old_variables[12] ) / dt;
-//    uakur = variables[13];
-    double duakur = ( variables[13] - old_variables[13] ) / dt;
-//    uikur = variables[14];
-    double duikur = ( variables[14] - old_variables[14] ) / dt;
-//    fca = variables[15];
-    double dfca = ( variables[15] - old_variables[15] ) / dt;
-//    ireljsrol = variables[16];
-    double direljsrol = ( variables[16] - old_variables[16] ) / dt;
-//
-//    jsr = variables[17];
-    double djsr = ( variables[17] - old_variables[17] ) / dt;
-//    nsr = variables[18];
-    double dnsr = ( variables[18] - old_variables[18] ) / dt;
-//    trpn = variables[19];
-    double dtrpn = ( variables[19] - old_variables[19] ) / dt;
-//    cmdn = variables[20];
-    double dcmdn = ( variables[20] - old_variables[20] ) / dt;
-//    csqn = variables[21];
-    double dcsqn = ( variables[21] - old_variables[21] ) / dt;
-//    urel = variables[22];
-    double durel = ( variables[22] - old_variables[22] ) / dt;
-//    vrel = variables[23];
-    double dvrel = ( variables[23] - old_variables[23] ) / dt;
-//    wrel = variables[24];
-    double dwrel = ( variables[24] - old_variables[24] ) / dt;
-//    yach = variables[25];
-    double dyach = ( variables[25] - old_variables[25] ) / dt;
-//    iky = variables[26];
-    double diky = ( variables[26] - old_variables[26] ) / dt;
-
-    double dItot = 0.0;
-    dItot += comp_d_ina(qn, dnai, dm, dh, dj);
-    dItot += comp_d_ical(qn, dd, df, dfca);
-    dItot += comp_d_ikr(qn, dki, dxr);
-    dItot += comp_d_ikr(qn, dki, dxs);
-    dItot += comp_d_iki(qn, dki);
-    dItot += comp_d_ikach(qn, dki, dyach);
-    dItot += comp_d_ikur(qn, dki, duakur, duikur);
-    dItot += comp_d_ito(qn, dki, dato, diito);
-    dItot += comp_d_inaca(qn, dnai, dcai);
-    dItot += comp_d_inak(qn, dnai);
-    dItot += comp_d_ipca(dcai);
-    dItot += comp_d_icab(qn, dcai);
-    dItot +=  comp_d_inab( qn,  dnai);
-
-    return dItot;
+    return cellTimeDerivative(variables, old_variables, dt, M_cell);
 }
 
-
-
+void
+Courtemanche::updateVariablesBatch( double * const * variables,
+                                    const double * Q,
+                                    const double * appliedCurrent,
+                                    double * iion,
+                                    double * diion,
+                                    int n,
+                                    double dt,
+                                    double h )
+{
+    // The derivative uses the variables at the beginning of the step:
+    // Q^n is not passed in old_variables[0] (see IonicModel::updateVariablesBatch)
+    // The work vectors grow to the largest batch and are not allocated again
+    if (diion)
+    {
+        if (M_oldValues.size() < static_cast<std::size_t>(M_numVariables * n)) M_oldValues.resize(M_numVariables * n);
+        M_oldVariables.resize(M_numVariables);
+        for (int k = 0; k < M_numVariables; ++k)
+        {
+            M_oldVariables[k] = M_oldValues.data() + k * n;
+            if (k > 0) std::copy(variables[k], variables[k] + n, M_oldVariables[k]);
+            else std::fill(M_oldVariables[k], M_oldVariables[k] + n, 0.0);
+        }
+        double * const * old_variables = M_oldVariables.data();
+        #pragma omp simd
+        for (int i = 0; i < n; ++i)
+        {
+            BatchCell cell_variables = { variables, i };
+            BatchCell cell_old_variables = { old_variables, i };
+            CellState cell;
+            cellStep(cell_variables, dt, cell);
+            iion[i] = cell.itot;
+            diion[i] = cellTimeDerivative(cell_variables, cell_old_variables, dt, cell);
+        }
+    }
+    else
+    {
+        #pragma omp simd
+        for (int i = 0; i < n; ++i)
+        {
+            BatchCell cell_variables = { variables, i };
+            CellState cell;
+            cellStep(cell_variables, dt, cell);
+            iion[i] = cell.itot;
+        }
+    }
+}
 
 } /* namespace BeatIt */
@@ -68,6 +68,7 @@ public:
 	 *
 	 */
 	Courtemanche();
+	IonicModel* clone() const { return new Courtemanche(*this); }
 
 
 	//! Update all the variables in the ionic model
@@ -111,6 +112,27 @@ public:
 			std::vector<double>& old_variables, double dt = 0.0,
 			double h = 0.0);
 
+	//! Right hand side of the variables for the Rush-Larsen integrators
+	/*!
+	 *  ireljsrol, trpn, cmdn and csqn are algebraic variables:
+	 *  their values at the given state are written in variables
+	 *  \param [in,out] variables Vector containing the local value of all variables
+	 *  \param [in] appliedCurrent value of the applied current
+	 *  \param [out] rhs right hand side of each variable
+	 *  \param [out] jac diagonal of the Jacobian of the right hand side
+	 */
+	double evaluateRates(std::vector<double>& variables, double appliedCurrent,
+			std::vector<double>& rhs, std::vector<double>& jac);
+	bool hasRates() const
+	{
+		return true;
+	}
+
+	//! Update the variables of n cells stored as structure of arrays (vectorized)
+	void updateVariablesBatch(double * const * variables, const double * Q,
+			const double * appliedCurrent, double * iion, double * diion,
+			int n, double dt, double h = 0.0);
+
 	//! Initialize the values of the variables
 	/*!
 	 *  \param [in] variables Vector containing the local value of all variables
@@ -126,7 +148,37 @@ public:
 	void nernst_potentials(const std::vector<double>& variables);
 
 private:
+	/* Quantities computed in a step and used by the ionic current and by its time derivative */
+	struct CellState
+	{
+		double itot;
+		double ena;
+		double ek;
+	};
+	//! Update the variables of a single cell
+	/*!
+	 *  Shared by the scalar and by the batched updates: it does not modify the members.
+	 *  The translocation itr is evaluated from nsr and jsr at the beginning of the step,
+	 *  as at the end of the previous one, so that the update depends only on the cell.
+	 *  \param [in,out] variables variables of the cell (std::vector or BatchCell)
+	 *  \param [in] dt        Timestep
+	 *  \param [out] cell     currents at the beginning of the step
+	 */
+	template <class Variables>
+	void cellStep(Variables& variables, double dt, CellState& cell) const;
+	template <class Variables, class OldVariables>
+	double cellTimeDerivative(Variables& variables, OldVariables& old_variables,
+			double dt, const CellState& cell) const;
+
+	CellState M_cell;
+	/* Variables at the beginning of the step in updateVariablesBatch: M_oldVariables[k][i] */
+	std::vector<double> M_oldValues;
+	std::vector<double *> M_oldVariables;
+
+	/* Rates of evaluateRates */
 	void update();
+	/* Copy the variables to the members */
+	void load_variables(const std::vector<double>& variables);
 	/* Ion Current Functions */
 	void comp_ina(); /* Calculates Fast Na Current */
 	void comp_ical(); /* Calculates Currents through L-Type Ca Channel */
@@ -151,19 +203,6 @@ private:
 	void calc_itr(); /* Calculates Translocation of Ca from NSR to JSR */
 	void conc_cai(); /* Calculates new myoplasmic Ca ion concentration */
 
-	double comp_d_ina(double qn, double dNai, double dm, double dh, double dj);
-	double comp_d_ical(double qn, double dd, double df, double dfca);
-	double comp_d_ikr(double qn, double dki, double dxr);
-	double comp_d_iks(double qn, double dki, double dxs);
-	double comp_d_iki(double qn, double dki);
-	double comp_d_ikach(double qn, double dki, double dyach);
-	double comp_d_ikur(double qn, double dki, double duakur, double duikur);
-	double comp_d_ito(double qn, double dki, double dato, double diito);
-	double comp_d_inaca(double qn, double dnai, double dcai);
-	double comp_d_inak(double qn, double dnai);
-	double comp_d_ipca(double dcai);
-	double comp_d_icab(double qn, double dcai);
-	double comp_d_inab(double qn, double dnai);
 
 	/* Cell Geometry */
 	constexpr static double l = 0.01; /* Length of the cell (cm) */
@@ -72,6 +72,7 @@ public:
      */
     Cubic();
     ~Cubic() {};
+    IonicModel* clone() const { return new Cubic(*this); }
 
     //! Update all the variables in the ionic model
     /*!
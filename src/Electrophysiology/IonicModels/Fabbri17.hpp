@@ -68,6 +68,7 @@ public:
 	 *
 	 */
 	Fabbri17();
+	IonicModel* clone() const { return new Fabbri17(*this); }
 
 
 	//! Update all the variables in the ionic model
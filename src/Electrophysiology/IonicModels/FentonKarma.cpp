@@ -49,6 +49,7 @@
 
 #include "Electrophysiology/IonicModels/FentonKarma.hpp"
 #include "libmesh/getpot.h"
+#include <cmath>
 
 namespace BeatIt
 {
@@ -278,15 +279,61 @@ FentonKarma::setup(GetPot& data, std::string sect)
 }
 
 
+BEATIT_CELL_KERNEL void
+FentonKarma::gatingRhs(double V, double v, double w, double& dv, double& dw) const
+{
+    double tau_v_m = ( 1 - q(V) ) * M_tau_v1_m + q(V) * M_tau_v2_m;
+    dv = ( ( 1-p(V) ) * ( 1 - v ) / tau_v_m - p(V) * v / M_tau_v_p );
+    dw = ( ( 1-p(V) ) * ( 1 - w ) / M_tau_w_m - p(V) * w / M_tau_w_p );
+}
+
+BEATIT_CELL_KERNEL double
+FentonKarma::ionicCurrent(double V, double v, double w) const
+{
+    double Ifi = - v * p(V) * (V- M_V_c) * (1-V) / M_tau_d;
+    double Iso = V * ( 1 - p(V) ) / M_tau_0 + p(V) / M_tau_r;
+    double Isi = - w * ( 1 + std::tanh(M_kappa * ( V - M_V_c_si ) ) ) / 2.0 / M_tau_si;
+    // Do not include applied current
+    return  Ifi + Iso + Isi;
+}
+
+BEATIT_CELL_KERNEL double
+FentonKarma::ionicCurrentTimeDerivative(double V, double v, double w, double Q, double dv, double dw) const
+{
+    //double Ifi = - v * p(V) * (V- M_V_c) * (1-V) / M_tau_d;
+    //double Iso = V * ( 1 - p(V) ) / M_tau_0 + p(V) / M_tau_r;
+    //double Isi = - w * ( 1 + std::tanh(M_kappa * ( V - M_V_c_si ) ) ) / 2.0 / M_tau_si;
+    // Itot = Ifi + Iso + Isi
+    double dIfi = - v * p(V) * (1-V) / M_tau_d + v * p(V) * (V- M_V_c) / M_tau_d;
+    double dIso = ( 1 - p(V) ) / M_tau_0;
+    double tan = std::tanh(M_kappa * ( V - M_V_c_si ) );
+    double dIsi = M_kappa*w*(tan * tan - 1.0)/(2*M_tau_si);
+
+    double dIdV =  (dIfi + dIso + dIsi);
+
+    double dIfidv = - p(V) * (V- M_V_c) * (1-V) / M_tau_d;
+    double dIsidw = - ( 1 + tan ) / 2.0 / M_tau_si;
+    return dIdV * Q + dIfidv * dv + dIsidw * dw;
+}
+
+double
+FentonKarma::evaluateRates(std::vector<double>& variables, double appliedCurrent, std::vector<double>& rhs, std::vector<double>& jac)
+{
+    const double V = variables[0];
+    gatingRhs(V, variables[1], variables[2], rhs[1], rhs[2]);
+    double tau_v_m = ( 1 - q(V) ) * M_tau_v1_m + q(V) * M_tau_v2_m;
+    jac[1] = - ( 1 - p(V) ) / tau_v_m - p(V) / M_tau_v_p;
+    jac[2] = - ( 1 - p(V) ) / M_tau_w_m - p(V) / M_tau_w_p;
+    return ionicCurrent(V, variables[1], variables[2]);
+}
+
 void
 FentonKarma::updateVariables(std::vector<double>& variables, double appliedCurrent, double dt)
 {
-    double V = variables[0];
-    double v = variables[1];
-    double w = variables[2];
-    double tau_v_m = ( 1 - q(V) ) * M_tau_v1_m + q(V) * M_tau_v2_m;
-    variables[1] += dt * ( ( 1-p(V) ) * ( 1 - v ) / tau_v_m - p(V) * v / M_tau_v_p );
-    variables[2] += dt * ( ( 1-p(V) ) * ( 1 - w ) / M_tau_w_m - p(V) * w / M_tau_w_p );
+    double dv, dw;
+    gatingRhs(variables[0], variables[1], variables[2], dv, dw);
+    variables[1] += dt * dv;
+    variables[2] += dt * dw;
 }
 
 void
@@ -347,15 +394,7 @@ FentonKarma::updateVariables(double V, std::vector<double>& variables, double dt
 double
 FentonKarma::evaluateIonicCurrent(std::vector<double>& variables, double appliedCurrent, double dt)
 {
-    double V = variables[0];
-    double v = variables[1];
-    double w = variables[2];
-
-    double Ifi = - v * p(V) * (V- M_V_c) * (1-V) / M_tau_d;
-    double Iso = V * ( 1 - p(V) ) / M_tau_0 + p(V) / M_tau_r;
-    double Isi = - w * ( 1 + std::tanh(M_kappa * ( V - M_V_c_si ) ) ) / 2.0 / M_tau_si;
-    // Do not include applied current
-    return  Ifi + Iso + Isi;
+    return ionicCurrent(variables[0], variables[1], variables[2]);
 }
 double
 FentonKarma::evaluateIonicCurrent(std::vector<double>& v_n, std::vector<double>& v_np1, double appliedCurrent, double dt)
@@ -399,28 +438,40 @@ FentonKarma::evaluateIonicCurrentTimeDerivative( std::vector<double>& variables,
                                      double dt,
                                      double h )
 {
-    double V = variables[0];
-    double v = variables[1];
-    double w = variables[2];
-    double Q = rhs[0];
-    double dv = rhs[1];
-    double dw = rhs[2];
-
-    //double Ifi = - v * p(V) * (V- M_V_c) * (1-V) / M_tau_d;
-    //double Iso = V * ( 1 - p(V) ) / M_tau_0 + p(V) / M_tau_r;
-    //double Isi = - w * ( 1 + std::tanh(M_kappa * ( V - M_V_c_si ) ) ) / 2.0 / M_tau_si;
-    // Itot = Ifi + Iso + Isi
-    double dIfi = - v * p(V) * (1-V) / M_tau_d + v * p(V) * (V- M_V_c) / M_tau_d;
-    double dIso = ( 1 - p(V) ) / M_tau_0;
-    double tan = std::tanh(M_kappa * ( V - M_V_c_si ) );
-    double dIsi = M_kappa*w*(tan * tan - 1.0)/(2*M_tau_si);
-
-    double dIdV =  (dIfi + dIso + dIsi);
-
-    double dIfidv = - p(V) * (V- M_V_c) * (1-V) / M_tau_d;
-    double dIsidw = - ( 1 + std::tanh(M_kappa * ( V - M_V_c_si ) ) ) / 2.0 / M_tau_si;
-    return dIdV * Q + dIfidv * dv + dIsidw * dw;
+    return ionicCurrentTimeDerivative(variables[0], variables[1], variables[2], rhs[0], rhs[1], rhs[2]);
+}
 
+void
+FentonKarma::updateVariablesBatch( double * const * variables,
+                                   const double * Q,
+                                   const double * appliedCurrent,
+                                   double * iion,
+                                   double * diion,
+                                   int n,
+                                   double dt,
+                                   double h )
+{
+    double * V = variables[0];
+    double * v = variables[1];
+    double * w = variables[2];
+    #pragma omp simd
+    for (int i = 0; i < n; ++i)
+    {
+        double dv, dw;
+        gatingRhs(V[i], v[i], w[i], dv, dw);
+        v[i] += dt * dv;
+        w[i] += dt * dw;
+        iion[i] = ionicCurrent(V[i], v[i], w[i]);
+    }
+    // As in the reaction step: the time derivative of the gating variables is not passed
+    if (diion)
+    {
+        #pragma omp simd
+        for (int i = 0; i < n; ++i)
+        {
+            diion[i] = ionicCurrentTimeDerivative(V[i], v[i], w[i], Q[i], 0.0, 0.0);
+        }
+    }
 }
 
 void
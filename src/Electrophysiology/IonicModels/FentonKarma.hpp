@@ -72,6 +72,7 @@ public:
      */
     FentonKarma();
     ~FentonKarma() {};
+    IonicModel* clone() const { return new FentonKarma(*this); }
 
     //! Update all the variables in the ionic model
     /*!
@@ -110,6 +111,27 @@ public:
 
      double evaluateIonicCurrentTimeDerivative(std::vector<double>& variables, std::vector<double>& old_variables, double dt = 0.0, double h = 0.0);
 
+     //! Right hand side of v and w for the Rush-Larsen integrators
+     /*!
+      *  Both gates are linear in themselves: with the potential fixed
+      *  the Rush-Larsen step is exact
+      */
+     double evaluateRates(std::vector<double>& variables, double appliedCurrent, std::vector<double>& rhs, std::vector<double>& jac);
+     bool hasRates() const
+     {
+         return true;
+     }
+
+     //! Update a batch of cells stored as structure of arrays
+     void updateVariablesBatch( double * const * variables,
+                                const double * Q,
+                                const double * appliedCurrent,
+                                double * iion,
+                                double * diion,
+                                int n,
+                                double dt,
+                                double h = 0.0 );
+
 
     //! Initialize the values of the variables
     /*!
@@ -142,8 +164,13 @@ private:
     double M_V_c;
     double M_V_v;
 
-    int p(double V) { return (V >= M_V_c ) ?  1 : 0; }
-    int q(double V) { return (V >= M_V_v ) ?  1 : 0; }
+    int p(double V) const { return (V >= M_V_c ) ?  1 : 0; }
+    int q(double V) const { return (V >= M_V_v ) ?  1 : 0; }
+
+    /// single cell kernels shared by the scalar and the batched methods
+    void gatingRhs(double V, double v, double w, double& dv, double& dw) const;
+    double ionicCurrent(double V, double v, double w) const;
+    double ionicCurrentTimeDerivative(double V, double v, double w, double Q, double dv, double dw) const;
 };
 
 
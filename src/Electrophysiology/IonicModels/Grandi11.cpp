@@ -48,6 +48,7 @@
  */
 
 #include "Electrophysiology/IonicModels/Grandi11.hpp"
+#include <algorithm>
 #include "libmesh/getpot.h"
 #include <cmath>
 //#include "Electrophysiology/IonicModels/Grandi11LUT.hpp"
@@ -63,7 +64,7 @@ IonicModel* createGrandi11()
 }
 
 Grandi11::Grandi11()
- : super(57, 0, "Grandi11", CellType::MCell)
+ : super(NumVariables, 0, "Grandi11", CellType::MCell)
  , set_resting_conditions(false)
  , markov_iks(false)
 {
@@ -491,6 +492,7 @@ void Grandi11::initialize(std::vector<double>& variables)
 
 void Grandi11::setup(GetPot& data, std::string sect)
 {
+	super::setup(data, sect);
 	std::string section = sect + "/Grandi11";
 	set_resting_conditions = data(section + "/resting_values", false);
 	std::cout << "Setting resting values: "<< set_resting_conditions << ", " << section << std::endl;
@@ -1099,6 +1101,314 @@ double Grandi11::evaluateIonicCurrentTimeDerivative(std::vector<double>& variabl
 	return dI_tot;
 }
 
+//! Steady states and time constants of the gates
+/*!
+ *  \param [in] v transmembrane potential
+ *  \param [out] inf steady state of the gates, indexed as the variables
+ *  \param [out] tau time constant of the gates, indexed as the variables
+ */
+void Grandi11::gatingKinetics(double v, double* inf, double* tau) const
+{
+	// I_Na: m, h, j
+	double aux = (1. + std::exp(-(56.86 + v) / 9.03));
+	inf[1] = 1. / (aux * aux);
+
+	aux = (v + 45.79) / 15.54;
+	tau[1] = 0.1292 * std::exp(-aux * aux);
+	aux = (v - 4.823) / 51.12;
+	tau[1] += 0.06487 * std::exp(-aux * aux);
+
+	double ah = (v < -40.0) ? 0.057 * std::exp(-(v + 80) / 6.8) : 0.0;
+	double bh =
+			(v < -40.0) ?
+					2.7 * std::exp(0.079 * v)
+							+ 3.1 * 1e5 * std::exp(0.3485 * v) :
+					0.77 / (0.13 * (1.0 + std::exp(-(v + 10.66) / 11.1)));
+
+	tau[2] = 1.0 / (ah + bh);
+
+	aux = 1.0 + std::exp((v + 71.55) / 7.43);
+	inf[2] = 1.0 / (aux * aux);
+
+	//    double  aj = (v >= -40) * (0)
+	//                +(v < -40) * (((-2.5428 * 10^4*std::exp(0.2444*v) - 6.948*10^-6 * std::exp(-0.04391*v)) * (v + 37.78)) /
+	//                         (1 + std::exp( 0.311 * (v + 79.23) )));
+	double aj =
+			(v < -40.0) ?
+					(-2.5428 * 1e4 * std::exp(0.2444 * v)
+							- 6.948 * 1e-6 * std::exp(-0.04391 * v))
+							* (v + 37.78)
+							/ (1.0 + std::exp(0.311 * (v + 79.23))) :
+					0.0;
+	//    double bj = (v >= -40) * ((0.6 * std::exp( 0.057 * v)) / (1 + std::exp( -0.1 * (v + 32) )))
+	//       + (v < -40) * ((0.02424 * std::exp( -0.01052 * v )) / (1 + std::exp( -0.1378 * (v + 40.14) )));
+	double bj =
+			(v < -40.0) ?
+					((0.02424 * std::exp(-0.01052 * v))
+							/ (1 + std::exp(-0.1378 * (v + 40.14)))) :
+					((0.6 * std::exp(0.057 * v))
+							/ (1 + std::exp(-0.1 * (v + 32))));
+	tau[3] = 1.0 / (aj + bj);
+	aux = 1.0 + std::exp((v + 71.55) / 7.43);
+	inf[3] = 1.0 / (aux * aux);
+
+	// Late I_Na
+	double aml = 0.32 * (v + 47.13) / (1 - std::exp(-0.1 * (v + 47.13)));
+	double bml = 0.08 * std::exp(-v / 11);
+	tau[55] = 1.0 / (aml + bml);
+	inf[55] = aml * tau[55];
+	inf[56] = 1 / (1 + std::exp((v + 91) / 6.1));
+	tau[56] = 600.0;
+
+	// I_kr
+	inf[10] = 1.0 / (1.0 + std::exp(-(v + 10.0) / 5.0));
+	tau[10] = 550.0 / (1.0 + std::exp((-22.0 - v) / 9.0)) * 6.0
+			/ (1.0 + std::exp((v - (-11.0)) / 9.0))
+			+ 230.0 / (1.0 + std::exp((v - (-40.0)) / 20.0));
+
+	// I_ks
+	inf[11] = 1.0 / (1.0 + std::exp(-(v + 40.0 * ISO + 3.8) / 14.25)); // fitting Fra
+	tau[11] = 990.1
+			/ (1 + std::exp(-(v + 40.0 * ISO + 2.436) / 14.12));
+
+	// I_to: activation
+	inf[8] = (1.0 / (1 + std::exp(-(v + 1.0) / 11.0)));
+	tau[8] = 3.5 * std::exp(-((v / 30.0) * (v / 30.0))) + 1.5;
+	// I_to: inactivation
+	inf[9] = (1.0 / (1 + std::exp((v + 40.5) / 11.5)));
+	tau[9] = 25.635
+			* std::exp(-(((v + 52.45) / 15.8827) * ((v + 52.45) / 15.8827)))
+			+ 24.14; //14.14
+
+	// I_kur: activation
+	inf[53] = (1.0 / (1 + std::exp((v + 6) / -8.6)));
+	tau[53] = 9 / (1 + std::exp((v + 5) / 12.0)) + 0.5;
+	// I_kur: inactivation
+	inf[54] = (1.0 / (1 + std::exp((v + 7.5) / 10)));
+	tau[54] = 590 / (1 + std::exp((v + 60) / 10.0)) + 3050;
+
+	// I_Ca: d, f
+	inf[4] = 1.0 / (1.0 + std::exp(-(v + 3 * ISO + 9) / 6)); //in Maleckar v1/2=-9 S=6 (mV); Courtemanche v1/2=-9 S=5.8 (mV)
+	tau[4] = 1.0 * inf[4] * (1 - std::exp(-(v + 3 * ISO + 9) / 6))
+			/ (0.035 * (v + 3 * ISO + 9));
+	inf[5] = 1.0 / (1.0 + std::exp((v + 3 * ISO + 30) / 7))
+			+ 0.2 / (1 + std::exp((50 - v - 3 * ISO) / 20)); // in Maleckar v1/2=-27.4 S=7.1 (mV); Courtemanche v1/2=-28 S=6.9 (mV)
+	tau[5] = 1.0
+			/ (0.0197
+					* std::exp(
+							-(0.0337 * (v + 3 * ISO + 25))
+									* (0.0337 * (v + 3 * ISO + 25))) + 0.02);
+}
+
+double Grandi11::evaluateRates(std::vector<double>& variables,
+		double appliedCurrent, std::vector<double>& rhs, std::vector<double>& jac)
+{
+	// Currents and fluxes at the given state:
+	// with dt = 0 updateVariables leaves the variables unchanged
+	M_state = variables;
+	updateVariables(M_state, appliedCurrent, 0.0);
+
+	std::fill(rhs.begin(), rhs.end(), 0.0);
+	std::fill(jac.begin(), jac.end(), 0.0);
+
+	const double v = variables[0];
+	double inf[NumVariables], tau[NumVariables];
+	gatingKinetics(v, inf, tau);
+	const int gates[] = { 1, 2, 3, 4, 5, 8, 9, 10, 11, 53, 54, 55, 56 };
+	for (int k : gates)
+	{
+		rhs[k] = (inf[k] - variables[k]) / tau[k];
+		jac[k] = -1.0 / tau[k];
+	}
+
+	const double fcaBj = variables[6];
+	const double fcaBsl = variables[7];
+	const double RyRr = variables[12];
+	const double RyRo = variables[13];
+	const double RyRi = variables[14];
+	const double NaBj = variables[15];
+	const double NaBsl = variables[16];
+	const double TnCL = variables[17];
+	const double TnCHc = variables[18];
+	const double TnCHm = variables[19];
+	const double CaM = variables[20];
+	const double Myoc = variables[21];
+	const double Myom = variables[22];
+	const double SRB = variables[23];
+	const double SLLj = variables[24];
+	const double SLLsl = variables[25];
+	const double SLHj = variables[26];
+	const double SLHsl = variables[27];
+	const double Csqnb = variables[28];
+	const double Ca_sr = variables[29];
+	const double Naj = variables[30];
+	const double Nasl = variables[31];
+	const double Nai = variables[32];
+	const double Caj = variables[34];
+	const double Casl = variables[35];
+	const double Cai = variables[36];
+
+	// I_Ca: Ca dependent inactivation
+	rhs[6] = 1.7 * Caj * (1 - fcaBj) - 1 * 11.9e-3 * fcaBj;
+	jac[6] = -(1.7 * Caj + 11.9e-3);
+	rhs[7] = 1.7 * Casl * (1 - fcaBsl) - 1 * 11.9e-3 * fcaBsl;
+	jac[7] = -(1.7 * Casl + 11.9e-3);
+
+	// I_ks: Markov model
+	if (markov_iks)
+	{
+		rhs[11] = 0.0;
+		jac[11] = 0.0;
+		const double C1 = variables[37];
+		const double C2 = variables[38];
+		const double C3 = variables[39];
+		const double C4 = variables[40];
+		const double C5 = variables[41];
+		const double C6 = variables[42];
+		const double C7 = variables[43];
+		const double C8 = variables[44];
+		const double C9 = variables[45];
+		const double C10 = variables[46];
+		const double C11 = variables[47];
+		const double C12 = variables[48];
+		const double C13 = variables[49];
+		const double C14 = variables[50];
+		const double C15 = variables[51];
+		const double O1 = variables[52];
+		double alpha = 3.98e-4 * std::exp(3.61e-1 * v * FoRT);
+		double beta = 5.74e-5 * std::exp(-9.23e-2 * v * FoRT);
+		double gamma = 3.41e-3 * std::exp(8.68e-1 * v * FoRT);
+		double delta = 1.2e-3 * std::exp(-3.3e-1 * v * FoRT);
+		double teta = 6.47e-3;
+		double eta = 1.25e-2 * std::exp(-4.81e-1 * v * FoRT);
+		double psi = 6.33e-3 * std::exp(1.27 * v * FoRT);
+		double omega = 4.91e-3 * std::exp(-6.79e-1 * v * FoRT);
+		double O2 = 1 - (C1 + C2 + C3 + C4 + C5 + C6 + C8 + C7 + C9 + C10 + C11 + C12 + C13 + C14 + C15 + O1);
+
+		rhs[37] = -4 * alpha * C1 + beta * C2;
+		jac[37] = -4 * alpha;
+		rhs[38] = 4 * alpha * C1 - (beta + gamma + 3 * alpha) * C2 + 2 * beta * C3;
+		jac[38] = -(beta + gamma + 3 * alpha);
+		rhs[39] = 3 * alpha * C2 - (2 * beta + 2 * gamma + 2 * alpha) * C3 + 3 * beta * C4;
+		jac[39] = -(2 * beta + 2 * gamma + 2 * alpha);
+		rhs[40] = 2 * alpha * C3 - (3 * beta + 3 * gamma + alpha) * C4 + 4 * beta * C5;
+		jac[40] = -(3 * beta + 3 * gamma + alpha);
+		rhs[41] = 1 * alpha * C3 - (4 * beta + 4 * gamma) * C5 + delta * C9;
+		jac[41] = -(4 * beta + 4 * gamma);
+		rhs[42] = gamma * C2 - (delta + 3 * alpha) * C6 + beta * C7;
+		jac[42] = -(delta + 3 * alpha);
+		rhs[43] = 2 * gamma * C3 + 3 * alpha * C6 - (delta + beta + 2 * alpha + gamma) * C7 + 2 * beta * C8 + 2 * delta * C10;
+		jac[43] = -(delta + beta + 2 * alpha + gamma);
+		rhs[44] = 3 * gamma * C4 + 2 * alpha * C7 - (delta + 2 * beta + 1 * alpha + 2 * gamma) * C8 + 3 * beta * C9 + 2 * delta * C11;
+		jac[44] = -(delta + 2 * beta + 1 * alpha + 2 * gamma);
+		rhs[45] = 4 * gamma * C5 + 1 * alpha * C8 - (delta + 3 * beta + 0 * alpha + 3 * gamma) * C9 + 2 * delta * C12;
+		jac[45] = -(delta + 3 * beta + 0 * alpha + 3 * gamma);
+		rhs[46] = 1 * gamma * C7 - (2 * delta + 2 * alpha) * C10 + beta * C11;
+		jac[46] = -(2 * delta + 2 * alpha);
+		rhs[47] = 2 * gamma * C8 + 2 * alpha * C10 - (2 * delta + beta + 1 * alpha + gamma) * C11 + 2 * beta * C12 + 3 * delta * C13;
+		jac[47] = -(2 * delta + beta + 1 * alpha + gamma);
+		rhs[48] = 3 * gamma * C9 + 1 * alpha * C11 - (2 * delta + 2 * beta + 2 * gamma) * C12 + 3 * delta * C14;
+		jac[48] = -(2 * delta + 2 * beta + 2 * gamma);
+		rhs[49] = 1 * gamma * C11 - (3 * delta + 1 * alpha) * C13 + beta * C14;
+		jac[49] = -(3 * delta + 1 * alpha);
+		rhs[50] = 2 * gamma * C12 + 1 * alpha * C13 - (3 * delta + 1 * beta + 1 * gamma) * C14 + 4 * delta * C15;
+		jac[50] = -(3 * delta + 1 * beta + 1 * gamma);
+		rhs[51] = 1 * gamma * C14 - (4 * delta + teta) * C15 + eta * O1;
+		jac[51] = -(4 * delta + teta);
+		rhs[52] = 1 * teta * C15 - (eta + psi) * O1 + omega * O2;
+		jac[52] = -(eta + psi + omega);
+	}
+
+	// SR fluxes: RyR
+	double MaxSR = 15;
+	double MinSR = 1;
+	double kCaSR = MaxSR
+			- (MaxSR - MinSR) / (1 + std::pow(ec50SR / Ca_sr, 2.5));
+	double koSRCa = koCa / kCaSR;
+	double kiSRCa = kiCa * kCaSR;
+	double RI = 1 - RyRr - RyRo - RyRi;
+	rhs[12] = (kim * RI - kiSRCa * Caj * RyRr) - (koSRCa * Caj * Caj * RyRr - kom * RyRo);
+	jac[12] = -(kim + kiSRCa * Caj + koSRCa * Caj * Caj);
+	rhs[13] = (koSRCa * Caj * Caj * RyRr - kom * RyRo) - (kiSRCa * Caj * RyRo - kim * RyRi);
+	jac[13] = -(kom + kiSRCa * Caj);
+	rhs[14] = (kiSRCa * Caj * RyRo - kim * RyRi) - (kom * RyRi - koSRCa * Caj * Caj * RI);
+	jac[14] = -(kim + kom + koSRCa * Caj * Caj);
+
+	// Sodium buffers
+	rhs[15] = kon_na * Naj * (Bmax_Naj - NaBj) - koff_na * NaBj;
+	jac[15] = -(kon_na * Naj + koff_na);
+	rhs[16] = kon_na * Nasl * (Bmax_Nasl - NaBsl) - koff_na * NaBsl;
+	jac[16] = -(kon_na * Nasl + koff_na);
+
+	// Cytosolic Ca Buffers
+	rhs[17] = kon_tncl * Cai * (Bmax_TnClow - TnCL) - koff_tncl * TnCL;
+	jac[17] = -(kon_tncl * Cai + koff_tncl);
+	rhs[18] = kon_tnchca * Cai * (Bmax_TnChigh - TnCHc - TnCHm) - koff_tnchca * TnCHc;
+	jac[18] = -(kon_tnchca * Cai + koff_tnchca);
+	rhs[19] = kon_tnchmg * Mgi * (Bmax_TnChigh - TnCHc - TnCHm) - koff_tnchmg * TnCHm;
+	jac[19] = -(kon_tnchmg * Mgi + koff_tnchmg);
+	rhs[20] = kon_cam * Cai * (Bmax_CaM - CaM) - koff_cam * CaM;
+	jac[20] = -(kon_cam * Cai + koff_cam);
+	rhs[21] = kon_myoca * Cai * (Bmax_myosin - Myoc - Myom) - koff_myoca * Myoc;
+	jac[21] = -(kon_myoca * Cai + koff_myoca);
+	rhs[22] = kon_myomg * Mgi * (Bmax_myosin - Myoc - Myom) - koff_myomg * Myom;
+	jac[22] = -(kon_myomg * Mgi + koff_myomg);
+	rhs[23] = kon_sr * Cai * (Bmax_SR - SRB) - koff_sr * SRB;
+	jac[23] = -(kon_sr * Cai + koff_sr);
+	double J_CaB_cyto = rhs[17] + rhs[18] + rhs[19] + rhs[20] + rhs[21] + rhs[22] + rhs[23];
+
+	// Junctional and SL Ca Buffers
+	rhs[24] = kon_sll * Caj * (Bmax_SLlowj - SLLj) - koff_sll * SLLj;
+	jac[24] = -(kon_sll * Caj + koff_sll);
+	rhs[25] = kon_sll * Casl * (Bmax_SLlowsl - SLLsl) - koff_sll * SLLsl;
+	jac[25] = -(kon_sll * Casl + koff_sll);
+	rhs[26] = kon_slh * Caj * (Bmax_SLhighj - SLHj) - koff_slh * SLHj;
+	jac[26] = -(kon_slh * Caj + koff_slh);
+	rhs[27] = kon_slh * Casl * (Bmax_SLhighsl - SLHsl) - koff_slh * SLHsl;
+	jac[27] = -(kon_slh * Casl + koff_slh);
+
+	// SR Ca Concentrations
+	const double kleak = (1.0 + 0.25 * AF) * 5.348e-6;
+	rhs[28] = kon_csqn * Ca_sr * (Bmax_Csqn - Csqnb) - koff_csqn * Csqnb;
+	jac[28] = -(kon_csqn * Ca_sr + koff_csqn);
+	rhs[29] = J_serca - (J_SRleak * Vmyo / Vsr + J_SRCarel) - rhs[28];
+	jac[29] = -(kleak * Vmyo / Vsr + ks * RyRo + kon_csqn * (Bmax_Csqn - Csqnb));
+
+	// Sodium Concentrations
+	rhs[30] = -I_Na_tot_junc * Cmem / (Vjunc * Frdy)
+			+ J_na_juncsl / Vjunc * (Nasl - Naj) - rhs[15];
+	jac[30] = -(J_na_juncsl / Vjunc + kon_na * (Bmax_Naj - NaBj));
+	rhs[31] = -I_Na_tot_sl * Cmem / (Vsl * Frdy)
+			+ J_na_juncsl / Vsl * (Naj - Nasl)
+			+ J_na_slmyo / Vsl * (Nai - Nasl) - rhs[16];
+	jac[31] = -((J_na_juncsl + J_na_slmyo) / Vsl + kon_na * (Bmax_Nasl - NaBsl));
+	rhs[32] = J_na_slmyo / Vmyo * (Nasl - Nai);
+	jac[32] = -J_na_slmyo / Vmyo;
+
+	// Calcium Concentrations
+	rhs[34] = -I_Ca_tot_junc * Cmem / (Vjunc * 2 * Frdy)
+			+ J_ca_juncsl / Vjunc * (Casl - Caj) - (rhs[24] + rhs[26])
+			+ J_SRCarel * Vsr / Vjunc + J_SRleak * Vmyo / Vjunc;
+	jac[34] = -(J_ca_juncsl / Vjunc
+			+ kon_sll * (Bmax_SLlowj - SLLj) + kon_slh * (Bmax_SLhighj - SLHj)
+			+ ks * RyRo * Vsr / Vjunc + kleak * Vmyo / Vjunc);
+	rhs[35] = -I_Ca_tot_sl * Cmem / (Vsl * 2 * Frdy)
+			+ J_ca_juncsl / Vsl * (Caj - Casl)
+			+ J_ca_slmyo / Vsl * (Cai - Casl) - (rhs[25] + rhs[27]);
+	jac[35] = -((J_ca_juncsl + J_ca_slmyo) / Vsl
+			+ kon_sll * (Bmax_SLlowsl - SLLsl) + kon_slh * (Bmax_SLhighsl - SLHsl));
+	rhs[36] = -J_serca * Vsr / Vmyo - J_CaB_cyto
+			+ J_ca_slmyo / Vmyo * (Casl - Cai);
+	jac[36] = -(J_ca_slmyo / Vmyo
+			+ kon_tncl * (Bmax_TnClow - TnCL)
+			+ kon_tnchca * (Bmax_TnChigh - TnCHc - TnCHm)
+			+ kon_cam * (Bmax_CaM - CaM)
+			+ kon_myoca * (Bmax_myosin - Myoc - Myom)
+			+ kon_sr * (Bmax_SR - SRB));
+
+	return I_tot;
+}
+
 void Grandi11::updateVariables(std::vector<double>& variables,
 		double appliedCurrent, double dt)
 {
@@ -1163,59 +1473,19 @@ void Grandi11::updateVariables(std::vector<double>& variables,
 	double& Inal1 = variables[55];
 	double& Inal2 = variables[56];
 
-	double aux = (1. + std::exp(-(56.86 + v) / 9.03));
-	double mss = 1. / (aux * aux);
-
-	aux = (v + 45.79) / 15.54;
-	double taum = 0.1292 * std::exp(-aux * aux);
-	aux = (v - 4.823) / 51.12;
-	taum += 0.06487 * std::exp(-aux * aux);
-
-	double ah = (v < -40.0) ? 0.057 * std::exp(-(v + 80) / 6.8) : 0.0;
-	double bh =
-			(v < -40.0) ?
-					2.7 * std::exp(0.079 * v)
-							+ 3.1 * 1e5 * std::exp(0.3485 * v) :
-					0.77 / (0.13 * (1.0 + std::exp(-(v + 10.66) / 11.1)));
-
-	double tauh = 1.0 / (ah + bh);
-
-	aux = 1.0 + std::exp((v + 71.55) / 7.43);
-	double hss = 1.0 / (aux * aux);
-
-	//    double  aj = (v >= -40) * (0)
-	//                +(v < -40) * (((-2.5428 * 10^4*std::exp(0.2444*v) - 6.948*10^-6 * std::exp(-0.04391*v)) * (v + 37.78)) /
-	//                         (1 + std::exp( 0.311 * (v + 79.23) )));
-	double aj =
-			(v < -40.0) ?
-					(-2.5428 * 1e4 * std::exp(0.2444 * v)
-							- 6.948 * 1e-6 * std::exp(-0.04391 * v))
-							* (v + 37.78)
-							/ (1.0 + std::exp(0.311 * (v + 79.23))) :
-					0.0;
-	//    double bj = (v >= -40) * ((0.6 * std::exp( 0.057 * v)) / (1 + std::exp( -0.1 * (v + 32) )))
-	//       + (v < -40) * ((0.02424 * std::exp( -0.01052 * v )) / (1 + std::exp( -0.1378 * (v + 40.14) )));
-	double bj =
-			(v < -40.0) ?
-					((0.02424 * std::exp(-0.01052 * v))
-							/ (1 + std::exp(-0.1378 * (v + 40.14)))) :
-					((0.6 * std::exp(0.057 * v))
-							/ (1 + std::exp(-0.1 * (v + 32))));
-	double tauj = 1.0 / (aj + bj);
-	aux = 1.0 + std::exp((v + 71.55) / 7.43);
-	double jss = 1.0 / (aux * aux);
-
-	// TODO:: USE RL
-	// sm = M_INF-(M_INF-sm)*std::exp(-dt/TAU_M);
+	// Steady states and time constants of the gates
+	double inf[NumVariables], tau[NumVariables];
+	gatingKinetics(v, inf, tau);
+	double aux;
 
 	//ydot(1) = (mss - y(1)) / taum;
 	//m += dt * (mss - m) / taum;
-	 m = mss - (mss - m) * std::exp(-dt / taum);
+	 m = inf[1] - (inf[1] - m) * std::exp(-dt / tau[1]);
 	//ydot(2) = (hss - y(2)) / tauh;
-	h = hss - (hss - h) * std::exp(-dt / tauh);
+	h = inf[2] - (inf[2] - h) * std::exp(-dt / tau[2]);
 	//h += dt * (hss - h) / tauh;
 	//ydot(3) = (jss - y(3)) / tauj;
-	j = jss - (jss - j) * std::exp(-dt / tauj);
+	j = inf[3] - (inf[3] - j) * std::exp(-dt / tau[3]);
 	//j += dt * (jss - j) / tauj;
 
 	I_Na_junc = Fjunc * GNa * m * m * m * h * j * (v - ena_junc);
@@ -1223,19 +1493,12 @@ void Grandi11::updateVariables(std::vector<double>& variables,
 	I_Na = I_Na_junc + I_Na_sl;
 
 	// Late I_Na
-	double aml = 0.32 * (v + 47.13) / (1 - std::exp(-0.1 * (v + 47.13)));
-	double bml = 0.08 * std::exp(-v / 11);
-	double hlinf = 1 / (1 + std::exp((v + 91) / 6.1));
-	double tauhl = 600.0;
-	//TODO use RL
 	//ydot(60) = aml*(1-y(60))-bml*y(60);
-	double tau_Inal1 = 1.0 / (aml + bml);
-	double Inal1_inf = aml * tau_Inal1;
-	Inal1 = Inal1_inf - (Inal1_inf - Inal1) * std::exp(-dt / tau_Inal1);
+	Inal1 = inf[55] - (inf[55] - Inal1) * std::exp(-dt / tau[55]);
 	//Inal1 +=  dt * ( aml*(1-Inal1)-bml*Inal1 );
 
 	//ydot(61) = (hlinf-y(61))/tauhl;
-	Inal2 = hlinf - (hlinf - Inal2) * std::exp(-dt / tauhl);
+	Inal2 = inf[56] - (inf[56] - Inal2) * std::exp(-dt / tau[56]);
 	//Inal2 +=  dt * ( hlinf - Inal2 ) / tauhl;
 
 	I_NaL_junc = Fjunc * GNaL * Inal1 * Inal1 * Inal1 * Inal2 * (v - ena_junc);
@@ -1267,13 +1530,8 @@ void Grandi11::updateVariables(std::vector<double>& variables,
 
 	// I_kr: Rapidly Activating K Current
 	double gkr = 0.035 * std::sqrt(Ko / 5.4);
-	double xrss = 1.0 / (1.0 + std::exp(-(v + 10.0) / 5.0));
-	double tauxr = 550.0 / (1.0 + std::exp((-22.0 - v) / 9.0)) * 6.0
-			/ (1.0 + std::exp((v - (-11.0)) / 9.0))
-			+ 230.0 / (1.0 + std::exp((v - (-40.0)) / 20.0));
-	// TODO: Use RL
 	//ydot(12) = (xrss-y(12))/tauxr;
-	xkr = xrss - (xrss - xkr) * std::exp(-dt / tauxr);
+	xkr = inf[10] - (inf[10] - xkr) * std::exp(-dt / tau[10]);
 	//xkr += dt * (xrss - xkr) / tauxr ;
 	double rkr = 1.0 / (1.0 + std::exp((v + 74.0) / 24.0));
 	I_kr = gkr * xkr * rkr * (v - ek);
@@ -1286,12 +1544,8 @@ void Grandi11::updateVariables(std::vector<double>& variables,
 	{
 		double gks_junc = 1.0 * (1.0 + 1.0 * AF + 2.0 * ISO) * 0.0035 * 1.0;
 		double gks_sl = 1.0 * (1.0 + 1.0 * AF + 2.0 * ISO) * 0.0035 * 1.0; // Fra
-		double xsss = 1.0 / (1.0 + std::exp(-(v + 40.0 * ISO + 3.8) / 14.25)); // fitting Fra
-		double tauxs = 990.1
-				/ (1 + std::exp(-(v + 40.0 * ISO + 2.436) / 14.12));
-		// TODO: Use RL
 		//ydot(13) = (xsss-y(13))/tauxs;
-		xks = xsss - (xsss - xks) * std::exp(-dt / tauxs);
+		xks = inf[11] - (inf[11] - xks) * std::exp(-dt / tau[11]);
 		//xks += dt * (xsss - xks) / tauxs ;
 
 		I_ks_junc = Fjunc * gks_junc * xks * xks * (v - eks);
@@ -1410,22 +1664,11 @@ void Grandi11::updateVariables(std::vector<double>& variables,
 
 	// 11/12/09; changed Itof to that from maleckar/giles/2009; removed I_tos
 	// atrium
-	// equations for activation;
-	double xtoss = (1.0 / (1 + std::exp(-(v + 1.0) / 11.0)));
-	double tauxtof = 3.5 * std::exp(-((v / 30.0) * (v / 30.0))) + 1.5;
-
-	// equations for inactivation;
-	double ytoss = (1.0 / (1 + std::exp((v + 40.5) / 11.5)));
-	double tauytof = 25.635
-			* std::exp(-(((v + 52.45) / 15.8827) * ((v + 52.45) / 15.8827)))
-			+ 24.14; //14.14
-
-	// TODO: Use RL
 	//ydot(10) = (xtoss-y(10))/tauxtof;
-	xtof = xtoss - (xtoss - xtof) * std::exp(-dt / tauxtof);
+	xtof = inf[8] - (inf[8] - xtof) * std::exp(-dt / tau[8]);
 	//xtof += dt * ( xtoss - xtof ) / tauxtof ;
 	//ydot(11) = (ytoss-y(11))/tauytof;
-	ytof = ytoss - (ytoss - ytof) * std::exp(-dt / tauytof);
+	ytof = inf[9] - (inf[9] - ytof) * std::exp(-dt / tau[9]);
 	//ytof += dt *( ytoss - ytof )  / tauytof;
 	I_tof = 1.0 * GtoFast * xtof * ytof * (v - ek);
 	I_to = 1.0 * I_tof;
@@ -1436,19 +1679,12 @@ void Grandi11::updateVariables(std::vector<double>& variables,
 	// equations for activation;
 	double RA = 0; // Right Atrium
 	double Gkur = 1 * (1.0 - 0.5 * AF) * (1 + 2 * ISO) * 0.045 * (1 + 0.2 * RA); // nS/pF maleckar 0.045
-	double xkurss = (1.0 / (1 + std::exp((v + 6) / -8.6)));
-	double tauxkur = 9 / (1 + std::exp((v + 5) / 12.0)) + 0.5;
-
-	// equations for inactivation;
-	double ykurss = (1.0 / (1 + std::exp((v + 7.5) / 10)));
-	double tauykur = 590 / (1 + std::exp((v + 60) / 10.0)) + 3050;
 
-	// TODO: Use RL
 	//ydot(58) = (xkurss-y(58))/tauxkur;
-	 rkur = xkurss - (xkurss - rkur) * std::exp(-dt / tauxkur);
+	 rkur = inf[53] - (inf[53] - rkur) * std::exp(-dt / tau[53]);
 	//rkur += dt * ( xkurss - rkur )  / tauxkur;
 	//ydot(59) = (ykurss-y(59))/tauykur;
-	  skur = ykurss - (ykurss - skur) * std::exp(-dt / tauykur);
+	  skur = inf[54] - (inf[54] - skur) * std::exp(-dt / tau[54]);
 	//skur += dt * ( ykurss - skur )  / tauykur;
 
 	I_kur = 1 * Gkur * rkur * skur * (v - ek);
@@ -1476,23 +1712,11 @@ void Grandi11::updateVariables(std::vector<double>& variables,
 	I_ClCFTR = GClCFTR * (v - ecl);
 
 	// I_Ca: L-type Calcium Current
-	double dss = 1.0 / (1.0 + std::exp(-(v + 3 * ISO + 9) / 6)); //in Maleckar v1/2=-9 S=6 (mV); Courtemanche v1/2=-9 S=5.8 (mV)
-	double taud = 1.0 * dss * (1 - std::exp(-(v + 3 * ISO + 9) / 6))
-			/ (0.035 * (v + 3 * ISO + 9));
-	double fss = 1.0 / (1.0 + std::exp((v + 3 * ISO + 30) / 7))
-			+ 0.2 / (1 + std::exp((50 - v - 3 * ISO) / 20)); // in Maleckar v1/2=-27.4 S=7.1 (mV); Courtemanche v1/2=-28 S=6.9 (mV)
-	double tauf = 1.0
-			/ (0.0197
-					* std::exp(
-							-(0.0337 * (v + 3 * ISO + 25))
-									* (0.0337 * (v + 3 * ISO + 25))) + 0.02);
-
-	// TODO: Use RL
 	//ydot(4) = (dss-d)/taud;
-	d = dss - (dss - d) * std::exp(-dt / taud);
+	d = inf[4] - (inf[4] - d) * std::exp(-dt / tau[4]);
 	//d += dt * ( dss - d )   / taud;
 	//ydot(5) = (fss-f)/tauf;
-	f = fss - (fss - f) * std::exp(-dt / tauf);
+	f = inf[5] - (inf[5] - f) * std::exp(-dt / tau[5]);
 	//f += dt *  ( fss - f )  / tauf;
 	//ydot(6) = 1.7*Caj*(1-fcaBj)-1*11.9e-3*fcaBj; // fCa_junc   koff!!!!!!!!
 	fcaBj += dt * (1.7 * Caj * (1 - fcaBj) - 1 * 11.9e-3 * fcaBj); // fCa_junc   koff!!!!!!!!
@@ -68,6 +68,7 @@ public:
      *
      */
     Grandi11();
+    IonicModel* clone() const { return new Grandi11(*this); }
 
     void setup(GetPot& data, std::string section);
 
@@ -103,6 +104,19 @@ public:
      double evaluateIonicCurrent(double V, std::vector<double>& variables, double appliedCurrent = 0.0, double dt = 0.0){ return 0.0;}
      double evaluateIonicCurrentTimeDerivative(std::vector<double>& variables, std::vector<double>& old_variables, double dt = 0.0, double h = 0.0);
 
+    //! Right hand side of the variables for the Rush-Larsen integrators
+    /*!
+     *  \param [in] variables Vector containing the local value of all variables
+     *  \param [in] appliedCurrent value of the applied current
+     *  \param [out] rhs right hand side of each variable
+     *  \param [out] jac diagonal of the Jacobian of the right hand side
+     */
+    double evaluateRates(std::vector<double>& variables, double appliedCurrent, std::vector<double>& rhs, std::vector<double>& jac);
+    bool hasRates() const
+    {
+        return true;
+    }
+
     //! Initialize the values of the variables
     /*!
      *  \param [in] variables Vector containing the local value of all variables
@@ -118,6 +132,13 @@ public:
     void nernst_potentials(const std::vector<double>& variables);
 
 private:
+    //! Steady states and time constants of the gates, indexed as the variables
+    void gatingKinetics(double v, double* inf, double* tau) const;
+    /// Number of variables, including the potential
+    constexpr static int NumVariables = 57;
+    /// Work vector of evaluateRates
+    std::vector<double> M_state;
+
     /// Physical Constants
     constexpr static double S_PI = 3.14159265358979323846264338327950288;
     constexpr static double Frdy = F;
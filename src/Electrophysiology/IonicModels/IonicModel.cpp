@@ -7,6 +7,9 @@
 
 #include "Electrophysiology/IonicModels/IonicModel.hpp"
 #include "libmesh/getpot.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
 
 
 namespace BeatIt
@@ -23,6 +26,16 @@ IonicModel::IonicModel( int numVar,
   , M_variablesNames(numVar-1)
   , M_ionicModelName(name)
   , M_membrane_capacitance(1.0)
+  , M_integrator(IonicIntegrator::Native)
+  , M_substepRelativeTolerance(1e-1)
+  , M_substepAbsoluteTolerance(1e-6)
+  , M_maxSubsteps(100)
+  , M_substepStiffness(1.0)
+  , M_useLUT(false)
+  , M_lut()
+  , M_lutTimestep(0.0)
+  , M_lutCellType(cell_type)
+  , M_luts()
 {
 }
 
@@ -31,6 +44,213 @@ void IonicModel::setup(GetPot& data, std::string section)
 {
     M_membrane_capacitance = data(section+"/Cm", 1.0 ); //uF/cm^2
     M_surface_to_volume_ratio = data(section+"/Chi", 1400.0 );// 1/cm
+
+    std::string model_section = section + "/" + M_ionicModelName;
+    std::string integrator = data(model_section + "/integrator", "native");
+    M_substepRelativeTolerance = data(model_section + "/substep_rtol", 1e-1);
+    M_substepAbsoluteTolerance = data(model_section + "/substep_atol", 1e-6);
+    M_maxSubsteps = data(model_section + "/max_substeps", 100);
+    M_substepStiffness = data(model_section + "/substep_stiffness", 1.0);
+    if ("native" == integrator) setIntegrator(IonicIntegrator::Native);
+    else if ("rush_larsen" == integrator) setIntegrator(IonicIntegrator::RushLarsen);
+    else if ("grl2" == integrator) setIntegrator(IonicIntegrator::GeneralizedRushLarsen2);
+    else if ("adaptive" == integrator) setIntegrator(IonicIntegrator::Adaptive);
+    else
+    {
+        throw std::runtime_error("IonicModel: unknown integrator " + integrator + " for " + M_ionicModelName + ". Options: native, rush_larsen, grl2, adaptive");
+    }
+    if (IonicIntegrator::Native != M_integrator)
+    {
+        std::cout << "* IonicModel: " << M_ionicModelName << " using the " << integrator << " integrator" << std::endl;
+    }
+
+    if (data(model_section + "/use_lut", false))
+    {
+        setLUTGrid(data(model_section + "/lut_vmin", -100.0),
+                   data(model_section + "/lut_vmax", 80.0),
+                   data(model_section + "/lut_dv", 0.01));
+        setUseLUT(true);
+        std::cout << "* IonicModel: " << M_ionicModelName << " using the lookup table " << M_lut.vmin() << ":" << M_lut.dv() << ":" << M_lut.vmax() << " mV" << std::endl;
+    }
+}
+
+void IonicModel::setUseLUT(bool use_lut)
+{
+    if (use_lut && numVoltageFunctions() == 0)
+    {
+        throw std::runtime_error("IonicModel: " + M_ionicModelName + " does not support the lookup table");
+    }
+    M_useLUT = use_lut;
+}
+
+void IonicModel::setLUTGrid(double vmin, double vmax, double dv)
+{
+    M_lut.setGrid(vmin, vmax, dv);
+    M_luts.clear();
+}
+
+void IonicModel::prepareLUT(double dt)
+{
+    if (!M_useLUT) return;
+    if (!M_lut.empty() && dt == M_lutTimestep && M_cellType == M_lutCellType) return;
+    for (auto && entry : M_luts)
+    {
+        if (entry.dt == dt && entry.cell_type == M_cellType)
+        {
+            selectLUT(dt);
+            return;
+        }
+    }
+    // Same grid, new table: the tables of the other time steps are kept
+    VoltageLUT lut(M_lut);
+    lut.build(numVoltageFunctions(), [this, dt](double v, double * values)
+    {
+        evaluateVoltageFunctions(v, dt, values);
+    });
+    M_luts.push_back( { dt, M_cellType, lut } );
+    selectLUT(dt);
+}
+
+void IonicModel::selectLUT(double dt)
+{
+    if (!M_useLUT) return;
+    if (!M_lut.empty() && dt == M_lutTimestep && M_cellType == M_lutCellType) return;
+    for (auto && entry : M_luts)
+    {
+        if (entry.dt == dt && entry.cell_type == M_cellType)
+        {
+            M_lut = entry.lut;
+            M_lutTimestep = dt;
+            M_lutCellType = M_cellType;
+            return;
+        }
+    }
+    throw std::runtime_error("IonicModel: " + M_ionicModelName + ": no lookup table for dt = " + std::to_string(dt) + ", call prepareLUT before the cell loops");
+}
+
+void IonicModel::shareLUT(const IonicModel& model)
+{
+    M_lut = model.M_lut;
+    M_lutTimestep = model.M_lutTimestep;
+    M_lutCellType = model.M_lutCellType;
+    M_luts = model.M_luts;
+}
+
+void IonicModel::setIntegrator(IonicIntegrator integrator)
+{
+    if (IonicIntegrator::Native != integrator && !hasRates())
+    {
+        throw std::runtime_error("IonicModel: " + M_ionicModelName + " does not implement evaluateRates, use the native integrator");
+    }
+    M_integrator = integrator;
+}
+
+double
+IonicModel::evaluateRates( std::vector<double>& /*variables*/,
+                           double /*appliedCurrent*/,
+                           std::vector<double>& /*rhs*/,
+                           std::vector<double>& /*jac*/ )
+{
+    throw std::runtime_error("Calling Base Class IonicModel::evaluateRates");
+    return 0.0;
+}
+
+namespace
+{
+// phi(z) = (exp(z) - 1) / z
+inline double phi(double z)
+{
+    return (std::abs(z) < 1e-12) ? 1.0 : std::expm1(z) / z;
+}
+}
+
+double
+IonicModel::integrateVariables( std::vector<double>& variables,
+                                double appliedCurrent,
+                                double dt)
+{
+    M_rhs.resize(M_numVariables);
+    M_jac.resize(M_numVariables);
+    M_stage.resize(M_numVariables);
+
+    double Iion = evaluateRates(variables, appliedCurrent, M_rhs, M_jac);
+    switch (M_integrator)
+    {
+        case IonicIntegrator::RushLarsen:
+        {
+            for (int k = 1; k < M_numVariables; ++k)
+            {
+                variables[k] += dt * phi(M_jac[k] * dt) * M_rhs[k];
+            }
+            return Iion;
+        }
+        case IonicIntegrator::GeneralizedRushLarsen2:
+        {
+            double stiffness = 0.0;
+            for (int k = 1; k < M_numVariables; ++k)
+            {
+                stiffness = std::max(stiffness, std::abs(M_jac[k] * dt));
+            }
+            int substeps = std::max(1, static_cast<int>(std::ceil(stiffness / M_substepStiffness)));
+            substeps = std::min(substeps, M_maxSubsteps);
+            const double h = dt / substeps;
+            // The potential is advanced locally in the substeps and restored at the end:
+            // the caller updates it with the average current
+            const double V = variables[0];
+            double Iion_average = 0.0;
+            for (int s = 0; s < substeps; ++s)
+            {
+                if (s > 0) Iion = evaluateRates(variables, appliedCurrent, M_rhs, M_jac);
+                // Half step
+                M_stage[0] = variables[0] - 0.5 * h * (Iion + appliedCurrent);
+                for (int k = 1; k < M_numVariables; ++k)
+                {
+                    M_stage[k] = variables[k] + 0.5 * h * phi(0.5 * M_jac[k] * h) * M_rhs[k];
+                }
+                Iion = evaluateRates(M_stage, appliedCurrent, M_rhs, M_jac);
+                // Full step from w^n with the rates linearized at the half step
+                for (int k = 1; k < M_numVariables; ++k)
+                {
+                    double rhs = M_rhs[k] + M_jac[k] * (variables[k] - M_stage[k]);
+                    variables[k] += h * phi(M_jac[k] * h) * rhs;
+                }
+                variables[0] -= h * (Iion + appliedCurrent);
+                Iion_average += Iion;
+            }
+            variables[0] = V;
+            return Iion_average / substeps;
+        }
+        case IonicIntegrator::Adaptive:
+        {
+            int substeps = 1;
+            for (int k = 1; k < M_numVariables; ++k)
+            {
+                double dw = dt * phi(M_jac[k] * dt) * M_rhs[k];
+                double w = std::max(std::abs(variables[k]), std::abs(variables[k] + dw));
+                double tol = M_substepRelativeTolerance * w + M_substepAbsoluteTolerance;
+                dw = std::abs(dw);
+                substeps = std::max(substeps, static_cast<int>(std::ceil(dw / tol)));
+            }
+            substeps = std::min(substeps, M_maxSubsteps);
+            const double h = dt / substeps;
+            double Iion_average = 0.0;
+            for (int s = 0; s < substeps; ++s)
+            {
+                if (s > 0) Iion = evaluateRates(variables, appliedCurrent, M_rhs, M_jac);
+                for (int k = 1; k < M_numVariables; ++k)
+                {
+                    variables[k] += h * phi(M_jac[k] * h) * M_rhs[k];
+                }
+                Iion_average += Iion;
+            }
+            return Iion_average / substeps;
+        }
+        default:
+        {
+            throw std::runtime_error("IonicModel::integrateVariables: use updateVariables for the native integrator");
+        }
+    }
+    return Iion;
 }
 
 double
@@ -52,6 +272,12 @@ IonicModel::solve( std::vector<double>& variables,
                    double appliedCurrent,
                    double dt)
 {
+    if (IonicIntegrator::Native != M_integrator)
+    {
+        // Cm dV/dt = - Iion - Istim
+        variables[0] += dt * (- integrateVariables(variables, appliedCurrent, dt) - appliedCurrent);
+        return;
+    }
     updateVariables(variables, appliedCurrent, dt);
     // evaluateIonicCurrent does not containe appliedCurrent
     // Cm dV/dt = - Iion - Istim
@@ -59,5 +285,105 @@ IonicModel::solve( std::vector<double>& variables,
 }
 
 
+void
+IonicModel::updateVariablesBatch( double * const * variables,
+                                  const double * Q,
+                                  const double * appliedCurrent,
+                                  double * iion,
+                                  double * diion,
+                                  int n,
+                                  double dt,
+                                  double h )
+{
+    // Work vectors of the model: no allocations after the first call
+    std::vector<double>& values = M_batchValues;
+    std::vector<double>& old_values = M_batchOldValues;
+    std::vector<double>& rhs = M_batchRhs;
+    values.resize(M_numVariables, 0.0);
+    old_values.resize(M_numVariables, 0.0);
+    rhs.resize(M_numVariables, 0.0);
+    for (int i = 0; i < n; ++i)
+    {
+        for (int k = 0; k < M_numVariables; ++k)
+        {
+            values[k] = variables[k][i];
+            old_values[k] = values[k];
+        }
+        // As in the reaction step: Q^n is passed only in the first entry of rhs
+        old_values[0] = 0.0;
+        if (IonicIntegrator::Native == M_integrator)
+        {
+            updateVariables(values, appliedCurrent[i], dt);
+            iion[i] = evaluateIonicCurrent(values, appliedCurrent[i], dt);
+        }
+        else
+        {
+            iion[i] = integrateVariables(values, appliedCurrent[i], dt);
+        }
+        if (diion)
+        {
+            rhs[0] = Q[i];
+            if (isSecondOrderImplemented()) diion[i] = evaluateIonicCurrentTimeDerivative(values, rhs, dt, h);
+            else diion[i] = evaluateIonicCurrentTimeDerivative(values, old_values, dt, h);
+        }
+        for (int k = 1; k < M_numVariables; ++k)
+        {
+            variables[k][i] = values[k];
+        }
+    }
+}
+
+void
+IonicModel::solveBatch( double * const * variables,
+                        const double * appliedCurrent,
+                        double * iion,
+                        int n,
+                        double dt)
+{
+    advanceBatch(variables, nullptr, appliedCurrent, iion, nullptr, n, dt);
+    // Cm dV/dt = - Iion - Istim
+    double * V = variables[0];
+    for (int i = 0; i < n; ++i)
+    {
+        V[i] += dt * (- iion[i] - appliedCurrent[i]);
+    }
+}
+
+void
+IonicModel::advanceBatch( double * const * variables,
+                          const double * Q,
+                          const double * appliedCurrent,
+                          double * iion,
+                          double * diion,
+                          int n,
+                          double dt,
+                          double h )
+{
+    // The vectorized kernels of the models implement the native integrator
+    if (IonicIntegrator::Native == M_integrator) updateVariablesBatch(variables, Q, appliedCurrent, iion, diion, n, dt, h);
+    else IonicModel::updateVariablesBatch(variables, Q, appliedCurrent, iion, diion, n, dt, h);
+}
+
+void
+IonicModel::evaluateIonicCurrentBatch( double * const * variables,
+                                       const double * appliedCurrent,
+                                       double * iion,
+                                       int n )
+{
+    // The potential is read only: the other variables are copied
+    M_batchState.resize(M_numVariables * n);
+    M_batchStatePointers.resize(M_numVariables);
+    M_batchStatePointers[0] = variables[0];
+    for (int k = 1; k < M_numVariables; ++k)
+    {
+        M_batchStatePointers[k] = M_batchState.data() + k * n;
+        std::copy(variables[k], variables[k] + n, M_batchStatePointers[k]);
+    }
+    // The table holds the functions of the time step of the reaction step
+    const bool use_lut = M_useLUT;
+    M_useLUT = false;
+    advanceBatch(M_batchStatePointers.data(), nullptr, appliedCurrent, iion, nullptr, n, 0.0);
+    M_useLUT = use_lut;
+}
 
 } // namespace BeatIt
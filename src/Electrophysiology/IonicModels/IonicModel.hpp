@@ -6,10 +6,18 @@
 #include <vector>
 #include "Util/Factory.hpp"
 #include "Electrophysiology/IonicModels/IonicModelsOptions.hpp"
+#include "Electrophysiology/IonicModels/VoltageLUT.hpp"
 
 
 class GetPot;
 
+// The cell kernels are inlined in the vectorized loops of updateVariablesBatch
+#if defined(__GNUC__)
+#define BEATIT_CELL_KERNEL inline __attribute__((always_inline))
+#else
+#define BEATIT_CELL_KERNEL inline
+#endif
+
 namespace BeatIt
 {
 
@@ -30,6 +38,12 @@ public:
     IonicModel(int numVar, int numGatingVar, const std::string& name = "empty", CellType cell_type = CellType::MCell);
     //! Virtual destructor
     virtual ~IonicModel() {}
+    //! Copy of the ionic model, with the same parameters
+    /*!
+     *  The scalar methods cache values of the last evaluated cell,
+     *  therefore each thread of the reaction step uses its own copy.
+     */
+    virtual IonicModel* clone() const = 0;
     //! Solve method
 	/*!
 	 *  \param [in] variables Vector containing the local value of all variables (Variables  includes potential)
@@ -85,6 +99,185 @@ public:
         return 0.0;
     }
 
+    //! Access to the variables of the cell i stored as structure of arrays
+    struct BatchCell
+    {
+        double * const * variables;
+        int i;
+        double& operator[](int k) const
+        {
+            return variables[k][i];
+        }
+    };
+
+    //! Update the variables of n cells stored as structure of arrays
+    /*!
+     *  Same operations of the reaction step for a single cell: updateVariables,
+     *  evaluateIonicCurrent and evaluateIonicCurrentTimeDerivative.
+     *  The default implementation loops over the cells calling these methods.
+     *  Models overriding it evaluate the cells in SIMD lanes (#pragma omp simd):
+     *  the results differ from the scalar path only in the rounding of the
+     *  vectorized exp/log (the 0D tests check the solution norm of the batched
+     *  kernel against the scalar one up to 1e-8).
+     *
+     *  \param [in,out] variables variables[k][i] is the variable k of the cell i (variables[0] = V, not modified)
+     *  \param [in] Q Q^n of each cell. It can be nullptr if diion is nullptr.
+     *  \param [in] appliedCurrent value of the applied current of each cell
+     *  \param [out] iion total ionic current of each cell (current_scaling is not applied)
+     *  \param [out] diion time derivative of the ionic current of each cell. It can be nullptr.
+     *  \param [in] n number of cells
+     *  \param [in] dt        Timestep
+     *  \param [in] h         mesh size
+     */
+    virtual void updateVariablesBatch( double * const * variables,
+                                       const double * Q,
+                                       const double * appliedCurrent,
+                                       double * iion,
+                                       double * diion,
+                                       int n,
+                                       double dt,
+                                       double h = 0.0 );
+    //! Solve method for n cells stored as structure of arrays
+    /*!
+     *  Batched version of solve
+     *  \param [in,out] variables variables[k][i] is the variable k of the cell i (variables[0] = V)
+     *  \param [in] appliedCurrent value of the applied current of each cell
+     *  \param [out] iion work array of size n, on exit it contains the ionic current
+     *  \param [in] n number of cells
+     *  \param [in] dt        Timestep
+     */
+    void solveBatch(double * const * variables, const double * appliedCurrent, double * iion, int n, double dt = 1e-3);
+    //! Update the variables of n cells with the selected integrator
+    /*!
+     *  Same arguments of updateVariablesBatch.
+     *  With IonicIntegrator::Native it calls updateVariablesBatch,
+     *  otherwise each cell is advanced with integrateVariables.
+     */
+    void advanceBatch( double * const * variables,
+                       const double * Q,
+                       const double * appliedCurrent,
+                       double * iion,
+                       double * diion,
+                       int n,
+                       double dt,
+                       double h = 0.0 );
+
+    //! Ionic current of n cells at the given state, without advancing the variables
+    /*!
+     *  The state is advanced by a step of zero length on a copy, without the lookup table:
+     *  for every integrator the current is the one of the given state
+     *  (the Rush-Larsen integrator otherwise returns the current before the step).
+     *  \param [in] variables variables[k][i] is the variable k of the cell i (variables[0] = V)
+     *  \param [in] appliedCurrent value of the applied current of each cell
+     *  \param [out] iion total ionic current of each cell (current_scaling is not applied)
+     */
+    void evaluateIonicCurrentBatch( double * const * variables,
+                                    const double * appliedCurrent,
+                                    double * iion,
+                                    int n );
+
+    //! Right hand side of the variables (excluding the potential) in linearized form
+    /*!
+     *  dw_k/dt = rhs_k, jac_k = d rhs_k / d w_k (diagonal of the Jacobian).
+     *  For gates rhs_k = (w_inf - w_k) / tau_w = alpha (1 - w_k) - beta w_k and jac_k = -1 / tau_w,
+     *  for the other variables rhs_k is the explicit right hand side and jac_k may be 0.
+     *  Algebraic variables have rhs_k = jac_k = 0 and their new value is written in variables.
+     *  Used by the Rush-Larsen integrators.
+     *
+     *  \param [in,out] variables Vector containing the local value of all variables (Variables  includes potential)
+     *  \param [in] appliedCurrent value of the applied current
+     *  \param [out] rhs right hand side of each variable (rhs[0] is not used)
+     *  \param [out] jac diagonal of the Jacobian of the right hand side (jac[0] is not used)
+     *  \return total ionic current evaluated at variables
+     */
+    virtual double evaluateRates( std::vector<double>& variables,
+                                  double appliedCurrent,
+                                  std::vector<double>& rhs,
+                                  std::vector<double>& jac );
+    //! Does the model implement evaluateRates?
+    virtual bool hasRates() const
+    {
+        return false;
+    }
+    //! Update the variables (excluding the potential) with the selected integrator
+    /*!
+     *  RushLarsen: w^n+1 = w^n + dt phi(jac dt) rhs, with phi(z) = (exp(z)-1)/z,
+     *              exact for the gates and forward Euler where jac = 0.
+     *  GeneralizedRushLarsen2: rates evaluated at the GRL1 half step (with the potential advanced by
+     *            the current at t^n), then a full step from w^n. The step is split in substeps such that
+     *            |jac h| <= substep_stiffness (default 1), up to max_substeps: the explicit coupling of the
+     *            stiff buffers is otherwise unstable for the larger time steps.
+     *  Adaptive: the step is split in GRL1 substeps such that each variable changes by less than
+     *            substep_rtol * |w| + substep_atol (defaults 0.1 and 1e-6), up to max_substeps (default 100).
+     *
+     *  \param [in,out] variables Vector containing the local value of all variables (Variables  includes potential)
+     *  \param [in] appliedCurrent value of the applied current
+     *  \param [in] dt        Timestep
+     *  \return ionic current used for the potential: at w^n (RushLarsen), averaged over the substeps (GRL2, Adaptive)
+     */
+    double integrateVariables(std::vector<double>& variables, double appliedCurrent, double dt);
+
+    //! Select the integrator of the variables
+    /*!
+     *  From the input file: section/ModelName/integrator = native, rush_larsen, grl2 or adaptive
+     */
+    void setIntegrator(IonicIntegrator integrator);
+    IonicIntegrator integrator() const
+    {
+        return M_integrator;
+    }
+
+    //! Number of functions of the potential tabulated in the lookup table
+    /*!
+     *  Models supporting the lookup table return the number of the expressions
+     *  depending only on the potential and the time step, evaluated by evaluateVoltageFunctions.
+     */
+    virtual int numVoltageFunctions() const
+    {
+        return 0;
+    }
+    //! Evaluate the functions of the potential tabulated in the lookup table
+    /*!
+     *  \param [in] v transmembrane potential
+     *  \param [in] dt        Timestep
+     *  \param [out] values array of size numVoltageFunctions()
+     */
+    virtual void evaluateVoltageFunctions(double /*v*/, double /*dt*/, double * /*values*/) const
+    {
+        throw std::runtime_error("Calling Base Class IonicModel::evaluateVoltageFunctions");
+    }
+    //! Use the lookup table for the functions of the potential
+    /*!
+     *  From the input file: section/ModelName/use_lut = true,
+     *  with the grid lut_vmin:lut_dv:lut_vmax (defaults -100:0.01:80 mV)
+     */
+    void setUseLUT(bool use_lut);
+    bool useLUT() const
+    {
+        return M_useLUT;
+    }
+    //! Set the grid of the lookup table
+    void setLUTGrid(double vmin, double vmax, double dv);
+    //! Build the lookup table for the time step dt, if needed, and use it
+    /*!
+     *  The table depends on dt (it contains exp(-dt/tau) of the gates) and on the cell type.
+     *  A table is kept for each time step prepared: the reaction step prepares the tables
+     *  of all its time steps before the cell loops, then copies them to the per thread
+     *  copies with shareLUT. The kernels only select them (see selectLUT).
+     */
+    void prepareLUT(double dt);
+    //! Use the table prepared for dt: never builds a table
+    /*!
+     *  Called by the kernels, throws if prepareLUT(dt) has not been called
+     */
+    void selectLUT(double dt);
+    //! Use the lookup tables of another copy of the model
+    void shareLUT(const IonicModel& model);
+    const VoltageLUT& voltageLUT() const
+    {
+        return M_lut;
+    }
+
     virtual double evaluateSAC(double /*v*/ , double /*I4f*/)
     {
         return 0.0;
@@ -198,6 +391,42 @@ protected:
     // Surface to Volume ratio \Chi
     double M_surface_to_volume_ratio;
 
+    /// Integrator of the variables
+    IonicIntegrator M_integrator;
+    /// Adaptive integrator: relative and absolute tolerance on the change of the variables in a substep
+    double M_substepRelativeTolerance;
+    double M_substepAbsoluteTolerance;
+    /// Adaptive and GRL2 integrators: maximum number of substeps
+    int    M_maxSubsteps;
+    /// GRL2 integrator: bound on |jac h| in a substep
+    double M_substepStiffness;
+    /// Work vectors of integrateVariables
+    std::vector<double> M_rhs;
+    std::vector<double> M_jac;
+    std::vector<double> M_stage;
+    /// Work vectors of updateVariablesBatch
+    std::vector<double> M_batchValues;
+    std::vector<double> M_batchOldValues;
+    std::vector<double> M_batchRhs;
+    /// Copy of the state of evaluateIonicCurrentBatch
+    std::vector<double> M_batchState;
+    std::vector<double *> M_batchStatePointers;
+
+    /// Lookup table of the functions of the potential
+    bool       M_useLUT;
+    VoltageLUT M_lut;
+    /// Time step and cell type of the table
+    double     M_lutTimestep;
+    CellType   M_lutCellType;
+    /// Tables prepared for each time step and cell type
+    struct LUTEntry
+    {
+        double     dt;
+        CellType   cell_type;
+        VoltageLUT lut;
+    };
+    std::vector<LUTEntry> M_luts;
+
 };
 
 
@@ -53,6 +53,10 @@
 namespace BeatIt
 {
     enum class CellType { Endocardial, Epicardial, MCell };
+    enum class IonicIntegrator { Native,                  // updateVariables of the ionic model
+                                 RushLarsen,              // RL / GRL1
+                                 GeneralizedRushLarsen2,  // GRL2
+                                 Adaptive };              // GRL1 with substeps
 }
 
 
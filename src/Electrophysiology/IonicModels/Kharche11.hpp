@@ -68,6 +68,7 @@ public:
      *
      */
     Kharche11();
+    IonicModel* clone() const { return new Kharche11(*this); }
 
     void setup(GetPot& data, std::string section);
 
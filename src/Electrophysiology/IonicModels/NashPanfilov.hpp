@@ -72,6 +72,7 @@ public:
      */
     NashPanfilov();
     ~NashPanfilov() {};
+    IonicModel* clone() const { return new NashPanfilov(*this); }
 
     //! Update all the variables in the ionic model
     /*!
@@ -47,6 +47,7 @@
  *
  */
 
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include "Electrophysiology/IonicModels/ORd.hpp"
@@ -62,6 +63,8 @@ IonicModel* createORd()
 
 ORd::ORd()
   : super(41,0, "ORd", CellType::MCell)
+  , M_Iion(0.0)
+  , Ist(0.0)
 {
     // Without potential
 
@@ -236,74 +239,166 @@ ORd::initialize(std::vector<double>& variables)
 }
 
 
-//! Update all the variables in the ionic model
-/*!
- *  \param [in] variables Vector containing the local value of all variables
- *  \param [in] dt        Timestep
- */
-void
-ORd::updateVariables(std::vector<double>& variables, double appliedCurrent, double dt)
+ORd::CellTypeParameters
+ORd::cellTypeParameters() const
 {
-	// For compatibility  with the original code where the applied stimulus in opposite
-	Ist = appliedCurrent;
-    revpots(variables);
-    RGC(variables, dt);
-    FBC(variables, dt);
+	CellTypeParameters p;
+	p.GNaL=0.0075;
+	p.Gto=0.02;
+	p.PCa=0.0001;
+	p.GKr=0.046;
+	p.GKs=0.0034;
+	p.GK1=0.1908;
+	p.Gncx=0.0008;
+	p.Pnak=30;
+	p.GKb=0.003;
+	p.delta_epi=0.0;
+	p.Jrel=1.0;
+	p.Jup=1.0;
+	p.cmdnmax=1.0;
+	if (M_cellType == CellType::Epicardial)
+	{
+		p.GNaL*=0.6;
+		p.Gto*=4.0;
+		p.PCa*=1.2;
+		p.GKr*=1.3;
+		p.GKs*=1.4;
+		p.GK1*=1.2;
+		p.Gncx*=1.1;
+		p.Pnak*=0.9;
+		p.GKb*=0.6;
+		p.delta_epi=1.0;
+		p.Jup=1.3;
+		p.cmdnmax=1.3;
+	}
+	else if (M_cellType == CellType::MCell)
+	{
+		p.Gto*=4.0;
+		p.PCa*=2.5;
+		p.GKr*=0.8;
+		p.GK1*=1.3;
+		p.Gncx*=1.4;
+		p.Pnak*=0.7;
+		p.Jrel=1.7;
+	}
+	return p;
 }
 
-
-void
-ORd::updateVariables(std::vector<double>& variables, std::vector<double>& rhs, double appliedCurrent, double dt, bool overwrite)
-{
-    // For compatibility  with the original code where the applied stimulus in opposite
-    Ist = appliedCurrent;
-    revpots(variables);
-    RGC(variables, dt);
-    FBC(variables, dt);
-}
-//! Evaluate total ionic current for the computation of the potential
-/*!
- *  \param [in] variables Vector containing the local value of all variables
- *  \param [in] appliedCurrent value of the applied current
- *  \param [in] dt        Timestep
- */
-double
-ORd::evaluateIonicCurrent(std::vector<double>& variables, double appliedCurrent, double dt)
+BEATIT_CELL_KERNEL void
+ORd::voltageFunctions(double v, double dt, const CellTypeParameters& p, double * vf) const
 {
-	// For compatibility  with the original code where the applied stimulus in opposite
-	Ist =appliedCurrent;
-	return (INa+INaL+Ito+ICaL+ICaNa+ICaK+IKr+IKs+IK1+INaCa+INaK+INab+IKb+IpCa+ICab/*+Ist*/);
+	double vfrt=v*F/(R*T);
 
-}
+	// m variable
+	double tm=1.0/(6.765*std::exp((v+11.64)/34.77)+8.552*std::exp(-(v+77.42)/5.955));
+	vf[VF_mss]=1.0/(1.0+std::exp((-(v+39.57))/9.871));
+	vf[VF_m_exp]=std::exp(-dt/tm);
 
+	// h variable
+	double thf=1.0/(1.432e-5*std::exp(-(v+1.196)/6.285)+6.149*std::exp((v+0.5096)/20.27));
+	double ths=1.0/(0.009794*std::exp(-(v+17.95)/28.05)+0.3343*std::exp((v+5.730)/56.66));
+	vf[VF_hss]=1.0/(1+std::exp((v+82.90)/6.086));
+	vf[VF_hf_exp]=std::exp(-dt/thf);
+	vf[VF_hs_exp]=std::exp(-dt/ths);
+	double tj=2.038+1.0/(0.02136*std::exp(-(v+100.6)/8.281)+0.3052*std::exp((v+0.9941)/38.45));
+	vf[VF_j_exp]=std::exp(-dt/tj);
+	double thsp=3.0*ths;
+	vf[VF_hssp]=1.0/(1+std::exp((v+89.1)/6.086));
+	vf[VF_hsp_exp]=std::exp(-dt/thsp);
+	double tjp=1.46*tj;
+	vf[VF_jp_exp]=std::exp(-dt/tjp);
 
-void
-ORd::revpots(std::vector<double>& variables)
-{
-    double nai = variables[1];
-    double ki  = variables[3];
-    ENa=(R*T/F)*std::log(nao/nai);
-    EK=(R*T/F)*std::log( ko/ki);
-    EKs=(R*T/F)*std::log(( ko+0.01833* nao)/(ki+0.01833*nai));
+	double tmL=tm;
+	vf[VF_mLss]=1.0/(1.0+std::exp((-(v+42.85))/5.264));
+	vf[VF_mL_exp]=std::exp(-dt/tmL);
+	vf[VF_hLss]=1.0/(1.0+std::exp((v+87.61)/7.488));
+	vf[VF_hLssp]=1.0/(1.0+std::exp((v+93.81)/7.488));
+
+	double ta=1.0515/(1.0/(1.2089*(1.0+std::exp(-(v-18.4099)/29.3814)))+3.5/(1.0+std::exp((v+100.0)/29.3814)));
+	vf[VF_ass]=1.0/(1.0+std::exp((-(v-14.34))/14.82));
+	vf[VF_a_exp]=std::exp(-dt/ta);
+
+	double delta_epi=1.0-p.delta_epi*(0.95/(1.0+std::exp((v+70.0)/5.0)));
+	double tiF=4.562+1/(0.3933*std::exp((-(v+100.0))/100.0)+0.08004*std::exp((v+50.0)/16.59));
+	double tiS=23.62+1/(0.001416*std::exp((-(v+96.52))/59.05)+1.780e-8*std::exp((v+114.1)/8.079));
+	tiF*=delta_epi;
+	tiS*=delta_epi;
+	vf[VF_iss]=1.0/(1.0+std::exp((v+43.94)/5.711));
+	vf[VF_iF_exp]=std::exp(-dt/tiF);
+	vf[VF_iS_exp]=std::exp(-dt/tiS);
+	vf[VF_AiF]=1.0/(1.0+std::exp((v-213.6)/151.2));
+	vf[VF_assp]=1.0/(1.0+std::exp((-(v-24.34))/14.82));
+
+	double dti_develop=1.354+1.0e-4/(std::exp((v-167.4)/15.89)+std::exp(-(v-12.23)/0.2154));
+	double dti_recover=1.0-0.5/(1.0+std::exp((v+70.0)/20.0));
+	double tiFp=dti_develop*dti_recover*tiF;
+	double tiSp=dti_develop*dti_recover*tiS;
+	vf[VF_iFp_exp]=std::exp(-dt/tiFp);
+	vf[VF_iSp_exp]=std::exp(-dt/tiSp);
+
+	double td=0.6+1.0/(std::exp(-0.05*(v+6.0))+std::exp(0.09*(v+14.0)));
+	vf[VF_dss]=1.0/(1.0+std::exp((-(v+3.940))/4.230));
+	vf[VF_d_exp]=std::exp(-dt/td);
+
+	double tff=7.0+1.0/(0.0045*std::exp(-(v+20.0)/10.0)+0.0045*std::exp((v+20.0)/10.0));
+	double tfs=1000.0+1.0/(0.000035*std::exp(-(v+5.0)/4.0)+0.000035*std::exp((v+5.0)/6.0));
+	vf[VF_fss]=1.0/(1.0+std::exp((v+19.58)/3.696));
+	vf[VF_ff_exp]=std::exp(-dt/tff);
+	vf[VF_fs_exp]=std::exp(-dt/tfs);
+	double tfcaf=7.0+1.0/(0.04*std::exp(-(v-4.0)/7.0)+0.04*std::exp((v-4.0)/7.0));
+	double tfcas=100.0+1.0/(0.00012*std::exp(-v/3.0)+0.00012*std::exp(v/7.0));
+	vf[VF_fcaf_exp]=std::exp(-dt/tfcaf);
+	vf[VF_fcas_exp]=std::exp(-dt/tfcas);
+	vf[VF_Afcaf]=0.3+0.6/(1.0+std::exp((v-10.0)/10.0));
+	double tffp=2.5*tff;
+	vf[VF_ffp_exp]=std::exp(-dt/tffp);
+	double tfcafp=2.5*tfcaf;
+	vf[VF_fcafp_exp]=std::exp(-dt/tfcafp);
+	vf[VF_exp_vfrt]=std::exp(1.0*vfrt);
+	vf[VF_exp_2vfrt]=std::exp(2.0*vfrt);
+
+	double txrf=12.98+1.0/(0.3652*std::exp((v-31.66)/3.869)+4.123e-5*std::exp((-(v-47.78))/20.38));
+	double txrs=1.865+1.0/(0.06629*std::exp((v-34.70)/7.355)+1.128e-5*std::exp((-(v-29.74))/25.94));
+	vf[VF_xrss]=1.0/(1.0+std::exp((-(v+8.337))/6.789));
+	vf[VF_xrf_exp]=std::exp(-dt/txrf);
+	vf[VF_xrs_exp]=std::exp(-dt/txrs);
+	vf[VF_Axrf]=1.0/(1.0+std::exp((v+54.81)/38.21));
+	vf[VF_rkr]=1.0/(1.0+std::exp((v+55.0)/75.0))*1.0/(1.0+std::exp((v-10.0)/30.0));
+
+	double txs1=817.3+1.0/(2.326e-4*std::exp((v+48.28)/17.80)+0.001292*std::exp((-(v+210.0))/230.0));
+	double txs2=1.0/(0.01*std::exp((v-50.0)/20.0)+0.0193*std::exp((-(v+66.54))/31.0));
+	vf[VF_xs1ss]=1.0/(1.0+std::exp((-(v+11.60))/8.932));
+	vf[VF_xs1_exp]=std::exp(-dt/txs1);
+	vf[VF_xs2_exp]=std::exp(-dt/txs2);
+
+	double txk1=122.2/(std::exp((-(v+127.2))/20.36)+std::exp((v+236.8)/69.33));
+	vf[VF_xk1ss]=1.0/(1.0+std::exp(-(v+2.5538*ko+144.59)/(1.5692*ko+3.8115)));
+	vf[VF_xk1_exp]=std::exp(-dt/txk1);
+	vf[VF_rk1]=1.0/(1.0+std::exp((v+105.8-2.6*ko)/9.493));
+
+	double qna=0.5224;
+	double qca=0.1670;
+	vf[VF_hca]=std::exp((qca*v*F)/(R*T));
+	vf[VF_hna]=std::exp((qna*v*F)/(R*T));
+
+	double Knai0=9.073;
+	double Knao0=27.78;
+	double delta=-0.1550;
+	vf[VF_Knai]=Knai0*std::exp((delta*v*F)/(3.0*R*T));
+	vf[VF_Knao]=Knao0*std::exp(((1.0-delta)*v*F)/(3.0*R*T));
+
+	vf[VF_xkb]=1.0/(1.0+std::exp(-(v-14.48)/18.34));
 }
 
 void
-ORd::initializeSaveData(std::ostream& output)
+ORd::evaluateVoltageFunctions(double v, double dt, double * values) const
 {
-	// time -  0
-	output << "time v ";
-	//  1 - 10
-	output << "nai nass ki kss cai cass cansr cajsr m hf ";
-	// 11 - 20
-	output << "hs j hsp jp mL hL hLp a iF iS ";
-	// 21 - 30
-	output << "ap iFp iSp d ff fs fcaf fcas jca nca";
-	// 31 - 40
-	output << "ffp fcafp xrf xrs xs1 xs2 xk1 Jrelnp Jrelp CaMKt\n";
+	voltageFunctions(v, dt, cellTypeParameters(), values);
 }
 
-void
-ORd::RGC(std::vector<double>& variables, double dt)
+template <bool UseLUT, class Variables>
+BEATIT_CELL_KERNEL double
+ORd::cellStep(Variables& variables, double Ist, double dt, const CellTypeParameters& p, const VoltageLUT& lut) const
 {
 	double v     = variables[0];
 	double nai   = variables[1];
@@ -343,147 +438,110 @@ ORd::RGC(std::vector<double>& variables, double dt)
 	double xs1   = variables[35];
 	double xs2   = variables[36];
 	double xk1   = variables[37];
-	//double Jrelnp= variables[38];
-	//double Jrelp = variables[39];
+	double Jrelnp= variables[38];
+	double Jrelp = variables[39];
 	double CaMKt = variables[40];
 
 
-	CaMKb=CaMKo*(1.0-CaMKt)/(1.0+KmCaM/cass);
-	CaMKa=CaMKb+CaMKt;
+	// functions of the potential: interpolated or evaluated
+	double vf[NumVoltageFunctions];
+	if (UseLUT) lut.interpolate<NumVoltageFunctions>(v, vf);
+	else voltageFunctions(v, dt, p, vf);
+
+	// revpots: reversal potentials
+	double ENa=(R*T/F)*std::log(nao/nai);
+	double EK=(R*T/F)*std::log( ko/ki);
+	double EKs=(R*T/F)*std::log(( ko+0.01833* nao)/(ki+0.01833*nai));
+
+	// RGC: currents and gating variables
+	double CaMKb=CaMKo*(1.0-CaMKt)/(1.0+KmCaM/cass);
+	double CaMKa=CaMKb+CaMKt;
 	double vffrt=v*F*F/(R*T);
-	double vfrt=v*F/(R*T);
 
 	// m variable
-	double mss=1.0/(1.0+std::exp((-(v+39.57))/9.871));
-	double tm=1.0/(6.765*std::exp((v+11.64)/34.77)+8.552*std::exp(-(v+77.42)/5.955));
-	m=mss-(mss-m)*std::exp(-dt/tm);
+	m=vf[VF_mss]-(vf[VF_mss]-m)*vf[VF_m_exp];
 
 	// h variable
-	double hss=1.0/(1+std::exp((v+82.90)/6.086));
-	double thf=1.0/(1.432e-5*std::exp(-(v+1.196)/6.285)+6.149*std::exp((v+0.5096)/20.27));
-	double ths=1.0/(0.009794*std::exp(-(v+17.95)/28.05)+0.3343*std::exp((v+5.730)/56.66));
+	double hss=vf[VF_hss];
 	double Ahf=0.99;
 	double Ahs=1.0-Ahf;
-	hf=hss-(hss-hf)*std::exp(-dt/thf);
-	hs=hss-(hss-hs)*std::exp(-dt/ths);
+	hf=hss-(hss-hf)*vf[VF_hf_exp];
+	hs=hss-(hss-hs)*vf[VF_hs_exp];
 
 	double h=Ahf*hf+Ahs*hs;
 	double jss=hss;
-	double tj=2.038+1.0/(0.02136*std::exp(-(v+100.6)/8.281)+0.3052*std::exp((v+0.9941)/38.45));
-	j=jss-(jss-j)*std::exp(-dt/tj);
+	j=jss-(jss-j)*vf[VF_j_exp];
 
-	double hssp=1.0/(1+std::exp((v+89.1)/6.086));
-	double thsp=3.0*ths;
-	hsp=hssp-(hssp-hsp)*std::exp(-dt/thsp);
+	double hssp=vf[VF_hssp];
+	hsp=hssp-(hssp-hsp)*vf[VF_hsp_exp];
 
 	double hp=Ahf*hf+Ahs*hsp;
-	double tjp=1.46*tj;
-	jp=jss-(jss-jp)*std::exp(-dt/tjp);
+	jp=jss-(jss-jp)*vf[VF_jp_exp];
 
 	double GNa=75;
 	double fINap=(1.0/(1.0+KmCaMK/CaMKa));
-	INa=GNa*(v-ENa)*m*m*m*((1.0-fINap)*h*j+fINap*hp*jp);
+	double INa=GNa*(v-ENa)*m*m*m*((1.0-fINap)*h*j+fINap*hp*jp);
 
-	double mLss=1.0/(1.0+std::exp((-(v+42.85))/5.264));
-	double tmL=tm;
-	mL=mLss-(mLss-mL)*std::exp(-dt/tmL);
+	double mLss=vf[VF_mLss];
+	mL=mLss-(mLss-mL)*vf[VF_mL_exp];
 
-	double hLss=1.0/(1.0+std::exp((v+87.61)/7.488));
+	double hLss=vf[VF_hLss];
 	double thL=200.0;
 	hL=hLss-(hLss-hL)*std::exp(-dt/thL);
 
-	double hLssp=1.0/(1.0+std::exp((v+93.81)/7.488));
+	double hLssp=vf[VF_hLssp];
 	double thLp=3.0*thL;
 	hLp=hLssp-(hLssp-hLp)*std::exp(-dt/thLp);
 
-	double GNaL=0.0075;
-	if (M_cellType == CellType::Epicardial )
-	{
-		GNaL*=0.6;
-	}
+	double GNaL=p.GNaL;
 	double fINaLp=(1.0/(1.0+KmCaMK/CaMKa));
-	INaL=GNaL*(v-ENa)*mL*((1.0-fINaLp)*hL+fINaLp*hLp);
-
-	double ass=1.0/(1.0+std::exp((-(v-14.34))/14.82));
-	double ta=1.0515/(1.0/(1.2089*(1.0+std::exp(-(v-18.4099)/29.3814)))+3.5/(1.0+std::exp((v+100.0)/29.3814)));
-	a=ass-(ass-a)*std::exp(-dt/ta);
-
-	double iss=1.0/(1.0+std::exp((v+43.94)/5.711));
-	double delta_epi;
-	if (M_cellType == CellType::Epicardial)
-	{
-		delta_epi=1.0-(0.95/(1.0+std::exp((v+70.0)/5.0)));
-	}
-	else
-	{
-		delta_epi=1.0;
-	}
+	double INaL=GNaL*(v-ENa)*mL*((1.0-fINaLp)*hL+fINaLp*hLp);
 
-	double tiF=4.562+1/(0.3933*std::exp((-(v+100.0))/100.0)+0.08004*std::exp((v+50.0)/16.59));
-	double tiS=23.62+1/(0.001416*std::exp((-(v+96.52))/59.05)+1.780e-8*std::exp((v+114.1)/8.079));
-	tiF*=delta_epi;
-	tiS*=delta_epi;
+	double ass=vf[VF_ass];
+	a=ass-(ass-a)*vf[VF_a_exp];
 
-	double AiF=1.0/(1.0+std::exp((v-213.6)/151.2));
+	double iss=vf[VF_iss];
+	double AiF=vf[VF_AiF];
 	double AiS=1.0-AiF;
-	iF=iss-(iss-iF)*std::exp(-dt/tiF);
-	iS=iss-(iss-iS)*std::exp(-dt/tiS);
+	iF=iss-(iss-iF)*vf[VF_iF_exp];
+	iS=iss-(iss-iS)*vf[VF_iS_exp];
 
 	double i=AiF*iF+AiS*iS;
-	double assp=1.0/(1.0+std::exp((-(v-24.34))/14.82));
-	ap=assp-(assp-ap)*std::exp(-dt/ta);
+	double assp=vf[VF_assp];
+	ap=assp-(assp-ap)*vf[VF_a_exp];
 
-	double dti_develop=1.354+1.0e-4/(std::exp((v-167.4)/15.89)+std::exp(-(v-12.23)/0.2154));
-	double dti_recover=1.0-0.5/(1.0+std::exp((v+70.0)/20.0));
-	double tiFp=dti_develop*dti_recover*tiF;
-	double tiSp=dti_develop*dti_recover*tiS;
-	iFp=iss-(iss-iFp)*std::exp(-dt/tiFp);
-	iSp=iss-(iss-iSp)*std::exp(-dt/tiSp);
+	iFp=iss-(iss-iFp)*vf[VF_iFp_exp];
+	iSp=iss-(iss-iSp)*vf[VF_iSp_exp];
 
 	double ip=AiF*iFp+AiS*iSp;
-	double Gto=0.02;
-	if (M_cellType == CellType::Epicardial)
-	{
-		Gto*=4.0;
-	}
-	else if (M_cellType == CellType::MCell )
-	{
-		Gto*=4.0;
-	}
+	double Gto=p.Gto;
 	double fItop=(1.0/(1.0+KmCaMK/CaMKa));
-	Ito=Gto*(v-EK)*((1.0-fItop)*a*i+fItop*ap*ip);
+	double Ito=Gto*(v-EK)*((1.0-fItop)*a*i+fItop*ap*ip);
 
-	double dss=1.0/(1.0+std::exp((-(v+3.940))/4.230));
-	double td=0.6+1.0/(std::exp(-0.05*(v+6.0))+std::exp(0.09*(v+14.0)));
-	d=dss-(dss-d)*std::exp(-dt/td);
+	double dss=vf[VF_dss];
+	d=dss-(dss-d)*vf[VF_d_exp];
 
-	double fss=1.0/(1.0+std::exp((v+19.58)/3.696));
-	double tff=7.0+1.0/(0.0045*std::exp(-(v+20.0)/10.0)+0.0045*std::exp((v+20.0)/10.0));
-	double tfs=1000.0+1.0/(0.000035*std::exp(-(v+5.0)/4.0)+0.000035*std::exp((v+5.0)/6.0));
+	double fss=vf[VF_fss];
 	double Aff=0.6;
 	double Afs=1.0-Aff;
-	ff=fss-(fss-ff)*std::exp(-dt/tff);
-	fs=fss-(fss-fs)*std::exp(-dt/tfs);
+	ff=fss-(fss-ff)*vf[VF_ff_exp];
+	fs=fss-(fss-fs)*vf[VF_fs_exp];
 
 	double f=Aff*ff+Afs*fs;
 	double fcass=fss;
-	double tfcaf=7.0+1.0/(0.04*std::exp(-(v-4.0)/7.0)+0.04*std::exp((v-4.0)/7.0));
-	double tfcas=100.0+1.0/(0.00012*std::exp(-v/3.0)+0.00012*std::exp(v/7.0));
-	double Afcaf=0.3+0.6/(1.0+std::exp((v-10.0)/10.0));
+	double Afcaf=vf[VF_Afcaf];
 	double Afcas=1.0-Afcaf;
-	fcaf=fcass-(fcass-fcaf)*std::exp(-dt/tfcaf);
-	fcas=fcass-(fcass-fcas)*std::exp(-dt/tfcas);
+	fcaf=fcass-(fcass-fcaf)*vf[VF_fcaf_exp];
+	fcas=fcass-(fcass-fcas)*vf[VF_fcas_exp];
 
 	double fca=Afcaf*fcaf+Afcas*fcas;
 	double tjca=75.0;
 	jca=fcass-(fcass-jca)*std::exp(-dt/tjca);
 
-	double tffp=2.5*tff;
-	ffp=fss-(fss-ffp)*std::exp(-dt/tffp);
+	ffp=fss-(fss-ffp)*vf[VF_ffp_exp];
 
 	double fp=Aff*ffp+Afs*fs;
-	double tfcafp=2.5*tfcaf;
-	fcafp=fcass-(fcass-fcafp)*std::exp(-dt/tfcafp);
+	fcafp=fcass-(fcass-fcafp)*vf[VF_fcafp_exp];
 
 	double fcap=Afcaf*fcafp+Afcas*fcas;
 	double Kmn=0.002;
@@ -492,81 +550,50 @@ ORd::RGC(std::vector<double>& variables, double dt)
 	double anca=1.0/(k2n/km2n+std::pow(1.0+Kmn/cass,4.0));
 	nca=anca*k2n/km2n-(anca*k2n/km2n-nca)*std::exp(-km2n*dt);
 
-	double PhiCaL=4.0*vffrt*(cass*std::exp(2.0*vfrt)-0.341*cao)/(std::exp(2.0*vfrt)-1.0);
-	double PhiCaNa=1.0*vffrt*(0.75*nass*std::exp(1.0*vfrt)-0.75*nao)/(std::exp(1.0*vfrt)-1.0);
-	double PhiCaK=1.0*vffrt*(0.75*kss*std::exp(1.0*vfrt)-0.75*ko)/(std::exp(1.0*vfrt)-1.0);
+	double exp_vfrt=vf[VF_exp_vfrt];
+	double exp_2vfrt=vf[VF_exp_2vfrt];
+	double PhiCaL=4.0*vffrt*(cass*exp_2vfrt-0.341*cao)/(exp_2vfrt-1.0);
+	double PhiCaNa=1.0*vffrt*(0.75*nass*exp_vfrt-0.75*nao)/(exp_vfrt-1.0);
+	double PhiCaK=1.0*vffrt*(0.75*kss*exp_vfrt-0.75*ko)/(exp_vfrt-1.0);
 	double zca=2.0;
-	double PCa=0.0001;
-	if (M_cellType == CellType::Epicardial)
-	{
-		PCa*=1.2;
-	}
-	else if (M_cellType == CellType::MCell)
-	{
-		PCa*=2.5;
-	}
+	double PCa=p.PCa;
 	double PCap=1.1*PCa;
 	double PCaNa=0.00125*PCa;
 	double PCaK=3.574e-4*PCa;
 	double PCaNap=0.00125*PCap;
 	double PCaKp=3.574e-4*PCap;
 	double fICaLp=(1.0/(1.0+KmCaMK/CaMKa));
-	ICaL=(1.0-fICaLp)*PCa*PhiCaL*d*(f*(1.0-nca)+jca*fca*nca)+fICaLp*PCap*PhiCaL*d*(fp*(1.0-nca)+jca*fcap*nca);
-	ICaNa=(1.0-fICaLp)*PCaNa*PhiCaNa*d*(f*(1.0-nca)+jca*fca*nca)+fICaLp*PCaNap*PhiCaNa*d*(fp*(1.0-nca)+jca*fcap*nca);
-	ICaK=(1.0-fICaLp)*PCaK*PhiCaK*d*(f*(1.0-nca)+jca*fca*nca)+fICaLp*PCaKp*PhiCaK*d*(fp*(1.0-nca)+jca*fcap*nca);
+	double ICaL=(1.0-fICaLp)*PCa*PhiCaL*d*(f*(1.0-nca)+jca*fca*nca)+fICaLp*PCap*PhiCaL*d*(fp*(1.0-nca)+jca*fcap*nca);
+	double ICaNa=(1.0-fICaLp)*PCaNa*PhiCaNa*d*(f*(1.0-nca)+jca*fca*nca)+fICaLp*PCaNap*PhiCaNa*d*(fp*(1.0-nca)+jca*fcap*nca);
+	double ICaK=(1.0-fICaLp)*PCaK*PhiCaK*d*(f*(1.0-nca)+jca*fca*nca)+fICaLp*PCaKp*PhiCaK*d*(fp*(1.0-nca)+jca*fcap*nca);
 
-	double xrss=1.0/(1.0+std::exp((-(v+8.337))/6.789));
-	double txrf=12.98+1.0/(0.3652*std::exp((v-31.66)/3.869)+4.123e-5*std::exp((-(v-47.78))/20.38));
-	double txrs=1.865+1.0/(0.06629*std::exp((v-34.70)/7.355)+1.128e-5*std::exp((-(v-29.74))/25.94));
-	double Axrf=1.0/(1.0+std::exp((v+54.81)/38.21));
+	double xrss=vf[VF_xrss];
+	double Axrf=vf[VF_Axrf];
 	double Axrs=1.0-Axrf;
-	xrf=xrss-(xrss-xrf)*std::exp(-dt/txrf);
-	xrs=xrss-(xrss-xrs)*std::exp(-dt/txrs);
+	xrf=xrss-(xrss-xrf)*vf[VF_xrf_exp];
+	xrs=xrss-(xrss-xrs)*vf[VF_xrs_exp];
 
 	double xr=Axrf*xrf+Axrs*xrs;
-	double rkr=1.0/(1.0+std::exp((v+55.0)/75.0))*1.0/(1.0+std::exp((v-10.0)/30.0));
-	double GKr=0.046;
-	if ( M_cellType == CellType::Epicardial )
-	{
-		GKr*=1.3;
-	}
-	else if ( M_cellType == CellType::MCell )
-	{
-		GKr*=0.8;
-	}
-	IKr=GKr*sqrt(ko/5.4)*xr*rkr*(v-EK);
+	double rkr=vf[VF_rkr];
+	double GKr=p.GKr;
+	double IKr=GKr*sqrt(ko/5.4)*xr*rkr*(v-EK);
 
-	double xs1ss=1.0/(1.0+std::exp((-(v+11.60))/8.932));
-	double txs1=817.3+1.0/(2.326e-4*std::exp((v+48.28)/17.80)+0.001292*std::exp((-(v+210.0))/230.0));
-	xs1=xs1ss-(xs1ss-xs1)*std::exp(-dt/txs1);
+	double xs1ss=vf[VF_xs1ss];
+	xs1=xs1ss-(xs1ss-xs1)*vf[VF_xs1_exp];
 
 	double xs2ss=xs1ss;
-	double txs2=1.0/(0.01*std::exp((v-50.0)/20.0)+0.0193*std::exp((-(v+66.54))/31.0));
-	xs2=xs2ss-(xs2ss-xs2)*std::exp(-dt/txs2);
+	xs2=xs2ss-(xs2ss-xs2)*vf[VF_xs2_exp];
 
 	double KsCa=1.0+0.6/(1.0+std::pow(3.8e-5/cai,1.4));
-	double GKs=0.0034;
-	if ( M_cellType == CellType::Epicardial)
-	{
-		GKs*=1.4;
-	}
-	IKs=GKs*KsCa*xs1*xs2*(v-EKs);
+	double GKs=p.GKs;
+	double IKs=GKs*KsCa*xs1*xs2*(v-EKs);
 
-	double xk1ss=1.0/(1.0+std::exp(-(v+2.5538*ko+144.59)/(1.5692*ko+3.8115)));
-	double txk1=122.2/(std::exp((-(v+127.2))/20.36)+std::exp((v+236.8)/69.33));
-	xk1=xk1ss-(xk1ss-xk1)*std::exp(-dt/txk1);
+	double xk1ss=vf[VF_xk1ss];
+	xk1=xk1ss-(xk1ss-xk1)*vf[VF_xk1_exp];
 
-	double rk1=1.0/(1.0+std::exp((v+105.8-2.6*ko)/9.493));
-	double GK1=0.1908;
-	if ( M_cellType == CellType::Epicardial )
-	{
-		GK1*=1.2;
-	}
-	else if ( M_cellType == CellType::MCell )
-	{
-		GK1*=1.3;
-	}
-	IK1=GK1*sqrt(ko)*rk1*xk1*(v-EK);
+	double rk1=vf[VF_rk1];
+	double GK1=p.GK1;
+	double IK1=GK1*sqrt(ko)*rk1*xk1*(v-EK);
 
 	double kna1=15.0;
 	double kna2=5.0;
@@ -577,10 +604,8 @@ ORd::RGC(std::vector<double>& variables, double dt)
 	double wnaca=5.0e3;
 	double kcaon=1.5e6;
 	double kcaoff=5.0e3;
-	double qna=0.5224;
-	double qca=0.1670;
-	double hca=std::exp((qca*v*F)/(R*T));
-	double hna=std::exp((qna*v*F)/(R*T));
+	double hca=vf[VF_hca];
+	double hna=vf[VF_hna];
 	double h1=1+nai/kna3*(1+hna);
 	double h2=(nai*hna)/(kna3*h1);
 	double h3=1.0/h1;
@@ -618,16 +643,8 @@ ORd::RGC(std::vector<double>& variables, double dt)
 	double zna=1.0;
 	double JncxNa=3.0*(E4*k7-E1*k8)+E3*k4pp-E2*k3pp;
 	double JncxCa=E2*k2-E1*k1;
-	double Gncx=0.0008;
-	if ( M_cellType == CellType::Epicardial)
-	{
-		Gncx*=1.1;
-	}
-	if ( M_cellType == CellType::MCell )
-	{
-		Gncx*=1.4;
-	}
-	INaCa_i=0.8*Gncx*allo*(zna*JncxNa+zca*JncxCa);
+	double Gncx=p.Gncx;
+	double INaCa_i=0.8*Gncx*allo*(zna*JncxNa+zca*JncxCa);
 
 	h1=1+nass/kna3*(1+hna);
 	h2=(nass*hna)/(kna3*h1);
@@ -665,9 +682,9 @@ ORd::RGC(std::vector<double>& variables, double dt)
 	allo=1.0/(1.0+std::pow(KmCaAct/cass,2.0));
 	JncxNa=3.0*(E4*k7-E1*k8)+E3*k4pp-E2*k3pp;
 	JncxCa=E2*k2-E1*k1;
-	INaCa_ss=0.2*Gncx*allo*(zna*JncxNa+zca*JncxCa);
+	double INaCa_ss=0.2*Gncx*allo*(zna*JncxNa+zca*JncxCa);
 
-	INaCa=INaCa_i+INaCa_ss;
+	double INaCa=INaCa_i+INaCa_ss;
 
 	double k1p=949.5;
 	double k1m=182.4;
@@ -677,11 +694,8 @@ ORd::RGC(std::vector<double>& variables, double dt)
 	double k3m=79300.0;
 	k4p=639.0;
 	double k4m=40.0;
-	double Knai0=9.073;
-	double Knao0=27.78;
-	double delta=-0.1550;
-	double Knai=Knai0*std::exp((delta*v*F)/(3.0*R*T));
-	double Knao=Knao0*std::exp(((1.0-delta)*v*F)/(3.0*R*T));
+	double Knai=vf[VF_Knai];
+	double Knao=vf[VF_Knao];
 	double Kki=0.5;
 	double Kko=0.3582;
 	double MgADP=0.05;
@@ -712,42 +726,83 @@ ORd::RGC(std::vector<double>& variables, double dt)
 	double zk=1.0;
 	double JnakNa=3.0*(E1*a3-E2*b3);
 	double JnakK=2.0*(E4*b1-E3*a1);
-	double Pnak=30;
-	if ( M_cellType == CellType::Epicardial )
-	{
-		Pnak*=0.9;
-	}
-	if ( M_cellType == CellType::MCell )
-	{
-		Pnak*=0.7;
-	}
-	INaK=Pnak*(zna*JnakNa+zk*JnakK);
+	double Pnak=p.Pnak;
+	double INaK=Pnak*(zna*JnakNa+zk*JnakK);
 
-	double xkb=1.0/(1.0+std::exp(-(v-14.48)/18.34));
-	double GKb=0.003;
-	if ( M_cellType == CellType::Epicardial )
-	{
-		GKb*=0.6;
-	}
-	IKb=GKb*xkb*(v-EK);
+	double xkb=vf[VF_xkb];
+	double GKb=p.GKb;
+	double IKb=GKb*xkb*(v-EK);
 
 	double PNab=3.75e-10;
-	INab=PNab*vffrt*(nai*std::exp(vfrt)-nao)/(std::exp(vfrt)-1.0);
+	double INab=PNab*vffrt*(nai*exp_vfrt-nao)/(exp_vfrt-1.0);
 
 	double PCab=2.5e-8;
-	ICab=PCab*4.0*vffrt*(cai*std::exp(2.0*vfrt)-0.341*cao)/(std::exp(2.0*vfrt)-1.0);
+	double ICab=PCab*4.0*vffrt*(cai*exp_2vfrt-0.341*cao)/(exp_2vfrt-1.0);
 
 	double GpCa=0.0005;
-	IpCa=GpCa*cai/(0.0005+cai);
-
-	//variables[1] = nai;
-	//variables[2] = nass;
-	//variables[3] = ki;
-	//variables[4] = kss;
-	//variables[5] = cai;
-	//variables[6] = cass;
-	//variables[7] = cansr;
-	//variables[8] = cajsr;
+	double IpCa=GpCa*cai/(0.0005+cai);
+
+	// FBC: fluxes and concentrations
+	CaMKt+=dt*(aCaMK*CaMKb*(CaMKb+CaMKt)-bCaMK*CaMKt);
+
+	double JdiffNa=(nass-nai)/2.0;
+	double JdiffK=(kss-ki)/2.0;
+	double Jdiff=(cass-cai)/0.2;
+
+	double bt=4.75;
+	double a_rel=0.5*bt;
+	double Jrel_inf=a_rel*(-ICaL)/(1.0+std::pow(1.5/cajsr,8.0));
+	Jrel_inf*=p.Jrel;
+	double tau_rel=bt/(1.0+0.0123/cajsr);
+	tau_rel = (tau_rel<0.005) ? 0.005 : tau_rel;
+	Jrelnp=Jrel_inf-(Jrel_inf-Jrelnp)*std::exp(-dt/tau_rel);
+
+	double btp=1.25*bt;
+	double a_relp=0.5*btp;
+	double Jrel_infp=a_relp*(-ICaL)/(1.0+std::pow(1.5/cajsr,8.0));
+	Jrel_infp*=p.Jrel;
+	double tau_relp=btp/(1.0+0.0123/cajsr);
+	tau_relp = (tau_relp<0.005) ? 0.005 : tau_relp;
+	Jrelp=Jrel_infp-(Jrel_infp-Jrelp)*std::exp(-dt/tau_relp);
+
+	double fJrelp=(1.0/(1.0+KmCaMK/CaMKa));
+	double Jrel=(1.0-fJrelp)*Jrelnp+fJrelp*Jrelp;
+
+	double Jupnp=0.004375*cai/(cai+0.00092);
+	double Jupp=2.75*0.004375*cai/(cai+0.00092-0.00017);
+	Jupnp*=p.Jup;
+	Jupp*=p.Jup;
+	double fJupp=(1.0/(1.0+KmCaMK/CaMKa));
+	double Jleak=0.0039375*cansr/15.0;
+	double Jup=(1.0-fJupp)*Jupnp+fJupp*Jupp-Jleak;
+
+	double Jtr=(cansr-cajsr)/100.0;
+
+	nai+=dt*(-(INa+INaL+3.0*INaCa_i+3.0*INaK+INab)*Acap/(F*vmyo)+JdiffNa*vss/vmyo);
+	nass+=dt*(-(ICaNa+3.0*INaCa_ss)*Acap/(F*vss)-JdiffNa);
+
+	ki+=dt*(-(Ito+IKr+IKs+IK1+IKb+Ist-2.0*INaK)*Acap/(F*vmyo)+JdiffK*vss/vmyo);
+	kss+=dt*(-(ICaK)*Acap/(F*vss)-JdiffK);
+
+	double Bcai= 1.0/(1.0+p.cmdnmax*cmdnmax*kmcmdn/std::pow(kmcmdn+cai,2.0)+trpnmax*kmtrpn/std::pow(kmtrpn+cai,2.0));
+	cai+=dt*(Bcai*(-(IpCa+ICab-2.0*INaCa_i)*Acap/(2.0*F*vmyo)-Jup*vnsr/vmyo+Jdiff*vss/vmyo));
+
+	double Bcass=1.0/(1.0+BSRmax*KmBSR/std::pow(KmBSR+cass,2.0)+BSLmax*KmBSL/std::pow(KmBSL+cass,2.0));
+	cass+=dt*(Bcass*(-(ICaL-2.0*INaCa_ss)*Acap/(2.0*F*vss)+Jrel*vjsr/vss-Jdiff));
+
+	cansr+=dt*(Jup-Jtr*vjsr/vnsr);
+
+	double Bcajsr=1.0/(1.0+csqnmax*kmcsqn/std::pow(kmcsqn+cajsr,2.0));
+	cajsr+=dt*(Bcajsr*(Jtr-Jrel));
+
+	variables[1] = nai;
+	variables[2] = nass;
+	variables[3] = ki;
+	variables[4] = kss;
+	variables[5] = cai;
+	variables[6] = cass;
+	variables[7] = cansr;
+	variables[8] = cajsr;
 	variables[9] = m;
 	variables[10] = hf;
 	variables[11]= hs;
@@ -777,118 +832,98 @@ ORd::RGC(std::vector<double>& variables, double dt)
 	variables[35]= xs1;
 	variables[36]= xs2;
 	variables[37]= xk1;
-	//variables[38]= Jrelnp;
-	//variables[39]= Jrelp;
-	//variables[40]= CaMKt;
+	variables[38]= Jrelnp;
+	variables[39]= Jrelp;
+	variables[40]= CaMKt;
+
+	// Total ionic current at the beginning of the step
+	return INa+INaL+Ito+ICaL+ICaNa+ICaK+IKr+IKs+IK1+INaCa+INaK+INab+IKb+IpCa+ICab/*+Ist*/;
 }
 
 
+//! Update all the variables in the ionic model
+/*!
+ *  \param [in] variables Vector containing the local value of all variables
+ *  \param [in] dt        Timestep
+ */
 void
-ORd::FBC(std::vector<double>& variables, double dt)
+ORd::updateVariables(std::vector<double>& variables, double appliedCurrent, double dt)
 {
-    double nai   = variables[1];
-    double nass  = variables[2];
-    double ki    = variables[3];
-    double kss   = variables[4];
-    double cai   = variables[5];
-    double cass  = variables[6];
-    double cansr = variables[7];
-    double cajsr = variables[8];
-
-    double Jrelnp= variables[38];
-    double Jrelp = variables[39];
-    double CaMKt = variables[40];
-
-    double CaMKb=CaMKo*(1.0-CaMKt)/(1.0+KmCaM/cass);
-    CaMKa=CaMKb+CaMKt;
-    CaMKt+=dt*(aCaMK*CaMKb*(CaMKb+CaMKt)-bCaMK*CaMKt);
-
-    JdiffNa=(nass-nai)/2.0;
-    JdiffK=(kss-ki)/2.0;
-    Jdiff=(cass-cai)/0.2;
-
-    double bt=4.75;
-    double a_rel=0.5*bt;
-    double Jrel_inf=a_rel*(-ICaL)/(1.0+std::pow(1.5/cajsr,8.0));
-    if (M_cellType == CellType::MCell )
-    {
-        Jrel_inf*=1.7;
-    }
-    double tau_rel=bt/(1.0+0.0123/cajsr);
-    if (tau_rel<0.005)
-    {
-        tau_rel=0.005;
-    }
-    Jrelnp=Jrel_inf-(Jrel_inf-Jrelnp)*std::exp(-dt/tau_rel);
-
-    double btp=1.25*bt;
-    double a_relp=0.5*btp;
-    double Jrel_infp=a_relp*(-ICaL)/(1.0+std::pow(1.5/cajsr,8.0));
-    if (M_cellType==CellType::MCell)
-    {
-        Jrel_infp*=1.7;
-    }
-    double tau_relp=btp/(1.0+0.0123/cajsr);
-    if (tau_relp<0.005)
-    {
-        tau_relp=0.005;
-    }
-    Jrelp=Jrel_infp-(Jrel_infp-Jrelp)*std::exp(-dt/tau_relp);
-
-    double fJrelp=(1.0/(1.0+KmCaMK/CaMKa));
-    Jrel=(1.0-fJrelp)*Jrelnp+fJrelp*Jrelp;
-
-    double Jupnp=0.004375*cai/(cai+0.00092);
-    double Jupp=2.75*0.004375*cai/(cai+0.00092-0.00017);
-    if (M_cellType == CellType::Epicardial )
-    {
-        Jupnp*=1.3;
-        Jupp*=1.3;
-    }
-    double fJupp=(1.0/(1.0+KmCaMK/CaMKa));
-    Jleak=0.0039375*cansr/15.0;
-    Jup=(1.0-fJupp)*Jupnp+fJupp*Jupp-Jleak;
+	// For compatibility  with the original code where the applied stimulus in opposite
+	Ist = appliedCurrent;
+	selectLUT(dt);
+	if (M_useLUT) M_Iion = cellStep<true>(variables, Ist, dt, cellTypeParameters(), M_lut);
+	else M_Iion = cellStep<false>(variables, Ist, dt, cellTypeParameters(), M_lut);
+}
 
-    Jtr=(cansr-cajsr)/100.0;
 
-    nai+=dt*(-(INa+INaL+3.0*INaCa_i+3.0*INaK+INab)*Acap/(F*vmyo)+JdiffNa*vss/vmyo);
-    nass+=dt*(-(ICaNa+3.0*INaCa_ss)*Acap/(F*vss)-JdiffNa);
+void
+ORd::updateVariables(std::vector<double>& variables, std::vector<double>& rhs, double appliedCurrent, double dt, bool overwrite)
+{
+    // For compatibility  with the original code where the applied stimulus in opposite
+    Ist = appliedCurrent;
+    selectLUT(dt);
+    if (M_useLUT) M_Iion = cellStep<true>(variables, Ist, dt, cellTypeParameters(), M_lut);
+    else M_Iion = cellStep<false>(variables, Ist, dt, cellTypeParameters(), M_lut);
+}
+//! Evaluate total ionic current for the computation of the potential
+/*!
+ *  \param [in] variables Vector containing the local value of all variables
+ *  \param [in] appliedCurrent value of the applied current
+ *  \param [in] dt        Timestep
+ */
+double
+ORd::evaluateIonicCurrent(std::vector<double>& variables, double appliedCurrent, double dt)
+{
+	// For compatibility  with the original code where the applied stimulus in opposite
+	Ist =appliedCurrent;
+	return M_Iion;
 
-    ki+=dt*(-(Ito+IKr+IKs+IK1+IKb+Ist-2.0*INaK)*Acap/(F*vmyo)+JdiffK*vss/vmyo);
-    kss+=dt*(-(ICaK)*Acap/(F*vss)-JdiffK);
+}
 
-    double Bcai;
-    if (M_cellType == CellType::Epicardial)
-    {
-        Bcai=1.0/(1.0+1.3*cmdnmax*kmcmdn/std::pow(kmcmdn+cai,2.0)+trpnmax*kmtrpn/std::pow(kmtrpn+cai,2.0));
-    }
-    else
+template <bool UseLUT>
+void
+ORd::cellLoop(double * const * variables, const double * appliedCurrent, double * iion, int n, double dt) const
+{
+    const CellTypeParameters p = cellTypeParameters();
+    #pragma omp simd
+    for (int i = 0; i < n; ++i)
     {
-        Bcai=1.0/(1.0+cmdnmax*kmcmdn/std::pow(kmcmdn+cai,2.0)+trpnmax*kmtrpn/std::pow(kmtrpn+cai,2.0));
+        BatchCell cell_variables = { variables, i };
+        iion[i] = cellStep<UseLUT>(cell_variables, appliedCurrent[i], dt, p, M_lut);
     }
-    cai+=dt*(Bcai*(-(IpCa+ICab-2.0*INaCa_i)*Acap/(2.0*F*vmyo)-Jup*vnsr/vmyo+Jdiff*vss/vmyo));
-
-    double Bcass=1.0/(1.0+BSRmax*KmBSR/std::pow(KmBSR+cass,2.0)+BSLmax*KmBSL/std::pow(KmBSL+cass,2.0));
-    cass+=dt*(Bcass*(-(ICaL-2.0*INaCa_ss)*Acap/(2.0*F*vss)+Jrel*vjsr/vss-Jdiff));
-
-    cansr+=dt*(Jup-Jtr*vjsr/vnsr);
-
-    double Bcajsr=1.0/(1.0+csqnmax*kmcsqn/std::pow(kmcsqn+cajsr,2.0));
-    cajsr+=dt*(Bcajsr*(Jtr-Jrel));
-
-    variables[1] = nai;
-    variables[2] = nass;
-    variables[3] = ki;
-    variables[4] = kss;
-    variables[5] = cai;
-    variables[6] = cass;
-    variables[7] = cansr;
-    variables[8] = cajsr;
+}
 
+void
+ORd::updateVariablesBatch( double * const * variables,
+                           const double * /*Q*/,
+                           const double * appliedCurrent,
+                           double * iion,
+                           double * diion,
+                           int n,
+                           double dt,
+                           double /*h*/ )
+{
+    selectLUT(dt);
+    if (M_useLUT) cellLoop<true>(variables, appliedCurrent, iion, n, dt);
+    else cellLoop<false>(variables, appliedCurrent, iion, n, dt);
+    // evaluateIonicCurrentTimeDerivative is not implemented
+    if (diion) std::fill(diion, diion + n, 0.0);
+}
 
-    variables[38]= Jrelnp;
-    variables[39]= Jrelp;
-    variables[40]= CaMKt;
+void
+ORd::initializeSaveData(std::ostream& output)
+{
+	// time -  0
+	output << "time v ";
+	//  1 - 10
+	output << "nai nass ki kss cai cass cansr cajsr m hf ";
+	// 11 - 20
+	output << "hs j hsp jp mL hL hLp a iF iS ";
+	// 21 - 30
+	output << "ap iFp iSp d ff fs fcaf fcas jca nca";
+	// 31 - 40
+	output << "ffp fcafp xrf xrs xs1 xs2 xk1 Jrelnp Jrelp CaMKt\n";
 }
 
 } /* namespace BeatIt */
@@ -63,6 +63,7 @@ public:
 	 *
 	 */
 	ORd();
+	IonicModel* clone() const { return new ORd(*this); }
 
 	//! Update all the variables in the ionic model
 	/*!
@@ -101,12 +102,29 @@ public:
               std::vector<double>& old_variables, double dt = 0.0,
               double h = 0.0) { return 0.0; }
 
+    //! Update a batch of cells stored as structure of arrays
+    void updateVariablesBatch( double * const * variables,
+                               const double * Q,
+                               const double * appliedCurrent,
+                               double * iion,
+                               double * diion,
+                               int n,
+                               double dt,
+                               double h = 0.0 );
+
 	//! Initialize the values of the variables
 	/*!
 	 *  \param [in] variables Vector containing the local value of all variables
 	 */
 	void initialize(std::vector<double>& variables);
 
+    //! Functions of the potential tabulated in the lookup table
+    int numVoltageFunctions() const
+    {
+        return NumVoltageFunctions;
+    }
+    void evaluateVoltageFunctions(double v, double dt, double * values) const;
+
 	//! Initialize the output files with the names
 	/*!
 	 *  \param [in] output output file where we will save the values
@@ -115,10 +133,47 @@ public:
 private:
 
 
-    /// original methods from OHara Rudy code
-    void revpots(std::vector<double>& variables);
-    void RGC(std::vector<double>& variables, double dt);
-    void FBC(std::vector<double>& variables, double dt);
+    /// conductances and scaling factors depending on the cell type
+    struct CellTypeParameters
+    {
+        double GNaL, Gto, PCa, GKr, GKs, GK1, Gncx, Pnak, GKb;
+        /// scaling of the Ito inactivation time constants (1 for epicardial cells)
+        double delta_epi;
+        /// scaling of Jrel, Jup and of the myoplasmic calmodulin buffer
+        double Jrel, Jup, cmdnmax;
+    };
+    CellTypeParameters cellTypeParameters() const;
+
+    /// Functions of the potential: steady states and exp(-dt/tau) of the gates,
+    /// amplitudes of the fast and slow components, rectification factors and exponentials
+    enum VoltageFunction
+    {
+        VF_mss, VF_m_exp, VF_hss, VF_hf_exp, VF_hs_exp, VF_j_exp, VF_hssp, VF_hsp_exp, VF_jp_exp,
+        VF_mLss, VF_mL_exp, VF_hLss, VF_hLssp,
+        VF_ass, VF_a_exp, VF_iss, VF_iF_exp, VF_iS_exp, VF_AiF, VF_assp, VF_iFp_exp, VF_iSp_exp,
+        VF_dss, VF_d_exp, VF_fss, VF_ff_exp, VF_fs_exp, VF_fcaf_exp, VF_fcas_exp, VF_Afcaf,
+        VF_ffp_exp, VF_fcafp_exp, VF_exp_vfrt, VF_exp_2vfrt,
+        VF_xrss, VF_xrf_exp, VF_xrs_exp, VF_Axrf, VF_rkr,
+        VF_xs1ss, VF_xs1_exp, VF_xs2_exp, VF_xk1ss, VF_xk1_exp, VF_rk1,
+        VF_hca, VF_hna, VF_Knai, VF_Knao, VF_xkb,
+        NumVoltageFunctions
+    };
+    void voltageFunctions(double v, double dt, const CellTypeParameters& p, double * vf) const;
+
+    //! Original methods from OHara Rudy code (revpots, RGC and FBC) for a single cell
+    /*!
+     *  Variables is either std::vector<double> or BatchCell.
+     *  The cell type is passed through p, so that the kernel has no branches.
+     *  \tparam UseLUT interpolate the functions of the potential from lut
+     *  \param [in] Ist applied current
+     *  \param [in] lut lookup table built for dt
+     *  \return total ionic current
+     */
+    template <bool UseLUT, class Variables>
+    double cellStep(Variables& variables, double Ist, double dt, const CellTypeParameters& p, const VoltageLUT& lut) const;
+    //! Vectorized loop of updateVariablesBatch over the cells
+    template <bool UseLUT>
+    void cellLoop(double * const * variables, const double * appliedCurrent, double * iion, int n, double dt) const;
 
     /// constants
     constexpr const static double nao = 140.0;//extracellular sodium in mM
@@ -158,11 +213,9 @@ private:
     constexpr const static double vss   = 0.02*vcell;
 
 
-    /// introduce varaibles for reversal potentials, currents, fluxes, and CaMK
-    double ENa,EK,EKs;
-    double INa,INaL,Ito,ICaL,ICaNa,ICaK,IKr,IKs,IK1,INaCa_i,INaCa_ss,INaCa,INaK,IKb,INab,IpCa,ICab,Ist;
-    double Jrel,Jup,Jtr,Jdiff,JdiffNa,JdiffK,Jleak;
-    double CaMKa,CaMKb;
+    /// total ionic current computed in the last update
+    double M_Iion;
+    double Ist;
 };
 
 
@@ -42,6 +42,7 @@
 
 #include <cmath>
 #include <fstream>
+#include <algorithm>
 #include "Electrophysiology/IonicModels/TP06.hpp"
 
 namespace BeatIt
@@ -88,6 +89,8 @@ TP06::selectParameters(CellType type)
 
 TP06::TP06()
   : super(20,0, "TP06", CellType::MCell)
+  , M_cell()
+  , Istim(0.0)
 {
     // Without potential
 
@@ -179,129 +182,108 @@ TP06::initialize(std::vector<double>& variables)
 }
 
 
-//! Update all the variables in the ionic model
-/*!
- *  \param [in] variables Vector containing the local value of all variables
- *  \param [in] dt        Timestep
- */
-void
-TP06::updateVariables(std::vector<double>& variables, double appliedCurrent, double dt)
+BEATIT_CELL_KERNEL void
+TP06::voltageFunctions(double svolt, double dt, double * vf) const
 {
-	// For compatibility  with the original code where the applied stimulus in opposite
-	Istim = appliedCurrent;
-    step(variables, dt);
-}
+	// The branches on the cell type and on the potential are written as
+	// selections, so that the kernel can be vectorized over the cells
+	const bool endo = (M_cellType == CellType::Endocardial);
 
-//! Evaluate total ionic current for the computation of the potential
-/*!
- *  \param [in] variables Vector containing the local value of all variables
- *  \param [in] appliedCurrent value of the applied current
- *  \param [in] dt        Timestep
- */
-double
-TP06::evaluateIonicCurrent(std::vector<double>& variables, double appliedCurrent, double dt)
-{
-	return Itot;
-
-}
-
-double
-TP06::evaluateIonicCurrentTimeDerivative( std::vector<double>& variables,
-                                     std::vector<double>& old_variables,
-                                     double dt,
-                                     double h )
-{
-    double svolt = variables[0];
-    double Q = old_variables[0];
-    double dIdV = dItot;
-
-    double Cai   = variables[1];
-    double CaSR  = variables[2];
-    double CaSS  = variables[3];
-    double Nai   = variables[4];
-    double Ki    = variables[5];
-    double sm    = variables[6];
-    double sh    = variables[7];
-    double sj    = variables[8];
-    double sxr1  = variables[9];
-    double sxr2  = variables[10];
-    double sxs   = variables[11];
-    double ss    = variables[12];
-    double sr    = variables[13];
-    double sd    = variables[14];
-    double sf    = variables[15];
-    double sf2   = variables[16];
-    double sfcass= variables[17];
-    double dCai   = (variables[1]- old_variables[1])/dt;
-    double dCaSR  = (variables[2]- old_variables[2])/dt;
-    double dCaSS  = (variables[3]- old_variables[3])/dt;
-    double dNai   = (variables[4]- old_variables[4])/dt;
-    double dKi    = (variables[5]- old_variables[5])/dt;
-    double dsm    = (variables[6]- old_variables[6])/dt;
-    double dsh    = (variables[7]- old_variables[7])/dt;
-    double dsj    = (variables[8]- old_variables[8])/dt;
-    double dsxr1  = (variables[9]- old_variables[9])/dt;
-    double dsxr2  = (variables[10]- old_variables[10])/dt;
-    double dsxs   = (variables[11]- old_variables[11])/dt;
-    double dss    = (variables[12]- old_variables[12])/dt;
-    double dsr    = (variables[13]- old_variables[13])/dt;
-    double dsd    = (variables[14]- old_variables[14])/dt;
-    double dsf    = (variables[15]- old_variables[15])/dt;
-    double dsf2   = (variables[16]- old_variables[16])/dt;
-    double dsfcass= (variables[17]- old_variables[17])/dt;
-
-
-    //Compute currents
-    double dINa=3*GNa*sm*sm*dsm*sh*sj*(svolt-Ena)
-               +GNa*sm*sm*sm*dsh*sj*(svolt-Ena)
-               +GNa*sm*sm*sm*sh*dsj*(svolt-Ena);
-    double aux1_dICaL = (std::exp(2*(svolt-15)*F/(R*T))-1.); // denominator
-    double dICaL=GCaL*sd*sf*sf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
-      (0.25*std::exp(2*(svolt-15)*F/(R*T))*dCaSS)/ aux1_dICaL // dCaSS
-      + GCaL*dsd*sf*sf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
-      (0.25*std::exp(2*(svolt-15)*F/(R*T))*CaSS-Cao)/ aux1_dICaL// dsd
-    + GCaL*sd*dsf*sf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
-    (0.25*std::exp(2*(svolt-15)*F/(R*T))*CaSS-Cao)/ aux1_dICaL// dsf
-    + GCaL*sd*sf*dsf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
-    (0.25*std::exp(2*(svolt-15)*F/(R*T))*CaSS-Cao)/ aux1_dICaL//dsf2
-      + GCaL*sd*sf*sf2*dsfcass*4*(svolt-15)*(F*F/(R*T))*
-      (0.25*std::exp(2*(svolt-15)*F/(R*T))*CaSS-Cao)/ aux1_dICaL; //dsfcass
-    double dIto=Gto*dsr*ss*(svolt-Ek)
-               +Gto*sr*dss*(svolt-Ek);
-    double dIKr=Gkr*sqrt(Ko/5.4)*dsxr1*sxr2*(svolt-Ek)
-               +Gkr*sqrt(Ko/5.4)*sxr1*dsxr2*(svolt-Ek);
-    double dIKs=2*Gks*sxs*dsxs*(svolt-Eks);
-
-    double dINaCa=knaca*(1./(KmNai*KmNai*KmNai+Nao*Nao*Nao))*(1./(KmCa+Cao))*
-      (1./(1+ksat*std::exp((n-1)*svolt*F/(R*T))))*
-      (std::exp(n*svolt*F/(R*T))*3*Nai*Nai*dNai*Cao-
-       std::exp((n-1)*svolt*F/(R*T))*Nao*Nao*Nao*dCai*2.5);
-    //INaK=knak*(Ko/(Ko+KmK))*(Nai/(Nai+KmNa))*rec_iNaK;
-    double aux_dINak = dNai/(Nai+KmNa) - Nai/(Nai+KmNa) /(Nai+KmNa) * dNai;
-    double dINaK=knak*(Ko/(Ko+KmK))*aux_dINak*rec_iNaK;
-    //IpCa=GpCa*Cai/(KpCa+Cai);
-    double dIpCa=GpCa*(dCai/(KpCa+Cai)-Cai/(KpCa+Cai)/(KpCa+Cai)*dCai);
-    //IpK=GpK*rec_ipK*(svolt-Ek);
-    //IbNa=GbNa*(svolt-Ena);
-    //IbCa=GbCa*(svolt-Eca);
-    double dI = dIdV * Q + dINa + dICaL + dIto + dIKr + dIKs + dINaCa + dINaK + dIpCa;
-    return dI;
+    vf[VF_rec_iNaK]=(1./(1.+0.1245*std::exp(-0.1*svolt*F/(R*T))+0.0353*std::exp(-svolt*F/(R*T))));
+    vf[VF_rec_ipK]=1./(1.+std::exp((25-svolt)/5.98));
+    vf[VF_exp_CaL]=std::exp(2*(svolt-15)*F/(R*T));
+    vf[VF_exp_NaCa_n]=std::exp(n*svolt*F/(R*T));
+    vf[VF_exp_NaCa_n1]=std::exp((n-1)*svolt*F/(R*T));
 
+    //compute steady state values and time constants
+    double AM=1./(1.+std::exp((-60.-svolt)/5.));
+    double BM=0.1/(1.+std::exp((svolt+35.)/5.))+0.10/(1.+std::exp((svolt-50.)/200.));
+    double TAU_M=AM*BM;
+    double M_INF=1./((1.+std::exp((-56.86-svolt)/9.03))*(1.+std::exp((-56.86-svolt)/9.03)));
+    const bool above = (svolt>=-40.);
+    double AH_1=0.;
+    double BH_1=(0.77/(0.13*(1.+std::exp(-(svolt+10.66)/11.1))));
+    double AH_2=(0.057*std::exp(-(svolt+80.)/6.8));
+    double BH_2=(2.7*std::exp(0.079*svolt)+(3.1e5)*std::exp(0.3485*svolt));
+    double TAU_H= above ? 1.0/(AH_1+BH_1) : 1.0/(AH_2+BH_2);
+    double H_INF=1./((1.+std::exp((svolt+71.55)/7.43))*(1.+std::exp((svolt+71.55)/7.43)));
+    double AJ_1=0.;
+    double BJ_1=(0.6*std::exp((0.057)*svolt)/(1.+std::exp(-0.1*(svolt+32.))));
+    double AJ_2=(((-2.5428e4)*std::exp(0.2444*svolt)-(6.948e-6)*
+      std::exp(-0.04391*svolt))*(svolt+37.78)/
+         (1.+std::exp(0.311*(svolt+79.23))));
+    double BJ_2=(0.02424*std::exp(-0.01052*svolt)/(1.+std::exp(-0.1378*(svolt+40.14))));
+    double TAU_J= above ? 1.0/(AJ_1+BJ_1) : 1.0/(AJ_2+BJ_2);
+
+    double Xr1_INF=1./(1.+std::exp((-26.-svolt)/7.));
+    double axr1=450./(1.+std::exp((-45.-svolt)/10.));
+    double bxr1=6./(1.+std::exp((svolt-(-30.))/11.5));
+    double TAU_Xr1=axr1*bxr1;
+    double Xr2_INF=1./(1.+std::exp((svolt-(-88.))/24.));
+    double axr2=3./(1.+std::exp((-60.-svolt)/20.));
+    double bxr2=1.12/(1.+std::exp((svolt-60.)/20.));
+    double TAU_Xr2=axr2*bxr2;
+
+    double Xs_INF=1./(1.+std::exp((-5.-svolt)/14.));
+    double Axs=(1400./(sqrt(1.+std::exp((5.-svolt)/6))));
+    double Bxs=(1./(1.+std::exp((svolt-35.)/15.)));
+    double TAU_Xs=Axs*Bxs+80;
+
+    // Epicardial and MCell share the same s gate
+    double R_INF=1./(1.+std::exp((20-svolt)/6.));
+    double S_INF= endo ? 1./(1.+std::exp((svolt+28)/5.))
+                       : 1./(1.+std::exp((svolt+20)/5.));
+    double TAU_R=9.5*std::exp(-(svolt+40.)*(svolt+40.)/1800.)+0.8;
+    double TAU_S= endo ? 1000.*std::exp(-(svolt+67)*(svolt+67)/1000.)+8.
+                       : 85.*std::exp(-(svolt+45.)*(svolt+45.)/320.)+5./(1.+std::exp((svolt-20.)/5.))+3.;
+
+    double D_INF=1./(1.+std::exp((-8-svolt)/7.5));
+    double Ad=1.4/(1.+std::exp((-35-svolt)/13))+0.25;
+    double Bd=1.4/(1.+std::exp((svolt+5)/5));
+    double Cd=1./(1.+std::exp((50-svolt)/20));
+    double TAU_D=Ad*Bd+Cd;
+    double F_INF=1./(1.+std::exp((svolt+20)/7));
+    double Af=1102.5*std::exp(-(svolt+27)*(svolt+27)/225);
+    double Bf=200./(1+std::exp((13-svolt)/10.));
+    double Cf=(180./(1+std::exp((svolt+30)/10)))+20;
+    double TAU_F=Af+Bf+Cf;
+    double F2_INF=0.67/(1.+std::exp((svolt+35)/7))+0.33;
+    double Af2=600*std::exp(-(svolt+25)*(svolt+25)/170);
+    double Bf2=31/(1.+std::exp((25-svolt)/10));
+    double Cf2=16/(1.+std::exp((svolt+30)/10));
+    double TAU_F2=Af2+Bf2+Cf2;
+    vf[VF_M_INF]=M_INF;
+    vf[VF_M_EXP]=std::exp(-dt/TAU_M);
+    vf[VF_H_INF]=H_INF;
+    vf[VF_H_EXP]=std::exp(-dt/TAU_H);
+    vf[VF_J_EXP]=std::exp(-dt/TAU_J);
+    vf[VF_Xr1_INF]=Xr1_INF;
+    vf[VF_Xr1_EXP]=std::exp(-dt/TAU_Xr1);
+    vf[VF_Xr2_INF]=Xr2_INF;
+    vf[VF_Xr2_EXP]=std::exp(-dt/TAU_Xr2);
+    vf[VF_Xs_INF]=Xs_INF;
+    vf[VF_Xs_EXP]=std::exp(-dt/TAU_Xs);
+    vf[VF_R_INF]=R_INF;
+    vf[VF_R_EXP]=std::exp(-dt/TAU_R);
+    vf[VF_S_INF]=S_INF;
+    vf[VF_S_EXP]=std::exp(-dt/TAU_S);
+    vf[VF_D_INF]=D_INF;
+    vf[VF_D_EXP]=std::exp(-dt/TAU_D);
+    vf[VF_F_INF]=F_INF;
+    vf[VF_F_EXP]=std::exp(-dt/TAU_F);
+    vf[VF_F2_INF]=F2_INF;
+    vf[VF_F2_EXP]=std::exp(-dt/TAU_F2);
 }
 
 void
-TP06::initializeSaveData(std::ostream& output)
+TP06::evaluateVoltageFunctions(double v, double dt, double * values) const
 {
-	// time -  0
-	output << "time v ";
-	//  1 - 10
-	output << "Cai CaSR CaSS Nai Ki M H J Xr1 Xr2 ";
-	// 11 - 19
-	output << "Xs S R D F F2 FCass RR OO\n";
+    voltageFunctions(v, dt, values);
 }
 
-void
-TP06::step(std::vector<double>& variables, double dt)
+template <bool UseLUT, class Variables>
+BEATIT_CELL_KERNEL void
+TP06::cellStep(Variables& variables, double Istim, double dt, CellState& cell, const VoltageLUT& lut) const
 {
 	double& svolt = variables[0];
 	double& Cai   = variables[1];
@@ -323,55 +305,57 @@ TP06::step(std::vector<double>& variables, double dt)
 	double& sfcass= variables[17];
 	double& sRR   = variables[18];
 	double& sOO   = variables[19];
-	double& svolt2= Volt2;
-	double& sItot = Itot;
+	// The functions of the potential are interpolated or evaluated
+	double vf[NumVoltageFunctions];
+	if (UseLUT) lut.interpolate<NumVoltageFunctions>(svolt, vf);
+	else voltageFunctions(svolt, dt, vf);
 
     //Needed to compute currents
-    Ek=RTONF*(std::log((Ko/Ki)));
-    Ena=RTONF*(std::log((Nao/Nai)));
-    Eks=RTONF*(std::log((Ko+pKNa*Nao)/(Ki+pKNa*Nai)));
-    Eca=0.5*RTONF*(std::log((Cao/Cai)));
-    Ak1=0.1/(1.+std::exp(0.06*(svolt-Ek-200)));
-    Bk1=(3.*std::exp(0.0002*(svolt-Ek+100))+
+    double Ek=RTONF*(std::log((Ko/Ki)));
+    double Ena=RTONF*(std::log((Nao/Nai)));
+    double Eks=RTONF*(std::log((Ko+pKNa*Nao)/(Ki+pKNa*Nai)));
+    double Eca=0.5*RTONF*(std::log((Cao/Cai)));
+    double Ak1=0.1/(1.+std::exp(0.06*(svolt-Ek-200)));
+    double Bk1=(3.*std::exp(0.0002*(svolt-Ek+100))+
      std::exp(0.1*(svolt-Ek-10)))/(1.+std::exp(-0.5*(svolt-Ek)));
-    rec_iK1=Ak1/(Ak1+Bk1);
-    rec_iNaK=(1./(1.+0.1245*std::exp(-0.1*svolt*F/(R*T))+0.0353*std::exp(-svolt*F/(R*T))));
-    rec_ipK=1./(1.+std::exp((25-svolt)/5.98));
+    double rec_iK1=Ak1/(Ak1+Bk1);
+    double rec_iNaK=vf[VF_rec_iNaK];
+    double rec_ipK=vf[VF_rec_ipK];
 
 
     //Compute currents
-    INa=GNa*sm*sm*sm*sh*sj*(svolt-Ena);
-    ICaL=GCaL*sd*sf*sf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
-      (0.25*std::exp(2*(svolt-15)*F/(R*T))*CaSS-Cao)/(std::exp(2*(svolt-15)*F/(R*T))-1.);
-    Ito=Gto*sr*ss*(svolt-Ek);
-    IKr=Gkr*sqrt(Ko/5.4)*sxr1*sxr2*(svolt-Ek);
-    IKs=Gks*sxs*sxs*(svolt-Eks);
-    IK1=GK1*rec_iK1*(svolt-Ek);
-    INaCa=knaca*(1./(KmNai*KmNai*KmNai+Nao*Nao*Nao))*(1./(KmCa+Cao))*
-      (1./(1+ksat*std::exp((n-1)*svolt*F/(R*T))))*
-      (std::exp(n*svolt*F/(R*T))*Nai*Nai*Nai*Cao-
-       std::exp((n-1)*svolt*F/(R*T))*Nao*Nao*Nao*Cai*2.5);
-    INaK=knak*(Ko/(Ko+KmK))*(Nai/(Nai+KmNa))*rec_iNaK;
-    IpCa=GpCa*Cai/(KpCa+Cai);
-    IpK=GpK*rec_ipK*(svolt-Ek);
-    IbNa=GbNa*(svolt-Ena);
-    IbCa=GbCa*(svolt-Eca);
+    double INa=GNa*sm*sm*sm*sh*sj*(svolt-Ena);
+    double ICaL=GCaL*sd*sf*sf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
+      (0.25*vf[VF_exp_CaL]*CaSS-Cao)/(vf[VF_exp_CaL]-1.);
+    double Ito=Gto*sr*ss*(svolt-Ek);
+    double IKr=Gkr*sqrt(Ko/5.4)*sxr1*sxr2*(svolt-Ek);
+    double IKs=Gks*sxs*sxs*(svolt-Eks);
+    double IK1=GK1*rec_iK1*(svolt-Ek);
+    double INaCa=knaca*(1./(KmNai*KmNai*KmNai+Nao*Nao*Nao))*(1./(KmCa+Cao))*
+      (1./(1+ksat*vf[VF_exp_NaCa_n1]))*
+      (vf[VF_exp_NaCa_n]*Nai*Nai*Nai*Cao-
+       vf[VF_exp_NaCa_n1]*Nao*Nao*Nao*Cai*2.5);
+    double INaK=knak*(Ko/(Ko+KmK))*(Nai/(Nai+KmNa))*rec_iNaK;
+    double IpCa=GpCa*Cai/(KpCa+Cai);
+    double IpK=GpK*rec_ipK*(svolt-Ek);
+    double IbNa=GbNa*(svolt-Ena);
+    double IbCa=GbCa*(svolt-Eca);
 
 
     //Determine total current
-    Itot = IKr   +
-           IKs   +
-           IK1   +
-           Ito   +
-           INa   +
-           IbNa  +
-           ICaL  +
-           IbCa  +
-           INaK  +
-           INaCa +
-           IpCa  +
-           IpK;/*   +
-           Istim;*/
+    cell.Itot = IKr   +
+                IKs   +
+                IK1   +
+                Ito   +
+                INa   +
+                IbNa  +
+                ICaL  +
+                IbCa  +
+                INaK  +
+                INaCa +
+                IpCa  +
+                IpK;/*   +
+                Istim;*/
 
     //Compute currents derivatives
     double dINa=GNa*sm*sm*sm*sh*sj;
@@ -401,8 +385,8 @@ TP06::step(std::vector<double>& variables, double dt)
     double drec_iK1=dAk1/(Ak1+Bk1) - Ak1/(Ak1+Bk1)/(Ak1+Bk1)*(dAk1+dBk1);
     double drec_iNaK= ((0.01245*F*std::exp(-(0.1*F*svolt)/(R*T)))/(R*T)
                     + (0.0353*F*std::exp(-(1.0*F*svolt)/(R*T)))/(R*T))
-                    / (0.1245*std::exp(-(0.1*F*svolt)/(R*T))+0.0353*exp(-(1.0*F*svolt)/(R*T))+1.0)
-                    / (0.1245*std::exp(-(0.1*F*svolt)/(R*T))+0.0353*exp(-(1.0*F*svolt)/(R*T))+1.0);
+                    / (0.1245*std::exp(-(0.1*F*svolt)/(R*T))+0.0353*std::exp(-(1.0*F*svolt)/(R*T))+1.0)
+                    / (0.1245*std::exp(-(0.1*F*svolt)/(R*T))+0.0353*std::exp(-(1.0*F*svolt)/(R*T))+1.0);
     double drec_ipK=  (std::exp((25-svolt)/5.98)) / 5.98
                    / (1.+std::exp((25-svolt)/5.98))
                    /(1.+std::exp((25-svolt)/5.98));
@@ -426,171 +410,286 @@ TP06::step(std::vector<double>& variables, double dt)
 
 
     //Determine total current
-    dItot = dIKr   +
-            dIKs   +
-            dIK1   +
-            dIto   +
-            dINa   +
-            dIbNa  +
-            dICaL  +
-            dIbCa  +
-            dINaK  +
-            dINaCa +
-            dIpCa  +
-            dIpK;
+    cell.dItot = dIKr   +
+                 dIKs   +
+                 dIK1   +
+                 dIto   +
+                 dINa   +
+                 dIbNa  +
+                 dICaL  +
+                 dIbCa  +
+                 dINaK  +
+                 dINaCa +
+                 dIpCa  +
+                 dIpK;
+    cell.Ek = Ek;
+    cell.Ena = Ena;
+    cell.Eks = Eks;
+    cell.rec_iNaK = rec_iNaK;
+
     //update concentrations
-    kCaSR=maxsr-((maxsr-minsr)/(1+(EC/CaSR)*(EC/CaSR)));
-    k1=k1_/kCaSR;
-    k2=k2_*kCaSR;
-    dRR=k4*(1-sRR)-k2*CaSS*sRR;
+    double kCaSR=maxsr-((maxsr-minsr)/(1+(EC/CaSR)*(EC/CaSR)));
+    double k1=k1_/kCaSR;
+    double k2=k2_*kCaSR;
+    double dRR=k4*(1-sRR)-k2*CaSS*sRR;
     sRR+=dt*dRR;
     sOO=k1*CaSS*CaSS*sRR/(k3+k1*CaSS*CaSS);
 
 
-    Irel=Vrel*sOO*(CaSR-CaSS);
-    Ileak=Vleak*(CaSR-Cai);
-    Iup=Vmaxup/(1.+((Kup*Kup)/(Cai*Cai)));
-    Ixfer=Vxfer*(CaSS-Cai);
+    double Irel=Vrel*sOO*(CaSR-CaSS);
+    double Ileak=Vleak*(CaSR-Cai);
+    double Iup=Vmaxup/(1.+((Kup*Kup)/(Cai*Cai)));
+    double Ixfer=Vxfer*(CaSS-Cai);
 
 
-    CaCSQN=Bufsr*CaSR/(CaSR+Kbufsr);
-    dCaSR=dt*(Iup-Irel-Ileak);
-    bjsr=Bufsr-CaCSQN-dCaSR-CaSR+Kbufsr;
-    cjsr=Kbufsr*(CaCSQN+dCaSR+CaSR);
+    double CaCSQN=Bufsr*CaSR/(CaSR+Kbufsr);
+    double dCaSR=dt*(Iup-Irel-Ileak);
+    double bjsr=Bufsr-CaCSQN-dCaSR-CaSR+Kbufsr;
+    double cjsr=Kbufsr*(CaCSQN+dCaSR+CaSR);
     CaSR=(sqrt(bjsr*bjsr+4*cjsr)-bjsr)/2;
 
 
-    CaSSBuf=Bufss*CaSS/(CaSS+Kbufss);
-    dCaSS=dt*(-Ixfer*(Vc/Vss)+Irel*(Vsr/Vss)+(-ICaL*inversevssF2*CAPACITANCE));
-    bcss=Bufss-CaSSBuf-dCaSS-CaSS+Kbufss;
-    ccss=Kbufss*(CaSSBuf+dCaSS+CaSS);
+    double CaSSBuf=Bufss*CaSS/(CaSS+Kbufss);
+    double dCaSS=dt*(-Ixfer*(Vc/Vss)+Irel*(Vsr/Vss)+(-ICaL*inversevssF2*CAPACITANCE));
+    double bcss=Bufss-CaSSBuf-dCaSS-CaSS+Kbufss;
+    double ccss=Kbufss*(CaSSBuf+dCaSS+CaSS);
     CaSS=(sqrt(bcss*bcss+4*ccss)-bcss)/2;
 
 
-    CaBuf=Bufc*Cai/(Cai+Kbufc);
-    dCai=dt*((-(IbCa+IpCa-2*INaCa)*inverseVcF2*CAPACITANCE)-(Iup-Ileak)*(Vsr/Vc)+Ixfer);
-    bc=Bufc-CaBuf-dCai-Cai+Kbufc;
-    cc=Kbufc*(CaBuf+dCai+Cai);
+    double CaBuf=Bufc*Cai/(Cai+Kbufc);
+    double dCai=dt*((-(IbCa+IpCa-2*INaCa)*inverseVcF2*CAPACITANCE)-(Iup-Ileak)*(Vsr/Vc)+Ixfer);
+    double bc=Bufc-CaBuf-dCai-Cai+Kbufc;
+    double cc=Kbufc*(CaBuf+dCai+Cai);
     Cai=(sqrt(bc*bc+4*cc)-bc)/2;
 
 
-    dNai=-(INa+IbNa+3*INaK+3*INaCa)*inverseVcF*CAPACITANCE;
+    double dNai=-(INa+IbNa+3*INaK+3*INaCa)*inverseVcF*CAPACITANCE;
     Nai+=dt*dNai;
 
-    dKi=-(Istim+IK1+Ito+IKr+IKs-2*INaK+IpK)*inverseVcF*CAPACITANCE;
+    double dKi=-(Istim+IK1+Ito+IKr+IKs-2*INaK+IpK)*inverseVcF*CAPACITANCE;
     Ki+=dt*dKi;
 
 
 
-    //compute steady state values and time constants
-    AM=1./(1.+std::exp((-60.-svolt)/5.));
-    BM=0.1/(1.+std::exp((svolt+35.)/5.))+0.10/(1.+std::exp((svolt-50.)/200.));
-    TAU_M=AM*BM;
-    M_INF=1./((1.+std::exp((-56.86-svolt)/9.03))*(1.+std::exp((-56.86-svolt)/9.03)));
-    if (svolt>=-40.)
-    {
-        AH_1=0.;
-        BH_1=(0.77/(0.13*(1.+std::exp(-(svolt+10.66)/11.1))));
-        TAU_H= 1.0/(AH_1+BH_1);
-    }
-    else
-    {
-        AH_2=(0.057*std::exp(-(svolt+80.)/6.8));
-        BH_2=(2.7*std::exp(0.079*svolt)+(3.1e5)*std::exp(0.3485*svolt));
-        TAU_H=1.0/(AH_2+BH_2);
-    }
-    H_INF=1./((1.+std::exp((svolt+71.55)/7.43))*(1.+std::exp((svolt+71.55)/7.43)));
-    if(svolt>=-40.)
+    double FCaSS_INF=0.6/(1+(CaSS/0.05)*(CaSS/0.05))+0.4;
+    double TAU_FCaSS=80./(1+(CaSS/0.05)*(CaSS/0.05))+2.;
+
+    //update the gates: the Rush-Larsen factors exp(-dt/tau) are in vf
+    sm = vf[VF_M_INF]-(vf[VF_M_INF]-sm)*vf[VF_M_EXP];
+    sh = vf[VF_H_INF]-(vf[VF_H_INF]-sh)*vf[VF_H_EXP];
+    sj = vf[VF_H_INF]-(vf[VF_H_INF]-sj)*vf[VF_J_EXP];
+    sxr1 = vf[VF_Xr1_INF]-(vf[VF_Xr1_INF]-sxr1)*vf[VF_Xr1_EXP];
+    sxr2 = vf[VF_Xr2_INF]-(vf[VF_Xr2_INF]-sxr2)*vf[VF_Xr2_EXP];
+    sxs = vf[VF_Xs_INF]-(vf[VF_Xs_INF]-sxs)*vf[VF_Xs_EXP];
+    ss= vf[VF_S_INF]-(vf[VF_S_INF]-ss)*vf[VF_S_EXP];
+    sr= vf[VF_R_INF]-(vf[VF_R_INF]-sr)*vf[VF_R_EXP];
+    sd = vf[VF_D_INF]-(vf[VF_D_INF]-sd)*vf[VF_D_EXP];
+    sf =vf[VF_F_INF]-(vf[VF_F_INF]-sf)*vf[VF_F_EXP];
+    sf2 =vf[VF_F2_INF]-(vf[VF_F2_INF]-sf2)*vf[VF_F2_EXP];
+    sfcass =FCaSS_INF-(FCaSS_INF-sfcass)*std::exp(-dt/TAU_FCaSS);
+}
+
+template <class Variables, class OldVariables>
+BEATIT_CELL_KERNEL double
+TP06::cellTimeDerivative( Variables& variables,
+                          OldVariables& old_variables,
+                          double dt,
+                          const CellState& cell ) const
+{
+    double svolt = variables[0];
+    double Q = old_variables[0];
+    double dIdV = cell.dItot;
+    const double Ena = cell.Ena;
+    const double Ek = cell.Ek;
+    const double Eks = cell.Eks;
+    const double rec_iNaK = cell.rec_iNaK;
+
+    double Cai   = variables[1];
+    double CaSS  = variables[3];
+    double Nai   = variables[4];
+    double sm    = variables[6];
+    double sh    = variables[7];
+    double sj    = variables[8];
+    double sxr1  = variables[9];
+    double sxr2  = variables[10];
+    double sxs   = variables[11];
+    double ss    = variables[12];
+    double sr    = variables[13];
+    double sd    = variables[14];
+    double sf    = variables[15];
+    double sf2   = variables[16];
+    double sfcass= variables[17];
+    double dCai   = (variables[1]- old_variables[1])/dt;
+    double dCaSS  = (variables[3]- old_variables[3])/dt;
+    double dNai   = (variables[4]- old_variables[4])/dt;
+    double dsm    = (variables[6]- old_variables[6])/dt;
+    double dsh    = (variables[7]- old_variables[7])/dt;
+    double dsj    = (variables[8]- old_variables[8])/dt;
+    double dsxr1  = (variables[9]- old_variables[9])/dt;
+    double dsxr2  = (variables[10]- old_variables[10])/dt;
+    double dsxs   = (variables[11]- old_variables[11])/dt;
+    double dss    = (variables[12]- old_variables[12])/dt;
+    double dsr    = (variables[13]- old_variables[13])/dt;
+    double dsd    = (variables[14]- old_variables[14])/dt;
+    double dsf    = (variables[15]- old_variables[15])/dt;
+    double dsf2   = (variables[16]- old_variables[16])/dt;
+    double dsfcass= (variables[17]- old_variables[17])/dt;
+
+
+    //Compute currents
+    double dINa=3*GNa*sm*sm*dsm*sh*sj*(svolt-Ena)
+               +GNa*sm*sm*sm*dsh*sj*(svolt-Ena)
+               +GNa*sm*sm*sm*sh*dsj*(svolt-Ena);
+    double aux1_dICaL = (std::exp(2*(svolt-15)*F/(R*T))-1.); // denominator
+    double dICaL=GCaL*sd*sf*sf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
+      (0.25*std::exp(2*(svolt-15)*F/(R*T))*dCaSS)/ aux1_dICaL // dCaSS
+      + GCaL*dsd*sf*sf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
+      (0.25*std::exp(2*(svolt-15)*F/(R*T))*CaSS-Cao)/ aux1_dICaL// dsd
+    + GCaL*sd*dsf*sf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
+    (0.25*std::exp(2*(svolt-15)*F/(R*T))*CaSS-Cao)/ aux1_dICaL// dsf
+    + GCaL*sd*sf*dsf2*sfcass*4*(svolt-15)*(F*F/(R*T))*
+    (0.25*std::exp(2*(svolt-15)*F/(R*T))*CaSS-Cao)/ aux1_dICaL//dsf2
+      + GCaL*sd*sf*sf2*dsfcass*4*(svolt-15)*(F*F/(R*T))*
+      (0.25*std::exp(2*(svolt-15)*F/(R*T))*CaSS-Cao)/ aux1_dICaL; //dsfcass
+    double dIto=Gto*dsr*ss*(svolt-Ek)
+               +Gto*sr*dss*(svolt-Ek);
+    double dIKr=Gkr*sqrt(Ko/5.4)*dsxr1*sxr2*(svolt-Ek)
+               +Gkr*sqrt(Ko/5.4)*sxr1*dsxr2*(svolt-Ek);
+    double dIKs=2*Gks*sxs*dsxs*(svolt-Eks);
+
+    double dINaCa=knaca*(1./(KmNai*KmNai*KmNai+Nao*Nao*Nao))*(1./(KmCa+Cao))*
+      (1./(1+ksat*std::exp((n-1)*svolt*F/(R*T))))*
+      (std::exp(n*svolt*F/(R*T))*3*Nai*Nai*dNai*Cao-
+       std::exp((n-1)*svolt*F/(R*T))*Nao*Nao*Nao*dCai*2.5);
+    //INaK=knak*(Ko/(Ko+KmK))*(Nai/(Nai+KmNa))*rec_iNaK;
+    double aux_dINak = dNai/(Nai+KmNa) - Nai/(Nai+KmNa) /(Nai+KmNa) * dNai;
+    double dINaK=knak*(Ko/(Ko+KmK))*aux_dINak*rec_iNaK;
+    //IpCa=GpCa*Cai/(KpCa+Cai);
+    double dIpCa=GpCa*(dCai/(KpCa+Cai)-Cai/(KpCa+Cai)/(KpCa+Cai)*dCai);
+    //IpK=GpK*rec_ipK*(svolt-Ek);
+    //IbNa=GbNa*(svolt-Ena);
+    //IbCa=GbCa*(svolt-Eca);
+    double dI = dIdV * Q + dINa + dICaL + dIto + dIKr + dIKs + dINaCa + dINaK + dIpCa;
+    return dI;
+}
+
+//! Update all the variables in the ionic model
+/*!
+ *  \param [in] variables Vector containing the local value of all variables
+ *  \param [in] dt        Timestep
+ */
+void
+TP06::updateVariables(std::vector<double>& variables, double appliedCurrent, double dt)
+{
+	// For compatibility  with the original code where the applied stimulus in opposite
+	Istim = appliedCurrent;
+    step(variables, dt);
+}
+
+//! Evaluate total ionic current for the computation of the potential
+/*!
+ *  \param [in] variables Vector containing the local value of all variables
+ *  \param [in] appliedCurrent value of the applied current
+ *  \param [in] dt        Timestep
+ */
+double
+TP06::evaluateIonicCurrent(std::vector<double>& variables, double appliedCurrent, double dt)
+{
+	return M_cell.Itot;
+
+}
+
+double
+TP06::evaluateIonicCurrentTimeDerivative( std::vector<double>& variables,
+                                     std::vector<double>& old_variables,
+                                     double dt,
+                                     double h )
+{
+    return cellTimeDerivative(variables, old_variables, dt, M_cell);
+}
+
+template <bool UseLUT>
+void
+TP06::cellLoop( double * const * variables,
+                double * const * old_variables,
+                const double * appliedCurrent,
+                double * iion,
+                double * diion,
+                int n,
+                double dt ) const
+{
+    if (diion)
     {
-        AJ_1=0.;
-        BJ_1=(0.6*std::exp((0.057)*svolt)/(1.+std::exp(-0.1*(svolt+32.))));
-        TAU_J= 1.0/(AJ_1+BJ_1);
+        #pragma omp simd
+        for (int i = 0; i < n; ++i)
+        {
+            BatchCell cell_variables = { variables, i };
+            BatchCell cell_old_variables = { old_variables, i };
+            CellState cell;
+            cellStep<UseLUT>(cell_variables, appliedCurrent[i], dt, cell, M_lut);
+            iion[i] = cell.Itot;
+            diion[i] = cellTimeDerivative(cell_variables, cell_old_variables, dt, cell);
+        }
     }
     else
     {
-        AJ_2=(((-2.5428e4)*std::exp(0.2444*svolt)-(6.948e-6)*
-          std::exp(-0.04391*svolt))*(svolt+37.78)/
-             (1.+std::exp(0.311*(svolt+79.23))));
-        BJ_2=(0.02424*std::exp(-0.01052*svolt)/(1.+std::exp(-0.1378*(svolt+40.14))));
-        TAU_J= 1.0/(AJ_2+BJ_2);
+        #pragma omp simd
+        for (int i = 0; i < n; ++i)
+        {
+            BatchCell cell_variables = { variables, i };
+            CellState cell;
+            cellStep<UseLUT>(cell_variables, appliedCurrent[i], dt, cell, M_lut);
+            iion[i] = cell.Itot;
+        }
     }
-    J_INF=H_INF;
-
-    Xr1_INF=1./(1.+std::exp((-26.-svolt)/7.));
-    axr1=450./(1.+std::exp((-45.-svolt)/10.));
-    bxr1=6./(1.+std::exp((svolt-(-30.))/11.5));
-    TAU_Xr1=axr1*bxr1;
-    Xr2_INF=1./(1.+std::exp((svolt-(-88.))/24.));
-    axr2=3./(1.+std::exp((-60.-svolt)/20.));
-    bxr2=1.12/(1.+std::exp((svolt-60.)/20.));
-    TAU_Xr2=axr2*bxr2;
-
-    Xs_INF=1./(1.+std::exp((-5.-svolt)/14.));
-    Axs=(1400./(sqrt(1.+std::exp((5.-svolt)/6))));
-    Bxs=(1./(1.+std::exp((svolt-35.)/15.)));
-    TAU_Xs=Axs*Bxs+80;
-
+}
 
-    switch(M_cellType)
+void
+TP06::updateVariablesBatch( double * const * variables,
+                            const double * Q,
+                            const double * appliedCurrent,
+                            double * iion,
+                            double * diion,
+                            int n,
+                            double dt,
+                            double h )
+{
+    // The derivative uses the variables at the beginning of the step:
+    // Q^n is not passed in old_variables[0] (see IonicModel::updateVariablesBatch)
+    // The work vectors grow to the largest batch and are not allocated again
+    if (diion)
     {
-      case CellType::Endocardial:
-      {
-          R_INF=1./(1.+std::exp((20-svolt)/6.));
-          S_INF=1./(1.+std::exp((svolt+28)/5.));
-          TAU_R=9.5*std::exp(-(svolt+40.)*(svolt+40.)/1800.)+0.8;
-          TAU_S=1000.*std::exp(-(svolt+67)*(svolt+67)/1000.)+8.;
-          break;
-      }
-      case CellType::Epicardial:
-      {
-          R_INF=1./(1.+std::exp((20-svolt)/6.));
-          S_INF=1./(1.+std::exp((svolt+20)/5.));
-          TAU_R=9.5*std::exp(-(svolt+40.)*(svolt+40.)/1800.)+0.8;
-          TAU_S=85.*std::exp(-(svolt+45.)*(svolt+45.)/320.)+5./(1.+std::exp((svolt-20.)/5.))+3.;
-          break;
-      }
-      default:
-      case CellType::MCell:
-      {
-          R_INF=1./(1.+std::exp((20-svolt)/6.));
-          S_INF=1./(1.+std::exp((svolt+20)/5.));
-          TAU_R=9.5*std::exp(-(svolt+40.)*(svolt+40.)/1800.)+0.8;
-          TAU_S=85.*std::exp(-(svolt+45.)*(svolt+45.)/320.)+5./(1.+std::exp((svolt-20.)/5.))+3.;
-          break;
-      }
+        if (M_oldValues.size() < static_cast<std::size_t>(M_numVariables * n)) M_oldValues.resize(M_numVariables * n);
+        M_oldVariables.resize(M_numVariables);
+        for (int k = 0; k < M_numVariables; ++k)
+        {
+            M_oldVariables[k] = M_oldValues.data() + k * n;
+            if (k > 0) std::copy(variables[k], variables[k] + n, M_oldVariables[k]);
+            else std::fill(M_oldVariables[k], M_oldVariables[k] + n, 0.0);
+        }
     }
+    selectLUT(dt);
+    if (M_useLUT) cellLoop<true>(variables, M_oldVariables.data(), appliedCurrent, iion, diion, n, dt);
+    else cellLoop<false>(variables, M_oldVariables.data(), appliedCurrent, iion, diion, n, dt);
+}
 
-    D_INF=1./(1.+std::exp((-8-svolt)/7.5));
-    Ad=1.4/(1.+std::exp((-35-svolt)/13))+0.25;
-    Bd=1.4/(1.+std::exp((svolt+5)/5));
-    Cd=1./(1.+std::exp((50-svolt)/20));
-    TAU_D=Ad*Bd+Cd;
-    F_INF=1./(1.+std::exp((svolt+20)/7));
-    Af=1102.5*std::exp(-(svolt+27)*(svolt+27)/225);
-    Bf=200./(1+std::exp((13-svolt)/10.));
-    Cf=(180./(1+std::exp((svolt+30)/10)))+20;
-    TAU_F=Af+Bf+Cf;
-    F2_INF=0.67/(1.+std::exp((svolt+35)/7))+0.33;
-    Af2=600*std::exp(-(svolt+25)*(svolt+25)/170);
-    Bf2=31/(1.+std::exp((25-svolt)/10));
-    Cf2=16/(1.+std::exp((svolt+30)/10));
-    TAU_F2=Af2+Bf2+Cf2;
-    FCaSS_INF=0.6/(1+(CaSS/0.05)*(CaSS/0.05))+0.4;
-    TAU_FCaSS=80./(1+(CaSS/0.05)*(CaSS/0.05))+2.;
-
-    sm = M_INF-(M_INF-sm)*std::exp(-dt/TAU_M);
-    sh = H_INF-(H_INF-sh)*std::exp(-dt/TAU_H);
-    sj = J_INF-(J_INF-sj)*std::exp(-dt/TAU_J);
-    sxr1 = Xr1_INF-(Xr1_INF-sxr1)*std::exp(-dt/TAU_Xr1);
-    sxr2 = Xr2_INF-(Xr2_INF-sxr2)*std::exp(-dt/TAU_Xr2);
-    sxs = Xs_INF-(Xs_INF-sxs)*std::exp(-dt/TAU_Xs);
-    ss= S_INF-(S_INF-ss)*std::exp(-dt/TAU_S);
-    sr= R_INF-(R_INF-sr)*std::exp(-dt/TAU_R);
-    sd = D_INF-(D_INF-sd)*std::exp(-dt/TAU_D);
-    sf =F_INF-(F_INF-sf)*std::exp(-dt/TAU_F);
-    sf2 =F2_INF-(F2_INF-sf2)*std::exp(-dt/TAU_F2);
-    sfcass =FCaSS_INF-(FCaSS_INF-sfcass)*std::exp(-dt/TAU_FCaSS);
+void
+TP06::initializeSaveData(std::ostream& output)
+{
+	// time -  0
+	output << "time v ";
+	//  1 - 10
+	output << "Cai CaSR CaSS Nai Ki M H J Xr1 Xr2 ";
+	// 11 - 19
+	output << "Xs S R D F F2 FCass RR OO\n";
+}
 
+void
+TP06::step(std::vector<double>& variables, double dt)
+{
+    selectLUT(dt);
+    if (M_useLUT) cellStep<true>(variables, Istim, dt, M_cell, M_lut);
+    else cellStep<false>(variables, Istim, dt, M_cell, M_lut);
 }
 
 } /* namespace BeatIt */
@@ -63,6 +63,7 @@ public:
 	 *
 	 */
 	TP06();
+	IonicModel* clone() const { return new TP06(*this); }
 
 	//! Update all the variables in the ionic model
 	/*!
@@ -96,6 +97,16 @@ public:
      double evaluateIonicCurrent(double V, std::vector<double>& variables, double appliedCurrent = 0.0, double dt = 0.0){ return 0.0;}
      double evaluateIonicCurrentTimeDerivative(std::vector<double>& variables, std::vector<double>& old_variables, double dt = 0.0, double h = 0.0);
 
+    //! Update the variables of n cells stored as structure of arrays (vectorized)
+    void updateVariablesBatch( double * const * variables,
+                               const double * Q,
+                               const double * appliedCurrent,
+                               double * iion,
+                               double * diion,
+                               int n,
+                               double dt,
+                               double h = 0.0 );
+
 	//! Initialize the values of the variables
 	/*!
 	 *  \param [in] variables Vector containing the local value of all variables
@@ -108,6 +119,13 @@ public:
 	 */
     void initializeSaveData(std::ostream& output);
 
+    //! Functions of the potential tabulated in the lookup table
+    int numVoltageFunctions() const
+    {
+        return NumVoltageFunctions;
+    }
+    void evaluateVoltageFunctions(double v, double dt, double * values) const;
+
     void step(std::vector<double>& variables, double dt);
     void setCellType(CellType type);
     void selectParameters(CellType type);
@@ -198,107 +216,60 @@ private:
     //Parameters for IpK;
     constexpr static double GpK=0.0146;
 
-    double Itot;
-    double dItot;
+    /// Quantities computed in a step and used by the ionic current and by its time derivative
+    struct CellState
+    {
+        double Itot;
+        double dItot;
+        double Ek;
+        double Ena;
+        double Eks;
+        double rec_iNaK;
+    };
+
+    /// Functions of the potential: steady states and exp(-dt/tau) of the gates,
+    /// rectification factors and exponentials of ICaL and INaCa
+    enum VoltageFunction
+    {
+        VF_rec_iNaK, VF_rec_ipK, VF_exp_CaL, VF_exp_NaCa_n, VF_exp_NaCa_n1,
+        VF_M_INF, VF_M_EXP, VF_H_INF, VF_H_EXP, VF_J_EXP,
+        VF_Xr1_INF, VF_Xr1_EXP, VF_Xr2_INF, VF_Xr2_EXP, VF_Xs_INF, VF_Xs_EXP,
+        VF_R_INF, VF_R_EXP, VF_S_INF, VF_S_EXP,
+        VF_D_INF, VF_D_EXP, VF_F_INF, VF_F_EXP, VF_F2_INF, VF_F2_EXP,
+        NumVoltageFunctions
+    };
+    void voltageFunctions(double svolt, double dt, double * vf) const;
+
+    //! Update the variables of a single cell
+    /*!
+     *  Shared by the scalar and by the batched updates: it does not modify the members.
+     *  \tparam UseLUT             interpolate the functions of the potential from lut
+     *  \param [in,out] variables   variables of the cell (std::vector or BatchCell)
+     *  \param [in] Istim           applied current
+     *  \param [in] dt              Timestep
+     *  \param [out] cell           currents at the beginning of the step
+     *  \param [in] lut             lookup table built for dt
+     */
+    template <bool UseLUT, class Variables>
+    void cellStep(Variables& variables, double Istim, double dt, CellState& cell, const VoltageLUT& lut) const;
+    template <class Variables, class OldVariables>
+    double cellTimeDerivative(Variables& variables, OldVariables& old_variables, double dt, const CellState& cell) const;
+
+    //! Vectorized loop of updateVariablesBatch over the cells
+    template <bool UseLUT>
+    void cellLoop( double * const * variables,
+                   double * const * old_variables,
+                   const double * appliedCurrent,
+                   double * iion,
+                   double * diion,
+                   int n,
+                   double dt ) const;
+
+    CellState M_cell;
     double Istim;
-    double Volt2;
-
-    double IKr;
-    double IKs;
-    double IK1;
-    double Ito;
-    double INa;
-    double IbNa;
-    double ICaL;
-    double IbCa;
-    double INaCa;
-    double IpCa;
-    double IpK;
-    double INaK;
-    double Irel;
-    double Ileak;
-    double Iup;
-    double Ixfer;
-    double k1;
-    double k2;
-    double kCaSR;
-
-
-    double dNai;
-    double dKi;
-    double dCai;
-    double dCaSR;
-    double dCaSS;
-    double dRR;
-
-
-    double Ek;
-    double Ena;
-    double Eks;
-    double Eca;
-    double CaCSQN;
-    double bjsr;
-    double cjsr;
-    double CaSSBuf;
-    double bcss;
-    double ccss;
-    double CaBuf;
-    double bc;
-    double cc;
-    double Ak1;
-    double Bk1;
-    double rec_iK1;
-    double rec_ipK;
-    double rec_iNaK;
-    double AM;
-    double BM;
-    double AH_1;
-    double BH_1;
-    double AH_2;
-    double BH_2;
-    double AJ_1;
-    double BJ_1;
-    double AJ_2;
-    double BJ_2;
-    double M_INF;
-    double H_INF;
-    double J_INF;
-    double TAU_M;
-    double TAU_H;
-    double TAU_J;
-    double axr1;
-    double bxr1;
-    double axr2;
-    double bxr2;
-    double Xr1_INF;
-    double Xr2_INF;
-    double TAU_Xr1;
-    double TAU_Xr2;
-    double Axs;
-    double Bxs;
-    double Xs_INF;
-    double TAU_Xs;
-    double R_INF;
-    double TAU_R;
-    double S_INF;
-    double TAU_S;
-    double Ad;
-    double Bd;
-    double Cd;
-    double Af;
-    double Bf;
-    double Cf;
-    double Af2;
-    double Bf2;
-    double Cf2;
-    double TAU_D;
-    double D_INF;
-    double TAU_F;
-    double F_INF;
-    double TAU_F2;
-    double F2_INF;
-    double TAU_FCaSS;
-    double FCaSS_INF;
+    /// Variables at the beginning of the step in updateVariablesBatch: M_oldVariables[k][i]
+    std::vector<double> M_oldValues;
+    std::vector<double *> M_oldVariables;
 };
 
 
@@ -0,0 +1,67 @@
+/*
+ * VoltageLUT.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Electrophysiology/IonicModels/VoltageLUT.hpp"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace BeatIt
+{
+
+VoltageLUT::VoltageLUT()
+    : M_vmin(0.0)
+    , M_vmax(0.0)
+    , M_dv(0.0)
+    , M_inverseDv(0.0)
+    , M_lastPoint(0.0)
+    , M_numPoints(0)
+    , M_numFunctions(0)
+    , M_table()
+    , M_data(nullptr)
+{
+    setGrid(-100.0, 80.0, 0.01);
+}
+
+void VoltageLUT::setGrid(double vmin, double vmax, double dv)
+{
+    if (dv <= 0.0 || vmax <= vmin)
+    {
+        throw std::runtime_error("VoltageLUT: invalid grid " + std::to_string(vmin) + ":" + std::to_string(dv) + ":" + std::to_string(vmax));
+    }
+    clear();
+    M_vmin = vmin;
+    M_dv = dv;
+    // The last point is vmin + (n-1) dv >= vmax
+    M_numPoints = static_cast<int>(std::ceil((vmax - vmin) / dv - 1e-9)) + 1;
+    M_vmax = vmin + (M_numPoints - 1) * dv;
+    M_inverseDv = 1.0 / dv;
+    M_lastPoint = M_numPoints - 1;
+}
+
+void VoltageLUT::build(int n_functions, const Functions& functions)
+{
+    // The other copies keep the old table
+    auto table = std::make_shared<std::vector<double> >(static_cast<std::size_t>(M_numPoints) * n_functions);
+    for (int p = 0; p < M_numPoints; ++p)
+    {
+        functions(M_vmin + p * M_dv, table->data() + static_cast<std::size_t>(p) * n_functions);
+    }
+    M_numFunctions = n_functions;
+    M_table = table;
+    M_data = M_table->data();
+}
+
+void VoltageLUT::clear()
+{
+    M_table.reset();
+    M_data = nullptr;
+    M_numFunctions = 0;
+}
+
+} /* namespace BeatIt */
@@ -0,0 +1,123 @@
+/*
+ * VoltageLUT.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_ELECTROPHYSIOLOGY_IONICMODELS_VOLTAGELUT_HPP_
+#define SRC_ELECTROPHYSIOLOGY_IONICMODELS_VOLTAGELUT_HPP_
+
+#include <vector>
+#include <memory>
+#include <functional>
+
+// Complete unrolling of the short loops inside the vectorized cell kernels
+#if defined(__GNUC__)
+#define BEATIT_UNROLL _Pragma("GCC unroll 64")
+#else
+#define BEATIT_UNROLL
+#endif
+
+namespace BeatIt
+{
+
+//! Lookup table of functions of the transmembrane potential
+/*!
+ *  The ionic models register the expressions depending only on the potential
+ *  (steady states and time constants of the gates, exponentials of the currents):
+ *  they are tabulated on a uniform grid vmin:dv:vmax and linearly interpolated.
+ *  The values of all the functions at a grid point are contiguous,
+ *  therefore a lookup reads two consecutive rows of the table.
+ *  Outside of the grid the table is clamped to the first or last interval.
+ *
+ *  Copies share the table, so the per thread copies of the ionic models
+ *  do not replicate it.
+ */
+class VoltageLUT
+{
+public:
+    //! Tabulated functions: evaluate all of them at v and store them in values
+    typedef std::function<void(double v, double * values)> Functions;
+
+    //! Empty table on the default grid -100:0.01:80 mV
+    VoltageLUT();
+
+    //! Set the grid: the table has to be built again
+    void setGrid(double vmin, double vmax, double dv);
+
+    //! Tabulate n_functions functions on the grid
+    void build(int n_functions, const Functions& functions);
+
+    //! Remove the table
+    void clear();
+
+    //! Linear interpolation of all the functions at v
+    /*!
+     *  Inlined in the vectorized cell kernels: the number of functions is a template
+     *  parameter, so that the loop over the functions is unrolled
+     *  \tparam NumFunctions equal to numFunctions()
+     *  \param [in] v transmembrane potential
+     *  \param [out] values array of size NumFunctions
+     */
+    template <int NumFunctions>
+    inline void interpolate(double v, double * values) const
+    {
+        double x = (v - M_vmin) * M_inverseDv;
+        x = (x < 0.0) ? 0.0 : x;
+        x = (x > M_lastPoint) ? M_lastPoint : x;
+        int i = static_cast<int>(x);
+        i = (i > M_numPoints - 2) ? M_numPoints - 2 : i;
+        const double w = x - i;
+        // Integer offsets, so that the loads are vectorized as gathers
+        const int row = i * NumFunctions;
+        const int next_row = row + NumFunctions;
+        BEATIT_UNROLL
+        for (int k = 0; k < NumFunctions; ++k)
+        {
+            values[k] = M_data[row + k] + w * (M_data[next_row + k] - M_data[row + k]);
+        }
+    }
+
+    bool empty() const
+    {
+        return nullptr == M_data;
+    }
+    int numFunctions() const
+    {
+        return M_numFunctions;
+    }
+    int numPoints() const
+    {
+        return M_numPoints;
+    }
+    double vmin() const
+    {
+        return M_vmin;
+    }
+    double vmax() const
+    {
+        return M_vmax;
+    }
+    double dv() const
+    {
+        return M_dv;
+    }
+
+private:
+    double M_vmin;
+    double M_vmax;
+    double M_dv;
+    double M_inverseDv;
+    /// Index of the last grid point, as a double for the clamping
+    double M_lastPoint;
+    int    M_numPoints;
+    int    M_numFunctions;
+    /// Shared among the copies
+    std::shared_ptr<std::vector<double> > M_table;
+    const double * M_data;
+};
+
+} /* namespace BeatIt */
+
+#endif /* SRC_ELECTROPHYSIOLOGY_IONICMODELS_VOLTAGELUT_HPP_ */
@@ -0,0 +1,221 @@
+/*
+ * IonicStateStore.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "libmesh/mesh.h"
+#include "libmesh/equation_systems.h"
+#include "libmesh/transient_system.h"
+#include "libmesh/explicit_system.h"
+#include "libmesh/linear_implicit_system.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/dof_map.h"
+#include "libmesh/node.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include "Electrophysiology/IonicStateStore.hpp"
+#include "Electrophysiology/IonicModels/IonicModel.hpp"
+
+namespace BeatIt
+{
+
+    typedef libMesh::TransientLinearImplicitSystem ElectroSystem;
+    typedef libMesh::TransientExplicitSystem IonicModelSystem;
+
+    IonicStateStore::IonicStateStore()
+            : M_blocks(), M_storeOld(false), M_nThreads(1),
+              M_system(nullptr), M_waveSystem(nullptr), M_istimSystem(nullptr), M_iionSystem(nullptr),
+              M_stim_i(nullptr), M_stim_e(nullptr), M_surf_stim_i(nullptr), M_surf_stim_e(nullptr),
+              M_diion(nullptr), M_diion_old(nullptr)
+    {
+    }
+
+    void IonicStateStore::clear()
+    {
+        M_blocks.clear();
+    }
+
+    void IonicStateStore::build(libMesh::EquationSystems& es,
+                                const std::string& model,
+                                const IonicModelPtrMap& ionic_models,
+                                const IonicModelNameMap& ionic_models_names,
+                                bool store_old,
+                                unsigned int n_threads)
+    {
+        clear();
+        M_storeOld = store_old;
+        M_nThreads = std::max(n_threads, 1u);
+
+        // One block for each ionic model
+        std::map<unsigned int, unsigned int> block_index;
+        for (auto && m : ionic_models)
+        {
+            auto it_name = ionic_models_names.find(m.first);
+            if (it_name == ionic_models_names.end())
+            {
+                throw std::runtime_error("IonicStateStore: no system associated to the ionic model key " + std::to_string(m.first));
+            }
+            Block block;
+            block.key = m.first;
+            block.model = m.second.get();
+            // The other threads use copies of the ionic model
+            block.thread_models.push_back(m.second);
+            for (unsigned int t = 1; t < M_nThreads; ++t)
+            {
+                block.thread_models.emplace_back(m.second->clone());
+            }
+            block.system = &es.get_system<IonicModelSystem>(it_name->second);
+            block.rhs_old_vector = &block.system->get_vector("rhs_old");
+            block.num_vars = block.system->n_vars();
+            block.dofs_gating.resize(block.num_vars);
+            block_index[m.first] = M_blocks.size();
+            M_blocks.push_back(block);
+        }
+
+        const libMesh::MeshBase & mesh = es.get_mesh();
+        ElectroSystem& system = es.get_system<ElectroSystem>(model);
+        ElectroSystem& wave_system = es.get_system<ElectroSystem>("wave");
+        IonicModelSystem& istim_system = es.get_system<IonicModelSystem>("istim");
+        IonicModelSystem& iion_system = es.get_system<IonicModelSystem>("iion");
+        auto& ionic_model_map = iion_system.get_vector("ionic_model_map");
+
+        M_system = &system;
+        M_waveSystem = &wave_system;
+        M_istimSystem = &istim_system;
+        M_iionSystem = &iion_system;
+        M_stim_i = &istim_system.get_vector("stim_i");
+        M_stim_e = &istim_system.get_vector("stim_e");
+        M_surf_stim_i = &istim_system.get_vector("surf_stim_i");
+        M_surf_stim_e = &istim_system.get_vector("surf_stim_e");
+        M_diion = &iion_system.get_vector("diion");
+        M_diion_old = &iion_system.get_vector("diion_old");
+
+        const libMesh::DofMap & dof_map = system.get_dof_map();
+        const libMesh::DofMap & dof_map_V = wave_system.get_dof_map();
+        const libMesh::DofMap & dof_map_istim = istim_system.get_dof_map();
+
+        std::vector<libMesh::dof_id_type> dof_indices_V;
+        std::vector<libMesh::dof_id_type> dof_indices_Q;
+        std::vector<libMesh::dof_id_type> dof_indices_istim;
+        std::vector<libMesh::dof_id_type> dof_indices_gating;
+
+        libMesh::MeshBase::const_node_iterator node = mesh.local_nodes_begin();
+        const libMesh::MeshBase::const_node_iterator end_node = mesh.local_nodes_end();
+        for (; node != end_node; ++node)
+        {
+            const libMesh::Node * nn = *node;
+            // Are we in the bath?
+            auto n_var = nn->n_vars(system.number());
+            auto n_dofs = nn->n_dofs(system.number());
+            if (n_var != n_dofs) continue;
+
+            dof_map.dof_indices(nn, dof_indices_Q, 0);
+            dof_map_V.dof_indices(nn, dof_indices_V, 0);
+            dof_map_istim.dof_indices(nn, dof_indices_istim, 0);
+
+            int key = ionic_model_map(dof_indices_istim[0]);
+            auto it_block = block_index.find(key);
+            if (it_block == block_index.end())
+            {
+                throw std::runtime_error("node without ionicModelPtr!!!");
+            }
+            Block& block = M_blocks[it_block->second];
+            block.nodes.push_back(nn);
+            block.points.push_back(*nn);
+            block.dofs_V.push_back(dof_indices_V[0]);
+            block.dofs_Q.push_back(dof_indices_Q[0]);
+            block.dofs_I.push_back(dof_indices_istim[0]);
+            block.system->get_dof_map().dof_indices(nn, dof_indices_gating);
+            for (unsigned int nv = 0; nv < block.num_vars; ++nv)
+            {
+                block.dofs_gating[nv].push_back(dof_indices_gating[nv]);
+            }
+        }
+
+        for (auto && block : M_blocks)
+        {
+            const unsigned int n = block.size();
+            block.state.assign(block.num_vars, Array(n, 0.0));
+            if (M_storeOld)
+            {
+                block.state_old.assign(block.num_vars, Array(n, 0.0));
+                block.rhs_old.assign(block.num_vars, Array(n, 0.0));
+            }
+            Buffers& b = block.buffers;
+            for (Array* a : { &b.V, &b.V_prev, &b.Q, &b.Iion, &b.dIion, &b.istim, &b.stim_i, &b.stim_e, &b.surf_stim_i, &b.surf_stim_e })
+            {
+                a->assign(n, 0.0);
+            }
+            // I4f is filled only when the stretch activated current is used
+            b.I4f.reserve(n);
+            block.thread_scratch.resize(M_nThreads);
+            for (auto && scratch : block.thread_scratch)
+            {
+                scratch.variables.assign(block.num_vars + 1, nullptr);
+                scratch.values.assign(block.num_vars + 1, 0.0);
+                scratch.old_values.assign(block.num_vars + 1, 0.0);
+                scratch.gating_rhs.assign(block.num_vars + 1, 0.0);
+                scratch.substepped_nodes = 0;
+            }
+        }
+
+        // One summary line for all the blocks
+        std::ostringstream summary;
+        for (auto && block : M_blocks)
+        {
+            unsigned long n = block.size();
+            mesh.comm().sum(n);
+            summary << " " << block.model->ionicModelName() << " (" << n << " nodes, " << block.num_vars << " variables)";
+        }
+        if (mesh.comm().rank() == 0)
+        {
+            std::cout << "* ElectroSolver: ionic state store: " << M_blocks.size() << " blocks," << summary.str() << ", " << M_nThreads << " threads" << std::endl;
+        }
+    }
+
+    void IonicStateStore::sync_from_systems()
+    {
+        for (auto && block : M_blocks)
+        {
+            if (block.size() == 0) continue;
+            auto& solution = *block.system->solution;
+            auto& rhs_old = *block.rhs_old_vector;
+            for (unsigned int nv = 0; nv < block.num_vars; ++nv)
+            {
+                solution.get(block.dofs_gating[nv], block.state[nv]);
+                if (M_storeOld)
+                {
+                    block.state_old[nv] = block.state[nv];
+                    rhs_old.get(block.dofs_gating[nv], block.rhs_old[nv]);
+                }
+            }
+        }
+    }
+
+    void IonicStateStore::sync_to_systems()
+    {
+        for (auto && block : M_blocks)
+        {
+            auto& solution = *block.system->solution;
+            auto& rhs_old = *block.rhs_old_vector;
+            if (block.size() > 0)
+            {
+                for (unsigned int nv = 0; nv < block.num_vars; ++nv)
+                {
+                    solution.insert(block.state[nv], block.dofs_gating[nv]);
+                    if (M_storeOld) rhs_old.insert(block.rhs_old[nv], block.dofs_gating[nv]);
+                }
+            }
+            // close is collective: call it also on empty blocks
+            solution.close();
+            rhs_old.close();
+            block.system->update();
+        }
+    }
+
+} /* namespace BeatIt */
@@ -0,0 +1,201 @@
+/*
+ * IonicStateStore.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_ELECTROPHYSIOLOGY_IONICSTATESTORE_HPP_
+#define SRC_ELECTROPHYSIOLOGY_IONICSTATESTORE_HPP_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "libmesh/id_types.h"
+#include "libmesh/libmesh_common.h"
+#include "libmesh/transient_system.h"
+#include "libmesh/linear_implicit_system.h"
+#include "libmesh/explicit_system.h"
+#include "libmesh/point.h"
+
+// Forward Definition
+namespace libMesh
+{
+class EquationSystems;
+class System;
+class Node;
+}
+
+namespace BeatIt
+{
+
+class IonicModel;
+
+/*!
+ *  Structure-of-arrays storage of the ionic model state variables.
+ *
+ *  The local nodes are grouped by the key stored in the "ionic_model_map"
+ *  vector, i.e. one block for each ionic model. Each block stores one
+ *  contiguous array for each state variable of the model (the potential is
+ *  not stored here) together with the dof indices needed to exchange data
+ *  with the libMesh systems. The reaction step iterates linearly over these
+ *  arrays: the IonicModelSystem vectors are only a mirror of the store and
+ *  they are synchronized when exporting or restarting.
+ *
+ *  The state is advanced in place: the arrays hold w^n when the reaction step
+ *  starts and w^n+1 when it ends. For SBDF2 each block also stores w^n-1 and
+ *  the right hand side f^n-1.
+ *
+ *  build also resolves the systems and vectors used by the reaction step and
+ *  allocates its buffers, so that the time loop does not allocate memory and
+ *  does not look up systems or vectors by name.
+ */
+class IonicStateStore
+{
+public:
+    typedef std::vector<double> Array;
+    typedef std::map<unsigned int, std::shared_ptr<IonicModel> > IonicModelPtrMap;
+    typedef std::map<unsigned int, std::string > IonicModelNameMap;
+    typedef libMesh::NumericVector<libMesh::Number> Vector;
+    typedef libMesh::TransientLinearImplicitSystem ElectroSystem;
+    typedef libMesh::TransientExplicitSystem IonicModelSystem;
+
+    /// Nodal values of a block read and written by the reaction step
+    struct Buffers
+    {
+        Array V;
+        /// potential at the previous step, for the multirate reaction step
+        Array V_prev;
+        Array Q;
+        Array I4f;
+        Array Iion;
+        Array dIion;
+        Array istim;
+        Array stim_i;
+        Array stim_e;
+        Array surf_stim_i;
+        Array surf_stim_e;
+    };
+
+    /// Work space of a thread
+    struct ThreadScratch
+    {
+        /// pointers to V and to the state variables of the chunk, for the batched update
+        std::vector<double *> variables;
+        /// values of a single cell (SBDF2)
+        std::vector<double> values;
+        std::vector<double> old_values;
+        std::vector<double> gating_rhs;
+        /// nodes advanced with substeps in the last reaction step
+        unsigned int substepped_nodes;
+    };
+
+    struct Block
+    {
+        Block() : key(0), model(nullptr), system(nullptr), rhs_old_vector(nullptr), num_vars(0) {}
+        /// number of local nodes in this block
+        unsigned int size() const
+        {
+            return nodes.size();
+        }
+
+        /// key in the ionic model map
+        unsigned int key;
+        /// ionic model used in this block
+        IonicModel * model;
+        /// one instance of the ionic model for each thread (the first one is model)
+        std::vector<std::shared_ptr<IonicModel> > thread_models;
+        /// libMesh system mirroring the state variables
+        libMesh::System * system;
+        /// "rhs_old" vector of system
+        Vector * rhs_old_vector;
+        /// number of state variables (potential excluded)
+        unsigned int num_vars;
+
+        std::vector<const libMesh::Node *> nodes;
+        /// coordinates of the nodes, for the batched evaluation of the pacing
+        std::vector<libMesh::Point> points;
+        /// dofs of the potential ("wave" system)
+        std::vector<libMesh::dof_id_type> dofs_V;
+        /// dofs of the main electrophysiology system
+        std::vector<libMesh::dof_id_type> dofs_Q;
+        /// dofs of the "iion" and "istim" systems
+        std::vector<libMesh::dof_id_type> dofs_I;
+        /// dofs_gating[var][node]
+        std::vector<std::vector<libMesh::dof_id_type> > dofs_gating;
+
+        /// state[var][node] = w^n
+        std::vector<Array> state;
+        /// state_old[var][node] = w^n-1 (SBDF2 only)
+        std::vector<Array> state_old;
+        /// rhs_old[var][node] = f^n-1 (SBDF2 only)
+        std::vector<Array> rhs_old;
+
+        /// buffers of the reaction step
+        Buffers buffers;
+        /// one for each thread
+        std::vector<ThreadScratch> thread_scratch;
+    };
+
+    IonicStateStore();
+
+    //! Create the blocks and the local node to dof tables
+    /*!
+     *  \param [in] es equation systems containing the ionic model systems
+     *  \param [in] model name of the main electrophysiology system
+     *  \param [in] ionic_models ionic model associated to each key
+     *  \param [in] ionic_models_names name of the system associated to each key
+     *  \param [in] store_old store w^n-1 and f^n-1 for SBDF2
+     *  \param [in] n_threads number of threads used in the reaction step
+     */
+    void build( libMesh::EquationSystems& es,
+                const std::string& model,
+                const IonicModelPtrMap& ionic_models,
+                const IonicModelNameMap& ionic_models_names,
+                bool store_old = false,
+                unsigned int n_threads = 1 );
+    void clear();
+
+    //! Copy the values of the IonicModelSystem vectors into the store
+    void sync_from_systems();
+    //! Copy the values of the store into the IonicModelSystem vectors
+    void sync_to_systems();
+
+    bool empty() const
+    {
+        return M_blocks.empty();
+    }
+
+    //! Number of threads, i.e. of contiguous chunks in each block
+    unsigned int n_threads() const
+    {
+        return M_nThreads;
+    }
+    //! First node of the chunk c of a block of n nodes
+    unsigned int chunk_begin(unsigned int n, unsigned int c) const
+    {
+        return static_cast<unsigned int>((static_cast<unsigned long>(n) * c) / M_nThreads);
+    }
+
+    std::vector<Block> M_blocks;
+    bool M_storeOld;
+    unsigned int M_nThreads;
+
+    /// Systems used by the reaction step
+    ElectroSystem * M_system;
+    ElectroSystem * M_waveSystem;
+    IonicModelSystem * M_istimSystem;
+    IonicModelSystem * M_iionSystem;
+    /// Vectors of the istim and iion systems
+    Vector * M_stim_i;
+    Vector * M_stim_e;
+    Vector * M_surf_stim_i;
+    Vector * M_surf_stim_e;
+    Vector * M_diion;
+    Vector * M_diion_old;
+};
+
+} /* namespace BeatIt */
+
+#endif /* SRC_ELECTROPHYSIOLOGY_IONICSTATESTORE_HPP_ */
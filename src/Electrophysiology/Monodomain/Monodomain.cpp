@@ -1019,6 +1019,8 @@ Monodomain::solve_reaction_step(double dt, double time, int step, bool useMidpoi
     auto i = first_local_index;
     int var_index = 0;
     auto& send_list = monodomain_system.get_dof_map().get_send_list();
+    // The lookup table is built before the loop, the kernels only select it
+    M_ionicModelPtr->prepareLUT(dt);
 
     // Solve the first time
     for( ; i < last_local_index; )
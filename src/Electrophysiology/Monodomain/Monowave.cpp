@@ -607,6 +607,8 @@ void Monowave::amr(libMesh::MeshRefinement& mesh_refinement, const std::string&
 //	std::cout << "Refine and Coarsen  " << std::endl;
 //	std::cout << " coarsen and refine ...  " << std::flush;
 //	timer.restart();
+    // Copy the ionic model variables in the systems so that they get projected
+    M_ionicStateStore.sync_to_systems();
     mesh_refinement.refine_and_coarsen_elements();
 //	timer.stop();
 //	timer.print(std::cout);
@@ -614,6 +616,7 @@ void Monowave::amr(libMesh::MeshRefinement& mesh_refinement, const std::string&
 //	std::cout << "Reinit system  " << std::endl;
 //	timer.restart();
     M_equationSystems.reinit();
+    mesh_changed();
 //	timer.stop();
 //	timer.print(std::cout);
 //	timer.restart();
@@ -1488,6 +1491,7 @@ void Monowave::form_system_matrix(double dt, bool /*useMidpoint */, const std::s
         monodomain_system.matrix->add(Cm * (1.0 + tau / (cdt)), monodomain_system.get_matrix(mass));
         monodomain_system.matrix->add(cdt, monodomain_system.get_matrix("stiffness"));
     }
+    operator_changed();
 //    else
 //    {
 //        monodomain_system.matrix->add(Cm / cdt, monodomain_system.get_matrix(mass));
@@ -1687,7 +1691,7 @@ void Monowave::solve_diffusion_step(double dt, double time, bool useMidpoint, co
 //
 //monodomain_system.matrix->print();
 //monodomain_system.rhs->print();
-    rval = M_linearSolver->solve(*monodomain_system.matrix, *monodomain_system.solution, *monodomain_system.rhs, tol, max_iter);
+    rval = solve_diffusion_system(*monodomain_system.matrix, *monodomain_system.solution, *monodomain_system.rhs, tol, max_iter);
 
 // std::cout << "solve done" << std::endl;
 // WAVE
@@ -51,6 +51,8 @@
 #include "libmesh/function_base.h"
 #include "libmesh/point.h"
 
+#include <stdexcept>
+
 namespace BeatIt
 {
 
@@ -126,17 +128,87 @@ double
 PacingProtocol::eval(const Point & p,
                            const double time)
 {
-    double pacing = 0.0;
+    return spatial_weight(p) * amplitude(time);
+}
+
+double
+PacingProtocol::spatial_weight(const Point & p) const
+{
     bool ispInside = BeatIt::isPointInside(M_type, M_radius, p(0)-M_x0, p(1)-M_y0, p(2)-M_z0);
-    if(ispInside)
+    return ispInside ? 1.0 : 0.0;
+}
+
+double
+PacingProtocol::amplitude(const double time) const
+{
+    if(  M_stopTime > 0 && time > M_stopTime) return 0.0;
+    return M_isPacingOn ? M_amplitude : 0.0;
+}
+
+void
+PacingProtocol::evaluate(const std::vector<Point>& points,
+                         const double time,
+                         std::vector<double>& values)
+{
+    values.resize(points.size());
+    for(unsigned int i = 0; i < points.size(); ++i)
     {
-        if(M_isPacingOn) pacing = M_amplitude;
+        values[i] = eval(points[i], time);
     }
+}
 
-    if(  M_stopTime > 0 && time > M_stopTime) pacing = 0.0;
-    return pacing;
+void
+PacingProtocol::build_support(unsigned int set, const std::vector<Point>& points)
+{
+    if(M_support.size() <= set) M_support.resize(set + 1);
+    Support& support = M_support[set];
+    support.indices.clear();
+    support.weights.clear();
+    support.dense = !is_separable();
+    if(support.dense) return;
+    for(unsigned int i = 0; i < points.size(); ++i)
+    {
+        double weight = spatial_weight(points[i]);
+        if(weight != 0.0)
+        {
+            support.indices.push_back(i);
+            support.weights.push_back(weight);
+        }
+    }
 }
 
+bool
+PacingProtocol::stimulate(unsigned int set,
+                          const std::vector<Point>& points,
+                          const double time,
+                          std::vector<double>& values)
+{
+    if(set >= M_support.size())
+    {
+        throw std::runtime_error("PacingProtocol::stimulate: build_support was not called for the set " + std::to_string(set));
+    }
+    const Support& support = M_support[set];
+    if(support.dense)
+    {
+        evaluate(points, time, values);
+        return true;
+    }
+    // Only the stimulated points are written
+    const double a = amplitude(time);
+    const unsigned int n = support.indices.size();
+    for(unsigned int k = 0; k < n; ++k)
+    {
+        values[support.indices[k]] = a * support.weights[k];
+    }
+    return a != 0.0 && n > 0;
+}
+
+unsigned int
+PacingProtocol::support_size(unsigned int set) const
+{
+    if(set >= M_support.size()) return 0;
+    return M_support[set].dense ? 0 : M_support[set].indices.size();
+}
 
 void
 PacingProtocol::set_distance_type(std::string& type)
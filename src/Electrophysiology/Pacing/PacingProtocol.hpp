@@ -94,6 +94,63 @@ public:
     libMesh::FunctionBase<double>* M_pacing;
     virtual double eval  (const Point & p,
                    const double time = 0.);
+    //! Evaluate the pacing at all the points
+    /*!
+     *  \param [in] points
+     *  \param [in] time
+     *  \param [out] values same size as points
+     */
+    virtual void evaluate(const std::vector<Point>& points,
+                          const double time,
+                          std::vector<double>& values);
+
+    //! Points stimulated by the protocol in a set of points
+    struct Support
+    {
+        Support() : dense(true) {}
+        /// the protocol is evaluated at all the points
+        bool dense;
+        /// stimulated points and their spatial weights
+        std::vector<unsigned int> indices;
+        std::vector<double> weights;
+    };
+
+    //! The pacing is spatial_weight(p) * amplitude(time)
+    /*!
+     *  In this case the stimulated points can be precomputed with build_support.
+     *  Protocols depending on space and time in a general way return false
+     */
+    virtual bool is_separable() const
+    {
+        return true;
+    }
+    //! Spatial part: 1 inside the stimulated region, 0 outside
+    virtual double spatial_weight(const Point & p) const;
+    //! Temporal part: M_amplitude while the pacing is on
+    virtual double amplitude(const double time) const;
+
+    //! Precompute the stimulated points of a set of points
+    /*!
+     *  Called at setup and after AMR for each set of local nodes
+     *  \param [in] set index of the set
+     *  \param [in] points
+     */
+    void build_support(unsigned int set, const std::vector<Point>& points);
+    //! Evaluate the pacing at a set of points, writing only the stimulated ones
+    /*!
+     *  The other entries of values are left untouched: they have to be zero.
+     *  \param [in] set index of the set passed to build_support
+     *  \param [in] points the same points passed to build_support
+     *  \param [in] time
+     *  \param [out] values same size as points
+     *  \return false if all the values are zero
+     */
+    bool stimulate(unsigned int set,
+                   const std::vector<Point>& points,
+                   const double time,
+                   std::vector<double>& values);
+    //! Number of stimulated points in a set (0 if the protocol is evaluated at all the points)
+    unsigned int support_size(unsigned int set) const;
 
     void set_distance_type(std::string& type);
 
@@ -112,6 +169,7 @@ public:
     double M_z0;
     double M_duration;
     int M_boundaryID;
+    std::vector<Support> M_support;
 };
 
 } /* namespace BeatIt */
@@ -88,6 +88,15 @@ PacingProtocolSpirit::eval(const Point & p,
     return dynamic_cast< SpiritFunction*>(M_pacing)->operator()(time, p(0), p(1), p(2), 0);
 }
 
+void
+PacingProtocolSpirit::evaluate(const std::vector<Point>& points,
+                               const double time,
+                               std::vector<double>& values)
+{
+    values.resize(points.size());
+    dynamic_cast< SpiritFunction*>(M_pacing)->evaluate(points.data(), points.size(), time, values.data(), 0);
+}
+
 void
 PacingProtocolSpirit::showMe()
 {
@@ -67,6 +67,15 @@ public:
     void update(double time) {}
     double eval  (const Point & p,
                    const double time = 0.);
+    //! The function is evaluated at all the points
+    bool is_separable() const
+    {
+        return false;
+    }
+    //! Batched evaluation of the compiled expression
+    void evaluate(const std::vector<Point>& points,
+                  const double time,
+                  std::vector<double>& values);
 
     void showMe();
 };
@@ -0,0 +1,86 @@
+/*
+ * SplittingScheduler.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Electrophysiology/SplittingScheduler.hpp"
+#include "Electrophysiology/ElectroSolver.hpp"
+#include "libmesh/getpot.h"
+
+#include <iostream>
+#include <stdexcept>
+
+namespace BeatIt
+{
+
+SplittingScheduler::SplittingScheduler(ElectroSolver& solver)
+    : M_solver(solver)
+    , M_scheme(SplittingScheme::Godunov)
+    , M_reactionSubsteps(1)
+    , M_dvdtThreshold(0.0)
+    , M_step(0)
+{
+}
+
+void
+SplittingScheduler::setup(const GetPot& data, const std::string& section)
+{
+    std::string scheme = data(section + "/splitting/scheme", "godunov");
+    if ("godunov" == scheme) M_scheme = SplittingScheme::Godunov;
+    else if ("strang" == scheme) M_scheme = SplittingScheme::Strang;
+    else throw std::runtime_error("SplittingScheduler: unknown splitting scheme " + scheme + ", use godunov or strang");
+
+    M_reactionSubsteps = data(section + "/splitting/reaction_substeps", 1);
+    M_dvdtThreshold = data(section + "/splitting/dvdt_threshold", 0.0);
+
+    if (M_scheme == SplittingScheme::Strang && TimeIntegrator::FirstOrderIMEX != M_solver.M_timeIntegrator)
+    {
+        throw std::runtime_error("SplittingScheduler: Strang splitting is implemented only for the FirstOrderIMEX time integrator");
+    }
+    M_solver.set_reaction_substeps(M_reactionSubsteps, M_dvdtThreshold);
+    showMe();
+}
+
+void
+SplittingScheduler::step( double dt,
+                          double time,
+                          bool useMidpoint,
+                          const std::string& mass,
+                          libMesh::NumericVector<libMesh::Number>* I4f_ptr )
+{
+    M_solver.advance();
+    M_solver.set_reaction_potential_timestep(dt);
+    if (M_scheme == SplittingScheme::Godunov)
+    {
+        M_solver.solve_reaction_step(dt, time, M_step, useMidpoint, mass, I4f_ptr);
+        M_solver.solve_diffusion_step(dt, time, useMidpoint, mass);
+    }
+    else
+    {
+        // Both half steps with V^n+1/2: the diffusion step uses the current at w^n+1/2,
+        // the current of the second half step is recomputed by the next step
+        M_solver.set_reaction_midpoint_potential(true);
+        M_solver.solve_reaction_step(0.5 * dt, time - 0.5 * dt, M_step, useMidpoint, mass, I4f_ptr);
+        M_solver.solve_diffusion_step(dt, time, useMidpoint, mass);
+        M_solver.solve_reaction_step(0.5 * dt, time, M_step, useMidpoint, mass, I4f_ptr);
+        M_solver.set_reaction_midpoint_potential(false);
+    }
+    ++M_step;
+}
+
+void
+SplittingScheduler::showMe(std::ostream& out) const
+{
+    out << "* SplittingScheduler: scheme: " << (M_scheme == SplittingScheme::Godunov ? "godunov" : "strang")
+        << ", reaction substeps: " << M_reactionSubsteps;
+    if (M_reactionSubsteps > 1)
+    {
+        if (M_dvdtThreshold > 0.0) out << " where |dV/dt| > " << M_dvdtThreshold;
+        else out << " at all the nodes";
+    }
+    out << std::endl;
+}
+
+} /* namespace BeatIt */
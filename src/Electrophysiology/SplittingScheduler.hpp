@@ -0,0 +1,92 @@
+/*
+ * SplittingScheduler.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_ELECTROPHYSIOLOGY_SPLITTINGSCHEDULER_HPP_
+#define SRC_ELECTROPHYSIOLOGY_SPLITTINGSCHEDULER_HPP_
+
+#include <iostream>
+#include <string>
+#include "libmesh/libmesh_common.h"
+
+class GetPot;
+
+namespace libMesh
+{
+template <typename T> class NumericVector;
+}
+
+namespace BeatIt
+{
+
+class ElectroSolver;
+
+enum class SplittingScheme { Godunov, Strang };
+
+//! Time step of an ElectroSolver: advance, reaction and diffusion steps
+/*!
+ *  Godunov: reaction step of dt with V^n, then diffusion step of dt.
+ *  Strang:  reaction step of dt/2, diffusion step of dt, reaction step of dt/2.
+ *           Both half steps use V^n+1/2 = ( 3 V^n - V^n-1 ) / 2 and the diffusion step
+ *           uses the current at ( V^n+1/2, w^n+1/2 ) (see ElectroSolver::set_reaction_midpoint_potential).
+ *           The scheme is second order if the state variables are integrated exactly or
+ *           with a second order method at fixed potential (e.g. FentonKarma with
+ *           integrator = rush_larsen): variables advanced with forward Euler, as in most
+ *           native integrators, make it first order.
+ *
+ *  The reaction steps can be multirate: the nodes with |dV/dt| above a threshold
+ *  advance their state variables with N substeps, the resting tissue takes a single step
+ *  (see ElectroSolver::set_reaction_substeps).
+ *
+ *  Input file, in section/splitting:
+ *      scheme = godunov        # godunov or strang
+ *      reaction_substeps = 1   # substeps of the reaction step
+ *      dvdt_threshold = 0.0    # mV/ms, nodes taking the substeps (<= 0: all the nodes)
+ *
+ *  Strang splitting and substeps need the FirstOrderIMEX time integrator.
+ */
+class SplittingScheduler
+{
+public:
+    SplittingScheduler(ElectroSolver& solver);
+
+    void setup(const GetPot& data, const std::string& section);
+
+    //! Advance the solver from time - dt to time
+    /*!
+     *  Replaces the sequence advance(), solve_reaction_step, solve_diffusion_step of the drivers
+     *  \param [in] dt diffusion time step
+     *  \param [in] time time at the end of the step
+     *  \param [in] useMidpoint, mass, I4f_ptr as in solve_reaction_step and solve_diffusion_step
+     */
+    void step( double dt,
+               double time,
+               bool useMidpoint = true,
+               const std::string& mass = "mass",
+               libMesh::NumericVector<libMesh::Number>* I4f_ptr = nullptr );
+
+    SplittingScheme scheme() const
+    {
+        return M_scheme;
+    }
+    unsigned int reaction_substeps() const
+    {
+        return M_reactionSubsteps;
+    }
+
+    void showMe(std::ostream& out = std::cout) const;
+
+private:
+    ElectroSolver& M_solver;
+    SplittingScheme M_scheme;
+    unsigned int M_reactionSubsteps;
+    double M_dvdtThreshold;
+    unsigned int M_step;
+};
+
+} /* namespace BeatIt */
+
+#endif /* SRC_ELECTROPHYSIOLOGY_SPLITTINGSCHEDULER_HPP_ */
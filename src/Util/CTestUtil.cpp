@@ -32,6 +32,35 @@ int check_test(double norm, double reference_norm, double tol)
 	  }
 }
 
+double action_potential_duration(const std::vector<double>& v, double dt, double& peak, double repolarization)
+{
+    peak = 0.0;
+    if (v.empty()) return 0.0;
+    peak = v[0];
+    std::size_t upstroke = 0;
+    std::size_t peak_index = 0;
+    double max_dvdt = 0.0;
+    for (std::size_t i = 1; i < v.size(); ++i)
+    {
+        if (v[i] - v[i-1] > max_dvdt)
+        {
+            max_dvdt = v[i] - v[i-1];
+            upstroke = i;
+        }
+        if (v[i] > peak)
+        {
+            peak = v[i];
+            peak_index = i;
+        }
+    }
+    const double threshold = peak - repolarization * (peak - v[0]);
+    for (std::size_t i = peak_index; i < v.size(); ++i)
+    {
+        if (v[i] < threshold) return (static_cast<double>(i) - static_cast<double>(upstroke)) * dt;
+    }
+    return 0.0;
+}
+
 } //CTest
 
 } //BeatIt
@@ -2,6 +2,8 @@
 #ifndef SRC_UTIL_CTESTUTIL_HPP_
 #define SRC_UTIL_CTESTUTIL_HPP_
 
+#include <vector>
+
 namespace BeatIt
 {
 
@@ -9,6 +11,14 @@ namespace CTest
 {
 
 	int check_test(double norm, double reference_norm, double tol);
+	//! Duration of the first action potential of the trace v, sampled every dt
+	/*!
+	 *  Measured from the maximum upstroke velocity to the time the potential goes below
+	 *  peak - repolarization * (peak - v[0]) (0.9 for the APD90).
+	 *  \param [out] peak maximum of the potential
+	 *  \return the duration, 0 if the potential does not repolarize
+	 */
+	double action_potential_duration(const std::vector<double>& v, double dt, double& peak, double repolarization = 0.9);
 
 } // CTest
 
@@ -0,0 +1,504 @@
+/*
+ * CompiledExpression.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Util/CompiledExpression.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace BeatIt
+{
+
+constexpr unsigned int CompiledExpression::BlockSize;
+constexpr unsigned int CompiledExpression::MaxStackSize;
+
+namespace
+{
+
+inline double unaryValue(CompiledExpression::OpCode op, double a)
+{
+    switch (op)
+    {
+        case CompiledExpression::Negate: return -a;
+        case CompiledExpression::Abs:    return std::fabs(a);
+        case CompiledExpression::Cos:    return std::cos(a);
+        case CompiledExpression::Sin:    return std::sin(a);
+        case CompiledExpression::Tan:    return std::tan(a);
+        case CompiledExpression::Cosh:   return std::cosh(a);
+        case CompiledExpression::Sinh:   return std::sinh(a);
+        case CompiledExpression::Tanh:   return std::tanh(a);
+        case CompiledExpression::Acos:   return std::acos(a);
+        case CompiledExpression::Asin:   return std::asin(a);
+        case CompiledExpression::Atan:   return std::atan(a);
+        case CompiledExpression::Sqrt:   return std::sqrt(a);
+        case CompiledExpression::Log:    return std::log(a);
+        case CompiledExpression::Log10:  return std::log10(a);
+        case CompiledExpression::Exp:    return std::exp(a);
+        default: break;
+    }
+    throw std::runtime_error("CompiledExpression: invalid unary operation");
+}
+
+inline double binaryValue(CompiledExpression::OpCode op, double a, double b)
+{
+    switch (op)
+    {
+        case CompiledExpression::Add:          return a + b;
+        case CompiledExpression::Subtract:     return a - b;
+        case CompiledExpression::Multiply:     return a * b;
+        case CompiledExpression::Divide:       return a / b;
+        case CompiledExpression::Power:        return std::pow(a, b);
+        case CompiledExpression::GreaterEqual: return a >= b;
+        case CompiledExpression::LessEqual:    return a <= b;
+        case CompiledExpression::Greater:      return a > b;
+        case CompiledExpression::Less:         return a < b;
+        default: break;
+    }
+    throw std::runtime_error("CompiledExpression: invalid binary operation");
+}
+
+inline bool isUnary(CompiledExpression::OpCode op)
+{
+    return op == CompiledExpression::Negate || op >= CompiledExpression::Abs;
+}
+
+struct FunctionName
+{
+    const char * name;
+    CompiledExpression::OpCode op;
+};
+
+// Same order as in the Grammar: a name is accepted only if followed by '('
+const FunctionName S_functions[] =
+{
+    { "abs", CompiledExpression::Abs },
+    { "cos", CompiledExpression::Cos },
+    { "sin", CompiledExpression::Sin },
+    { "tan", CompiledExpression::Tan },
+    { "cosh", CompiledExpression::Cosh },
+    { "sinh", CompiledExpression::Sinh },
+    { "tanh", CompiledExpression::Tanh },
+    { "acos", CompiledExpression::Acos },
+    { "asin", CompiledExpression::Asin },
+    { "atan", CompiledExpression::Atan },
+    { "sqrt", CompiledExpression::Sqrt },
+    { "log", CompiledExpression::Log },
+    { "log10", CompiledExpression::Log10 },
+    { "exp", CompiledExpression::Exp }
+};
+
+} // namespace
+
+//! Recursive descent parser following the rules of the Grammar
+/*!
+ *  expression := compare*      (the value is the one of the last compare)
+ *  compare    := plus_minus ( (">=" | "<=" | ">" | "<") plus_minus )*
+ *  plus_minus := multiply_divide ( ('+' | '-') multiply_divide )*
+ *  multiply_divide := power ( ('*' | '/') power )*
+ *  power      := part ( '^' part )*
+ *  part       := number | function group | group | '-' power | '+' power | symbol
+ *  group      := '(' expression ')'
+ *
+ *  As in the Grammar, a number can start with a sign: -2^2 = 4 while -x^2 = -(x^2).
+ */
+class CompiledExpression::Parser
+{
+public:
+    Parser(const std::string& str, std::vector<Instruction>& code)
+        : M_str(str), M_pos(0), M_code(code), M_depth(0)
+    {
+    }
+
+    void parse()
+    {
+        M_code.clear();
+        parseExpression();
+        skip();
+        if (M_pos != M_str.size()) error("unexpected character");
+    }
+
+private:
+    void parseExpression()
+    {
+        const std::size_t start = M_code.size();
+        const unsigned int depth = M_depth;
+        bool empty = true;
+        skip();
+        while (M_pos < M_str.size() && M_str[M_pos] != ')')
+        {
+            // Only the last comparison gives the value
+            M_code.resize(start);
+            M_depth = depth;
+            parseCompare();
+            empty = false;
+            skip();
+        }
+        if (empty) emit(Constant, 0.0);
+    }
+
+    void parseCompare()
+    {
+        parsePlusMinus();
+        while (true)
+        {
+            skip();
+            OpCode op;
+            if (match(">=")) op = GreaterEqual;
+            else if (match("<=")) op = LessEqual;
+            else if (match(">")) op = Greater;
+            else if (match("<")) op = Less;
+            else return;
+            parsePlusMinus();
+            emit(op);
+        }
+    }
+
+    void parsePlusMinus()
+    {
+        parseMultiplyDivide();
+        while (true)
+        {
+            skip();
+            OpCode op;
+            if (match("+")) op = Add;
+            else if (match("-")) op = Subtract;
+            else return;
+            parseMultiplyDivide();
+            emit(op);
+        }
+    }
+
+    void parseMultiplyDivide()
+    {
+        parsePower();
+        while (true)
+        {
+            skip();
+            OpCode op;
+            if (match("*")) op = Multiply;
+            else if (match("/")) op = Divide;
+            else return;
+            parsePower();
+            emit(op);
+        }
+    }
+
+    void parsePower()
+    {
+        parsePart();
+        while (true)
+        {
+            skip();
+            if (!match("^")) return;
+            parsePart();
+            emit(Power);
+        }
+    }
+
+    void parsePart()
+    {
+        skip();
+        if (parseNumber()) return;
+        if (parseFunction()) return;
+        if (M_pos < M_str.size() && M_str[M_pos] == '(')
+        {
+            parseGroup();
+            return;
+        }
+        if (match("-"))
+        {
+            parsePower();
+            emit(Negate);
+            return;
+        }
+        if (match("+"))
+        {
+            parsePower();
+            return;
+        }
+        if (parseSymbol()) return;
+        error("expected a number, a function, a variable or '('");
+    }
+
+    void parseGroup()
+    {
+        skip();
+        if (!match("(")) error("expected '('");
+        parseExpression();
+        skip();
+        if (!match(")")) error("expected ')'");
+    }
+
+    bool parseFunction()
+    {
+        for (auto && f : S_functions)
+        {
+            const std::size_t length = std::strlen(f.name);
+            if (M_str.compare(M_pos, length, f.name) != 0) continue;
+            std::size_t next = M_pos + length;
+            while (next < M_str.size() && std::isspace(static_cast<unsigned char>(M_str[next]))) ++next;
+            if (next < M_str.size() && M_str[next] == '(')
+            {
+                M_pos = next;
+                parseGroup();
+                emit(f.op);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool parseSymbol()
+    {
+        if (match("pi")) emit(Constant, M_PI);
+        else if (match("e")) emit(Constant, M_E);
+        else if (match("t")) emit(VariableT);
+        else if (match("x")) emit(VariableX);
+        else if (match("y")) emit(VariableY);
+        else if (match("z")) emit(VariableZ);
+        else return false;
+        return true;
+    }
+
+    //! [sign] (digits [. digits] | . digits) [(e|E) [sign] digits]
+    bool parseNumber()
+    {
+        std::size_t i = M_pos;
+        const std::size_t n = M_str.size();
+        if (i < n && (M_str[i] == '+' || M_str[i] == '-')) ++i;
+        std::size_t digits = 0;
+        while (i < n && std::isdigit(static_cast<unsigned char>(M_str[i]))) { ++i; ++digits; }
+        if (i < n && M_str[i] == '.')
+        {
+            ++i;
+            while (i < n && std::isdigit(static_cast<unsigned char>(M_str[i]))) { ++i; ++digits; }
+        }
+        if (0 == digits) return false;
+        if (i < n && (M_str[i] == 'e' || M_str[i] == 'E'))
+        {
+            std::size_t j = i + 1;
+            if (j < n && (M_str[j] == '+' || M_str[j] == '-')) ++j;
+            std::size_t exponent_digits = 0;
+            while (j < n && std::isdigit(static_cast<unsigned char>(M_str[j]))) { ++j; ++exponent_digits; }
+            if (exponent_digits > 0) i = j;
+        }
+        const double value = std::strtod(M_str.substr(M_pos, i - M_pos).c_str(), nullptr);
+        M_pos = i;
+        emit(Constant, value);
+        return true;
+    }
+
+    //! Append an instruction, folding the operations on constants
+    void emit(OpCode op, double value = 0.0)
+    {
+        const std::size_t n = M_code.size();
+        if (op <= VariableZ)
+        {
+            M_code.push_back({ op, value });
+            if (++M_depth > MaxStackSize) error("expression too deeply nested");
+        }
+        else if (isUnary(op))
+        {
+            if (M_code[n - 1].op == Constant) M_code[n - 1].value = unaryValue(op, M_code[n - 1].value);
+            else M_code.push_back({ op, 0.0 });
+        }
+        else
+        {
+            if (M_code[n - 1].op == Constant && M_code[n - 2].op == Constant)
+            {
+                M_code[n - 2].value = binaryValue(op, M_code[n - 2].value, M_code[n - 1].value);
+                M_code.pop_back();
+            }
+            else M_code.push_back({ op, 0.0 });
+            --M_depth;
+        }
+    }
+
+    bool match(const char * token)
+    {
+        const std::size_t length = std::strlen(token);
+        if (M_str.compare(M_pos, length, token) != 0) return false;
+        M_pos += length;
+        return true;
+    }
+
+    void skip()
+    {
+        while (M_pos < M_str.size() && std::isspace(static_cast<unsigned char>(M_str[M_pos]))) ++M_pos;
+    }
+
+    void error(const std::string& message) const
+    {
+        throw std::runtime_error("CompiledExpression: " + message + " at position " + std::to_string(M_pos) + " in '" + M_str + "'");
+    }
+
+    const std::string& M_str;
+    std::size_t M_pos;
+    std::vector<Instruction>& M_code;
+    unsigned int M_depth;
+};
+
+CompiledExpression::CompiledExpression()
+    : M_expression("0")
+    , M_code(1, Instruction{ Constant, 0.0 })
+{
+}
+
+CompiledExpression::CompiledExpression(const std::string& expression)
+    : CompiledExpression()
+{
+    compile(expression);
+}
+
+void
+CompiledExpression::compile(const std::string& expression)
+{
+    std::vector<Instruction> code;
+    Parser(expression, code).parse();
+    M_code.swap(code);
+    M_expression = expression;
+}
+
+double
+CompiledExpression::operator()(double t, double x, double y, double z) const
+{
+    double stack[MaxStackSize];
+    int sp = -1;
+    for (auto && ins : M_code)
+    {
+        switch (ins.op)
+        {
+            case Constant:  stack[++sp] = ins.value; break;
+            case VariableT: stack[++sp] = t; break;
+            case VariableX: stack[++sp] = x; break;
+            case VariableY: stack[++sp] = y; break;
+            case VariableZ: stack[++sp] = z; break;
+            default:
+            {
+                if (isUnary(ins.op))
+                {
+                    stack[sp] = unaryValue(ins.op, stack[sp]);
+                }
+                else
+                {
+                    stack[sp - 1] = binaryValue(ins.op, stack[sp - 1], stack[sp]);
+                    --sp;
+                }
+                break;
+            }
+        }
+    }
+    return stack[0];
+}
+
+void
+CompiledExpression::evaluate(unsigned int n, const double * x, const double * y, const double * z, double t, double * values) const
+{
+    if (isConstant())
+    {
+        std::fill(values, values + n, M_code[0].value);
+        return;
+    }
+
+    double stack[MaxStackSize][BlockSize];
+    for (unsigned int begin = 0; begin < n; begin += BlockSize)
+    {
+        const unsigned int m = std::min(BlockSize, n - begin);
+        int sp = -1;
+        for (auto && ins : M_code)
+        {
+            // Each instruction is executed on the whole block of points
+            double * a = (sp > 0) ? stack[sp - 1] : nullptr;
+            double * b = (sp >= 0) ? stack[sp] : nullptr;
+            switch (ins.op)
+            {
+                case Constant:
+                    ++sp;
+                    std::fill(stack[sp], stack[sp] + m, ins.value);
+                    break;
+                case VariableT:
+                    ++sp;
+                    std::fill(stack[sp], stack[sp] + m, t);
+                    break;
+                case VariableX:
+                    std::copy(x + begin, x + begin + m, stack[++sp]);
+                    break;
+                case VariableY:
+                    std::copy(y + begin, y + begin + m, stack[++sp]);
+                    break;
+                case VariableZ:
+                    std::copy(z + begin, z + begin + m, stack[++sp]);
+                    break;
+                case Negate:
+                    for (unsigned int i = 0; i < m; ++i) b[i] = -b[i];
+                    break;
+                case Add:
+                    for (unsigned int i = 0; i < m; ++i) a[i] += b[i];
+                    --sp;
+                    break;
+                case Subtract:
+                    for (unsigned int i = 0; i < m; ++i) a[i] -= b[i];
+                    --sp;
+                    break;
+                case Multiply:
+                    for (unsigned int i = 0; i < m; ++i) a[i] *= b[i];
+                    --sp;
+                    break;
+                case Divide:
+                    for (unsigned int i = 0; i < m; ++i) a[i] /= b[i];
+                    --sp;
+                    break;
+                case GreaterEqual:
+                    for (unsigned int i = 0; i < m; ++i) a[i] = (a[i] >= b[i]) ? 1.0 : 0.0;
+                    --sp;
+                    break;
+                case LessEqual:
+                    for (unsigned int i = 0; i < m; ++i) a[i] = (a[i] <= b[i]) ? 1.0 : 0.0;
+                    --sp;
+                    break;
+                case Greater:
+                    for (unsigned int i = 0; i < m; ++i) a[i] = (a[i] > b[i]) ? 1.0 : 0.0;
+                    --sp;
+                    break;
+                case Less:
+                    for (unsigned int i = 0; i < m; ++i) a[i] = (a[i] < b[i]) ? 1.0 : 0.0;
+                    --sp;
+                    break;
+                case Power:
+                    for (unsigned int i = 0; i < m; ++i) a[i] = std::pow(a[i], b[i]);
+                    --sp;
+                    break;
+                default:
+                    for (unsigned int i = 0; i < m; ++i) b[i] = unaryValue(ins.op, b[i]);
+                    break;
+            }
+        }
+        std::copy(stack[0], stack[0] + m, values + begin);
+    }
+}
+
+bool
+CompiledExpression::isConstant() const
+{
+    return M_code.size() == 1 && M_code[0].op == Constant;
+}
+
+bool
+CompiledExpression::isTimeDependent() const
+{
+    for (auto && ins : M_code)
+    {
+        if (ins.op == VariableT) return true;
+    }
+    return false;
+}
+
+} /* namespace BeatIt */
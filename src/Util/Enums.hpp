@@ -53,7 +53,8 @@
 namespace BeatIt
 {
 
-enum class DynamicTimeIntegratorType {Explicit, Implicit};
+//! CentralDifference: explicit dynamics with the lumped mass, no linear solves
+enum class DynamicTimeIntegratorType {Explicit, Implicit, CentralDifference};
 
 } // namespace BeatIt
 
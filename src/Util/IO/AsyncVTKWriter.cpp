@@ -0,0 +1,386 @@
+/*
+ * AsyncVTKWriter.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Util/IO/AsyncVTKWriter.hpp"
+#include "Util/Timer.hpp"
+
+#include "libmesh/mesh_base.h"
+#include "libmesh/elem.h"
+#include "libmesh/node.h"
+#include "libmesh/equation_systems.h"
+#include "libmesh/system.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/fe_type.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace BeatIt
+{
+
+namespace
+{
+
+const char * byte_order()
+{
+    const std::uint16_t one = 1;
+    return *reinterpret_cast<const char *>(&one) == 1 ? "LittleEndian" : "BigEndian";
+}
+
+//! VTK cell type and libMesh index of the VTK nodes
+std::uint8_t vtk_cell_type(const libMesh::Elem& elem, std::vector<unsigned int>& node_map)
+{
+    node_map.resize(elem.n_nodes());
+    for (unsigned int n = 0; n < node_map.size(); ++n)
+        node_map[n] = n;
+    switch (elem.type())
+    {
+        case libMesh::NODEELEM:
+            return 1;
+        case libMesh::EDGE2:
+            return 3;
+        case libMesh::EDGE3:
+            return 21;
+        case libMesh::TRI3:
+            return 5;
+        case libMesh::TRI6:
+            return 22;
+        case libMesh::QUAD4:
+            return 9;
+        case libMesh::QUAD8:
+            return 23;
+        case libMesh::TET4:
+            return 10;
+        case libMesh::TET10:
+            return 24;
+        case libMesh::PRISM6:
+            return 13;
+        case libMesh::PYRAMID5:
+            return 14;
+        case libMesh::HEX8:
+            return 12;
+        case libMesh::HEX20:
+            // VTK: bottom edges, top edges, vertical edges
+            node_map = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 16, 17, 18, 19, 12, 13, 14, 15 };
+            return 25;
+        default:
+            throw std::runtime_error("AsyncVTKWriter: element type " + std::to_string(elem.type()) + " not supported");
+    }
+}
+
+template<typename T>
+void write_array(std::ostream& out, const std::vector<T>& array)
+{
+    const std::uint64_t bytes = array.size() * sizeof(T);
+    out.write(reinterpret_cast<const char *>(&bytes), sizeof(bytes));
+    if (bytes > 0) out.write(reinterpret_cast<const char *>(array.data()), bytes);
+}
+
+template<typename T>
+std::uint64_t array_size(const std::vector<T>& array)
+{
+    return sizeof(std::uint64_t) + array.size() * sizeof(T);
+}
+
+std::string piece_name(const std::string& basename, int step, unsigned int rank)
+{
+    std::ostringstream ss;
+    ss << basename << "_" << std::setw(4) << std::setfill('0') << step << "_" << rank << ".vtu";
+    return ss.str();
+}
+
+std::string master_name(const std::string& basename, int step)
+{
+    std::ostringstream ss;
+    ss << basename << "_" << std::setw(4) << std::setfill('0') << step << ".pvtu";
+    return ss.str();
+}
+
+}
+
+AsyncVTKWriter::AsyncVTKWriter(const libMesh::MeshBase& mesh, const std::string& output_folder)
+    : M_mesh(mesh), M_outputFolder(output_folder), M_rank(mesh.processor_id()), M_nProcessors(mesh.n_processors()), M_meshIsSet(false), M_points(), M_connectivity(), M_offsets(), M_types(), M_pointNodes(), M_cellElems(), M_dofs(), M_collections(), M_frames(), M_busy{ false, false }, M_queue(), M_stop(false), M_mutex(), M_condition(), M_thread(), M_snapshotTime(0.0), M_writeTime(0.0), M_numberOfWrites(0)
+{
+    M_thread = std::thread(&AsyncVTKWriter::run, this);
+}
+
+AsyncVTKWriter::~AsyncVTKWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(M_mutex);
+        M_stop = true;
+    }
+    M_condition.notify_all();
+    if (M_thread.joinable()) M_thread.join();
+}
+
+void AsyncVTKWriter::reset_mesh()
+{
+    // The writer thread may still use the mesh data
+    finish();
+    M_meshIsSet = false;
+    M_dofs.clear();
+}
+
+void AsyncVTKWriter::setup_mesh()
+{
+    M_points.clear();
+    M_connectivity.clear();
+    M_offsets.clear();
+    M_types.clear();
+    M_pointNodes.clear();
+    M_cellElems.clear();
+
+    std::unordered_map<libMesh::dof_id_type, std::int64_t> point_index;
+    std::vector<unsigned int> node_map;
+    libMesh::MeshBase::const_element_iterator el = M_mesh.active_local_elements_begin();
+    const libMesh::MeshBase::const_element_iterator end_el = M_mesh.active_local_elements_end();
+    for (; el != end_el; ++el)
+    {
+        const libMesh::Elem * elem = *el;
+        M_types.push_back(vtk_cell_type(*elem, node_map));
+        for (auto n : node_map)
+        {
+            const libMesh::Node& node = *elem->node_ptr(n);
+            auto it = point_index.find(node.id());
+            if (it == point_index.end())
+            {
+                it = point_index.emplace(node.id(), M_pointNodes.size()).first;
+                M_pointNodes.push_back(&node);
+                for (unsigned int d = 0; d < 3; ++d)
+                    M_points.push_back(node(d));
+            }
+            M_connectivity.push_back(it->second);
+        }
+        M_offsets.push_back(M_connectivity.size());
+        M_cellElems.push_back(elem);
+    }
+    M_meshIsSet = true;
+}
+
+const std::vector<libMesh::dof_id_type>& AsyncVTKWriter::variable_dofs(const libMesh::System& system, unsigned int var, bool& cell)
+{
+    const std::string key = system.name() + "/" + system.variable_name(var);
+    auto it = M_dofs.find(key);
+    if (it == M_dofs.end())
+    {
+        const libMesh::FEType& fe_type = system.variable_type(var);
+        const bool is_cell = fe_type.family == libMesh::MONOMIAL && fe_type.order == libMesh::CONSTANT;
+        const std::vector<const libMesh::DofObject *>& objects = is_cell ? M_cellElems : M_pointNodes;
+        const unsigned int sys = system.number();
+        std::vector<libMesh::dof_id_type> dofs(objects.size(), libMesh::DofObject::invalid_id);
+        for (unsigned int i = 0; i < objects.size(); ++i)
+        {
+            // The variable may not be defined on all the subdomains (bath)
+            if (objects[i]->n_comp(sys, var) > 0) dofs[i] = objects[i]->dof_number(sys, var, 0);
+        }
+        it = M_dofs.emplace(key, std::make_pair(is_cell, std::move(dofs))).first;
+    }
+    cell = it->second.first;
+    return it->second.second;
+}
+
+void AsyncVTKWriter::write(const std::string& basename,
+                           int step,
+                           double time,
+                           const libMesh::EquationSystems& es,
+                           const std::set<std::string>& system_names)
+{
+    Timer timer;
+    timer.start();
+    if (!M_meshIsSet) setup_mesh();
+
+    // Wait for a free buffer
+    unsigned int b = 0;
+    {
+        std::unique_lock<std::mutex> lock(M_mutex);
+        M_condition.wait(lock, [this]
+        {   return !M_busy[0] || !M_busy[1];});
+        b = M_busy[0] ? 1 : 0;
+    }
+
+    Frame& frame = M_frames[b];
+    frame.basename = basename;
+    frame.step = step;
+    frame.time = time;
+    // Reuse the storage of the previous frame
+    unsigned int n_fields = 0;
+    for (auto && name : system_names)
+    {
+        if (!es.has_system(name)) continue;
+        const libMesh::System& system = es.get_system(name);
+        const libMesh::NumericVector<libMesh::Number>& solution = *system.current_local_solution;
+        for (unsigned int v = 0; v < system.n_vars(); ++v)
+        {
+            bool cell = false;
+            const std::vector<libMesh::dof_id_type>& dofs = variable_dofs(system, v, cell);
+            if (frame.fields.size() <= n_fields) frame.fields.emplace_back();
+            Field& field = frame.fields[n_fields++];
+            field.name = system.variable_name(v);
+            field.cell = cell;
+            field.values.resize(dofs.size());
+            for (unsigned int i = 0; i < dofs.size(); ++i)
+            {
+                field.values[i] = dofs[i] == libMesh::DofObject::invalid_id ? 0.0 : solution(dofs[i]);
+            }
+        }
+    }
+    frame.fields.resize(n_fields);
+
+    {
+        std::lock_guard<std::mutex> lock(M_mutex);
+        M_busy[b] = true;
+        M_queue.push_back(b);
+    }
+    M_condition.notify_all();
+    timer.stop();
+    M_snapshotTime += timer.M_elapsed.count();
+}
+
+void AsyncVTKWriter::finish()
+{
+    std::unique_lock<std::mutex> lock(M_mutex);
+    M_condition.wait(lock, [this]
+    {   return !M_busy[0] && !M_busy[1];});
+}
+
+void AsyncVTKWriter::run()
+{
+    while (true)
+    {
+        unsigned int b = 0;
+        {
+            std::unique_lock<std::mutex> lock(M_mutex);
+            M_condition.wait(lock, [this]
+            {   return M_stop || !M_queue.empty();});
+            if (M_queue.empty()) return;
+            b = M_queue.front();
+            M_queue.pop_front();
+        }
+
+        Timer timer;
+        timer.start();
+        try
+        {
+            write_piece(M_frames[b]);
+            if (M_rank == 0) write_master(M_frames[b]);
+        }
+        catch (std::exception& e)
+        {
+            // The exception cannot be propagated to the solver thread
+            std::cerr << "* AsyncVTKWriter: " << e.what() << std::endl;
+        }
+        timer.stop();
+
+        {
+            std::lock_guard<std::mutex> lock(M_mutex);
+            M_writeTime += timer.M_elapsed.count();
+            ++M_numberOfWrites;
+            M_busy[b] = false;
+        }
+        M_condition.notify_all();
+    }
+}
+
+void AsyncVTKWriter::write_piece(const Frame& frame) const
+{
+    const std::string filename = M_outputFolder + piece_name(frame.basename, frame.step, M_rank);
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) throw std::runtime_error("cannot open " + filename);
+
+    std::uint64_t offset = 0;
+    auto data_array = [&](const std::string& type, const std::string& name, unsigned int n_components, std::uint64_t bytes)
+    {
+        out << "<DataArray type=\"" << type << "\"";
+        if (!name.empty()) out << " Name=\"" << name << "\"";
+        if (n_components > 1) out << " NumberOfComponents=\"" << n_components << "\"";
+        out << " format=\"appended\" offset=\"" << offset << "\"/>\n";
+        offset += bytes;
+    };
+
+    out << "<?xml version=\"1.0\"?>\n";
+    out << "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"" << byte_order() << "\" header_type=\"UInt64\">\n";
+    out << "<UnstructuredGrid>\n";
+    out << "<Piece NumberOfPoints=\"" << M_pointNodes.size() << "\" NumberOfCells=\"" << M_types.size() << "\">\n";
+    out << "<PointData>\n";
+    for (auto && field : frame.fields)
+        if (!field.cell) data_array("Float64", field.name, 1, array_size(field.values));
+    out << "</PointData>\n";
+    out << "<CellData>\n";
+    for (auto && field : frame.fields)
+        if (field.cell) data_array("Float64", field.name, 1, array_size(field.values));
+    out << "</CellData>\n";
+    out << "<Points>\n";
+    data_array("Float64", "", 3, array_size(M_points));
+    out << "</Points>\n";
+    out << "<Cells>\n";
+    data_array("Int64", "connectivity", 1, array_size(M_connectivity));
+    data_array("Int64", "offsets", 1, array_size(M_offsets));
+    data_array("UInt8", "types", 1, array_size(M_types));
+    out << "</Cells>\n";
+    out << "</Piece>\n";
+    out << "</UnstructuredGrid>\n";
+    out << "<AppendedData encoding=\"raw\">\n_";
+    // Same order as the headers
+    for (auto && field : frame.fields)
+        if (!field.cell) write_array(out, field.values);
+    for (auto && field : frame.fields)
+        if (field.cell) write_array(out, field.values);
+    write_array(out, M_points);
+    write_array(out, M_connectivity);
+    write_array(out, M_offsets);
+    write_array(out, M_types);
+    out << "\n</AppendedData>\n";
+    out << "</VTKFile>\n";
+    if (!out) throw std::runtime_error("error writing " + filename);
+}
+
+void AsyncVTKWriter::write_master(const Frame& frame)
+{
+    const std::string master = master_name(frame.basename, frame.step);
+    {
+        const std::string filename = M_outputFolder + master;
+        std::ofstream out(filename);
+        if (!out) throw std::runtime_error("cannot open " + filename);
+        out << "<?xml version=\"1.0\"?>\n";
+        out << "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" byte_order=\"" << byte_order() << "\" header_type=\"UInt64\">\n";
+        out << "<PUnstructuredGrid GhostLevel=\"0\">\n";
+        out << "<PPointData>\n";
+        for (auto && field : frame.fields)
+            if (!field.cell) out << "<PDataArray type=\"Float64\" Name=\"" << field.name << "\"/>\n";
+        out << "</PPointData>\n";
+        out << "<PCellData>\n";
+        for (auto && field : frame.fields)
+            if (field.cell) out << "<PDataArray type=\"Float64\" Name=\"" << field.name << "\"/>\n";
+        out << "</PCellData>\n";
+        out << "<PPoints>\n<PDataArray type=\"Float64\" NumberOfComponents=\"3\"/>\n</PPoints>\n";
+        for (unsigned int p = 0; p < M_nProcessors; ++p)
+            out << "<Piece Source=\"" << piece_name(frame.basename, frame.step, p) << "\"/>\n";
+        out << "</PUnstructuredGrid>\n";
+        out << "</VTKFile>\n";
+    }
+
+    // Time collection, rewritten at each step
+    auto& collection = M_collections[frame.basename];
+    collection.emplace_back(frame.time, master);
+    const std::string filename = M_outputFolder + frame.basename + ".pvd";
+    std::ofstream out(filename);
+    if (!out) throw std::runtime_error("cannot open " + filename);
+    out << "<?xml version=\"1.0\"?>\n";
+    out << "<VTKFile type=\"Collection\" version=\"0.1\">\n";
+    out << "<Collection>\n";
+    for (auto && entry : collection)
+        out << "<DataSet timestep=\"" << std::setprecision(12) << entry.first << "\" part=\"0\" file=\"" << entry.second << "\"/>\n";
+    out << "</Collection>\n";
+    out << "</VTKFile>\n";
+}
+
+} /* namespace BeatIt */
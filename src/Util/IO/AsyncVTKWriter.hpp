@@ -0,0 +1,137 @@
+/*
+ * AsyncVTKWriter.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_UTIL_IO_ASYNCVTKWRITER_HPP_
+#define SRC_UTIL_IO_ASYNCVTKWRITER_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "libmesh/id_types.h"
+
+namespace libMesh
+{
+class MeshBase;
+class EquationSystems;
+class System;
+class DofObject;
+}
+
+namespace BeatIt
+{
+
+//! Double-buffered VTK writer running in a background thread
+/*!
+ *  write() copies the values of the variables of the selected systems at the nodes
+ *  (and at the elements for constant monomials) of the local elements into one of two
+ *  buffers and returns: the background thread of each processor writes its piece
+ *  basename_XXXX_rank.vtu (raw binary) while the solver continues.
+ *  The processor 0 also writes the master file basename_XXXX.pvtu and the collection basename.pvd.
+ *  The writer thread does not use MPI. write() waits only when both buffers are still being written.
+ *
+ *  The copy uses the ghosted current_local_solution of the systems, which must be up to date.
+ *  The local mesh and the dof indices are extracted at the first write: after the mesh
+ *  changes (AMR, EquationSystems::reinit) reset_mesh() must be called.
+ */
+class AsyncVTKWriter
+{
+public:
+    AsyncVTKWriter(const libMesh::MeshBase& mesh, const std::string& output_folder);
+    //! Waits for the pending writes
+    ~AsyncVTKWriter();
+
+    //! Copy the data of the systems and queue the write of basename_XXXX
+    void write(const std::string& basename,
+               int step,
+               double time,
+               const libMesh::EquationSystems& es,
+               const std::set<std::string>& system_names);
+    //! Wait until all the queued writes are completed
+    void finish();
+    //! The local mesh is extracted again at the next write: waits for the pending writes
+    void reset_mesh();
+
+    //! Time spent by write() copying the data and waiting for a free buffer
+    double snapshot_time() const
+    {
+        return M_snapshotTime;
+    }
+    //! Time spent by the background thread writing the files
+    double write_time() const
+    {
+        return M_writeTime;
+    }
+    unsigned int number_of_writes() const
+    {
+        return M_numberOfWrites;
+    }
+
+    struct Field
+    {
+        std::string name;
+        //! Cell data (true) or point data (false)
+        bool cell;
+        std::vector<double> values;
+    };
+
+    struct Frame
+    {
+        std::string basename;
+        int step;
+        double time;
+        std::vector<Field> fields;
+    };
+
+private:
+    //! Points, connectivity and cell types of the local elements
+    void setup_mesh();
+    //! Point or cell dofs of a variable, invalid_id where the variable is not defined
+    const std::vector<libMesh::dof_id_type>& variable_dofs(const libMesh::System& system, unsigned int var, bool& cell);
+    void run();
+    void write_piece(const Frame& frame) const;
+    void write_master(const Frame& frame);
+
+    const libMesh::MeshBase& M_mesh;
+    std::string M_outputFolder;
+    unsigned int M_rank;
+    unsigned int M_nProcessors;
+
+    bool M_meshIsSet;
+    std::vector<double> M_points;
+    std::vector<std::int64_t> M_connectivity;
+    std::vector<std::int64_t> M_offsets;
+    std::vector<std::uint8_t> M_types;
+    std::vector<const libMesh::DofObject *> M_pointNodes;
+    std::vector<const libMesh::DofObject *> M_cellElems;
+    std::map<std::string, std::pair<bool, std::vector<libMesh::dof_id_type> > > M_dofs;
+
+    //! Entries of the pvd collections
+    std::map<std::string, std::vector<std::pair<double, std::string> > > M_collections;
+
+    Frame M_frames[2];
+    bool M_busy[2];
+    std::deque<unsigned int> M_queue;
+    bool M_stop;
+    std::mutex M_mutex;
+    std::condition_variable M_condition;
+    std::thread M_thread;
+
+    double M_snapshotTime;
+    double M_writeTime;
+    unsigned int M_numberOfWrites;
+};
+
+} /* namespace BeatIt */
+
+#endif /* SRC_UTIL_IO_ASYNCVTKWRITER_HPP_ */
@@ -0,0 +1,490 @@
+/*
+ * Checkpoint.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Util/IO/Checkpoint.hpp"
+
+#include "libmesh/equation_systems.h"
+#include "libmesh/system.h"
+#include "libmesh/explicit_system.h"
+#include "libmesh/linear_implicit_system.h"
+#include "libmesh/transient_system.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/dof_map.h"
+#include "libmesh/mesh_base.h"
+#include "libmesh/node.h"
+#include "libmesh/elem.h"
+#include "libmesh/enum_parallel_type.h"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace BeatIt
+{
+
+namespace
+{
+
+typedef libMesh::NumericVector<libMesh::Number> Vector;
+
+const char magic[8] = { 'B', 'E', 'A', 'T', 'I', 'T', 'C', 'K' };
+//! Version 2 stores the step counter and the time of each system
+const std::uint32_t version = 2;
+const std::uint32_t byte_order_mark = 0x01020304;
+//! Bytes of magic, version, byte order mark and header size
+const std::uint64_t prefix_size = 24;
+//! Elements of a single MPI-IO call
+const std::uint64_t max_count = 1 << 28;
+
+template<typename T>
+void write_pod(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+void read_pod(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    if (!in) throw std::runtime_error("Checkpoint: truncated header");
+}
+
+void write_string(std::ostream& out, const std::string& s)
+{
+    write_pod(out, static_cast<std::uint32_t>(s.size()));
+    out.write(s.data(), s.size());
+}
+
+std::string read_string(std::istream& in)
+{
+    std::uint32_t length;
+    read_pod(in, length);
+    std::string s(length, ' ');
+    in.read(&s[0], length);
+    return s;
+}
+
+template<class Base>
+void add_transient_vectors(libMesh::System& system, std::vector<std::string>& names, std::vector<Vector *>& vectors)
+{
+    auto * transient = dynamic_cast<libMesh::TransientSystem<Base> *>(&system);
+    if (!transient) return;
+    names.push_back("old_local_solution");
+    vectors.push_back(&*transient->old_local_solution);
+    names.push_back("older_local_solution");
+    vectors.push_back(&*transient->older_local_solution);
+}
+
+//! Solution, old solutions (SBDF2) and additional vectors of the system
+void system_vectors(libMesh::System& system, std::vector<std::string>& names, std::vector<Vector *>& vectors)
+{
+    names.assign(1, "solution");
+    vectors.assign(1, &*system.solution);
+    add_transient_vectors<libMesh::LinearImplicitSystem>(system, names, vectors);
+    add_transient_vectors<libMesh::ExplicitSystem>(system, names, vectors);
+    std::set<const Vector *> added(vectors.begin(), vectors.end());
+    for (unsigned int i = 0; i < system.n_vectors(); ++i)
+    {
+        Vector * vector = &system.get_vector(i);
+        // The old solutions may also be stored as additional vectors
+        if (added.count(vector) || vector->size() != system.n_dofs()) continue;
+        names.push_back(system.vector_name(i));
+        vectors.push_back(vector);
+        added.insert(vector);
+    }
+}
+
+//! (object id, variable / component / object type) of the owned dofs, in dof order
+void dof_keys(const libMesh::System& system, std::vector<std::uint64_t>& keys, std::string& error)
+{
+    const libMesh::DofMap& dof_map = system.get_dof_map();
+    const libMesh::dof_id_type first = dof_map.first_dof();
+    const libMesh::dof_id_type end = dof_map.end_dof();
+    const unsigned int sys = system.number();
+    keys.assign(2 * (end - first), std::uint64_t(-1));
+    auto add = [&](const libMesh::DofObject& object, std::uint64_t is_elem)
+    {
+        for (unsigned int v = 0; v < system.n_vars(); ++v)
+        {
+            for (unsigned int c = 0; c < object.n_comp(sys, v); ++c)
+            {
+                const libMesh::dof_id_type dof = object.dof_number(sys, v, c);
+                if (dof < first || dof >= end) continue;
+                keys[2 * (dof - first)] = object.id();
+                keys[2 * (dof - first) + 1] = (std::uint64_t(v) << 32) | (std::uint64_t(c) << 1) | is_elem;
+            }
+        }
+    };
+    const libMesh::MeshBase& mesh = system.get_mesh();
+    for (auto node = mesh.local_nodes_begin(); node != mesh.local_nodes_end(); ++node)
+        add(**node, 0);
+    for (auto elem = mesh.local_elements_begin(); elem != mesh.local_elements_end(); ++elem)
+        add(**elem, 1);
+    for (auto && key : keys)
+    {
+        if (std::uint64_t(-1) == key && error.empty())
+        {
+            error = "Checkpoint: dof of the system " + system.name() + " not found on the local nodes and elements";
+        }
+    }
+}
+
+std::uint64_t hash(const std::vector<std::uint64_t>& keys)
+{
+    // FNV-1a
+    std::uint64_t h = 14695981039346656037ull;
+    for (auto && key : keys)
+    {
+        h ^= key;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+struct KeyHash
+{
+    std::size_t operator()(const std::pair<std::uint64_t, std::uint64_t>& key) const
+    {
+        return std::hash<std::uint64_t>()(key.first * 1099511628211ull ^ key.second);
+    }
+};
+
+//! Keep the first error of this processor
+void check(int status, const std::string& what, const std::string& filename, std::string& error)
+{
+    if (MPI_SUCCESS != status && error.empty()) error = "Checkpoint: " + what + " " + filename + " failed";
+}
+
+//! Collective: throw on all the processors if any of them had an error
+/*!
+ *  The errors are local (a failed read, dofs not matching the mesh) while the calls
+ *  that follow are collective: throwing only on one processor would hang the others.
+ *  \param [in] fh if given, the file is closed before throwing
+ */
+void throw_on_error(const libMesh::Parallel::Communicator& comm, const std::string& error, MPI_File * fh = nullptr)
+{
+    unsigned int failed = !error.empty();
+    comm.max(failed);
+    if (!failed) return;
+    if (fh) MPI_File_close(fh);
+    throw std::runtime_error(error.empty() ? "Checkpoint: error on another processor" : error);
+}
+
+//! Independent read of count elements, split in several calls if needed
+int read_at(MPI_File fh, std::uint64_t offset, void * data, std::uint64_t count, MPI_Datatype type, unsigned int size)
+{
+    char * bytes = static_cast<char *>(data);
+    for (std::uint64_t begin = 0; begin < count; begin += max_count)
+    {
+        const std::uint64_t n = std::min(max_count, count - begin);
+        const int status = MPI_File_read_at(fh, offset + begin * size, bytes + begin * size, static_cast<int>(n), type, MPI_STATUS_IGNORE);
+        if (MPI_SUCCESS != status) return status;
+    }
+    return MPI_SUCCESS;
+}
+
+//! Collective write: a processor with too many values takes part in the call without data
+int write_at_all(MPI_File fh, std::uint64_t offset, const void * data, std::uint64_t count, MPI_Datatype type)
+{
+    const bool too_large = count > INT_MAX;
+    const int status = MPI_File_write_at_all(fh, offset, const_cast<void *>(data), too_large ? 0 : static_cast<int>(count), type, MPI_STATUS_IGNORE);
+    return too_large ? MPI_ERR_COUNT : status;
+}
+
+//! Collective read: a processor with too many values takes part in the call without data
+int read_at_all(MPI_File fh, std::uint64_t offset, void * data, std::uint64_t count, MPI_Datatype type)
+{
+    const bool too_large = count > INT_MAX;
+    const int status = MPI_File_read_at_all(fh, offset, data, too_large ? 0 : static_cast<int>(count), type, MPI_STATUS_IGNORE);
+    return too_large ? MPI_ERR_COUNT : status;
+}
+
+//! Copy the values of the owned dofs into the vector
+void set_owned_values(const libMesh::System& system, const std::vector<libMesh::numeric_index_type>& indices, const std::vector<libMesh::Number>& values, Vector& vector)
+{
+    if (libMesh::SERIAL == vector.type())
+    {
+        // Every processor needs all the values
+        std::unique_ptr<Vector> parallel = Vector::build(system.comm());
+        parallel->init(system.n_dofs(), system.n_local_dofs(), false, libMesh::PARALLEL);
+        parallel->insert(values, indices);
+        parallel->close();
+        parallel->localize(vector);
+    }
+    else
+    {
+        // close() updates the ghosts
+        vector.insert(values, indices);
+        vector.close();
+    }
+}
+
+}
+
+void write_checkpoint(const std::string& filename, const libMesh::EquationSystems& es, double time, int step, long int counter)
+{
+    const libMesh::Parallel::Communicator& comm = es.comm();
+    const std::uint32_t n_processors = comm.size();
+    const std::uint32_t rank = comm.rank();
+    std::string error;
+
+    // Header: every processor builds it to know the offsets
+    std::ostringstream header;
+    header.write(magic, 8);
+    write_pod(header, version);
+    write_pod(header, byte_order_mark);
+    write_pod(header, std::uint64_t(0));
+    write_pod(header, n_processors);
+    write_pod(header, time);
+    write_pod(header, static_cast<std::int32_t>(step));
+    write_pod(header, static_cast<std::int64_t>(counter));
+    write_pod(header, static_cast<std::uint32_t>(es.n_systems()));
+
+    std::vector<std::vector<std::string> > names(es.n_systems());
+    std::vector<std::vector<Vector *> > vectors(es.n_systems());
+    std::vector<std::vector<std::uint64_t> > keys(es.n_systems());
+    for (unsigned int s = 0; s < es.n_systems(); ++s)
+    {
+        libMesh::System& system = const_cast<libMesh::System&>(es.get_system(s));
+        const libMesh::DofMap& dof_map = system.get_dof_map();
+        system_vectors(system, names[s], vectors[s]);
+        dof_keys(system, keys[s], error);
+        std::vector<std::uint64_t> first, n_local, hashes;
+        comm.allgather(static_cast<std::uint64_t>(dof_map.first_dof()), first);
+        comm.allgather(static_cast<std::uint64_t>(dof_map.n_local_dofs()), n_local);
+        comm.allgather(hash(keys[s]), hashes);
+
+        write_string(header, system.name());
+        write_pod(header, static_cast<double>(system.time));
+        write_pod(header, static_cast<std::uint64_t>(system.n_dofs()));
+        for (unsigned int p = 0; p < n_processors; ++p)
+        {
+            write_pod(header, first[p]);
+            write_pod(header, n_local[p]);
+            write_pod(header, hashes[p]);
+        }
+        write_pod(header, static_cast<std::uint32_t>(names[s].size()));
+        for (auto && name : names[s])
+            write_string(header, name);
+    }
+    throw_on_error(comm, error);
+    std::string header_bytes = header.str();
+    const std::uint64_t header_size = header_bytes.size();
+    std::memcpy(&header_bytes[16], &header_size, sizeof(header_size));
+
+    MPI_File fh;
+    check(MPI_File_open(comm.get(), const_cast<char *>(filename.c_str()), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh), "opening", filename, error);
+    throw_on_error(comm, error);
+    check(MPI_File_set_size(fh, 0), "truncating", filename, error);
+    if (0 == rank) check(MPI_File_write_at(fh, 0, &header_bytes[0], header_bytes.size(), MPI_BYTE, MPI_STATUS_IGNORE), "writing the header of", filename, error);
+
+    // Data: for each system the dof map and the vectors, as global vectors in dof order
+    // The writes are collective: the errors are checked at the end
+    std::uint64_t offset = header_size;
+    std::vector<libMesh::numeric_index_type> indices;
+    std::vector<libMesh::Number> values;
+    for (unsigned int s = 0; s < es.n_systems(); ++s)
+    {
+        const libMesh::System& system = es.get_system(s);
+        const libMesh::DofMap& dof_map = system.get_dof_map();
+        const std::uint64_t n_dofs = system.n_dofs();
+        const std::uint64_t first = dof_map.first_dof();
+        check(write_at_all(fh, offset + 2 * sizeof(std::uint64_t) * first, keys[s].data(), keys[s].size(), MPI_UINT64_T), "writing the dof map of " + system.name() + " to", filename, error);
+        offset += 2 * sizeof(std::uint64_t) * n_dofs;
+
+        indices.resize(dof_map.n_local_dofs());
+        for (unsigned int i = 0; i < indices.size(); ++i)
+            indices[i] = first + i;
+        for (unsigned int v = 0; v < vectors[s].size(); ++v)
+        {
+            vectors[s][v]->get(indices, values);
+            check(write_at_all(fh, offset + sizeof(double) * first, values.data(), values.size(), MPI_DOUBLE), "writing the vector " + names[s][v] + " of " + system.name() + " to", filename, error);
+            offset += sizeof(double) * n_dofs;
+        }
+    }
+    check(MPI_File_close(&fh), "closing", filename, error);
+    throw_on_error(comm, error);
+}
+
+void read_checkpoint(const std::string& filename, libMesh::EquationSystems& es, double& time, int& step, long int * counter)
+{
+    const libMesh::Parallel::Communicator& comm = es.comm();
+    const std::uint32_t rank = comm.rank();
+    std::string error;
+
+    MPI_File fh;
+    check(MPI_File_open(comm.get(), const_cast<char *>(filename.c_str()), MPI_MODE_RDONLY, MPI_INFO_NULL, &fh), "opening", filename, error);
+    throw_on_error(comm, error);
+
+    struct SystemData
+    {
+        std::string name;
+        double time;
+        std::uint64_t n_dofs;
+        std::vector<std::uint64_t> first, n_local, hashes;
+        std::vector<std::string> vectors;
+        std::uint64_t offset;
+    };
+    std::uint32_t n_processors = 0;
+    std::int64_t file_counter = 0;
+    std::vector<SystemData> systems;
+
+    // Header
+    try
+    {
+        std::string prefix(prefix_size, ' ');
+        check(read_at(fh, 0, &prefix[0], prefix_size, MPI_BYTE, 1), "reading", filename, error);
+        if (!error.empty()) throw std::runtime_error(error);
+        if (std::memcmp(prefix.data(), magic, 8) != 0) throw std::runtime_error("Checkpoint: " + filename + " is not a BeatIt checkpoint");
+        std::uint32_t file_version, bom;
+        std::uint64_t header_size;
+        std::memcpy(&file_version, &prefix[8], 4);
+        std::memcpy(&bom, &prefix[12], 4);
+        std::memcpy(&header_size, &prefix[16], 8);
+        if (file_version < 1 || file_version > version) throw std::runtime_error("Checkpoint: unsupported version " + std::to_string(file_version) + " of " + filename);
+        if (bom != byte_order_mark) throw std::runtime_error("Checkpoint: " + filename + " has been written with a different byte order");
+        std::string header_bytes(header_size, ' ');
+        check(read_at(fh, 0, &header_bytes[0], header_size, MPI_BYTE, 1), "reading the header of", filename, error);
+        if (!error.empty()) throw std::runtime_error(error);
+        std::istringstream header(header_bytes);
+        header.seekg(prefix_size);
+
+        std::uint32_t n_systems;
+        std::int32_t file_step;
+        read_pod(header, n_processors);
+        read_pod(header, time);
+        read_pod(header, file_step);
+        if (file_version > 1) read_pod(header, file_counter);
+        read_pod(header, n_systems);
+        step = file_step;
+
+        systems.resize(n_systems);
+        std::uint64_t offset = header_size;
+        for (auto && data : systems)
+        {
+            data.name = read_string(header);
+            data.time = time;
+            if (file_version > 1) read_pod(header, data.time);
+            read_pod(header, data.n_dofs);
+            data.first.resize(n_processors);
+            data.n_local.resize(n_processors);
+            data.hashes.resize(n_processors);
+            for (unsigned int p = 0; p < n_processors; ++p)
+            {
+                read_pod(header, data.first[p]);
+                read_pod(header, data.n_local[p]);
+                read_pod(header, data.hashes[p]);
+            }
+            std::uint32_t n_vectors;
+            read_pod(header, n_vectors);
+            for (unsigned int v = 0; v < n_vectors; ++v)
+                data.vectors.push_back(read_string(header));
+            data.offset = offset;
+            offset += (2 * sizeof(std::uint64_t) + data.vectors.size() * sizeof(double)) * data.n_dofs;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        error = e.what();
+    }
+    throw_on_error(comm, error, &fh);
+    if (counter) *counter = file_counter;
+
+    std::vector<libMesh::numeric_index_type> indices;
+    std::vector<libMesh::Number> values;
+    std::vector<std::uint64_t> keys;
+    for (auto && data : systems)
+    {
+        if (!es.has_system(data.name))
+        {
+            std::cout << "* Checkpoint: skipping the system " << data.name << std::endl;
+            continue;
+        }
+        libMesh::System& system = es.get_system(data.name);
+        if (system.n_dofs() != data.n_dofs) error = "Checkpoint: the system " + data.name + " has " + std::to_string(system.n_dofs()) + " dofs instead of " + std::to_string(data.n_dofs);
+        throw_on_error(comm, error, &fh);
+        const libMesh::DofMap& dof_map = system.get_dof_map();
+        const std::uint64_t first = dof_map.first_dof();
+        const std::uint64_t n_local = dof_map.n_local_dofs();
+        std::vector<std::string> names;
+        std::vector<Vector *> vectors;
+        system_vectors(system, names, vectors);
+        dof_keys(system, keys, error);
+        throw_on_error(comm, error, &fh);
+
+        // Same dof numbering: each processor reads its owned dofs
+        unsigned int same_layout = n_processors == comm.size() && data.first[rank] == first && data.n_local[rank] == n_local && data.hashes[rank] == hash(keys);
+        comm.min(same_layout);
+
+        // Otherwise match the dofs through the node and element ids
+        std::vector<std::uint64_t> old_dofs;
+        std::vector<libMesh::Number> global_values;
+        if (!same_layout)
+        {
+            std::unordered_map<std::pair<std::uint64_t, std::uint64_t>, std::uint64_t, KeyHash> local_dofs;
+            for (std::uint64_t i = 0; i < n_local; ++i)
+                local_dofs[std::make_pair(keys[2 * i], keys[2 * i + 1])] = i;
+            std::vector<std::uint64_t> file_keys(2 * data.n_dofs);
+            check(read_at(fh, data.offset, file_keys.data(), file_keys.size(), MPI_UINT64_T, sizeof(std::uint64_t)), "reading the dof map of " + data.name + " from", filename, error);
+            old_dofs.assign(n_local, std::uint64_t(-1));
+            for (std::uint64_t d = 0; d < data.n_dofs; ++d)
+            {
+                auto it = local_dofs.find(std::make_pair(file_keys[2 * d], file_keys[2 * d + 1]));
+                if (it != local_dofs.end()) old_dofs[it->second] = d;
+            }
+            for (auto && d : old_dofs)
+            {
+                if (std::uint64_t(-1) == d && error.empty()) error = "Checkpoint: the dofs of the system " + data.name + " do not match the mesh of the checkpoint";
+            }
+            throw_on_error(comm, error, &fh);
+        }
+        std::cout << "* Checkpoint: reading the system " << data.name << (same_layout ? "" : " (repartitioned)") << std::endl;
+
+        indices.resize(n_local);
+        for (unsigned int i = 0; i < n_local; ++i)
+            indices[i] = first + i;
+        values.resize(n_local);
+        for (unsigned int v = 0; v < data.vectors.size(); ++v)
+        {
+            unsigned int j = 0;
+            while (j < names.size() && names[j] != data.vectors[v])
+                ++j;
+            if (j == names.size()) continue;
+            const std::uint64_t vector_offset = data.offset + (2 * sizeof(std::uint64_t) + v * sizeof(double)) * data.n_dofs;
+            const std::string what = "reading the vector " + data.vectors[v] + " of " + data.name + " from";
+            if (same_layout)
+            {
+                check(read_at_all(fh, vector_offset + sizeof(double) * first, values.data(), n_local, MPI_DOUBLE), what, filename, error);
+            }
+            else
+            {
+                global_values.resize(data.n_dofs);
+                check(read_at(fh, vector_offset, global_values.data(), data.n_dofs, MPI_DOUBLE, sizeof(double)), what, filename, error);
+                for (std::uint64_t i = 0; i < n_local; ++i)
+                    values[i] = global_values[old_dofs[i]];
+            }
+            set_owned_values(system, indices, values, *vectors[j]);
+        }
+        throw_on_error(comm, error, &fh);
+        system.time = data.time;
+        system.update();
+    }
+    check(MPI_File_close(&fh), "closing", filename, error);
+    throw_on_error(comm, error);
+}
+
+} /* namespace BeatIt */
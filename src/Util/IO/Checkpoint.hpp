@@ -0,0 +1,53 @@
+/*
+ * Checkpoint.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_UTIL_IO_CHECKPOINT_HPP_
+#define SRC_UTIL_IO_CHECKPOINT_HPP_
+
+#include <string>
+
+namespace libMesh
+{
+class EquationSystems;
+}
+
+namespace BeatIt
+{
+
+//! Binary checkpoint of all the vectors of all the systems
+/*!
+ *  For each system the file contains the solution, the old and older solutions of the
+ *  transient systems and the additional vectors, each one stored as the global vector in
+ *  dof order: every processor writes its owned dofs in a single MPI-IO collective write.
+ *  The header stores, for each system and processor, the first dof, the number of local dofs
+ *  and a hash of the dof numbering, and the time of each system; the file also contains the
+ *  (node / element id, variable, component) of each dof.
+ *  The errors are collective: if a processor fails all of them throw.
+ *
+ *  \param [in] filename single file shared by all the processors
+ *  \param [in] counter step counter of the solver (e.g. the start of SBDF2)
+ */
+void write_checkpoint(const std::string& filename, const libMesh::EquationSystems& es, double time, int step, long int counter = 0);
+
+//! Read a checkpoint written by write_checkpoint
+/*!
+ *  With the same number of processors and the same dof numbering each processor reads
+ *  its owned dofs with a single collective read per vector.
+ *  Otherwise (different number of processors or partitioning) the dofs are matched
+ *  through the node / element ids: each processor reads the dof map and the vectors of
+ *  the checkpoint and picks its dofs. The mesh must be the same.
+ *  The vectors of the checkpoint not present in the systems are skipped.
+ *  The time of each system is restored.
+ *  \param [out] time time of the checkpoint
+ *  \param [out] step step of the checkpoint
+ *  \param [out] counter if given, the step counter of the solver
+ */
+void read_checkpoint(const std::string& filename, libMesh::EquationSystems& es, double& time, int& step, long int * counter = nullptr);
+
+} /* namespace BeatIt */
+
+#endif /* SRC_UTIL_IO_CHECKPOINT_HPP_ */
@@ -0,0 +1,396 @@
+/*
+ * CompressedFieldIO.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Util/IO/CompressedFieldIO.hpp"
+
+#include "libmesh/mesh_base.h"
+#include "libmesh/node.h"
+#include "libmesh/equation_systems.h"
+#include "libmesh/system.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/fe_type.h"
+#include "libmesh/getpot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace BeatIt
+{
+
+namespace
+{
+
+const char magic[8] = { 'B', 'E', 'A', 'T', 'I', 'T', 'F', 'O' };
+//! Version 2 reserves the last quantization level to the non-finite values
+const std::uint32_t version = 2;
+const std::uint32_t byte_order_mark = 0x01020304;
+const std::uint32_t step_marker = 0x53544550;
+
+template<typename T>
+void write_pod(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template<typename T>
+bool read_pod(std::istream& in, T& value)
+{
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+    return static_cast<bool>(in);
+}
+
+std::string piece_name(const std::string& filename, unsigned int rank)
+{
+    return filename + "_" + std::to_string(rank) + ".bfo";
+}
+
+struct Header
+{
+    std::uint32_t rank;
+    std::uint32_t n_processors;
+    std::vector<libMesh::dof_id_type> node_ids;
+    std::vector<std::string> names;
+    std::vector<FieldEncoding> encodings;
+};
+
+void read_header(std::istream& in, const std::string& filename, Header& header)
+{
+    char m[8];
+    in.read(m, 8);
+    if (!in || std::memcmp(m, magic, 8) != 0) throw std::runtime_error("CompressedFieldReader: " + filename + " is not a BeatIt field output file");
+    std::uint32_t v, bom;
+    read_pod(in, v);
+    read_pod(in, bom);
+    if (v != version) throw std::runtime_error("CompressedFieldReader: unsupported version " + std::to_string(v) + " of " + filename);
+    if (bom != byte_order_mark) throw std::runtime_error("CompressedFieldReader: " + filename + " has been written with a different byte order");
+    read_pod(in, header.rank);
+    read_pod(in, header.n_processors);
+    std::uint64_t n_nodes = 0;
+    read_pod(in, n_nodes);
+    header.node_ids.resize(n_nodes);
+    for (auto && id : header.node_ids)
+    {
+        std::uint64_t value;
+        read_pod(in, value);
+        id = value;
+    }
+    std::uint32_t n_fields = 0;
+    read_pod(in, n_fields);
+    header.names.resize(n_fields);
+    header.encodings.resize(n_fields);
+    for (unsigned int f = 0; f < n_fields; ++f)
+    {
+        std::uint32_t length, type, bits;
+        read_pod(in, length);
+        header.names[f].resize(length);
+        in.read(&header.names[f][0], length);
+        read_pod(in, type);
+        read_pod(in, bits);
+        FieldEncoding& encoding = header.encodings[f];
+        encoding.type = static_cast<FieldEncoding::Type>(type);
+        encoding.bits = bits;
+        read_pod(in, encoding.min);
+        read_pod(in, encoding.max);
+    }
+    if (!in) throw std::runtime_error("CompressedFieldReader: truncated header in " + filename);
+}
+
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Writer
+// ///////////////////////////////////////////////////////////////////////
+
+CompressedFieldWriter::CompressedFieldWriter(const libMesh::MeshBase& mesh, const std::string& filename)
+    : M_mesh(mesh), M_filename(filename), M_defaultEncoding(), M_encodings(), M_compressionLevel(6), M_file(), M_fields(), M_nSeries(0), M_values(), M_stored(), M_inputBytes(0), M_storedBytes(0)
+{
+}
+
+CompressedFieldWriter::~CompressedFieldWriter()
+{
+}
+
+void CompressedFieldWriter::setup(GetPot& data, const std::string& section)
+{
+    const std::string prefix = section + "/compressed_output/";
+    std::string precision = data(prefix + "precision", "float32");
+    FieldEncoding quantized(FieldEncoding::Quantized, data(prefix + "min", -100.0), data(prefix + "max", 60.0), data(prefix + "bits", 12));
+    if (quantized.bits < 2 || quantized.bits > 32 || quantized.max <= quantized.min)
+    {
+        throw std::runtime_error("CompressedFieldWriter: the quantization needs 2 to 32 bits and min < max");
+    }
+    M_defaultEncoding = FieldEncoding::Quantized == FieldEncoding::type_from_string(precision) ? quantized : FieldEncoding(FieldEncoding::type_from_string(precision));
+    M_compressionLevel = data(prefix + "level", 6);
+
+    std::string variables = data(prefix + "quantized", "");
+    std::replace(variables.begin(), variables.end(), ',', ' ');
+    std::istringstream ss(variables);
+    std::string name;
+    while (ss >> name)
+    {
+        M_encodings[name] = quantized;
+    }
+    std::cout << "* CompressedFieldWriter: precision " << precision << ", " << M_encodings.size() << " variables quantized with " << quantized.bits << " bits in [" << quantized.min << ", " << quantized.max << "], max error " << quantized.max_error() << ", zlib level " << M_compressionLevel << (FieldCodec::has_zlib() ? "" : " (not available)") << std::endl;
+}
+
+void CompressedFieldWriter::open(const libMesh::EquationSystems& es, const std::set<std::string>& system_names)
+{
+    std::string filename = M_filename;
+    if (M_nSeries > 0)
+    {
+        std::ostringstream ss;
+        ss << M_filename << "-s" << std::setw(4) << std::setfill('0') << M_nSeries;
+        filename = ss.str();
+    }
+    ++M_nSeries;
+
+    std::vector<const libMesh::Node *> nodes;
+    libMesh::MeshBase::const_node_iterator node = M_mesh.local_nodes_begin();
+    const libMesh::MeshBase::const_node_iterator end_node = M_mesh.local_nodes_end();
+    for (; node != end_node; ++node)
+        nodes.push_back(*node);
+
+    // Nodal variables of the systems
+    M_fields.clear();
+    for (auto && name : system_names)
+    {
+        if (!es.has_system(name)) continue;
+        const libMesh::System& system = es.get_system(name);
+        const unsigned int sys = system.number();
+        for (unsigned int v = 0; v < system.n_vars(); ++v)
+        {
+            const libMesh::FEType& fe_type = system.variable_type(v);
+            if (fe_type.family == libMesh::MONOMIAL && fe_type.order == libMesh::CONSTANT) continue;
+            Field field;
+            field.name = system.variable_name(v);
+            field.system = sys;
+            field.variable = v;
+            auto it = M_encodings.find(field.name);
+            field.encoding = it != M_encodings.end() ? it->second : M_defaultEncoding;
+            field.dofs.assign(nodes.size(), libMesh::DofObject::invalid_id);
+            for (unsigned int i = 0; i < nodes.size(); ++i)
+            {
+                // The variable may not be defined on all the subdomains (bath)
+                if (nodes[i]->n_comp(sys, v) > 0) field.dofs[i] = nodes[i]->dof_number(sys, v, 0);
+            }
+            M_fields.push_back(field);
+        }
+    }
+
+    const std::string piece = piece_name(filename, M_mesh.processor_id());
+    M_file.close();
+    M_file.clear();
+    M_file.open(piece, std::ios::binary | std::ios::trunc);
+    if (!M_file) throw std::runtime_error("CompressedFieldWriter: cannot open " + piece);
+
+    M_file.write(magic, 8);
+    write_pod(M_file, version);
+    write_pod(M_file, byte_order_mark);
+    write_pod(M_file, static_cast<std::uint32_t>(M_mesh.processor_id()));
+    write_pod(M_file, static_cast<std::uint32_t>(M_mesh.n_processors()));
+    write_pod(M_file, static_cast<std::uint64_t>(nodes.size()));
+    for (auto && n : nodes)
+        write_pod(M_file, static_cast<std::uint64_t>(n->id()));
+    write_pod(M_file, static_cast<std::uint32_t>(M_fields.size()));
+    for (auto && field : M_fields)
+    {
+        write_pod(M_file, static_cast<std::uint32_t>(field.name.size()));
+        M_file.write(field.name.data(), field.name.size());
+        write_pod(M_file, static_cast<std::uint32_t>(field.encoding.type));
+        write_pod(M_file, static_cast<std::uint32_t>(field.encoding.bits));
+        write_pod(M_file, field.encoding.min);
+        write_pod(M_file, field.encoding.max);
+    }
+    std::cout << "* CompressedFieldWriter: writing " << M_fields.size() << " fields in " << filename << "_*.bfo" << std::endl;
+}
+
+void CompressedFieldWriter::reset()
+{
+    M_file.close();
+    M_file.clear();
+}
+
+void CompressedFieldWriter::write_timestep(const libMesh::EquationSystems& es, const std::set<std::string>& system_names, int step, double time)
+{
+    if (!M_file.is_open()) open(es, system_names);
+
+    write_pod(M_file, step_marker);
+    write_pod(M_file, static_cast<std::int32_t>(step));
+    write_pod(M_file, time);
+    for (auto && field : M_fields)
+    {
+        const libMesh::NumericVector<libMesh::Number>& solution = *es.get_system(field.system).solution;
+        M_values.resize(field.dofs.size());
+        for (unsigned int i = 0; i < field.dofs.size(); ++i)
+        {
+            M_values[i] = field.dofs[i] == libMesh::DofObject::invalid_id ? 0.0 : solution(field.dofs[i]);
+        }
+        FieldCodec::Codec codec;
+        const std::uint64_t raw_bytes = FieldCodec::encode(M_values.data(), M_values.size(), field.encoding, M_compressionLevel, M_stored, codec);
+        write_pod(M_file, static_cast<std::uint32_t>(codec));
+        write_pod(M_file, raw_bytes);
+        write_pod(M_file, static_cast<std::uint64_t>(M_stored.size()));
+        M_file.write(M_stored.data(), M_stored.size());
+        M_inputBytes += M_values.size() * sizeof(double);
+        M_storedBytes += M_stored.size();
+    }
+    // Complete time steps survive a crash
+    M_file.flush();
+    if (!M_file) throw std::runtime_error("CompressedFieldWriter: error writing " + M_filename);
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Reader
+// ///////////////////////////////////////////////////////////////////////
+
+CompressedFieldReader::CompressedFieldReader(const std::string& filename)
+    : M_pieces(), M_fieldNames(), M_fieldEncodings(), M_steps(), M_times()
+{
+    unsigned int n_processors = 1;
+    for (unsigned int p = 0; p < n_processors; ++p)
+    {
+        Piece piece;
+        piece.filename = piece_name(filename, p);
+        std::ifstream in(piece.filename, std::ios::binary);
+        if (!in) throw std::runtime_error("CompressedFieldReader: cannot open " + piece.filename);
+        in.seekg(0, std::ios::end);
+        const std::uint64_t file_size = in.tellg();
+        in.seekg(0);
+        Header header;
+        read_header(in, piece.filename, header);
+        if (0 == p)
+        {
+            n_processors = header.n_processors;
+            M_fieldNames = header.names;
+            M_fieldEncodings = header.encodings;
+        }
+        else if (header.names != M_fieldNames)
+        {
+            throw std::runtime_error("CompressedFieldReader: " + piece.filename + " has different fields");
+        }
+        piece.node_ids.swap(header.node_ids);
+
+        // Index the time steps: an incomplete last step is ignored
+        std::vector<int> steps;
+        std::vector<double> times;
+        while (true)
+        {
+            std::uint32_t marker;
+            std::int32_t step;
+            double time;
+            if (!read_pod(in, marker)) break;
+            if (marker != step_marker) throw std::runtime_error("CompressedFieldReader: corrupted time step in " + piece.filename);
+            if (!read_pod(in, step) || !read_pod(in, time)) break;
+            std::vector<std::uint64_t> offsets;
+            bool complete = true;
+            for (unsigned int f = 0; f < M_fieldNames.size() && complete; ++f)
+            {
+                offsets.push_back(in.tellg());
+                std::uint32_t codec;
+                std::uint64_t raw_bytes, stored_bytes;
+                complete = read_pod(in, codec) && read_pod(in, raw_bytes) && read_pod(in, stored_bytes);
+                if (!complete) break;
+                const std::uint64_t end = static_cast<std::uint64_t>(in.tellg()) + stored_bytes;
+                complete = end <= file_size;
+                in.seekg(end);
+            }
+            if (!complete) break;
+            piece.offsets.push_back(offsets);
+            steps.push_back(step);
+            times.push_back(time);
+        }
+        if (0 == p)
+        {
+            M_steps = steps;
+            M_times = times;
+        }
+        else if (steps.size() < M_steps.size())
+        {
+            M_steps.resize(steps.size());
+            M_times.resize(steps.size());
+        }
+        M_pieces.push_back(piece);
+    }
+}
+
+CompressedFieldReader::~CompressedFieldReader()
+{
+}
+
+const FieldEncoding& CompressedFieldReader::encoding(const std::string& field) const
+{
+    for (unsigned int f = 0; f < M_fieldNames.size(); ++f)
+        if (M_fieldNames[f] == field) return M_fieldEncodings[f];
+    throw std::runtime_error("CompressedFieldReader: no field " + field);
+}
+
+void CompressedFieldReader::read(unsigned int timestep,
+                                 const std::string& field,
+                                 std::vector<libMesh::dof_id_type>& node_ids,
+                                 std::vector<double>& values) const
+{
+    if (timestep >= n_timesteps()) throw std::runtime_error("CompressedFieldReader: time step " + std::to_string(timestep) + " not available");
+    unsigned int f = 0;
+    while (f < M_fieldNames.size() && M_fieldNames[f] != field)
+        ++f;
+    if (f == M_fieldNames.size()) throw std::runtime_error("CompressedFieldReader: no field " + field);
+
+    node_ids.clear();
+    values.clear();
+    std::vector<char> stored;
+    for (auto && piece : M_pieces)
+    {
+        std::ifstream in(piece.filename, std::ios::binary);
+        in.seekg(piece.offsets[timestep][f]);
+        std::uint32_t codec;
+        std::uint64_t raw_bytes, stored_bytes;
+        read_pod(in, codec);
+        read_pod(in, raw_bytes);
+        read_pod(in, stored_bytes);
+        stored.resize(stored_bytes);
+        in.read(stored.data(), stored_bytes);
+        if (!in) throw std::runtime_error("CompressedFieldReader: error reading " + piece.filename);
+        const std::uint64_t n = piece.node_ids.size();
+        if (0 == n) continue;
+        values.resize(values.size() + n);
+        FieldCodec::decode(stored.data(), stored_bytes, static_cast<FieldCodec::Codec>(codec), n, M_fieldEncodings[f], &values[values.size() - n]);
+        node_ids.insert(node_ids.end(), piece.node_ids.begin(), piece.node_ids.end());
+    }
+}
+
+unsigned int CompressedFieldReader::read(unsigned int timestep, libMesh::System& system) const
+{
+    const libMesh::MeshBase& mesh = system.get_mesh();
+    const unsigned int sys = system.number();
+    const libMesh::processor_id_type rank = mesh.processor_id();
+    unsigned int n_fields = 0;
+    std::vector<libMesh::dof_id_type> node_ids;
+    std::vector<double> values;
+    for (auto && name : M_fieldNames)
+    {
+        if (!system.has_variable(name)) continue;
+        const unsigned int var = system.variable_number(name);
+        read(timestep, name, node_ids, values);
+        for (unsigned int i = 0; i < node_ids.size(); ++i)
+        {
+            const libMesh::Node * node = mesh.query_node_ptr(node_ids[i]);
+            if (!node || node->processor_id() != rank) continue;
+            if (node->n_comp(sys, var) == 0) continue;
+            system.solution->set(node->dof_number(sys, var, 0), values[i]);
+        }
+        ++n_fields;
+    }
+    system.solution->close();
+    system.update();
+    return n_fields;
+}
+
+} /* namespace BeatIt */
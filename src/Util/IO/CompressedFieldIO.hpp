@@ -0,0 +1,177 @@
+/*
+ * CompressedFieldIO.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_UTIL_IO_COMPRESSEDFIELDIO_HPP_
+#define SRC_UTIL_IO_COMPRESSEDFIELDIO_HPP_
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "libmesh/id_types.h"
+#include "Util/IO/FieldCodec.hpp"
+
+class GetPot;
+
+namespace libMesh
+{
+class MeshBase;
+class EquationSystems;
+class System;
+}
+
+namespace BeatIt
+{
+
+/*!
+ *  Compressed output of nodal fields (.bfo files)
+ *
+ *  Each processor writes the values at its local nodes in filename_rank.bfo:
+ *  a header with the number of processors, the global ids of the nodes and the name and
+ *  encoding (float64, float32 or quantized, see FieldEncoding) of each field,
+ *  followed by one chunk per time step containing the step, the time and the
+ *  encoded values of each field (see FieldCodec::encode).
+ *  The CompressedFieldReader maps the values back onto the nodes of a libMesh mesh,
+ *  on any number of processors.
+ */
+class CompressedFieldWriter
+{
+public:
+    //! \param [in] filename name of the series, including the output folder
+    CompressedFieldWriter(const libMesh::MeshBase& mesh, const std::string& filename);
+    ~CompressedFieldWriter();
+
+    //! Read the encodings from section/compressed_output
+    /*!
+     *  precision = float64, float32 (default) or quantized: encoding of all the variables
+     *  quantized = 'V, Ve': variables stored with bits in [min, max]
+     *  bits = 12, min = -100, max = 60: quantization (the default range is in mV)
+     *  level = 6: zlib compression level
+     */
+    void setup(GetPot& data, const std::string& section);
+
+    //! Encoding of the variables without a specific encoding (default: float32)
+    void set_default_encoding(const FieldEncoding& encoding)
+    {
+        M_defaultEncoding = encoding;
+    }
+    void set_encoding(const std::string& variable, const FieldEncoding& encoding)
+    {
+        M_encodings[variable] = encoding;
+    }
+    //! zlib level (0: no compression, 1 - 9)
+    void set_compression_level(int level)
+    {
+        M_compressionLevel = level;
+    }
+
+    //! Append the nodal variables of the systems
+    /*!
+     *  The fields are fixed at the first call. Only the local solution is used.
+     */
+    void write_timestep(const libMesh::EquationSystems& es, const std::set<std::string>& system_names, int step, double time);
+    //! The mesh has changed (AMR): the next time step starts a new series filename-s0001, filename-s0002, ...
+    void reset();
+
+    //! Bytes of the local values in double precision
+    std::uint64_t input_bytes() const
+    {
+        return M_inputBytes;
+    }
+    //! Bytes written in the local file
+    std::uint64_t stored_bytes() const
+    {
+        return M_storedBytes;
+    }
+
+private:
+    void open(const libMesh::EquationSystems& es, const std::set<std::string>& system_names);
+
+    struct Field
+    {
+        std::string name;
+        unsigned int system;
+        unsigned int variable;
+        FieldEncoding encoding;
+        std::vector<libMesh::dof_id_type> dofs;
+    };
+
+    const libMesh::MeshBase& M_mesh;
+    std::string M_filename;
+    FieldEncoding M_defaultEncoding;
+    std::map<std::string, FieldEncoding> M_encodings;
+    int M_compressionLevel;
+
+    std::ofstream M_file;
+    std::vector<Field> M_fields;
+    unsigned int M_nSeries;
+    std::vector<double> M_values;
+    std::vector<char> M_stored;
+    std::uint64_t M_inputBytes;
+    std::uint64_t M_storedBytes;
+};
+
+//! Reader of the .bfo series written by CompressedFieldWriter
+class CompressedFieldReader
+{
+public:
+    //! Read the headers and index the time steps of all the pieces filename_rank.bfo
+    explicit CompressedFieldReader(const std::string& filename);
+    ~CompressedFieldReader();
+
+    unsigned int n_timesteps() const
+    {
+        return M_steps.size();
+    }
+    int step(unsigned int timestep) const
+    {
+        return M_steps[timestep];
+    }
+    double time(unsigned int timestep) const
+    {
+        return M_times[timestep];
+    }
+    const std::vector<std::string>& field_names() const
+    {
+        return M_fieldNames;
+    }
+    const FieldEncoding& encoding(const std::string& field) const;
+
+    //! Values of a field at all the nodes of the series
+    void read(unsigned int timestep,
+              const std::string& field,
+              std::vector<libMesh::dof_id_type>& node_ids,
+              std::vector<double>& values) const;
+    //! Copy the fields into the variables with the same name of the system, at the local nodes
+    /*!
+     *  \return number of fields copied
+     */
+    unsigned int read(unsigned int timestep, libMesh::System& system) const;
+
+private:
+    struct Piece
+    {
+        std::string filename;
+        std::vector<libMesh::dof_id_type> node_ids;
+        //! offsets[timestep][field]: position of the chunk of the field
+        std::vector<std::vector<std::uint64_t> > offsets;
+    };
+
+    std::vector<Piece> M_pieces;
+    std::vector<std::string> M_fieldNames;
+    std::vector<FieldEncoding> M_fieldEncodings;
+    std::vector<int> M_steps;
+    std::vector<double> M_times;
+};
+
+} /* namespace BeatIt */
+
+#endif /* SRC_UTIL_IO_COMPRESSEDFIELDIO_HPP_ */
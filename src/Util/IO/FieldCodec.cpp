@@ -0,0 +1,232 @@
+/*
+ * FieldCodec.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Util/IO/FieldCodec.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#ifdef BEATIT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace BeatIt
+{
+
+FieldEncoding::Type FieldEncoding::type_from_string(const std::string& name)
+{
+    if ("float64" == name) return Float64;
+    if ("float32" == name) return Float32;
+    if ("quantized" == name) return Quantized;
+    throw std::runtime_error("FieldEncoding: unknown precision " + name + " (float64, float32, quantized)");
+}
+
+unsigned int FieldEncoding::value_size() const
+{
+    switch (type)
+    {
+        case Float64:
+            return 8;
+        case Float32:
+            return 4;
+        default:
+            return bits <= 8 ? 1 : (bits <= 16 ? 2 : 4);
+    }
+}
+
+double FieldEncoding::max_error() const
+{
+    if (Quantized != type) return 0.0;
+    return 0.5 * (max - min) / (std::pow(2.0, bits) - 2.0);
+}
+
+namespace FieldCodec
+{
+
+namespace
+{
+
+// The finite values use the levels 0, ..., 2^bits - 2:
+// the last level 2^bits - 1 stores the non-finite values (NaN, inf), decoded as NaN
+template<typename T>
+void quantize(const double * values, std::uint64_t n, const FieldEncoding& encoding, char * bytes)
+{
+    const double levels = std::pow(2.0, encoding.bits) - 2.0;
+    const double scale = encoding.max > encoding.min ? levels / (encoding.max - encoding.min) : 0.0;
+    const T non_finite = static_cast<T>(levels + 1.0);
+    T previous = 0;
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        T value = non_finite;
+        if (std::isfinite(values[i]))
+        {
+            double q = std::round((values[i] - encoding.min) * scale);
+            value = static_cast<T>(std::min(std::max(q, 0.0), levels));
+        }
+        // Delta along the array: wraps around and is undone exactly
+        const T delta = static_cast<T>(value - previous);
+        previous = value;
+        std::memcpy(bytes + i * sizeof(T), &delta, sizeof(T));
+    }
+}
+
+template<typename T>
+void dequantize(const char * bytes, std::uint64_t n, const FieldEncoding& encoding, double * values)
+{
+    const double levels = std::pow(2.0, encoding.bits) - 2.0;
+    const double step = (encoding.max - encoding.min) / levels;
+    const T non_finite = static_cast<T>(levels + 1.0);
+    T value = 0;
+    for (std::uint64_t i = 0; i < n; ++i)
+    {
+        T delta;
+        std::memcpy(&delta, bytes + i * sizeof(T), sizeof(T));
+        value = static_cast<T>(value + delta);
+        values[i] = non_finite == value ? std::numeric_limits<double>::quiet_NaN() : encoding.min + step * value;
+    }
+}
+
+void shuffle(const char * in, std::uint64_t n, unsigned int size, char * out)
+{
+    for (std::uint64_t i = 0; i < n; ++i)
+        for (unsigned int b = 0; b < size; ++b)
+            out[b * n + i] = in[i * size + b];
+}
+
+void unshuffle(const char * in, std::uint64_t n, unsigned int size, char * out)
+{
+    for (std::uint64_t i = 0; i < n; ++i)
+        for (unsigned int b = 0; b < size; ++b)
+            out[i * size + b] = in[b * n + i];
+}
+
+}
+
+bool has_zlib()
+{
+#ifdef BEATIT_HAVE_ZLIB
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::uint64_t encode(const double * values,
+                     std::uint64_t n,
+                     const FieldEncoding& encoding,
+                     int compression_level,
+                     std::vector<char>& stored,
+                     Codec& codec)
+{
+    const unsigned int size = encoding.value_size();
+    const std::uint64_t raw_bytes = n * size;
+    std::vector<char> bytes(raw_bytes);
+    switch (encoding.type)
+    {
+        case FieldEncoding::Float64:
+        {
+            std::memcpy(bytes.data(), values, raw_bytes);
+            break;
+        }
+        case FieldEncoding::Float32:
+        {
+            for (std::uint64_t i = 0; i < n; ++i)
+            {
+                const float value = static_cast<float>(values[i]);
+                std::memcpy(&bytes[i * 4], &value, 4);
+            }
+            break;
+        }
+        default:
+        {
+            if (encoding.bits < 2 || encoding.bits > 32) throw std::runtime_error("FieldCodec: quantized values need 2 to 32 bits");
+            if (1 == size) quantize<std::uint8_t>(values, n, encoding, bytes.data());
+            else if (2 == size) quantize<std::uint16_t>(values, n, encoding, bytes.data());
+            else quantize<std::uint32_t>(values, n, encoding, bytes.data());
+            break;
+        }
+    }
+
+    stored.resize(raw_bytes);
+    shuffle(bytes.data(), n, size, stored.data());
+    codec = None;
+#ifdef BEATIT_HAVE_ZLIB
+    if (compression_level != 0 && raw_bytes > 0)
+    {
+        uLongf compressed_bytes = compressBound(raw_bytes);
+        std::vector<char> compressed(compressed_bytes);
+        int status = compress2(reinterpret_cast<Bytef *>(compressed.data()), &compressed_bytes, reinterpret_cast<const Bytef *>(stored.data()), raw_bytes, compression_level);
+        if (Z_OK != status) throw std::runtime_error("FieldCodec: zlib compression failed");
+        // Keep the uncompressed bytes if zlib does not help
+        if (compressed_bytes < raw_bytes)
+        {
+            compressed.resize(compressed_bytes);
+            stored.swap(compressed);
+            codec = Zlib;
+        }
+    }
+#endif
+    return raw_bytes;
+}
+
+void decode(const char * stored, std::uint64_t stored_bytes, Codec codec, std::uint64_t n, const FieldEncoding& encoding, double * values)
+{
+    const unsigned int size = encoding.value_size();
+    const std::uint64_t raw_bytes = n * size;
+    std::vector<char> shuffled;
+    if (Zlib == codec)
+    {
+#ifdef BEATIT_HAVE_ZLIB
+        shuffled.resize(raw_bytes);
+        uLongf uncompressed_bytes = raw_bytes;
+        int status = uncompress(reinterpret_cast<Bytef *>(shuffled.data()), &uncompressed_bytes, reinterpret_cast<const Bytef *>(stored), stored_bytes);
+        if (Z_OK != status || uncompressed_bytes != raw_bytes) throw std::runtime_error("FieldCodec: zlib decompression failed");
+#else
+        throw std::runtime_error("FieldCodec: the data are compressed with zlib, but BeatIt has been compiled without zlib");
+#endif
+    }
+    else
+    {
+        if (stored_bytes != raw_bytes) throw std::runtime_error("FieldCodec: wrong size of the stored data");
+        shuffled.assign(stored, stored + stored_bytes);
+    }
+
+    std::vector<char> bytes(raw_bytes);
+    unshuffle(shuffled.data(), n, size, bytes.data());
+    switch (encoding.type)
+    {
+        case FieldEncoding::Float64:
+        {
+            std::memcpy(values, bytes.data(), raw_bytes);
+            break;
+        }
+        case FieldEncoding::Float32:
+        {
+            for (std::uint64_t i = 0; i < n; ++i)
+            {
+                float value;
+                std::memcpy(&value, &bytes[i * 4], 4);
+                values[i] = value;
+            }
+            break;
+        }
+        default:
+        {
+            if (1 == size) dequantize<std::uint8_t>(bytes.data(), n, encoding, values);
+            else if (2 == size) dequantize<std::uint16_t>(bytes.data(), n, encoding, values);
+            else dequantize<std::uint32_t>(bytes.data(), n, encoding, values);
+            break;
+        }
+    }
+}
+
+} /* namespace FieldCodec */
+
+} /* namespace BeatIt */
@@ -0,0 +1,85 @@
+/*
+ * FieldCodec.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_UTIL_IO_FIELDCODEC_HPP_
+#define SRC_UTIL_IO_FIELDCODEC_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BeatIt
+{
+
+//! Precision of a field in the compressed output
+struct FieldEncoding
+{
+    enum Type
+    {
+        Float64 = 0, Float32 = 1, Quantized = 2
+    };
+
+    FieldEncoding(Type t = Float32, double min_value = 0.0, double max_value = 1.0, unsigned int n_bits = 16)
+        : type(t), min(min_value), max(max_value), bits(n_bits)
+    {
+    }
+
+    //! Parse "float64", "float32" or "quantized"
+    static Type type_from_string(const std::string& name);
+
+    //! Bytes of a stored value
+    unsigned int value_size() const;
+    //! Largest difference between a value in [min, max] and its decoded value
+    double max_error() const;
+
+    Type type;
+    //! Range of the quantized values: the values outside the range are clamped
+    /*!
+     *  The finite values use 2^bits - 1 levels, the last level is reserved to the
+     *  non-finite values (NaN, inf), which are decoded as NaN.
+     */
+    double min;
+    double max;
+    //! Number of bits of the quantized values (2 - 32)
+    unsigned int bits;
+};
+
+namespace FieldCodec
+{
+
+//! Compression of the stored bytes
+enum Codec
+{
+    None = 0, Zlib = 1
+};
+
+//! The library has been compiled with zlib
+bool has_zlib();
+
+//! Encode n values
+/*!
+ *  The values are converted to the precision of the encoding (quantized values are also
+ *  delta encoded along the array), the bytes are shuffled (first bytes of all the values,
+ *  then second bytes, ...) and compressed with zlib when available.
+ *  \param [out] codec compression used for the stored bytes
+ *  \return number of bytes before the compression
+ */
+std::uint64_t encode(const double * values,
+                     std::uint64_t n,
+                     const FieldEncoding& encoding,
+                     int compression_level,
+                     std::vector<char>& stored,
+                     Codec& codec);
+
+//! Decode n values encoded with encode()
+void decode(const char * stored, std::uint64_t stored_bytes, Codec codec, std::uint64_t n, const FieldEncoding& encoding, double * values);
+
+} /* namespace FieldCodec */
+
+} /* namespace BeatIt */
+
+#endif /* SRC_UTIL_IO_FIELDCODEC_HPP_ */
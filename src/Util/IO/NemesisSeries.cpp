@@ -0,0 +1,69 @@
+/*
+ * NemesisSeries.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#include "Util/IO/NemesisSeries.hpp"
+
+#include "libmesh/mesh_base.h"
+#include "libmesh/equation_systems.h"
+#include "libmesh/system.h"
+#include "libmesh/nemesis_io.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace BeatIt
+{
+
+NemesisSeries::NemesisSeries(libMesh::MeshBase& mesh, const std::string& filename, const std::set<std::string>& system_names)
+    : M_mesh(mesh), M_filename(filename), M_systemNames(system_names), M_io(), M_currentFile(), M_timestep(0), M_nSeries(0)
+{
+}
+
+NemesisSeries::~NemesisSeries()
+{
+}
+
+void NemesisSeries::open(const libMesh::EquationSystems& es)
+{
+    // filename, filename-s0001, filename-s0002, ...
+    M_currentFile = M_filename;
+    if (M_nSeries > 0)
+    {
+        std::ostringstream ss;
+        ss << M_filename << "-s" << std::setw(4) << std::setfill('0') << M_nSeries;
+        M_currentFile = ss.str();
+    }
+    ++M_nSeries;
+    M_timestep = 0;
+
+    std::vector<std::string> variables;
+    for (auto && name : M_systemNames)
+    {
+        if (!es.has_system(name)) continue;
+        const libMesh::System& system = es.get_system(name);
+        for (unsigned int v = 0; v < system.n_vars(); ++v)
+            variables.push_back(system.variable_name(v));
+    }
+    M_io.reset(new libMesh::Nemesis_IO(M_mesh));
+    M_io->set_output_variables(variables);
+    std::cout << "* NemesisSeries: writing " << variables.size() << " variables in " << M_currentFile << std::endl;
+}
+
+void NemesisSeries::reset()
+{
+    M_io.reset();
+}
+
+void NemesisSeries::write_timestep(const libMesh::EquationSystems& es, double time)
+{
+    if (!M_io) open(es);
+    // The mesh is written only at the first time step
+    M_io->write_timestep(M_currentFile, es, ++M_timestep, time);
+}
+
+} /* namespace BeatIt */
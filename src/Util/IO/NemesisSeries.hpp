@@ -0,0 +1,73 @@
+/*
+ * NemesisSeries.hpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+#ifndef SRC_UTIL_IO_NEMESISSERIES_HPP_
+#define SRC_UTIL_IO_NEMESISSERIES_HPP_
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace libMesh
+{
+class MeshBase;
+class EquationSystems;
+class Nemesis_IO;
+}
+
+namespace BeatIt
+{
+
+//! Long-lived parallel writer of a time series
+/*!
+ *  The same Nemesis_IO is used for the whole run: the mesh is written at the first time step
+ *  (one file per processor, filename.nproc.rank) and the following calls append only the
+ *  nodal values of the variables of the selected systems.
+ *  When the mesh changes (AMR) reset() must be called: the next time step starts a new
+ *  series filename-s0001, filename-s0002, ...
+ */
+class NemesisSeries
+{
+public:
+    /*!
+     *  \param [in] filename name of the series, including the output folder
+     *  \param [in] system_names the variables of these systems are exported
+     */
+    NemesisSeries(libMesh::MeshBase& mesh, const std::string& filename, const std::set<std::string>& system_names);
+    ~NemesisSeries();
+
+    //! Append a time step
+    void write_timestep(const libMesh::EquationSystems& es, double time);
+    //! The mesh has changed: the next time step starts a new series
+    void reset();
+
+    //! Number of time steps in the current file
+    int n_timesteps() const
+    {
+        return M_timestep;
+    }
+    const std::string& current_file() const
+    {
+        return M_currentFile;
+    }
+
+private:
+    void open(const libMesh::EquationSystems& es);
+
+    libMesh::MeshBase& M_mesh;
+    std::string M_filename;
+    std::set<std::string> M_systemNames;
+    std::unique_ptr<libMesh::Nemesis_IO> M_io;
+    std::string M_currentFile;
+    int M_timestep;
+    unsigned int M_nSeries;
+};
+
+} /* namespace BeatIt */
+
+#endif /* SRC_UTIL_IO_NEMESISSERIES_HPP_ */
@@ -51,13 +51,14 @@
 #include "libmesh/point.h"
 #include "Util/IO/io.hpp"
 
+#include <algorithm>
+
 namespace BeatIt
 {
 
-SpiritFunction::grammar_Type   SpiritFunction::M_grammar;
-
 SpiritFunction::SpiritFunction()
     : M_expression()
+    , M_compiled()
 {
     _initialized = true;
     _is_time_dependent = true;
@@ -71,7 +72,7 @@ SpiritFunction::~SpiritFunction()
 bool
 SpiritFunction::read(std::string& str)
 {
-    M_expression.clear();
+    clear();
 
 //    auto f( str.begin() );
 //    auto l( str.end()   );
@@ -82,6 +83,7 @@ SpiritFunction::read(std::string& str)
     _initialized = ok;
     if (!ok )
         throw std::runtime_error("parser error: '" + str ); // FIXME
+    for(auto&& expression : M_expression) M_compiled.emplace_back(expression);
     return ok;
 }
 
@@ -97,6 +99,7 @@ void
 SpiritFunction::add_function(std::string str)
 {
     _initialized = true;
+    M_compiled.emplace_back(str);
     M_expression.push_back(str);
 }
 
@@ -111,21 +114,9 @@ SpiritFunction::operator()(  const double t,
 
     double result = 0.0;
 
-    if( component < M_expression.size() )
+    if( component < M_compiled.size() )
     {
-        M_grammar.setSymbol("t", t);
-        M_grammar.setSymbol("x", x);
-        M_grammar.setSymbol("y", y);
-        M_grammar.setSymbol("z", z);
-
-        iterator iter = M_expression[component].begin();
-        iterator end = M_expression[component].end();
-        bool r = phrase_parse(iter, end, M_grammar, space, result);
-        if(!r)
-        {
-            std::cout << "\nSpiritFunction::Parse failed!!!!" << std::endl;
-            exit(-1);
-        }
+        result = M_compiled[component](t, x, y, z);
     }
     else
     {
@@ -156,10 +147,49 @@ SpiritFunction::clone () const
     {
         pcopy->M_expression.push_back(M_expression[i]);
     }
+    pcopy->M_compiled = M_compiled;
     return std::unique_ptr<libMesh::FunctionBase<double> >(pcopy);
 }
 
 
+void
+SpiritFunction::evaluate( const Point * points,
+                          unsigned int n,
+                          const double time,
+                          double * values,
+                          const unsigned int component ) const
+{
+    if( component >= M_compiled.size() )
+    {
+        throw std::runtime_error("SpiritFunction::evaluate: asked for component " + std::to_string(component)
+                                 + " but I have only " + std::to_string(M_compiled.size()) + " components.");
+    }
+    const CompiledExpression& expression = M_compiled[component];
+    if( expression.isConstant() )
+    {
+        std::fill(values, values + n, expression(time, 0.0, 0.0, 0.0));
+        return;
+    }
+    // The coordinates are copied in blocks, to evaluate the expression on contiguous arrays
+    constexpr unsigned int block_size = CompiledExpression::BlockSize;
+    double x[block_size];
+    double y[block_size];
+    double z[block_size];
+    for(unsigned int begin = 0; begin < n; begin += block_size)
+    {
+        const unsigned int m = std::min(block_size, n - begin);
+        for(unsigned int i = 0; i < m; ++i)
+        {
+            const Point& p = points[begin + i];
+            x[i] = p(0);
+            y[i] = p(1);
+            z[i] = p(2);
+        }
+        expression.evaluate(m, x, y, z, time, values + begin);
+    }
+}
+
+
 double
 SpiritFunction::operator() (const Point & p,
                            const double time )
@@ -51,13 +51,15 @@
 #define SRC_UTIL_SPIRITFUNCTION_HPP_
 
 #include "Util/Grammar.hpp"
+#include "Util/CompiledExpression.hpp"
 #include "libmesh/function_base.h"
 
 namespace BeatIt
 {
 
 /*!
- *
+ *  The expressions are compiled once when they are read:
+ *  the evaluation does not parse the strings and can be called concurrently.
  */
 
 class SpiritFunction : public virtual libMesh::FunctionBase<libMesh::Number>
@@ -116,10 +118,24 @@ public:
                        const double z,
                        const unsigned int component ) const;
 
+    //! Evaluate a component at n points
+    /*!
+     *  \param [in] points array of size n
+     *  \param [in] n number of points
+     *  \param [in] time
+     *  \param [out] values array of size n
+     *  \param [in] component
+     */
+    void evaluate( const Point * points,
+                   unsigned int n,
+                   const double time,
+                   double * values,
+                   const unsigned int component = 0 ) const;
+
     /**
      * Clears the function.
      */
-    void clear () { M_expression.clear(); }
+    void clear () { M_expression.clear(); M_compiled.clear(); }
 
     /**
      * Returns a new copy of the function.  The new copy should be as
@@ -139,8 +155,8 @@ public:
                      double time = 0.0);
 	void showMe(std::ostream& ofstream = std::cout );
 	int size() const;
-    static grammar_Type  M_grammar;
     std::vector<std::string>    M_expression;
+    std::vector<CompiledExpression> M_compiled;
 };
 
 } /* namespace BeatIt */
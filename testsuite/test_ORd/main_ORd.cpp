@@ -51,6 +51,8 @@
 #include "Electrophysiology/IonicModels/ORd.hpp"
 #include "Util/IO/io.hpp"
 #include "Util/CTestUtil.hpp"
+#include "Util/Timer.hpp"
+#include <algorithm>
 #include <iomanip>
 
 
@@ -104,6 +106,7 @@ int main()
 	Stimulus stimulus;
 	// for ctest purposes
 	double solution_norm = 0.0;
+	std::vector<double> trace;
 	while( time <= TF )
 	{
 		Ist = stimulus.get(time);
@@ -120,12 +123,100 @@ int main()
 
 		// for ctest purposes
 		solution_norm += variables[0];
+		trace.push_back(variables[0]);
 
 	}
 	output.close();
 	//for ctest purposes
 	solution_norm /= iter;
 	std::cout << std::setprecision(18) << "Solution norm = " << solution_norm << std::endl;
+
+	// Scalar kernel: the same protocol on a block of cells, one call for each cell.
+	// The timers measure only the calls of the kernels: no output and no bookkeeping
+	const int num_cells = 64;
+	pORd->initialize(variables);
+	std::vector<std::vector<double> > scalar_cells(num_cells, variables);
+	Stimulus scalar_stimulus;
+	BeatIt::Timer timer;
+	time = 0.0;
+	while( time <= TF )
+	{
+		Ist = scalar_stimulus.get(time);
+		timer.start();
+		for (int i = 0; i < num_cells; ++i) pORd->solve(scalar_cells[i], Ist, dt);
+		timer.stop();
+		time += dt;
+	}
+	double scalar_time = timer.elapsed().count() / iter / num_cells;
+
+	// Batched kernel: the same protocol on a block of cells stored as structure of arrays,
+	// evaluated by a copy of the model as done by each thread in the reaction step
+	std::unique_ptr<BeatIt::IonicModel> pClone( pORd->clone() );
+	std::vector<std::vector<double> > batch_values(numVar, std::vector<double>(num_cells, 0.0));
+	std::vector<double *> batch_variables(numVar);
+	pORd->initialize(variables);
+	for (int k = 0; k < numVar; ++k)
+	{
+		std::fill(batch_values[k].begin(), batch_values[k].end(), variables[k]);
+		batch_variables[k] = batch_values[k].data();
+	}
+	std::vector<double> batch_Ist(num_cells, 0.0);
+	std::vector<double> batch_iion(num_cells, 0.0);
+	std::vector<double> batch_norm(num_cells, 0.0);
+	Stimulus batch_stimulus;
+	time = 0.0;
+	timer.reset();
+	while( time <= TF )
+	{
+		std::fill(batch_Ist.begin(), batch_Ist.end(), batch_stimulus.get(time));
+		timer.start();
+		pClone->solveBatch(batch_variables.data(), batch_Ist.data(), batch_iion.data(), num_cells, dt);
+		timer.stop();
+		time += dt;
+		for (int i = 0; i < num_cells; ++i) batch_norm[i] += batch_values[0][i];
+	}
+	double batch_time = timer.elapsed().count() / iter / num_cells;
+	double batch_error = 0.0;
+	for (int i = 0; i < num_cells; ++i) batch_error = std::max(batch_error, std::abs(batch_norm[i] / iter - solution_norm));
+	std::cout << "Scalar kernel: " << 1e9 * scalar_time << " ns/cell/step, batched kernel: " << 1e9 * batch_time
+	          << " ns/cell/step, speedup: " << scalar_time / batch_time << std::endl;
+	std::cout << "Batched kernel: solution norm difference = " << batch_error << std::endl;
+	if (batch_error > 1e-8) return 1;
+
+	// Lookup table of the functions of the potential: the same batched protocol,
+	// the copy of the model shares the table built by pORd
+	pORd->setUseLUT(true);
+	pORd->prepareLUT(dt);
+	std::unique_ptr<BeatIt::IonicModel> pLUT( pORd->clone() );
+	pORd->initialize(variables);
+	for (int k = 0; k < numVar; ++k)
+	{
+		std::fill(batch_values[k].begin(), batch_values[k].end(), variables[k]);
+	}
+	std::vector<double> lut_trace;
+	Stimulus lut_stimulus;
+	time = 0.0;
+	timer.reset();
+	while( time <= TF )
+	{
+		std::fill(batch_Ist.begin(), batch_Ist.end(), lut_stimulus.get(time));
+		timer.start();
+		pLUT->solveBatch(batch_variables.data(), batch_Ist.data(), batch_iion.data(), num_cells, dt);
+		timer.stop();
+		time += dt;
+		lut_trace.push_back(batch_values[0][0]);
+	}
+	pORd->setUseLUT(false);
+	double lut_time = timer.elapsed().count() / iter / num_cells;
+	double peak = 0.0;
+	double lut_peak = 0.0;
+	double apd = BeatIt::CTest::action_potential_duration(trace, dt, peak);
+	double lut_apd = BeatIt::CTest::action_potential_duration(lut_trace, dt, lut_peak);
+	std::cout << "Lookup table: " << 1e9 * lut_time << " ns/cell/step, speedup: " << batch_time / lut_time << std::endl;
+	std::cout << "Lookup table: APD90 = " << lut_apd << " ms (error " << std::abs(lut_apd - apd)
+	          << " ms), peak = " << lut_peak << " mV (error " << std::abs(lut_peak - peak) << " mV)" << std::endl;
+	if (std::abs(lut_apd - apd) > 1.0 || std::abs(lut_peak - peak) > 0.5) return 1;
+
 	//up to the 16th digit
 	const double reference_solution_norm = -4.04702501464674036;
 	//We check only up to 12th
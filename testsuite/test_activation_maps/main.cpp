@@ -0,0 +1,99 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+// Two beats of a planar wave with a piecewise linear action potential:
+// the crossings of the thresholds fall on the linear parts, therefore the
+// interpolated activation and repolarization times and the APD are exact,
+// while a step of 0.25 ms would give errors up to dt without interpolation.
+
+#include "Electrophysiology/ActivationMaps.hpp"
+
+#include "libmesh/transient_system.h"
+#include "libmesh/explicit_system.h"
+#include "libmesh/mesh.h"
+#include "libmesh/mesh_generation.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/node.h"
+
+#include <cmath>
+
+int main(int argc, char ** argv)
+{
+    using namespace libMesh;
+    LibMeshInit init(argc, argv, MPI_COMM_WORLD);
+
+    Mesh mesh(init.comm());
+    MeshTools::Generation::build_square(mesh, 20, 20, 0.0, 1.0, 0.0, 1.0, QUAD4);
+    EquationSystems es(mesh);
+    TransientExplicitSystem& wave = es.add_system<TransientExplicitSystem>("wave");
+    wave.add_variable("V", FIRST);
+    ExplicitSystem& maps = es.add_system<ExplicitSystem>("activation_maps");
+    maps.add_variable("activation_time", FIRST);
+    maps.add_variable("repolarization_time", FIRST);
+    maps.add_variable("apd", FIRST);
+    maps.add_variable("n_activations", FIRST);
+    es.init();
+
+    const double cycle_length = 300.0;
+    const double dt = 0.25;
+    // upstroke from -85 to 35 mV in [ta - 5, ta + 5], repolarization to -85 mV in [ta + 200, ta + 220]
+    auto center = [](const Point& p)
+    {   return 10.0 + 20.0 * p(0);};
+    auto V = [&](const Point& p, double t)
+    {
+        double v = -85.0;
+        for (int beat = 0; beat < 2; ++beat)
+        {
+            const double s = t - center(p) - beat * cycle_length;
+            if (s > -5.0 && s < 5.0) v = -85.0 + 12.0 * (s + 5.0);
+            else if (s >= 5.0 && s < 200.0) v = 35.0;
+            else if (s >= 200.0 && s < 220.0) v = 35.0 - 6.0 * (s - 200.0);
+        }
+        return v;
+    };
+    // exact times of the crossings of -40 and -70 mV
+    const double activation_delay = -5.0 + 45.0 / 12.0;
+    const double repolarization_delay = 200.0 + 105.0 / 6.0;
+
+    BeatIt::ActivationMaps activation_maps;
+    activation_maps.set_thresholds(-40.0, -70.0);
+    activation_maps.set_cycle_length(cycle_length);
+    activation_maps.build(es, "wave", "activation_maps");
+
+    const unsigned int sys = wave.number();
+    const unsigned int maps_sys = maps.number();
+    int errors = 0;
+    double error = 0.0;
+    for (int n = 0; n * dt <= 2 * cycle_length; ++n)
+    {
+        const double t = n * dt;
+        for (auto node = mesh.local_nodes_begin(); node != mesh.local_nodes_end(); ++node)
+            wave.solution->set((*node)->dof_number(sys, 0, 0), V(**node, t));
+        wave.solution->close();
+        if (!activation_maps.update(t)) continue;
+
+        const int beat = activation_maps.beat();
+        BeatIt::ActivationMaps::Summary summary = activation_maps.end_beat();
+        for (auto node = mesh.local_nodes_begin(); node != mesh.local_nodes_end(); ++node)
+        {
+            const Node& nn = **node;
+            const double ta = center(nn) + (beat - 1) * cycle_length;
+            error = std::max(error, std::abs((*maps.solution)(nn.dof_number(maps_sys, 0, 0)) - (ta + activation_delay)));
+            error = std::max(error, std::abs((*maps.solution)(nn.dof_number(maps_sys, 1, 0)) - (ta + repolarization_delay)));
+            error = std::max(error, std::abs((*maps.solution)(nn.dof_number(maps_sys, 2, 0)) - (repolarization_delay - activation_delay)));
+            if ((*maps.solution)(nn.dof_number(maps_sys, 3, 0)) != 1.0) ++errors;
+        }
+        std::cout << "beat " << beat << ": " << summary.n_activated << " / " << summary.n_nodes << " activated in [" << summary.first_activation << ", " << summary.last_activation << "], mean APD " << summary.mean_apd << std::endl;
+        if (summary.n_activated != summary.n_nodes || summary.n_repolarized != summary.n_nodes) ++errors;
+        if (std::abs(summary.mean_apd - (repolarization_delay - activation_delay)) > 1e-8) ++errors;
+    }
+    init.comm().max(error);
+    init.comm().sum(errors);
+    std::cout << "max error: " << error << ", beats: " << activation_maps.beat() - 1 << std::endl;
+    if (error > 1e-8 || activation_maps.beat() != 3) ++errors;
+    return errors > 0 ? 1 : 0;
+}
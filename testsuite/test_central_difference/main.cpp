@@ -0,0 +1,90 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+// Free vibration of a linear elastic cantilever with the central difference integrator.
+// Each call of newton(dt) takes dt = 3 times the stable time step, i.e. 3 substeps.
+// Checks:
+// - the lumped mass preserves the mass of the bar, rho * area for each component
+// - the energy 1/2 v M_L v + 1/2 u K u stays within 5% of its initial value
+//   (K u = -F(u): the residual without inertia and loads is minus the internal force)
+
+#include "Elasticity/DynamicElasticity.hpp"
+
+#include "libmesh/transient_system.h"
+#include "libmesh/mesh.h"
+#include "libmesh/mesh_generation.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/node.h"
+
+#include <cmath>
+#include <iomanip>
+
+int main(int argc, char ** argv)
+{
+    using namespace libMesh;
+    LibMeshInit init(argc, argv, MPI_COMM_WORLD);
+
+    GetPot commandLine(argc, argv);
+    std::string datafile_name = commandLine.follow("data.beat", 2, "-i", "--input");
+    GetPot data(datafile_name);
+
+    const double maxX = data("maxX", 10.0);
+    const double maxY = data("maxY", 1.0);
+    Mesh mesh(init.comm());
+    MeshTools::Generation::build_square(mesh, data("elX", 20), data("elY", 2), 0.0, maxX, 0.0, maxY, TRI3);
+    EquationSystems es(mesh);
+
+    BeatIt::DynamicElasticity elas(es, "Elasticity");
+    elas.setup(data, "elasticity");
+    typedef TransientLinearImplicitSystem LinearSystem;
+    LinearSystem& system = es.get_system<LinearSystem>("Elasticity");
+    LinearSystem& disp_system = es.get_system<LinearSystem>("displacement");
+
+    // Bending velocity, zero at the clamped end
+    const double v0 = data("v0", 0.01);
+    const unsigned int sys = system.number();
+    for (auto node = mesh.local_nodes_begin(); node != mesh.local_nodes_end(); ++node)
+    {
+        const double x = (**node)(0) / maxX;
+        system.solution->set((*node)->dof_number(sys, 1, 0), v0 * x * x);
+    }
+    system.solution->close();
+    system.update();
+
+    elas.assemble_lumped_mass();
+    const auto& lumped_mass = system.get_vector("lumped_mass");
+    const double rho = data("elasticity/materials/linear/rho", 1.0);
+    const double expected_mass = 2.0 * rho * maxX * maxY;
+    const double mass = lumped_mass.sum();
+    int errors = 0;
+    std::cout << "lumped mass: " << mass << ", expected: " << expected_mass << std::endl;
+    if (std::abs(mass - expected_mass) > 1e-10 * expected_mass) ++errors;
+
+    std::unique_ptr<NumericVector<Number> > work = system.solution->clone();
+    auto energy = [&]()
+    {
+        work->pointwise_mult(*system.solution, lumped_mass);
+        const double kinetic = 0.5 * work->dot(*system.solution);
+        // The velocity is the same at the current and old step: the residual is F(u)
+        elas.assemble_residual_only(1.0);
+        const double strain = -0.5 * system.rhs->dot(*disp_system.solution);
+        return kinetic + strain;
+    };
+
+    const double dt = 3.0 * elas.estimate_stable_time_step();
+    const double E0 = energy();
+    double max_deviation = 0.0;
+    const int n_steps = data("n_steps", 200);
+    for (int n = 0; n < n_steps; ++n)
+    {
+        if (elas.central_difference(dt) != 3) ++errors;
+        max_deviation = std::max(max_deviation, std::abs(energy() - E0) / E0);
+    }
+    std::cout << std::setprecision(10) << "initial energy: " << E0 << ", max relative deviation: " << max_deviation << std::endl;
+    if (max_deviation > 0.05) ++errors;
+    return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+// Write a checkpoint of a transient nodal system (solution, old solutions and an
+// additional vector) and of an elemental system, then read it back.
+// "write": write and read on the same processors (same dof numbering)
+// "read": read the checkpoint written by "write" on a different number of processors
+
+#include "Util/IO/Checkpoint.hpp"
+#include "Util/IO/io.hpp"
+
+#include "libmesh/transient_system.h"
+#include "libmesh/explicit_system.h"
+#include "libmesh/mesh.h"
+#include "libmesh/mesh_generation.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/dof_map.h"
+#include "libmesh/node.h"
+#include "libmesh/elem.h"
+
+#include <cmath>
+
+int main(int argc, char ** argv)
+{
+    using namespace libMesh;
+    LibMeshInit init(argc, argv, MPI_COMM_WORLD);
+    const std::string mode = argc > 1 ? argv[1] : "write";
+
+    Mesh mesh(init.comm());
+    MeshTools::Generation::build_square(mesh, 30, 30, 0.0, 1.0, 0.0, 1.0, QUAD4);
+    EquationSystems es(mesh);
+    typedef TransientExplicitSystem WaveSystem;
+    WaveSystem& wave = es.add_system<WaveSystem>("wave");
+    wave.add_variable("V", FIRST);
+    wave.add_variable("w", FIRST);
+    wave.add_vector("I4f");
+    ExplicitSystem& cells = es.add_system<ExplicitSystem>("cells");
+    cells.add_variable("tag", CONSTANT, MONOMIAL);
+    es.init();
+
+    std::string folder = "./ctest_checkpoint/";
+    BeatIt::createOutputFolder(init.comm(), folder);
+    const std::string filename = folder + "checkpoint.bin";
+
+    // Value of each vector as a function of the position, the variable and the vector
+    auto value = [](const Point& p, unsigned int var, unsigned int vector)
+    {   return std::sin(3.0 * p(0) + var) + std::cos(2.0 * p(1) + 0.5 * vector);};
+    const unsigned int wave_sys = wave.number();
+    const unsigned int cells_sys = cells.number();
+    std::vector<NumericVector<Number> *> wave_vectors = { &*wave.solution, &*wave.old_local_solution, &*wave.older_local_solution, &wave.get_vector("I4f") };
+
+    auto fill = [&](bool zero)
+    {
+        for (unsigned int k = 0; k < wave_vectors.size(); ++k)
+        {
+            for (auto node = mesh.local_nodes_begin(); node != mesh.local_nodes_end(); ++node)
+                for (unsigned int v = 0; v < 2; ++v)
+                    wave_vectors[k]->set((*node)->dof_number(wave_sys, v, 0), zero ? 0.0 : value(**node, v, k));
+            wave_vectors[k]->close();
+        }
+        for (auto elem = mesh.active_local_elements_begin(); elem != mesh.active_local_elements_end(); ++elem)
+            cells.solution->set((*elem)->dof_number(cells_sys, 0, 0), zero ? 0.0 : value((*elem)->centroid(), 0, 0));
+        cells.solution->close();
+        wave.update();
+        cells.update();
+    };
+
+    if ("write" == mode)
+    {
+        fill(false);
+        BeatIt::write_checkpoint(filename, es, 12.5, 25);
+        fill(true);
+    }
+
+    double time = 0.0;
+    int step = 0;
+    BeatIt::read_checkpoint(filename, es, time, step);
+
+    int errors = 0;
+    if (time != 12.5 || step != 25)
+    {
+        std::cout << "wrong time " << time << " or step " << step << std::endl;
+        ++errors;
+    }
+    double error = 0.0;
+    for (unsigned int k = 0; k < wave_vectors.size(); ++k)
+        for (auto node = mesh.local_nodes_begin(); node != mesh.local_nodes_end(); ++node)
+            for (unsigned int v = 0; v < 2; ++v)
+                error = std::max(error, std::abs((*wave_vectors[k])((*node)->dof_number(wave_sys, v, 0)) - value(**node, v, k)));
+    for (auto elem = mesh.active_local_elements_begin(); elem != mesh.active_local_elements_end(); ++elem)
+        error = std::max(error, std::abs((*cells.solution)((*elem)->dof_number(cells_sys, 0, 0)) - value((*elem)->centroid(), 0, 0)));
+    init.comm().max(error);
+    init.comm().sum(errors);
+    std::cout << mode << " on " << init.comm().size() << " processors: max error " << error << std::endl;
+    if (error > 0.0) ++errors;
+    return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+// Restart of the ElectroSolver from a binary checkpoint: a run of 2 n steps is
+// compared with a run of n steps that writes a checkpoint and a new solver that
+// restarts from it and does the remaining n steps. With SBDF2 the restarted
+// solver must continue with the second order scheme, therefore the time step
+// counter and the old solutions must be restored.
+
+#include "Electrophysiology/Monodomain/Monowave.hpp"
+#include "Util/IO/io.hpp"
+
+#include "libmesh/transient_system.h"
+#include "libmesh/mesh.h"
+#include "libmesh/mesh_generation.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/getpot.h"
+
+#include <cmath>
+#include <iomanip>
+#include <memory>
+
+int main(int argc, char ** argv)
+{
+    using namespace libMesh;
+    LibMeshInit init(argc, argv, MPI_COMM_WORLD);
+
+    GetPot commandLine(argc, argv);
+    std::string datafile_name = commandLine.follow("data.beat", 2, "-i", "--input");
+    GetPot data(datafile_name);
+
+    Mesh mesh(init.comm());
+    MeshTools::Generation::build_cube(mesh, data("mesh/elX", 12), data("mesh/elY", 6), data("mesh/elZ", 2),
+                                      0.0, data("mesh/maxX", 1.2), 0.0, data("mesh/maxY", 0.6), 0.0, data("mesh/maxZ", 0.2), TET4);
+
+    const double dt = data("time/dt", 0.05);
+    const int n_steps = data("time/n_steps", 20);
+    const std::string model = data("model", "monowave");
+    const std::string mass = data(model + "/reaction_mass", "lumped_mass");
+    std::string folder = "./" + std::string(data(model + "/output_folder", "ctest_checkpoint_restart")) + "/";
+    BeatIt::createOutputFolder(init.comm(), folder);
+    const std::string filename = folder + "checkpoint.bin";
+
+    // Time loop of example_electro_solver
+    auto run = [&](BeatIt::ElectroSolver& solver, int& iter, double& time, int n)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            ++iter;
+            time += dt;
+            solver.advance();
+            solver.solve_reaction_step(dt, time, 0, false, mass);
+            solver.solve_diffusion_step(dt, time, false, mass);
+        }
+    };
+
+    // Uninterrupted run
+    EquationSystems es_reference(mesh);
+    std::unique_ptr<BeatIt::ElectroSolver> reference(BeatIt::ElectroSolver::ElectroFactory::Create(model, es_reference));
+    reference->setup(data, model);
+    reference->init(0.0);
+    reference->assemble_matrices(dt);
+    int iter = 0;
+    double time = 0.0;
+    run(*reference, iter, time, 2 * n_steps);
+
+    // First half and checkpoint
+    {
+        EquationSystems es(mesh);
+        std::unique_ptr<BeatIt::ElectroSolver> solver(BeatIt::ElectroSolver::ElectroFactory::Create(model, es));
+        solver->setup(data, model);
+        solver->init(0.0);
+        solver->assemble_matrices(dt);
+        int iter_first = 0;
+        double time_first = 0.0;
+        run(*solver, iter_first, time_first, n_steps);
+        solver->save_checkpoint(filename, time_first, iter_first);
+    }
+
+    // Restart: a new solver, as in a new run
+    EquationSystems es_restart(mesh);
+    std::unique_ptr<BeatIt::ElectroSolver> restarted(BeatIt::ElectroSolver::ElectroFactory::Create(model, es_restart));
+    restarted->setup(data, model);
+    restarted->init(0.0);
+    int iter_restart = 0;
+    double time_restart = 0.0;
+    restarted->restart_from_checkpoint(filename, time_restart, iter_restart);
+    int errors = 0;
+    if (iter_restart != n_steps || restarted->timestep_counter() != n_steps || es_restart.get_system("wave").time != time_restart)
+    {
+        std::cout << "wrong step " << iter_restart << ", time step counter " << restarted->timestep_counter() << " or time of the wave system " << es_restart.get_system("wave").time << std::endl;
+        ++errors;
+    }
+    restarted->assemble_matrices(dt);
+    run(*restarted, iter_restart, time_restart, n_steps);
+
+    // Compare the potentials
+    auto& V_reference = *es_reference.get_system<TransientLinearImplicitSystem>("wave").solution;
+    auto& V_restart = *es_restart.get_system<TransientLinearImplicitSystem>("wave").solution;
+    const double norm = V_reference.l2_norm();
+    std::unique_ptr<NumericVector<Number> > difference = V_restart.clone();
+    difference->add(-1.0, V_reference);
+    const double error = difference->l2_norm() / norm;
+    std::cout << std::setprecision(6) << "restart at step " << n_steps << " of " << 2 * n_steps << ": |V| = " << norm << ", relative difference " << error << std::endl;
+    if (error > 1e-10 || std::abs(time_restart - time) > 1e-12) ++errors;
+    return errors > 0 ? 1 : 0;
+}
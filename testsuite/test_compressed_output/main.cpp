@@ -0,0 +1,120 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+// Write a potential and a gating variable in float64, float32 and with a 12 bit
+// quantization of V, read them back onto the mesh and check the errors
+// against the precision of each encoding.
+
+#include "Util/IO/CompressedFieldIO.hpp"
+#include "Util/IO/io.hpp"
+
+#include "libmesh/transient_system.h"
+#include "libmesh/explicit_system.h"
+#include "libmesh/mesh.h"
+#include "libmesh/mesh_generation.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/dof_map.h"
+#include "libmesh/node.h"
+
+#include <cmath>
+#include <iomanip>
+
+int main(int argc, char ** argv)
+{
+    using namespace libMesh;
+    LibMeshInit init(argc, argv, MPI_COMM_WORLD);
+
+    Mesh mesh(init.comm());
+    MeshTools::Generation::build_square(mesh, 40, 40, 0.0, 1.0, 0.0, 1.0, QUAD4);
+    EquationSystems es(mesh);
+    ExplicitSystem& system = es.add_system<ExplicitSystem>("wave");
+    system.add_variable("V", FIRST);
+    system.add_variable("w", FIRST);
+    es.init();
+
+    std::string folder = "./ctest_compressed_output/";
+    BeatIt::createOutputFolder(init.comm(), folder);
+
+    const unsigned int sys = system.number();
+    auto V = [](const Point& p, double t)
+    {   return -85.0 + 120.0 / (1.0 + std::exp(-(p(0) - 0.1 * t) / 0.02));};
+    auto w = [](const Point& p, double t)
+    {   return 0.5 + 0.5 * std::sin(3.0 * p(1) + t);};
+    auto fill = [&](double t)
+    {
+        for (auto node = mesh.local_nodes_begin(); node != mesh.local_nodes_end(); ++node)
+        {
+            const Node& n = **node;
+            system.solution->set(n.dof_number(sys, 0, 0), V(n, t));
+            system.solution->set(n.dof_number(sys, 1, 0), w(n, t));
+        }
+        system.solution->close();
+    };
+
+    struct Case
+    {
+        std::string name;
+        BeatIt::FieldEncoding encoding;
+        bool quantize_V;
+    };
+    BeatIt::FieldEncoding quantized(BeatIt::FieldEncoding::Quantized, -100.0, 60.0, 12);
+    std::vector<Case> cases = { { "float64", BeatIt::FieldEncoding(BeatIt::FieldEncoding::Float64), false },
+                                { "float32", BeatIt::FieldEncoding(BeatIt::FieldEncoding::Float32), false },
+                                { "quantized", BeatIt::FieldEncoding(BeatIt::FieldEncoding::Float32), true } };
+
+    std::set<std::string> systems = { "wave" };
+    const std::vector<double> times = { 0.0, 2.5, 5.0 };
+    int errors = 0;
+    for (auto && c : cases)
+    {
+        BeatIt::CompressedFieldWriter writer(mesh, folder + c.name);
+        writer.set_default_encoding(c.encoding);
+        if (c.quantize_V) writer.set_encoding("V", quantized);
+        for (unsigned int i = 0; i < times.size(); ++i)
+        {
+            fill(times[i]);
+            writer.write_timestep(es, systems, i + 1, times[i]);
+        }
+        // The files of all the processors are complete
+        init.comm().barrier();
+
+        BeatIt::CompressedFieldReader reader(folder + c.name);
+        if (reader.n_timesteps() != times.size())
+        {
+            std::cout << c.name << ": " << reader.n_timesteps() << " time steps read instead of " << times.size() << std::endl;
+            ++errors;
+            continue;
+        }
+        const double tol_V = c.quantize_V ? quantized.max_error() * (1.0 + 1e-12) : (c.encoding.type == BeatIt::FieldEncoding::Float32 ? 1e-5 : 0.0);
+        const double tol_w = c.encoding.type == BeatIt::FieldEncoding::Float32 ? 1e-7 : 0.0;
+        double error_V = 0.0;
+        double error_w = 0.0;
+        for (unsigned int i = 0; i < times.size(); ++i)
+        {
+            system.solution->zero();
+            system.solution->close();
+            if (reader.read(i, system) != 2) ++errors;
+            if (reader.step(i) != static_cast<int>(i + 1) || reader.time(i) != times[i]) ++errors;
+            for (auto node = mesh.local_nodes_begin(); node != mesh.local_nodes_end(); ++node)
+            {
+                const Node& n = **node;
+                error_V = std::max(error_V, std::abs((*system.solution)(n.dof_number(sys, 0, 0)) - V(n, times[i])));
+                error_w = std::max(error_w, std::abs((*system.solution)(n.dof_number(sys, 1, 0)) - w(n, times[i])));
+            }
+        }
+        init.comm().max(error_V);
+        init.comm().max(error_w);
+        std::uint64_t input_bytes = writer.input_bytes();
+        std::uint64_t stored_bytes = writer.stored_bytes();
+        init.comm().sum(input_bytes);
+        init.comm().sum(stored_bytes);
+        std::cout << std::setw(10) << c.name << ": max error V = " << error_V << " (tol " << tol_V << "), w = " << error_w << " (tol " << tol_w << "), " << input_bytes << " -> " << stored_bytes << " bytes, ratio "
+                  << static_cast<double>(input_bytes) / stored_bytes << std::endl;
+        if (error_V > tol_V || error_w > tol_w) ++errors;
+    }
+    return errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+// Assembly benchmark of the quasi-static elasticity on TET4 (P1), TET10 (P2) and HEX8 (P1):
+// the Jacobian evaluated once per quadrature point must match the one evaluated
+// for each trial function, and the assembly times of the two are compared.
+// The matrix-free Jacobian must give the same product as the assembled one, constrained rows included:
+// its memory is compared with the one of the assembled Jacobian and of its low order preconditioner.
+// The residual and the Jacobian assembled by the threads (--n_threads) must match the ones of a single thread.
+
+#include "Elasticity/Elasticity.hpp"
+#include "Util/SpiritFunction.hpp"
+#include "Util/Timer.hpp"
+
+#include "libmesh/linear_implicit_system.h"
+#include "libmesh/transient_system.h"
+#include "libmesh/mesh.h"
+#include "libmesh/mesh_generation.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/sparse_matrix.h"
+#include "libmesh/petsc_matrix.h"
+#include "libmesh/getpot.h"
+
+#include <iomanip>
+#include <sstream>
+
+//! Bytes used by the local part of the matrix
+double local_memory(libMesh::SparseMatrix<libMesh::Number>& matrix)
+{
+    auto petsc_matrix = dynamic_cast<libMesh::PetscMatrix<libMesh::Number>*>(&matrix);
+    if (!petsc_matrix) return 0.0;
+    MatInfo info;
+    MatGetInfo(petsc_matrix->mat(), MAT_LOCAL, &info);
+    return info.memory;
+}
+
+int main(int argc, char ** argv)
+{
+    using namespace libMesh;
+    LibMeshInit init(argc, argv, MPI_COMM_WORLD);
+
+    GetPot commandLine(argc, argv);
+    std::string datafile_name = commandLine.follow("data.beat", 2, "-i", "--input");
+    GetPot data(datafile_name);
+
+    const int elX = data("elX", 10);
+    const int elY = data("elY", 2);
+    const int elZ = data("elZ", 2);
+    const int repeats = data("repeats", 3);
+
+    struct Case
+    {
+        std::string name;
+        ElemType type;
+        std::string section;
+    };
+    std::vector<Case> cases = { { "TET4  P1", TET4, "p1" },
+                                { "TET10 P2", TET10, "p2" },
+                                { "HEX8  P1", HEX8, "p1" } };
+
+    std::vector<std::string> report;
+    int errors = 0;
+    for (auto && c : cases)
+    {
+        Mesh mesh(init.comm());
+        MeshTools::Generation::build_cube(mesh, elX, elY, elZ, 0.0, 10.0, 0.0, 2.0, 0.0, 2.0, c.type);
+        EquationSystems es(mesh);
+        BeatIt::Elasticity elas(es, "Elasticity");
+        elas.setup(data, c.section);
+
+        // Deformed state: the tangent is not the one of the reference configuration
+        TransientLinearImplicitSystem& system = es.get_system<TransientLinearImplicitSystem>("Elasticity");
+        BeatIt::SpiritFunction displacement;
+        displacement.add_function("0.01*x*y");
+        displacement.add_function("0.02*x*z");
+        displacement.add_function("-0.01*y*z+0.005*x*x");
+        system.project_solution(&displacement);
+        system.update();
+
+        std::unique_ptr<NumericVector<Number> > v = system.solution->clone();
+        std::unique_ptr<NumericVector<Number> > Kv = system.solution->zero_clone();
+        std::unique_ptr<NumericVector<Number> > Kv_once = system.solution->zero_clone();
+
+        double elapsed[2];
+        for (int once = 0; once < 2; ++once)
+        {
+            elas.M_tangentOnce = (once == 1);
+            BeatIt::Timer timer;
+            timer.start();
+            for (int r = 0; r < repeats; ++r)
+            {
+                elas.assemble_jacobian_only();
+            }
+            timer.stop();
+            elapsed[once] = timer.elapsed().count() / repeats;
+            system.matrix->vector_mult(once == 1 ? *Kv_once : *Kv, *v);
+        }
+
+        // Matrix-free Jacobian
+        std::unique_ptr<NumericVector<Number> > Kv_free = system.solution->zero_clone();
+        elas.M_matrixFree = true;
+        BeatIt::Timer timer_free;
+        timer_free.start();
+        elas.assemble_jacobian_only();
+        timer_free.stop();
+        elas.M_shellMatrix->vector_mult(*Kv_free, *v);
+        const double memory = local_memory(*system.matrix);
+        // Preconditioner of the matrix-free Jacobian
+        elas.assemble_reference_tangent();
+        const double memory_preconditioner = local_memory(*system.matrix);
+        elas.M_matrixFree = false;
+
+        // Threaded and serial assembly: without copies of the materials a single chunk is assembled
+        elas.M_tangentOnce = false;
+        std::unique_ptr<NumericVector<Number> > residual[2];
+        std::unique_ptr<NumericVector<Number> > Kv_threads[2];
+        for (int threaded = 0; threaded < 2; ++threaded)
+        {
+            if (threaded) elas.init_thread_materials();
+            else elas.M_threadMaterials.clear();
+            elas.assemble_residual();
+            residual[threaded] = system.rhs->clone();
+            Kv_threads[threaded] = system.solution->zero_clone();
+            system.matrix->vector_mult(*Kv_threads[threaded], *v);
+        }
+        const double norm_residual = residual[0]->l2_norm();
+        residual[1]->add(-1.0, *residual[0]);
+        Kv_threads[1]->add(-1.0, *Kv_threads[0]);
+        const double error_residual = residual[1]->l2_norm() / norm_residual;
+        const double error_threads = Kv_threads[1]->l2_norm() / Kv_threads[0]->l2_norm();
+        if (error_residual > 1e-12) ++errors;
+        if (error_threads > 1e-12) ++errors;
+
+        const double norm = Kv->l2_norm();
+        Kv_once->add(-1.0, *Kv);
+        Kv_free->add(-1.0, *Kv);
+        const double error = Kv_once->l2_norm() / norm;
+        const double error_free = Kv_free->l2_norm() / norm;
+        if (error > 1e-12) ++errors;
+        if (error_free > 1e-12) ++errors;
+
+        std::ostringstream line;
+        line << std::setprecision(4) << c.name << ": " << system.n_dofs() << " dofs, per trial function: " << elapsed[0] << " s, once per quadrature point: " << elapsed[1] << " s, speedup: " << elapsed[0] / elapsed[1] << ", relative difference: " << error;
+        report.push_back(line.str());
+        std::ostringstream line_free;
+        line_free << std::setprecision(4) << "          matrix-free setup: " << timer_free.elapsed().count() << " s, memory: " << elas.M_shellMatrix->memory() / 1048576.0
+                  << " MB (assembled: " << memory / 1048576.0 << " MB, preconditioner: " << memory_preconditioner / 1048576.0 << " MB), relative difference: " << error_free;
+        report.push_back(line_free.str());
+        std::ostringstream line_threads;
+        line_threads << std::setprecision(4) << "          " << libMesh::n_threads() << " threads against 1: residual relative difference: " << error_residual
+                     << ", Jacobian relative difference: " << error_threads;
+        report.push_back(line_threads.str());
+    }
+
+    std::cout << std::endl;
+    for (auto && line : report)
+    {
+        std::cout << line << std::endl;
+    }
+    std::cout << "errors: " << errors << std::endl;
+    return (0 == errors) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
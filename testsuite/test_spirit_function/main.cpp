@@ -0,0 +1,112 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+// Compare the compiled expressions of the SpiritFunction with the Grammar:
+// scalar, batched and concurrent evaluations must give the same values
+
+#include "Util/SpiritFunction.hpp"
+#include "libmesh/point.h"
+
+#include <iostream>
+#include <thread>
+#include <cmath>
+
+int main()
+{
+    std::vector<std::string> expressions = { "1.0",
+                                             "x+2*y-z/3",
+                                             "-2^2",
+                                             "-x^2",
+                                             "2^3^2",
+                                             "x*-2^2",
+                                             "(x<0.5)*(y>=0.2)*10",
+                                             "sin(x)+cosh(y)+log10(z+2)+exp(-t)",
+                                             "abs(x-0.5)+sqrt(y+1)+atan(z)",
+                                             "pi*e",
+                                             "(t>=0)*(t<=2)*50*(x*x+y*y<0.1)",
+                                             "1e-3*x+2.5E2",
+                                             "tanh(3*(x-0.1))+acos(0.3)+asin(0.2)+tan(0.1)+sinh(1)",
+                                             "3 - -x",
+                                             "x/y/z" };
+    Grammar<std::string::const_iterator> grammar;
+    std::vector<libMesh::Point> points;
+    for (int i = 0; i < 1000; ++i)
+    {
+        double x = 1e-3 * i;
+        points.push_back(libMesh::Point(x, 0.25 * x + 0.05, 1.0 - x));
+    }
+
+    int errors = 0;
+    for (auto && expression : expressions)
+    {
+        BeatIt::SpiritFunction function;
+        function.add_function(expression);
+        for (double t : { 0.0, 1.0, 3.0 })
+        {
+            std::vector<double> values(points.size());
+            function.evaluate(points.data(), points.size(), t, values.data());
+            for (unsigned int i = 0; i < points.size(); ++i)
+            {
+                const libMesh::Point& p = points[i];
+                grammar.setSymbol("t", t);
+                grammar.setSymbol("x", p(0));
+                grammar.setSymbol("y", p(1));
+                grammar.setSymbol("z", p(2));
+                double expected = 0.0;
+                auto iter = expression.cbegin();
+                phrase_parse(iter, expression.cend(), grammar, space, expected);
+                const double value = function(t, p(0), p(1), p(2), 0);
+                if (std::abs(value - expected) > 1e-14 * (1.0 + std::abs(expected)) || values[i] != value)
+                {
+                    std::cout << expression << ": expected " << expected << ", scalar " << value << ", batched " << values[i] << std::endl;
+                    ++errors;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Concurrent evaluations on the same function
+    BeatIt::SpiritFunction function;
+    function.add_function("(t>=0)*(t<=2)*50*(x*x+y*y<0.1)+sin(z)");
+    std::vector<double> serial(points.size());
+    std::vector<double> concurrent(points.size());
+    function.evaluate(points.data(), points.size(), 1.0, serial.data());
+    const unsigned int n_threads = 4;
+    std::vector<std::thread> threads;
+    for (unsigned int k = 0; k < n_threads; ++k)
+    {
+        threads.emplace_back([&, k]()
+        {
+            const unsigned int begin = k * points.size() / n_threads;
+            const unsigned int end = (k + 1) * points.size() / n_threads;
+            function.evaluate(points.data() + begin, end - begin, 1.0, concurrent.data() + begin);
+        });
+    }
+    for (auto && thread : threads) thread.join();
+    if (serial != concurrent)
+    {
+        std::cout << "concurrent evaluation differs" << std::endl;
+        ++errors;
+    }
+
+    // Invalid expressions are reported when they are read
+    try
+    {
+        BeatIt::SpiritFunction invalid;
+        invalid.add_function("sin x");
+        std::cout << "invalid expression accepted" << std::endl;
+        ++errors;
+    }
+    catch (std::runtime_error& e)
+    {
+        std::cout << e.what() << std::endl;
+    }
+
+    std::cout << "errors: " << errors << std::endl;
+    return (0 == errors) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,123 @@
+/*
+ * main.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: srossi
+ */
+
+// Order of convergence of the SplittingScheduler on a uniform potential (0D):
+// the Fenton-Karma model with the Rush-Larsen integrator, which is exact at fixed
+// potential, is advanced with decreasing time steps and the potential at the end
+// time is compared with a reference computed with the Strang splitting and a much
+// smaller time step. The Godunov splitting must be first order and the Strang
+// splitting second order, with and without substeps of the reaction step.
+
+#include "Electrophysiology/Monodomain/Monowave.hpp"
+#include "Electrophysiology/SplittingScheduler.hpp"
+
+#include "libmesh/transient_system.h"
+#include "libmesh/mesh.h"
+#include "libmesh/mesh_generation.h"
+#include "libmesh/numeric_vector.h"
+#include "libmesh/getpot.h"
+
+#include <cmath>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+
+int main(int argc, char ** argv)
+{
+    using namespace libMesh;
+    LibMeshInit init(argc, argv, MPI_COMM_WORLD);
+
+    GetPot commandLine(argc, argv);
+    std::string datafile_name = commandLine.follow("data.beat", 2, "-i", "--input");
+    GetPot data(datafile_name);
+
+    Mesh mesh(init.comm());
+    MeshTools::Generation::build_cube(mesh, data("mesh/elX", 2), data("mesh/elY", 1), data("mesh/elZ", 1),
+                                      0.0, 1.0, 0.0, 1.0, 0.0, 1.0, TET4);
+
+    const double end_time = data("time/end_time", 50.0);
+    const double dt0 = data("time/dt", 0.1);
+    const int n_dt = data("time/n_dt", 4);
+    const int reference_refinement = data("time/reference_refinement", 64);
+    const std::string model = data("model", "monowave");
+    const std::string mass = data(model + "/reaction_mass", "lumped_mass");
+
+    // Potential at the end time: the scheme is read from scheme/splitting
+    auto run = [&](const std::string& scheme, unsigned int substeps, double dt)
+    {
+        EquationSystems es(mesh);
+        std::unique_ptr<BeatIt::ElectroSolver> solver(BeatIt::ElectroSolver::ElectroFactory::Create(model, es));
+        solver->setup(data, model);
+        solver->init(0.0);
+        solver->assemble_matrices(dt);
+        BeatIt::SplittingScheduler splitting(*solver);
+        splitting.setup(data, scheme);
+        solver->set_reaction_substeps(substeps);
+
+        const int n_steps = static_cast<int>(std::lround(end_time / dt));
+        double time = 0.0;
+        for (int i = 0; i < n_steps; ++i)
+        {
+            time += dt;
+            splitting.step(dt, time, false, mass);
+        }
+        return es.get_system<TransientLinearImplicitSystem>("wave").solution->clone();
+    };
+
+    std::unique_ptr<NumericVector<Number> > reference = run("strang", 1, dt0 / reference_refinement);
+
+    struct Case
+    {
+        std::string scheme;
+        unsigned int substeps;
+        double min_order;
+        double max_order;
+    };
+    std::vector<Case> cases = { { "godunov", 1, 0.8, 1.3 },
+                                { "godunov", 2, 0.8, 1.3 },
+                                { "strang", 1, 1.8, 2.3 },
+                                { "strang", 2, 1.8, 2.3 } };
+
+    std::vector<std::string> report;
+    int errors = 0;
+    for (auto && c : cases)
+    {
+        std::ostringstream line;
+        line << std::setprecision(4) << c.scheme << ", " << c.substeps << " substeps:";
+        double error_previous = 0.0;
+        double order = 0.0;
+        for (int k = 0; k < n_dt; ++k)
+        {
+            const double dt = dt0 / (1 << k);
+            std::unique_ptr<NumericVector<Number> > V = run(c.scheme, c.substeps, dt);
+            V->add(-1.0, *reference);
+            const double error = V->linfty_norm();
+            line << "  dt = " << dt << ": " << error;
+            if (k > 0)
+            {
+                order = std::log2(error_previous / error);
+                line << " (" << order << ")";
+            }
+            error_previous = error;
+        }
+        // Order of the two smallest time steps
+        if (order < c.min_order || order > c.max_order)
+        {
+            line << "  order out of [" << c.min_order << ", " << c.max_order << "]";
+            ++errors;
+        }
+        report.push_back(line.str());
+    }
+
+    std::cout << std::endl;
+    for (auto && line : report)
+    {
+        std::cout << line << std::endl;
+    }
+    std::cout << "errors: " << errors << std::endl;
+    return (0 == errors) ? EXIT_SUCCESS : EXIT_FAILURE;
+}